@@ -1,14 +1,44 @@
-#define MAX_LIGHTS 16
-
 struct FragInput
 {
 
 };
 
+// Mirrors PointLight in RenderStructs.h
 struct Light
 {
     float3 position;
-    float _pad0;
+    float radius;
     float3 color;
-    float _pad1;
+    float _pad0;
+};
+
+// Mirrors MaterialGPU in RenderStructs.h: a packed texture slot (array << 16 | layer) per texture type
+struct Material
+{
+    uint albedo;
+    uint normal;
+    uint emissive;
+    uint metallic;
+    uint roughness;
+    uint ao;
+    uint2 _pad0;
 };
+
+// Mirrors ClusterRangeGPU in RenderStructs.h
+struct ClusterRange
+{
+    uint offset;
+    uint count;
+};
+
+// Vertex decoding for PackedVertex in RenderStructs.h
+
+// Inverse of the octahedral mapping in VertexPacking.cpp
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
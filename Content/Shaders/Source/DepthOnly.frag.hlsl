@@ -0,0 +1,4 @@
+// SDL_GPU pipelines always need a fragment shader, even when only depth is written.
+// The color target is bound with a zero write mask.
+void main() {
+}
@@ -0,0 +1,33 @@
+cbuffer Camera : register(b0, space1) {
+  float4x4 u_view;
+  float4x4 u_proj;
+  float4x4 u_viewProj;
+  float3 u_viewPos;
+};
+
+// Mirrors ModelUniformGPU in RenderStructs.h
+cbuffer Model : register(b1, space1) {
+  float4x4 u_model;
+  float4 u_positionOffset;
+  float4 u_positionScale;
+  uint4 u_material;
+};
+
+// Position-only input for the depth pre-pass (first attribute of PackedVertex).
+// The transform must match PBR.vert exactly so the main pass can use an EQUAL depth test.
+struct Input {
+  float4 Position : POSITION0;
+};
+
+struct Output {
+  float4 Position : SV_Position;
+};
+
+Output main(Input input) {
+  Output output;
+  precise float3 position = u_positionOffset.xyz + input.Position.xyz * u_positionScale.xyz;
+  precise float4 vertPos = mul(u_model, float4(position, 1.0f));
+  precise float4 clipPos = mul(u_viewProj, vertPos);
+  output.Position = clipPos;
+  return output;
+}
@@ -1,22 +1,51 @@
 #include "Common.hlsl"
 
-Texture2D<float4> AlbedoTex : register(t0, space2);
-Texture2D<float4> NormalTex : register(t1, space2);
-Texture2D<float4> EmissiveTex : register(t2, space2);
-Texture2D<float4> MetallicTex : register(t3, space2);
-Texture2D<float4> RoughnessTex : register(t4, space2);
-Texture2D<float4> AOTex : register(t5, space2);
+// MaterialTable texture arrays, one per format and size (MaterialTable::MAX_TEXTURE_ARRAYS)
+Texture2DArray<float4> TextureArray0 : register(t0, space2);
+Texture2DArray<float4> TextureArray1 : register(t1, space2);
+Texture2DArray<float4> TextureArray2 : register(t2, space2);
+Texture2DArray<float4> TextureArray3 : register(t3, space2);
+Texture2DArray<float4> TextureArray4 : register(t4, space2);
+Texture2DArray<float4> TextureArray5 : register(t5, space2);
+Texture2DArray<float4> TextureArray6 : register(t6, space2);
+Texture2DArray<float4> TextureArray7 : register(t7, space2);
+Texture2DArray<float4> TextureArray8 : register(t8, space2);
+Texture2DArray<float4> TextureArray9 : register(t9, space2);
+Texture2DArray<float4> TextureArray10 : register(t10, space2);
+Texture2DArray<float4> TextureArray11 : register(t11, space2);
+Texture2DArray<float4> TextureArray12 : register(t12, space2);
+Texture2DArray<float4> TextureArray13 : register(t13, space2);
+Texture2DArray<float4> TextureArray14 : register(t14, space2);
+Texture2DArray<float4> TextureArray15 : register(t15, space2);
 SamplerState Sampler : register(s0, space2);
 
+// Clustered lighting, storage buffers follow the sampled textures
+StructuredBuffer<Light> Lights : register(t16, space2);
+StructuredBuffer<ClusterRange> ClusterRanges : register(t17, space2);
+StructuredBuffer<uint> ClusterLightIndices : register(t18, space2);
+StructuredBuffer<Material> Materials : register(t19, space2);
+
+// Mirrors ClusterParamsGPU in RenderStructs.h
+cbuffer ClusterParams : register(b0, space3) {
+  float2 u_screenSize;
+  float u_zNear;
+  float u_zFar;
+  uint3 u_gridSize;
+  float u_logDepthScale;
+  float u_logDepthBias;
+  uint u_numLights;
+};
+
 struct Input {
+  float4 Position : SV_Position;
   float3 ViewPos : POSITION0;
   float3 FragPos : POSITION1;
-  float3 LightsPos[MAX_LIGHTS] : POSITION2;
   float3 Normal : NORMAL0;
   float3 Tangent : TANGENT0;
   float3 Bitangent : TANGENT1;
   float2 UV : TEXCOORD0;
-  uint NumLights : BLENDINDICES0;
+  float ViewDepth : TEXCOORD1;
+  nointerpolation uint MaterialIndex : TEXCOORD2;
 };
 
 struct TexSamples {
@@ -28,14 +57,42 @@ struct TexSamples {
   float ao;
 };
 
+// The array index is the same for the whole draw, so the switch doesn't diverge
+float4 SampleMaterialTexture(uint slot, float2 uv) {
+  float3 coord = float3(uv, float(slot & 0xFFFF));
+  switch (slot >> 16) {
+    case 0: return TextureArray0.Sample(Sampler, coord);
+    case 1: return TextureArray1.Sample(Sampler, coord);
+    case 2: return TextureArray2.Sample(Sampler, coord);
+    case 3: return TextureArray3.Sample(Sampler, coord);
+    case 4: return TextureArray4.Sample(Sampler, coord);
+    case 5: return TextureArray5.Sample(Sampler, coord);
+    case 6: return TextureArray6.Sample(Sampler, coord);
+    case 7: return TextureArray7.Sample(Sampler, coord);
+    case 8: return TextureArray8.Sample(Sampler, coord);
+    case 9: return TextureArray9.Sample(Sampler, coord);
+    case 10: return TextureArray10.Sample(Sampler, coord);
+    case 11: return TextureArray11.Sample(Sampler, coord);
+    case 12: return TextureArray12.Sample(Sampler, coord);
+    case 13: return TextureArray13.Sample(Sampler, coord);
+    case 14: return TextureArray14.Sample(Sampler, coord);
+    default: return TextureArray15.Sample(Sampler, coord);
+  }
+}
+
+uint ClusterIndex(float2 fragCoord, float viewDepth) {
+  uint2 tile = min(uint2(fragCoord / u_screenSize * float2(u_gridSize.xy)), u_gridSize.xy - 1);
+  float slice = log(max(viewDepth, u_zNear)) * u_logDepthScale + u_logDepthBias;
+  uint z = min(uint(max(slice, 0.0f)), u_gridSize.z - 1);
+  return tile.x + u_gridSize.x * (tile.y + u_gridSize.y * z);
+}
+
 float3 BlinnPhong(TexSamples samples, float3x3 TBN, float3 viewPos, float3 fragPos, float3 lightPos,
-                  float3 lightColor) {
-  const float radius = 15.0f;
+                  float3 lightColor, float radius) {
   float dist = length(lightPos - fragPos);
   if (dist >= radius) return float3(0, 0, 0);
 
-  float3 norm = normalize(samples.normal * 2.0f - 1.0f);
-  norm = normalize(mul(norm, TBN));
+  float3 norm = normalize(mul(samples.normal, TBN));
   float3 lightDir = normalize(lightPos - fragPos);
 
   // diffuse
@@ -62,25 +119,29 @@ float3 BlinnPhong(TexSamples samples, float3x3 TBN, float3 viewPos, float3 fragP
 
 float4 main(Input input) : SV_Target0 {
   float3x3 TBN = float3x3(input.Tangent, input.Bitangent, input.Normal);
-  float3 u_lightcolor = float3(1.0f, 1.0f, 1.0f);
   float gamma = 1.0 / 2.2;
 
+  Material material = Materials[input.MaterialIndex];
   TexSamples samples;
-  samples.albedo    = AlbedoTex.Sample(Sampler, input.UV).rgb;
-  samples.normal    = NormalTex.Sample(Sampler, input.UV).rgb;
-  samples.emissive  = EmissiveTex.Sample(Sampler, input.UV).rgb;
-  samples.metallic  = MetallicTex.Sample(Sampler, input.UV).b;   // glTF: blue channel
-  samples.roughness = RoughnessTex.Sample(Sampler, input.UV).g;  // glTF: green channel
-  samples.ao        = AOTex.Sample(Sampler, input.UV).r;
+  samples.albedo    = SampleMaterialTexture(material.albedo, input.UV).rgb;
+  // normal maps may be two channel (BC5), z is rebuilt from xy
+  float2 normalXY   = SampleMaterialTexture(material.normal, input.UV).rg * 2.0f - 1.0f;
+  samples.normal    = float3(normalXY, sqrt(saturate(1.0f - dot(normalXY, normalXY))));
+  samples.emissive  = SampleMaterialTexture(material.emissive, input.UV).rgb;
+  samples.metallic  = SampleMaterialTexture(material.metallic, input.UV).b;   // glTF: blue channel
+  samples.roughness = SampleMaterialTexture(material.roughness, input.UV).g;  // glTF: green channel
+  samples.ao        = SampleMaterialTexture(material.ao, input.UV).r;
 
   // ambient: albedo scaled by AO
   float3 ambient = 0.03f * samples.albedo * samples.ao;
 
-  // accumulate light contributions
+  // accumulate contributions of the lights binned into this fragment's cluster
   float3 result = ambient;
-  for (uint i = 0; i < input.NumLights; ++i) {
-    result += BlinnPhong(samples, TBN, input.ViewPos, input.FragPos, input.LightsPos[i],
-                         u_lightcolor);
+  ClusterRange cluster = ClusterRanges[ClusterIndex(input.Position.xy, input.ViewDepth)];
+  for (uint i = 0; i < cluster.count; ++i) {
+    Light light = Lights[ClusterLightIndices[cluster.offset + i]];
+    result += BlinnPhong(samples, TBN, input.ViewPos, input.FragPos, light.position,
+                         light.color, light.radius);
   }
 
   result += samples.emissive;
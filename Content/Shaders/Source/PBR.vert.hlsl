@@ -6,19 +6,19 @@ cbuffer Camera : register(b0, space1) {
   float3 u_viewPos;
 };
 
-cbuffer Model : register(b1, space1) { float4x4 u_model; };
-
-cbuffer Lights : register(b2, space1) {
-  uint u_numLights;
-  uint3 _padLights;
-  Light u_lights[MAX_LIGHTS];
+// Mirrors ModelUniformGPU in RenderStructs.h
+cbuffer Model : register(b1, space1) {
+  float4x4 u_model;
+  float4 u_positionOffset;
+  float4 u_positionScale;
+  uint4 u_material; // x: material table index
 };
 
+// PackedVertex
 struct Input {
-  float3 Position : POSITION0;
-  float3 Normal : NORMAL0;
-  float3 Tangent : TANGENT0;
-  float3 Bitangent : TANGENT1;
+  float4 Position : POSITION0; // xyz within the submesh bounds, w = bitangent sign as 0/1
+  float2 Normal : NORMAL0;     // octahedral
+  float2 Tangent : TANGENT0;   // octahedral
   float2 UV : TEXCOORD0;
 };
 
@@ -26,27 +26,31 @@ struct Output {
   float4 Position : SV_Position;
   float3 ViewPos : POSITION0;
   float3 FragPos : POSITION1;
-  float3 LightsPos[MAX_LIGHTS] : POSITION2;
   float3 Normal : NORMAL0;
   float3 Tangent : TANGENT0;
   float3 Bitangent : TANGENT1;
   float2 UV : TEXCOORD0;
-  uint NumLights : BLENDINDICES0;
+  float ViewDepth : TEXCOORD1;
+  nointerpolation uint MaterialIndex : TEXCOORD2;
 };
 
 Output main(Input input) {
   Output output;
-  float4 vertPos = mul(u_model, float4(input.Position, 1.0f));
-  output.Position  = mul(u_viewProj, vertPos);
+  // precise: must produce the same depth as DepthOnly.vert for the EQUAL test after the pre-pass
+  precise float3 position = u_positionOffset.xyz + input.Position.xyz * u_positionScale.xyz;
+  precise float4 vertPos = mul(u_model, float4(position, 1.0f));
+  precise float4 clipPos = mul(u_viewProj, vertPos);
+  output.Position  = clipPos;
   output.ViewPos   = u_viewPos;
   output.FragPos   = vertPos.xyz;
-  output.Normal    = normalize(mul(u_model, float4(input.Normal,    0.0f))).xyz;
-  output.Tangent   = normalize(mul(u_model, float4(input.Tangent,   0.0f))).xyz;
-  output.Bitangent = normalize(mul(u_model, float4(input.Bitangent, 0.0f))).xyz;
-  for (int i = 0; i < MAX_LIGHTS; ++i) {
-    output.LightsPos[i] = u_lights[i].position;
-  }
-  output.NumLights = u_numLights;
+  float3 normal    = OctDecode(input.Normal);
+  float3 tangent   = OctDecode(input.Tangent);
+  float3 bitangent = cross(normal, tangent) * (input.Position.w * 2.0f - 1.0f);
+  output.Normal    = normalize(mul(u_model, float4(normal,    0.0f))).xyz;
+  output.Tangent   = normalize(mul(u_model, float4(tangent,   0.0f))).xyz;
+  output.Bitangent = normalize(mul(u_model, float4(bitangent, 0.0f))).xyz;
   output.UV = input.UV;
+  output.ViewDepth = mul(u_view, vertPos).z;
+  output.MaterialIndex = u_material.x;
   return output;
 }
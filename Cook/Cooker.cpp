@@ -0,0 +1,498 @@
+#include "Cooker.h"
+
+#include <algorithm>
+#include <assimp/scene.h>
+#include <cctype>
+#include <charconv>
+#include <ContentPack.h>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <map>
+#include <MappedFile.h>
+#include <mutex>
+#include <Render/MeshFile.h>
+#include <Render/ModelImporter.h>
+#include <Render/TextureCache.h>
+#include <Render/TextureFile.h>
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <set>
+#include <string_view>
+#include <ThreadPool.h>
+
+// Bumped whenever a change to the cooker changes its output
+static constexpr uint64_t s_CookVersion = 1;
+static constexpr const char* s_ManifestFilename = ".cookmanifest";
+
+static std::string GetLowerExtension(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+static bool IsModelPath(const std::filesystem::path& path) {
+    const std::string extension = GetLowerExtension(path);
+    return extension == ".gltf" || extension == ".glb" || extension == ".obj";
+}
+
+// Images SDL_image decodes that the renderer would otherwise compress at load
+static bool IsImagePath(const std::filesystem::path& path) {
+    const std::string extension = GetLowerExtension(path);
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".tga";
+}
+
+static double GetMilliseconds(const Uint64 startTime) {
+    return static_cast<double>(SDL_GetPerformanceCounter() - startTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// 0 for a missing file
+static uint64_t GetFileSize(const std::filesystem::path& path) {
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(path, error);
+    return error ? 0 : size;
+}
+
+static std::string FormatSize(const uint64_t bytes) {
+    if (bytes >= 1024ull * 1024) return std::format("{:.1f} MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return std::format("{:.1f} KB", static_cast<double>(bytes) / 1024.0);
+}
+
+static const char* s_ResultNames[] = { "cooked", "current", "skipped", "FAILED" };
+
+bool Cooker::Run(const Settings& settings) {
+    mSettings = settings;
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+    if (!std::filesystem::is_directory(mSettings.sourceDir)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Content directory %s doesn't exist", mSettings.sourceDir.string().c_str());
+        return false;
+    }
+    // The importer logs every texture slot of every material, which buries the report
+    if (!mSettings.bVerbose) {
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+    }
+
+    std::error_code error;
+    if (!std::filesystem::equivalent(mSettings.sourceDir, mSettings.outputDir, error) && !Mirror(mSettings.sourceDir, mSettings.outputDir)) {
+        return false;
+    }
+    LoadManifest();
+
+    // Models first, they decide what their textures compress to
+    std::vector<Asset> models;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(mSettings.outputDir / "Models", error)) {
+        if (entry.is_regular_file() && IsModelPath(entry.path())) {
+            Asset& asset = models.emplace_back();
+            asset.type = AssetType::Model;
+            asset.path = entry.path();
+        }
+    }
+    CookAssets(models);
+
+    std::map<std::filesystem::path, std::set<aiTextureType>> textureTypes;
+    for (const Asset& model : models) {
+        for (const auto& [filename, type] : model.textures) {
+            // '*' names embedded images, which stay in the model
+            if (filename.empty() || filename[0] == '*') continue;
+            const std::filesystem::path texturePath = (model.path.parent_path() / filename).lexically_normal();
+            if (IsImagePath(texturePath) && std::filesystem::is_regular_file(texturePath, error)) {
+                textureTypes[texturePath].insert(type);
+            }
+        }
+    }
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(mSettings.outputDir / "Images", error)) {
+        if (entry.is_regular_file() && IsImagePath(entry.path())) {
+            textureTypes.try_emplace(entry.path());
+        }
+    }
+    std::vector<Asset> textures;
+    for (const auto& [path, types] : textureTypes) {
+        Asset& asset = textures.emplace_back();
+        asset.type = AssetType::Texture;
+        asset.path = path;
+        asset.role = types.empty() ? TextureEncoder::TextureRole::Color : ModelImporter::GetTextureRole(types);
+    }
+    CookAssets(textures);
+
+    uint32_t numResults[4] = {};
+    uint64_t sourceBytes = 0;
+    uint64_t outputBytes = 0;
+    for (const std::vector<Asset>* assets : { &models, &textures }) {
+        for (const Asset& asset : *assets) {
+            ++numResults[static_cast<uint8_t>(asset.result)];
+            sourceBytes += asset.sourceSize;
+            outputBytes += asset.outputSize;
+            if (asset.result != CookResult::Failed) {
+                mManifest[asset.name] = asset.entry;
+            }
+        }
+    }
+    SaveManifest();
+    const bool bPacked = mSettings.packPath.empty() || WritePack(models, textures);
+
+    std::printf("%zu assets in %.1f ms: %u cooked, %u current, %u skipped, %u failed. %s of sources, %s cooked\n",
+        models.size() + textures.size(), GetMilliseconds(startTime),
+        numResults[0], numResults[1], numResults[2], numResults[3], FormatSize(sourceBytes).c_str(), FormatSize(outputBytes).c_str());
+    return numResults[static_cast<uint8_t>(CookResult::Failed)] == 0 && bPacked;
+}
+
+bool Cooker::Mirror(const std::filesystem::path& sourceDir, const std::filesystem::path& outputDir) {
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+    uint32_t numCopied = 0;
+    uint64_t bytesCopied = 0;
+    std::set<std::string> sources;
+    std::set<std::string> sourceStems; // what cooked files are named after
+    std::error_code readError;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(sourceDir, readError)) {
+        if (!entry.is_regular_file()) continue;
+        const std::filesystem::path relativePath = std::filesystem::relative(entry.path(), sourceDir);
+        sources.insert(relativePath.generic_string());
+        sourceStems.insert(std::filesystem::path(relativePath).replace_extension().generic_string());
+        const std::filesystem::path destination = outputDir / relativePath;
+        const std::filesystem::file_time_type modifiedTime = entry.last_write_time();
+        std::error_code destinationError;
+        if (std::filesystem::file_size(destination, destinationError) == entry.file_size() && !destinationError &&
+            std::filesystem::last_write_time(destination, destinationError) == modifiedTime && !destinationError) {
+            continue;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(destination.parent_path(), error);
+        if (!std::filesystem::copy_file(entry.path(), destination, std::filesystem::copy_options::overwrite_existing, error)) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't copy %s: %s", entry.path().string().c_str(), error.message().c_str());
+            return false;
+        }
+        // Keeps the next run's comparison cheap, copies don't always carry the time over
+        std::filesystem::last_write_time(destination, modifiedTime, error);
+        ++numCopied;
+        bytesCopied += entry.file_size();
+    }
+    if (readError) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't read %s: %s", sourceDir.string().c_str(), readError.message().c_str());
+        return false;
+    }
+
+    // Files whose source is gone, and cooked files of removed sources, would otherwise still load
+    // and get packed
+    std::vector<std::filesystem::path> staleFiles;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(outputDir, readError)) {
+        if (!entry.is_regular_file()) continue;
+        const std::filesystem::path relativePath = std::filesystem::relative(entry.path(), outputDir);
+        const std::string name = relativePath.generic_string();
+        const std::string extension = GetLowerExtension(entry.path());
+        const bool bCooked = extension == MeshFile::EXTENSION || extension == ".dds";
+        if (sources.contains(name) || name == s_ManifestFilename || extension == ContentPack::EXTENSION
+            || (bCooked && sourceStems.contains(std::filesystem::path(relativePath).replace_extension().generic_string()))) {
+            continue;
+        }
+        staleFiles.push_back(entry.path());
+    }
+    for (const std::filesystem::path& path : staleFiles) {
+        std::error_code error;
+        if (!std::filesystem::remove(path, error)) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't remove stale %s: %s", path.string().c_str(), error.message().c_str());
+        }
+    }
+    std::printf("Mirrored %u changed files (%s) into %s, removed %zu stale files, in %.1f ms\n",
+        numCopied, FormatSize(bytesCopied).c_str(), outputDir.string().c_str(), staleFiles.size(), GetMilliseconds(startTime));
+    return true;
+}
+
+void Cooker::CookAssets(std::vector<Asset>& assets) {
+    for (Asset& asset : assets) {
+        asset.name = std::filesystem::relative(asset.path, mSettings.outputDir).generic_string();
+        if (asset.type == AssetType::Model) {
+            // glTF geometry lives in the buffers next to the model
+            for (const std::string& source : ModelImporter::GetSources(asset.path.string())) {
+                asset.sourceSize += GetFileSize(asset.path.parent_path() / source);
+            }
+        }
+        else {
+            asset.sourceSize = GetFileSize(asset.path);
+        }
+    }
+    // Largest first, so the long cooks don't start last and leave the other threads idle
+    std::ranges::sort(assets, std::greater{}, &Asset::sourceSize);
+
+    // One asset per thread, each cooked serially: the importer and the encoder can't spread
+    // their own work over the pool from inside a pool job. The calling thread takes work too.
+    ThreadPool threadPool;
+    if (mSettings.numThreads != 1) {
+        threadPool.Init(mSettings.numThreads > 1 ? mSettings.numThreads - 1 : 0);
+    }
+    std::mutex reportMutex;
+    threadPool.ParallelFor(assets.size(), [&](size_t i) {
+        Asset& asset = assets[i];
+        const Uint64 startTime = SDL_GetPerformanceCounter();
+        if (asset.type == AssetType::Model) {
+            CookModel(asset);
+        }
+        else {
+            CookTexture(asset);
+        }
+        asset.milliseconds = GetMilliseconds(startTime);
+        std::lock_guard lock(reportMutex);
+        ReportAsset(asset);
+    });
+}
+
+bool Cooker::IsUpToDate(Asset& asset, const std::filesystem::path& outputPath, const std::vector<std::filesystem::path>& sources, const uint64_t settingsHash) const {
+    uint64_t stamp = settingsHash;
+    for (const std::filesystem::path& source : sources) {
+        std::error_code error;
+        const uint64_t values[] = {
+            GetFileSize(source),
+            static_cast<uint64_t>(std::filesystem::last_write_time(source, error).time_since_epoch().count()),
+        };
+        stamp = TextureCache::HashContent(values, sizeof(values), stamp);
+    }
+    asset.entry.stamp = stamp;
+
+    auto it = mManifest.find(asset.name);
+    const bool bKnown = !mSettings.bForce && it != mManifest.end() &&
+        (!it->second.bHasOutput || std::filesystem::exists(outputPath));
+    if (bKnown && it->second.stamp == stamp) {
+        asset.entry = it->second;
+        return true;
+    }
+
+    // Touched or copied, only new contents need a cook
+    uint64_t inputHash = settingsHash;
+    for (const std::filesystem::path& source : sources) {
+        MappedFile file;
+        if (!file.Open(source.string())) {
+            asset.entry.inputHash = 0;
+            return false;
+        }
+        inputHash = TextureCache::HashContent(file.GetData(), file.GetSize(), inputHash);
+    }
+    asset.entry.inputHash = inputHash;
+    if (bKnown && it->second.inputHash == inputHash) {
+        asset.entry.bHasOutput = it->second.bHasOutput;
+        return true;
+    }
+    return false;
+}
+
+void Cooker::CookModel(Asset& asset) const {
+    // The renderer's table of models may flip axes, those models are cooked again at load
+    const ModelImporter::ImportSettings importSettings{};
+    const std::string modelPath = asset.path.string();
+    const std::string cookedPath = MeshFile::GetCookedPath(modelPath);
+    std::vector<std::filesystem::path> sources;
+    for (const std::string& source : ModelImporter::GetSources(modelPath)) {
+        sources.push_back(asset.path.parent_path() / source);
+    }
+
+    const uint64_t settings[] = { s_CookVersion, ModelImporter::GetSettingsHash(importSettings), mSettings.bCompressGeometry ? 1u : 0u };
+    const uint64_t settingsHash = TextureCache::HashContent(settings, sizeof(settings));
+
+    if (IsUpToDate(asset, cookedPath, sources, settingsHash)) {
+        asset.result = CookResult::UpToDate;
+        MeshFile cookedFile;
+        if (asset.entry.bHasOutput && cookedFile.Load(cookedPath)) {
+            for (const MeshFile::Material& material : cookedFile.GetMaterials()) {
+                for (const MeshFile::TextureReference& texture : material.textures) {
+                    if (!texture.bUseFallback) asset.textures.emplace_back(texture.filename, texture.type);
+                }
+            }
+            asset.outputSize = GetFileSize(cookedPath);
+        }
+        return;
+    }
+
+    ModelImporter importer;
+    importer.Init(nullptr);
+    MeshData mesh;
+    ModelImporter::MeshLoadingContext context{};
+    if (!importer.Import(modelPath, importSettings, mesh, context)) {
+        asset.result = CookResult::Failed;
+        return;
+    }
+    for (const ModelImporter::MaterialLoadingContext& material : context.materialInfos) {
+        for (const auto& [type, texture] : material.textureContextMap) {
+            if (!texture.bUseFallback) asset.textures.emplace_back(texture.filename, type);
+        }
+    }
+    // Embedded textures are decoded from the source at load, so those models load from it too
+    if (context.scene->mNumTextures > 0) {
+        asset.result = CookResult::NotCooked;
+        asset.entry.bHasOutput = false;
+        return;
+    }
+    if (!importer.Cook(modelPath, importSettings, mesh, context, mSettings.bCompressGeometry)) {
+        asset.result = CookResult::Failed;
+        return;
+    }
+    asset.result = CookResult::Cooked;
+    asset.entry.bHasOutput = true;
+    asset.outputSize = GetFileSize(cookedPath);
+}
+
+void Cooker::CookTexture(Asset& asset) const {
+    std::filesystem::path cookedPath = asset.path;
+    cookedPath.replace_extension(".dds");
+    const uint64_t settings[] = { s_CookVersion, static_cast<uint64_t>(asset.role), static_cast<uint64_t>(mSettings.quality) };
+    const uint64_t settingsHash = TextureCache::HashContent(settings, sizeof(settings));
+
+    if (IsUpToDate(asset, cookedPath, { asset.path }, settingsHash)) {
+        asset.result = CookResult::UpToDate;
+        asset.outputSize = GetFileSize(cookedPath);
+        return;
+    }
+
+    SDL_Surface* image = IMG_Load(asset.path.string().c_str());
+    if (!image) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load image %s: %s", asset.name.c_str(), SDL_GetError());
+        asset.result = CookResult::Failed;
+        return;
+    }
+    // Tightly packed RGBA8, which ABGR8888 is in memory
+    SDL_Surface* rgbaImage = SDL_ConvertSurface(image, SDL_PIXELFORMAT_ABGR8888);
+    SDL_DestroySurface(image);
+    if (!rgbaImage) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to convert image %s: %s", asset.name.c_str(), SDL_GetError());
+        asset.result = CookResult::Failed;
+        return;
+    }
+    const uint32_t width = static_cast<uint32_t>(rgbaImage->w);
+    const uint32_t height = static_cast<uint32_t>(rgbaImage->h);
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        std::memcpy(pixels.data() + static_cast<size_t>(y) * width * 4,
+            static_cast<const uint8_t*>(rgbaImage->pixels) + static_cast<size_t>(y) * rgbaImage->pitch, width * 4);
+    }
+    SDL_DestroySurface(rgbaImage);
+
+    TextureFile textureFile;
+    const SDL_GPUTextureFormat format = TextureEncoder::GetFormatForRole(asset.role);
+    if (!TextureEncoder::EncodeTexture(format, pixels.data(), width, height, mSettings.quality, nullptr, textureFile) ||
+        !textureFile.Save(cookedPath.string())) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to cook texture %s", asset.name.c_str());
+        asset.result = CookResult::Failed;
+        return;
+    }
+    asset.result = CookResult::Cooked;
+    asset.entry.bHasOutput = true;
+    asset.outputSize = GetFileSize(cookedPath);
+}
+
+bool Cooker::WritePack(const std::vector<Asset>& models, const std::vector<Asset>& textures) const {
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+    // The runtime reads sources only when their cooked file is missing or stale, which the loose
+    // files still cover
+    std::set<std::filesystem::path> cookedSources;
+    for (const Asset& model : models) {
+        if (model.result == CookResult::Failed || !model.entry.bHasOutput) continue;
+        for (const std::string& source : ModelImporter::GetSources(model.path.string())) {
+            cookedSources.insert((model.path.parent_path() / source).lexically_normal());
+        }
+    }
+    for (const Asset& texture : textures) {
+        if (texture.result == CookResult::Failed || !texture.entry.bHasOutput) continue;
+        cookedSources.insert(texture.path.lexically_normal());
+    }
+
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(mSettings.outputDir, error)) {
+        if (!entry.is_regular_file()) continue;
+        const std::filesystem::path path = entry.path().lexically_normal();
+        const std::string name = std::filesystem::relative(path, mSettings.outputDir, error).generic_string();
+        const std::string extension = GetLowerExtension(path);
+        // Shader sources only matter to hot reload, which compiles them from the source tree
+        if (name == s_ManifestFilename || name.starts_with("Shaders/Source/") || extension == ContentPack::EXTENSION
+            || extension == ".tmp" || cookedSources.contains(path)) {
+            continue;
+        }
+        files.push_back(name);
+    }
+    // Directory iteration order isn't stable, the stamp and the layout should be
+    std::ranges::sort(files);
+
+    uint64_t stamp = TextureCache::HashContent(&s_CookVersion, sizeof(s_CookVersion));
+    uint64_t packedBytes = 0;
+    for (const std::string& name : files) {
+        const std::filesystem::path path = mSettings.outputDir / name;
+        const uint64_t values[] = {
+            GetFileSize(path),
+            static_cast<uint64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count()),
+        };
+        stamp = TextureCache::HashContent(name.data(), name.size(), stamp);
+        stamp = TextureCache::HashContent(values, sizeof(values), stamp);
+        packedBytes += values[0];
+    }
+
+    const std::string packPath = mSettings.packPath.string();
+    ContentPack existingPack;
+    if (!mSettings.bForce && std::filesystem::exists(packPath, error) && existingPack.Open(packPath, mSettings.outputDir.string())
+        && existingPack.GetStamp() == stamp) {
+        if (mSettings.bVerbose) std::printf("Content pack %s is current\n", packPath.c_str());
+        return true;
+    }
+    existingPack.Close();
+
+    if (!ContentPack::Write(packPath, mSettings.outputDir.string(), files, stamp)) {
+        return false;
+    }
+    std::printf("Packed %zu files (%s) into %s in %.1f ms\n",
+        files.size(), FormatSize(packedBytes).c_str(), packPath.c_str(), GetMilliseconds(startTime));
+    return true;
+}
+
+void Cooker::ReportAsset(const Asset& asset) const {
+    if (asset.result == CookResult::UpToDate && !mSettings.bVerbose) return;
+    std::printf("  %-8s %-64s %9.1f ms %10s -> %10s\n",
+        s_ResultNames[static_cast<uint8_t>(asset.result)], asset.name.c_str(), asset.milliseconds,
+        FormatSize(asset.sourceSize).c_str(), asset.outputSize > 0 ? FormatSize(asset.outputSize).c_str() : "-");
+}
+
+// One asset per line: "<stamp> <input hash> <has output> <name>", hex hashes
+bool Cooker::LoadManifest() {
+    mManifest.clear();
+    const std::string path = (mSettings.outputDir / s_ManifestFilename).string();
+    size_t size = 0;
+    char* data = static_cast<char*>(SDL_LoadFile(path.c_str(), &size));
+    if (!data) {
+        return false;
+    }
+    const std::string_view text(data, size);
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+        const std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        ManifestEntry entry;
+        const char* cursor = line.data();
+        const char* end = line.data() + line.size();
+        uint32_t bHasOutput = 0;
+        auto readField = [&](auto& value, const int base) {
+            const std::from_chars_result result = std::from_chars(cursor, end, value, base);
+            if (result.ec != std::errc() || result.ptr >= end || *result.ptr != ' ') return false;
+            cursor = result.ptr + 1;
+            return true;
+        };
+        if (!readField(entry.stamp, 16) || !readField(entry.inputHash, 16) || !readField(bHasOutput, 10) || cursor >= end) {
+            continue;
+        }
+        entry.bHasOutput = bHasOutput != 0;
+        mManifest[std::string(cursor, end)] = entry;
+    }
+    SDL_free(data);
+    return true;
+}
+
+bool Cooker::SaveManifest() const {
+    std::string text;
+    std::map<std::string, ManifestEntry> sorted(mManifest.begin(), mManifest.end());
+    for (const auto& [name, entry] : sorted) {
+        text += std::format("{:016x} {:016x} {} {}\n", entry.stamp, entry.inputHash, entry.bHasOutput ? 1 : 0, name);
+    }
+    const std::string path = (mSettings.outputDir / s_ManifestFilename).string();
+    if (!SDL_SaveFile(path.c_str(), text.data(), text.size())) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write %s: %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+    return true;
+}
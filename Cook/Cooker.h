@@ -0,0 +1,87 @@
+#pragma once
+
+#include <assimp/material.h>
+#include <filesystem>
+#include <Render/TextureEncoder.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Offline counterpart of the renderer's load path: turns the sources under a Content directory
+// into what the runtime loads without further work.
+//  - Models (.gltf, .glb, .obj) are imported and written as MeshFiles (.scmesh) next to them.
+//  - Textures the models reference, and the images in Content/Images, are block compressed with
+//    their full mip chain into a DDS next to the source image, which the renderer prefers.
+//  - When the output is another directory, the sources are mirrored into it first, copying only
+//    files whose size or modification time differ.
+//  - Optionally the output is packed into a ContentPack: everything the runtime reads, with the
+//    cooked files in place of the sources they were cooked from.
+// Every asset records a hash of its inputs (source contents and cook settings) in a manifest in
+// the output directory, so a later run skips what's unchanged. Sources whose size and
+// modification time match the manifest aren't even read. Assets cook in parallel, one per thread.
+class Cooker {
+public:
+    struct Settings {
+        std::filesystem::path sourceDir;
+        std::filesystem::path outputDir;  // same as sourceDir to cook in place
+        std::filesystem::path packPath;   // where to pack the output, empty for no pack
+        TextureEncoder::Quality quality = TextureEncoder::Quality::Normal;
+        uint32_t numThreads = 0;          // 0: one per hardware thread
+        bool bCompressGeometry = false;   // store mesh vertices and indices GeometryCodec encoded
+        bool bForce = false;              // cook everything, ignoring the manifest
+        bool bVerbose = false;            // keep the importer's logging
+    };
+
+    // False if any asset failed to cook
+    bool Run(const Settings& settings);
+
+private:
+    enum class AssetType : uint8_t {
+        Model = 0,
+        Texture,
+    };
+
+    enum class CookResult : uint8_t {
+        Cooked = 0,
+        UpToDate,
+        NotCooked, // nothing to cook, e.g. a model that embeds its textures
+        Failed,
+    };
+
+    struct ManifestEntry {
+        uint64_t stamp = 0;     // sizes and modification times of the sources, the cheap check
+        uint64_t inputHash = 0; // source contents and cook settings
+        bool bHasOutput = false; // false for assets that cook to nothing
+    };
+
+    struct Asset {
+        AssetType type = AssetType::Model;
+        std::string name;                 // relative to the output directory, the manifest key
+        std::filesystem::path path;       // in the output directory
+        TextureEncoder::TextureRole role = TextureEncoder::TextureRole::Color;
+        uint64_t sourceSize = 0;
+        // Filled in by the cook
+        CookResult result = CookResult::Failed;
+        ManifestEntry entry;
+        uint64_t outputSize = 0;
+        double milliseconds = 0.0;
+        std::vector<std::pair<std::string, aiTextureType>> textures; // referenced by a model, relative to it
+    };
+
+    bool Mirror(const std::filesystem::path& sourceDir, const std::filesystem::path& outputDir);
+    void CookAssets(std::vector<Asset>& assets);
+    void CookModel(Asset& asset) const;
+    void CookTexture(Asset& asset) const;
+    // Whether the manifest says the asset is current, hashing its sources only if the stamp changed
+    bool IsUpToDate(Asset& asset, const std::filesystem::path& outputPath, const std::vector<std::filesystem::path>& sources, const uint64_t settingsHash) const;
+    void ReportAsset(const Asset& asset) const;
+    // Rewritten only when the packed files changed
+    bool WritePack(const std::vector<Asset>& models, const std::vector<Asset>& textures) const;
+
+    bool LoadManifest();
+    bool SaveManifest() const;
+
+    Settings mSettings;
+    std::unordered_map<std::string, ManifestEntry> mManifest;
+};
@@ -0,0 +1,71 @@
+#include "Cooker.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <SDL3/SDL.h>
+
+static void PrintUsage() {
+    std::printf(
+        "Usage: SandCastleCook [options]\n"
+        "  --source <dir>    Content directory to cook (default: Content)\n"
+        "  --output <dir>    Where the cooked Content goes, sources are mirrored into it (default: the source)\n"
+        "  --pack <file>     Also pack the cooked Content into one archive the runtime maps (Content.scpack)\n"
+        "  --quality <q>     Texture compression quality: fast, normal or high (default: normal)\n"
+        "  --compress-geometry  Store mesh vertices and indices compressed, decoded at load\n"
+        "  --threads <n>     Assets cooked at once (default: one per hardware thread)\n"
+        "  --force           Cook everything, even what's up to date\n"
+        "  --verbose         Report up to date assets and keep the importer's logging\n");
+}
+
+int main(int argc, char* argv[]) {
+    Cooker::Settings settings;
+    settings.sourceDir = "Content";
+    bool bHasOutput = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool bHasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--source") == 0 && bHasValue) {
+            settings.sourceDir = argv[++i];
+        }
+        else if (std::strcmp(arg, "--output") == 0 && bHasValue) {
+            settings.outputDir = argv[++i];
+            bHasOutput = true;
+        }
+        else if (std::strcmp(arg, "--pack") == 0 && bHasValue) {
+            settings.packPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--quality") == 0 && bHasValue) {
+            const char* quality = argv[++i];
+            if (std::strcmp(quality, "fast") == 0) settings.quality = TextureEncoder::Quality::Fast;
+            else if (std::strcmp(quality, "normal") == 0) settings.quality = TextureEncoder::Quality::Normal;
+            else if (std::strcmp(quality, "high") == 0) settings.quality = TextureEncoder::Quality::High;
+            else {
+                PrintUsage();
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(arg, "--threads") == 0 && bHasValue) {
+            settings.numThreads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--compress-geometry") == 0) {
+            settings.bCompressGeometry = true;
+        }
+        else if (std::strcmp(arg, "--force") == 0) {
+            settings.bForce = true;
+        }
+        else if (std::strcmp(arg, "--verbose") == 0) {
+            settings.bVerbose = true;
+        }
+        else {
+            PrintUsage();
+            return (std::strcmp(arg, "--help") == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (!bHasOutput) {
+        settings.outputDir = settings.sourceDir;
+    }
+
+    Cooker cooker;
+    return cooker.Run(settings) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reference to an asset of type T in an AssetRegistry<T>. The generation tells a handle to an
+// unloaded asset apart from one to whatever reused its slot.
+template<typename T>
+struct AssetHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+    bool operator==(const AssetHandle& other) const = default;
+};
+
+struct AssetRegistryStats {
+    uint32_t numAssets = 0;     // loaded or loading
+    uint32_t numReferenced = 0; // of which with at least one reference
+    uint32_t numRequests = 0;   // Acquire calls
+    uint32_t numShared = 0;     // requests served by an asset already loaded or loading
+    uint32_t numUnloaded = 0;
+};
+
+// Named assets of one type behind reference counted handles.
+//  - Acquire returns the asset for a name with a new reference, creating it on the first request.
+//    The caller starts the load only then, so concurrent requests for a name share one load.
+//  - Release drops a reference. Assets nobody references stay loaded, so one requested again
+//    soon (e.g. by the next level) is reused, until the owner unloads them: the least recently
+//    released first, when it's short on memory.
+//  - Remove frees the slot. Handles to it go stale, Get returns null for them.
+// Get pointers are invalidated by Acquire, which may grow the storage. Not thread safe.
+template<typename T>
+class AssetRegistry {
+public:
+    using Handle = AssetHandle<T>;
+
+    // outCreated is set when the asset is new and has to be loaded
+    Handle Acquire(const std::string& name, bool& outCreated) {
+        ++mStats.numRequests;
+        auto it = mNames.find(name);
+        if (it != mNames.end()) {
+            Slot& slot = mSlots[it->second];
+            if (slot.refCount++ == 0) ++mStats.numReferenced;
+            ++mStats.numShared;
+            outCreated = false;
+            return { it->second, slot.generation };
+        }
+
+        uint32_t index;
+        if (!mFreeSlots.empty()) {
+            index = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else {
+            index = static_cast<uint32_t>(mSlots.size());
+            mSlots.emplace_back();
+        }
+        Slot& slot = mSlots[index];
+        slot.name = name;
+        slot.refCount = 1;
+        slot.bAlive = true;
+        mNames[name] = index;
+        ++mStats.numAssets;
+        ++mStats.numReferenced;
+        outCreated = true;
+        return { index, slot.generation };
+    }
+
+    // Stale handles are ignored
+    void Release(const Handle handle) {
+        Slot* slot = GetSlot(handle);
+        if (!slot || slot->refCount == 0) return;
+        if (--slot->refCount == 0) {
+            slot->releaseOrder = ++mNumReleases;
+            --mStats.numReferenced;
+        }
+    }
+
+    // Unloads the asset: it's dropped from the registry whatever its references
+    void Remove(const Handle handle) {
+        Slot* slot = GetSlot(handle);
+        if (!slot) return;
+        if (slot->refCount > 0) --mStats.numReferenced;
+        mNames.erase(slot->name);
+        *slot = Slot{ .generation = slot->generation + 1 };
+        mFreeSlots.push_back(handle.index);
+        --mStats.numAssets;
+        ++mStats.numUnloaded;
+    }
+
+    T* Get(const Handle handle) {
+        Slot* slot = GetSlot(handle);
+        return slot ? &slot->asset : nullptr;
+    }
+    const T* Get(const Handle handle) const {
+        const Slot* slot = GetSlot(handle);
+        return slot ? &slot->asset : nullptr;
+    }
+    Handle Find(const std::string& name) const {
+        auto it = mNames.find(name);
+        return it != mNames.end() ? Handle{ it->second, mSlots[it->second].generation } : Handle{};
+    }
+
+    // The unreferenced asset released longest ago among those bCanUnload(asset) accepts, or an
+    // invalid handle
+    template<typename Predicate>
+    Handle GetLeastRecentlyReleased(Predicate bCanUnload) const {
+        Handle oldest;
+        uint64_t oldestOrder = UINT64_MAX;
+        for (uint32_t i = 0; i < mSlots.size(); ++i) {
+            const Slot& slot = mSlots[i];
+            if (!slot.bAlive || slot.refCount > 0 || slot.releaseOrder >= oldestOrder || !bCanUnload(slot.asset)) continue;
+            oldest = { i, slot.generation };
+            oldestOrder = slot.releaseOrder;
+        }
+        return oldest;
+    }
+
+    // fn(handle, asset) for every asset
+    template<typename F>
+    void ForEach(F&& fn) {
+        for (uint32_t i = 0; i < mSlots.size(); ++i) {
+            if (mSlots[i].bAlive) fn(Handle{ i, mSlots[i].generation }, mSlots[i].asset);
+        }
+    }
+
+    const AssetRegistryStats* GetStats() const { return &mStats; }
+
+private:
+    struct Slot {
+        T asset{};
+        std::string name;
+        uint32_t generation = 0;
+        uint32_t refCount = 0;
+        uint64_t releaseOrder = 0; // when the last reference went
+        bool bAlive = false;
+    };
+
+    Slot* GetSlot(const Handle handle) {
+        if (handle.index >= mSlots.size()) return nullptr;
+        Slot& slot = mSlots[handle.index];
+        return (slot.bAlive && slot.generation == handle.generation) ? &slot : nullptr;
+    }
+    const Slot* GetSlot(const Handle handle) const {
+        return const_cast<AssetRegistry*>(this)->GetSlot(handle);
+    }
+
+    std::vector<Slot> mSlots;
+    std::vector<uint32_t> mFreeSlots;
+    std::unordered_map<std::string, uint32_t> mNames;
+    uint64_t mNumReleases = 0;
+    AssetRegistryStats mStats;
+};
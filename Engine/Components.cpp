@@ -22,22 +22,33 @@ void VelocityComponent::BeginFrame() {
     ImGui::InputFloat3("Velocity", &mVelocity.x);
     ImGui::InputFloat3("Angular Velocity", &mAngularVelocity.x);
 }
+DisplayComponent::DisplayComponent(Renderer* renderer, const std::string& meshName)
+    : mMesh(renderer->AcquireMesh(meshName)), mRenderer(renderer) {}
+DisplayComponent::~DisplayComponent() {
+    mRenderer->ReleaseMesh(mMesh);
+}
 void DisplayComponent::BeginFrame() {
-    // Display the mesh information in the imgui UI
-    if (mMesh) {
+    // Display the mesh information in the imgui UI. Null once a failed load dropped it.
+    const MeshData* mesh = mRenderer->GetMesh(mMesh);
+    if (mesh && !mesh->bLoaded) {
+        ImGui::Text("MeshData Information");
+        ImGui::Text("\tLoading...");
+        ImGui::Checkbox("Show", &mShow);
+    }
+    else if (mesh) {
         ImGui::Text("MeshData Information");
-        ImGui::Text("\tVertices: %i", mMesh->vertices.size());
-        ImGui::Text("\tIndices: %i", mMesh->indices.size());
+        ImGui::Text("\tVertices: %u", mesh->numVertices);
+        ImGui::Text("\tIndices: %u", mesh->numIndices);
         ImGui::Checkbox("Show", &mShow);
         if (ImGui::TreeNode("aiScene")) {
-            DisplaySceneDetails();
+            DisplaySceneDetails(*mesh);
             ImGui::TreePop();
         }
     }
 }
-void DisplayComponent::DisplaySceneDetails() {
+void DisplayComponent::DisplaySceneDetails(const MeshData& mesh) {
     if (!scene) {
-        scene = importer.ReadFile(mMesh->filepath, aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_FlipUVs);
+        scene = importer.ReadFile(mesh.filepath, aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_FlipUVs);
         
         rootUI.node = scene->mRootNode;
         std::queue<UINode> queue;
@@ -62,15 +62,17 @@ public:
         aiNode* node = nullptr;
     };
 
-    DisplayComponent() = default;
-    explicit DisplayComponent(MeshData* mesh) : mMesh(mesh) {}
+    // Holds a reference to the named mesh for as long as it lives
+    DisplayComponent(Renderer* renderer, const std::string& meshName);
+    ~DisplayComponent() override;
 
     void BeginFrame() override;
 
     bool mShow = true;
-    MeshData* mMesh = nullptr;
+    MeshHandle mMesh;
 private:
-    void DisplaySceneDetails();
+    void DisplaySceneDetails(const MeshData& mesh);
+    Renderer* mRenderer = nullptr;
     Assimp::Importer importer;
     const aiScene* scene = nullptr;
     UINode rootUI;
@@ -0,0 +1,169 @@
+#include "ContentPack.h"
+
+#include <cstring>
+#include <filesystem>
+#include <SDL3/SDL.h>
+
+namespace {
+    constexpr uint32_t s_Magic = 0x4B504353; // "SCPK"
+    constexpr uint64_t s_BlobAlignment = 16;
+
+    struct Header {
+        uint32_t magic = s_Magic;
+        uint32_t version = ContentPack::VERSION;
+        uint64_t stamp = 0;
+        uint64_t numEntries = 0;
+        uint64_t entriesOffset = 0;
+        uint64_t stringsOffset = 0;
+        uint64_t stringsSize = 0;
+    };
+
+    struct EntryRecord {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t nameOffset = 0; // in the strings
+        uint32_t nameLength = 0;
+    };
+
+    uint64_t AlignUp(const uint64_t value) {
+        return (value + s_BlobAlignment - 1) & ~(s_BlobAlignment - 1);
+    }
+}
+
+bool ContentPack::Open(const std::string& path, const std::string& rootDir) {
+    Close();
+    if (!mFile.Open(path)) {
+        return false;
+    }
+    const uint8_t* data = mFile.GetData();
+    const size_t size = mFile.GetSize();
+    Header header;
+    if (!data || size < sizeof(Header)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid content pack %s", path.c_str());
+        Close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != s_Magic || header.version != VERSION) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Content pack %s is invalid or from another version", path.c_str());
+        Close();
+        return false;
+    }
+    const bool bValidDirectory = header.entriesOffset <= size && header.numEntries <= (size - header.entriesOffset) / sizeof(EntryRecord)
+        && header.stringsOffset <= size && header.stringsSize <= size - header.stringsOffset;
+    if (!bValidDirectory) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid content pack directory in %s", path.c_str());
+        Close();
+        return false;
+    }
+
+    const char* strings = reinterpret_cast<const char*>(data + header.stringsOffset);
+    mEntries.reserve(header.numEntries);
+    for (uint64_t i = 0; i < header.numEntries; ++i) {
+        EntryRecord record;
+        std::memcpy(&record, data + header.entriesOffset + i * sizeof(EntryRecord), sizeof(EntryRecord));
+        if (record.offset > size || record.size > size - record.offset
+            || record.nameOffset > header.stringsSize || record.nameLength > header.stringsSize - record.nameOffset) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid content pack entry %llu in %s", static_cast<unsigned long long>(i), path.c_str());
+            Close();
+            return false;
+        }
+        mEntries[std::string(strings + record.nameOffset, record.nameLength)] = { record.offset, record.size };
+    }
+    mRootDir = std::filesystem::path(rootDir).lexically_normal().string();
+    mStamp = header.stamp;
+    return true;
+}
+
+void ContentPack::Close() {
+    mFile.Close();
+    mEntries.clear();
+    mRootDir.clear();
+    mStamp = 0;
+}
+
+std::string ContentPack::GetName(const std::string& path) const {
+    const std::string name = std::filesystem::path(path).lexically_normal().lexically_relative(mRootDir).generic_string();
+    if (name.empty() || name.starts_with("..")) {
+        return {};
+    }
+    return name;
+}
+
+const uint8_t* ContentPack::Find(const std::string& path, size_t& outSize) const {
+    if (mEntries.empty()) {
+        return nullptr;
+    }
+    auto it = mEntries.find(GetName(path));
+    if (it == mEntries.end()) {
+        return nullptr;
+    }
+    outSize = it->second.size;
+    return mFile.GetData() + it->second.offset;
+}
+
+bool ContentPack::Contains(const std::string& path) const {
+    return !mEntries.empty() && mEntries.contains(GetName(path));
+}
+
+bool ContentPack::Write(const std::string& path, const std::string& rootDir, const std::vector<std::string>& files, const uint64_t stamp) {
+    // Everything is mapped first, the directory needs the sizes
+    std::vector<MappedFile> mappedFiles(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!mappedFiles[i].Open((std::filesystem::path(rootDir) / files[i]).string())) {
+            return false;
+        }
+    }
+
+    Header header{ .stamp = stamp, .numEntries = files.size(), .entriesOffset = sizeof(Header) };
+    std::vector<EntryRecord> records(files.size());
+    std::vector<char> strings;
+    for (size_t i = 0; i < files.size(); ++i) {
+        records[i].nameOffset = static_cast<uint32_t>(strings.size());
+        records[i].nameLength = static_cast<uint32_t>(files[i].size());
+        strings.insert(strings.end(), files[i].begin(), files[i].end());
+    }
+    header.stringsOffset = header.entriesOffset + records.size() * sizeof(EntryRecord);
+    header.stringsSize = strings.size();
+    uint64_t offset = AlignUp(header.stringsOffset + header.stringsSize);
+    for (size_t i = 0; i < files.size(); ++i) {
+        records[i].offset = offset;
+        records[i].size = mappedFiles[i].GetSize();
+        offset = AlignUp(offset + records[i].size);
+    }
+
+    // Streamed out rather than assembled in memory, and moved into place like cooked files
+    const std::string tempPath = path + ".tmp";
+    SDL_IOStream* stream = SDL_IOFromFile(tempPath.c_str(), "wb");
+    if (!stream) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write content pack %s: %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+    uint64_t position = 0;
+    auto write = [&](const void* data, const uint64_t size) {
+        position += size;
+        return size == 0 || SDL_WriteIO(stream, data, size) == size;
+    };
+    auto padTo = [&](const uint64_t target) {
+        static constexpr uint8_t s_Padding[s_BlobAlignment] = {};
+        return write(s_Padding, target - position);
+    };
+    bool bWritten = write(&header, sizeof(Header))
+        && write(records.data(), records.size() * sizeof(EntryRecord))
+        && write(strings.data(), strings.size());
+    for (size_t i = 0; i < files.size() && bWritten; ++i) {
+        bWritten = padTo(records[i].offset) && write(mappedFiles[i].GetData(), records[i].size);
+    }
+    bWritten = SDL_CloseIO(stream) && bWritten;
+
+    std::error_code error;
+    if (bWritten) {
+        std::filesystem::rename(tempPath, path, error);
+    }
+    if (!bWritten || error) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write content pack %s: %s", path.c_str(), bWritten ? error.message().c_str() : SDL_GetError());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
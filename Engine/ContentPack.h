@@ -0,0 +1,56 @@
+#pragma once
+
+#include <MappedFile.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Many files of a Content directory in one archive, memory mapped once so a cold start reads it
+// sequentially instead of opening every asset on its own.
+//  - A directory of entries, by path relative to the Content directory, then each file's bytes
+//    as they are on disk. Blobs start 16 byte aligned, like MeshFile sections, so a file read
+//    from the pack is laid out the way it would be if it was mapped by itself.
+//  - Find takes the path a loose file would be loaded from and returns its bytes in the mapping,
+//    valid until Close. Loaders try the pack first and fall back to the loose file.
+//  - Write builds a pack from files under a directory, which is how SandCastleCook packs Content.
+// Every reader shares the mapping, Find is safe to call from any thread once Open returns.
+class ContentPack {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char* EXTENSION = ".scpack";
+
+    // rootDir is the directory the pack stands in for, Find looks paths up relative to it
+    bool Open(const std::string& path, const std::string& rootDir);
+    void Close();
+    bool IsOpen() const { return mFile.IsOpen(); }
+    // Starts reading the whole pack in, for callers about to load most of it
+    void Prefetch() const { mFile.Prefetch(); }
+
+    // The bytes of the file at path, null if it isn't in the pack
+    const uint8_t* Find(const std::string& path, size_t& outSize) const;
+    bool Contains(const std::string& path) const;
+
+    size_t GetNumFiles() const { return mEntries.size(); }
+    size_t GetSize() const { return mFile.GetSize(); }
+    // What the pack was written from, see Write
+    uint64_t GetStamp() const { return mStamp; }
+
+    // Packs files (relative to rootDir) into path. stamp identifies the inputs, e.g. a hash of
+    // their sizes and modification times, so a writer can tell an existing pack is current.
+    static bool Write(const std::string& path, const std::string& rootDir, const std::vector<std::string>& files, const uint64_t stamp);
+
+private:
+    struct Entry {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    // Relative generic path ("Models/Sponza/glTF/Sponza.scmesh"), empty if path is outside the root
+    std::string GetName(const std::string& path) const;
+
+    MappedFile mFile;
+    std::string mRootDir;
+    uint64_t mStamp = 0;
+    std::unordered_map<std::string, Entry> mEntries;
+};
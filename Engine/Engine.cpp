@@ -21,6 +21,15 @@ bool Engine::Init() {
 
     mUIManager.Init(mRenderer.GetWindow(), mRenderer.GetDevice());
     mUIManager.SetDebugLightsToggle(mRenderer.GetDebugLightsToggle());
+    mUIManager.SetDepthPrepassToggle(mRenderer.GetDepthPrepassToggle());
+    mUIManager.SetMeshLodsToggle(mRenderer.GetMeshLodsToggle());
+    mUIManager.SetMeshletCullingToggle(mRenderer.GetMeshletCullingToggle());
+    mUIManager.SetPassStats(mRenderer.GetPassStats());
+    mUIManager.SetTextureMemoryStats(mRenderer.GetTextureMemoryStats());
+    mUIManager.SetTextureCacheStats(mRenderer.GetTextureCacheStats());
+    mUIManager.SetStagingStats(mRenderer.GetStagingStats());
+    mUIManager.SetTextureStreamingStats(mRenderer.GetTextureStreamingStats());
+    mUIManager.SetMeshRegistryStats(mRenderer.GetMeshRegistryStats());
     
     mSystems.resize(ISystem::SystemPriority::count);
     AddSystem<MoveSystem>();
@@ -43,7 +52,7 @@ bool Engine::Init() {
     }
     {
         auto entity = CreateEntity("Sponza");
-        entity->AddComponent<DisplayComponent>(mRenderer.GetMeshData("Sponza"));
+        entity->AddComponent<DisplayComponent>(&mRenderer, "Sponza");
         entity->AddComponent<TransformComponent>(
             glm::vec3(0.0f, 0.0f, 0.0f), 
             glm::vec3(0.0f, 0.0f, 0.0f), 
@@ -53,7 +62,7 @@ bool Engine::Init() {
     }
     {
         auto entity = CreateEntity("Space Helmet");
-        entity->AddComponent<DisplayComponent>(mRenderer.GetMeshData("DamagedHelmet"));
+        entity->AddComponent<DisplayComponent>(&mRenderer, "DamagedHelmet");
         entity->AddComponent<TransformComponent>(
             glm::vec3(3.0f, 2.0f, 0.0f), 
             glm::vec3(0.0f, 0.0f, 0.0f), 
@@ -64,7 +73,7 @@ bool Engine::Init() {
     }
     {
         auto entity = CreateEntity("Sci Fi Helmet");
-        entity->AddComponent<DisplayComponent>(mRenderer.GetMeshData("SciFiHelmet"));
+        entity->AddComponent<DisplayComponent>(&mRenderer, "SciFiHelmet");
         entity->AddComponent<TransformComponent>(
             glm::vec3(-3.0f, 2.0f, 0.0f), 
             glm::vec3(0.0f, 135.0f, 0.0f), 
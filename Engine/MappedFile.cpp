@@ -0,0 +1,133 @@
+#include "MappedFile.h"
+
+#include <SDL3/SDL.h>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    Close();
+    mData = std::exchange(other.mData, nullptr);
+    mSize = std::exchange(other.mSize, 0);
+    mIsEmpty = std::exchange(other.mIsEmpty, false);
+#ifdef _WIN32
+    mFileHandle = std::exchange(other.mFileHandle, nullptr);
+    mMappingHandle = std::exchange(other.mMappingHandle, nullptr);
+#endif
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't open file: %s", path.c_str());
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't read file size: %s", path.c_str());
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        mIsEmpty = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't map file: %s", path.c_str());
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mFileHandle = file;
+    mMappingHandle = mapping;
+    mData = static_cast<const uint8_t*>(view);
+    mSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData) UnmapViewOfFile(mData);
+    if (mMappingHandle) CloseHandle(mMappingHandle);
+    if (mFileHandle) CloseHandle(mFileHandle);
+    mData = nullptr;
+    mMappingHandle = nullptr;
+    mFileHandle = nullptr;
+    mSize = 0;
+    mIsEmpty = false;
+}
+
+void MappedFile::Prefetch() const {
+    if (!mData) return;
+    WIN32_MEMORY_RANGE_ENTRY range{ const_cast<uint8_t*>(mData), mSize };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't open file: %s", path.c_str());
+        return false;
+    }
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't read file size: %s", path.c_str());
+        close(fd);
+        return false;
+    }
+    if (fileStat.st_size == 0) {
+        close(fd);
+        mIsEmpty = true;
+        return true;
+    }
+
+    // The mapping keeps its own reference to the file, the descriptor isn't needed afterwards
+    void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't map file: %s", path.c_str());
+        return false;
+    }
+    mData = static_cast<const uint8_t*>(view);
+    mSize = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData) munmap(const_cast<uint8_t*>(mData), mSize);
+    mData = nullptr;
+    mSize = 0;
+    mIsEmpty = false;
+}
+
+void MappedFile::Prefetch() const {
+    if (!mData) return;
+    madvise(const_cast<uint8_t*>(mData), mSize, MADV_WILLNEED);
+}
+#endif
@@ -0,0 +1,339 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <SDL3/SDL.h>
+
+// Pooled textures not used for this many frames are released (e.g. after a resize)
+static constexpr uint32_t s_MaxUnusedFrames = 3;
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::WriteColor(ResourceHandle handle, std::optional<SDL_FColor> clearColor) {
+    Attachment attachment{};
+    attachment.resource = handle;
+    attachment.clearColor = clearColor;
+    mGraph.mPasses[mPassIndex].colorWrites.push_back(attachment);
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::WriteDepth(ResourceHandle handle, std::optional<float> clearDepth) {
+    Attachment& attachment = mGraph.mPasses[mPassIndex].depthWrite;
+    SDL_assert(attachment.resource == InvalidResource);
+    attachment.resource = handle;
+    attachment.clearDepth = clearDepth;
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::Read(ResourceHandle handle) {
+    mGraph.mPasses[mPassIndex].reads.push_back(handle);
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::SetSideEffect() {
+    mGraph.mPasses[mPassIndex].bSideEffect = true;
+    return *this;
+}
+
+void FrameGraph::Release(SDL_GPUDevice* device) {
+    for (PooledTexture& pooled : mPool) {
+        SDL_ReleaseGPUTexture(device, pooled.texture);
+    }
+    mPool.clear();
+    Reset();
+}
+
+void FrameGraph::Reset() {
+    mPasses.clear();
+    mResources.clear();
+    mOrder.clear();
+    mGroups.clear();
+    mCompiled = false;
+}
+
+FrameGraph::ResourceHandle FrameGraph::ImportTexture(const std::string& name, SDL_GPUTexture* texture, const TextureDesc& desc) {
+    Resource resource{};
+    resource.name = name;
+    resource.desc = desc;
+    resource.texture = texture;
+    resource.bImported = true;
+    mResources.push_back(resource);
+    return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+FrameGraph::ResourceHandle FrameGraph::CreateTexture(const std::string& name, const TextureDesc& desc) {
+    Resource resource{};
+    resource.name = name;
+    resource.desc = desc;
+    mResources.push_back(resource);
+    return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+FrameGraph::PassBuilder FrameGraph::AddPass(const std::string& name, ExecuteFn execute) {
+    Pass pass{};
+    pass.name = name;
+    pass.execute = std::move(execute);
+    mPasses.push_back(std::move(pass));
+    return PassBuilder(*this, static_cast<uint32_t>(mPasses.size() - 1));
+}
+
+SDL_GPUTexture* FrameGraph::GetTexture(ResourceHandle handle) const {
+    if (handle >= mResources.size()) return nullptr;
+    return mResources[handle].texture;
+}
+
+bool FrameGraph::HasAttachments(const Pass& pass) const {
+    return !pass.colorWrites.empty() || pass.depthWrite.resource != InvalidResource;
+}
+
+bool FrameGraph::CanMerge(const Pass& groupPass, const Pass& pass) const {
+    if (!HasAttachments(groupPass) || !HasAttachments(pass)) return false;
+    if (groupPass.depthWrite.resource != pass.depthWrite.resource) return false;
+    if (groupPass.colorWrites.size() != pass.colorWrites.size()) return false;
+    for (size_t i = 0; i < pass.colorWrites.size(); ++i) {
+        if (groupPass.colorWrites[i].resource != pass.colorWrites[i].resource) return false;
+    }
+    // Sampling one of the group's own attachments needs the pass to be split
+    for (ResourceHandle read : pass.reads) {
+        if (read == groupPass.depthWrite.resource) return false;
+        for (const Attachment& color : groupPass.colorWrites) {
+            if (read == color.resource) return false;
+        }
+    }
+    return true;
+}
+
+void FrameGraph::Compile() {
+    // Reference counts: a pass is referenced by every resource it writes,
+    // a resource by every pass that reads it. Imported resources are consumed outside the graph.
+    for (uint32_t passIndex = 0; passIndex < mPasses.size(); ++passIndex) {
+        Pass& pass = mPasses[passIndex];
+        auto addProducer = [&](ResourceHandle handle) {
+            mResources[handle].producers.push_back(passIndex);
+            ++pass.refCount;
+        };
+        for (const Attachment& color : pass.colorWrites) addProducer(color.resource);
+        if (pass.depthWrite.resource != InvalidResource) addProducer(pass.depthWrite.resource);
+        for (ResourceHandle read : pass.reads) ++mResources[read].refCount;
+    }
+    for (Resource& resource : mResources) {
+        if (resource.bImported) ++resource.refCount;
+    }
+
+    // Cull: walk back from unreferenced resources, removing passes nobody depends on
+    std::vector<ResourceHandle> unreferenced;
+    for (ResourceHandle handle = 0; handle < mResources.size(); ++handle) {
+        if (mResources[handle].refCount == 0) unreferenced.push_back(handle);
+    }
+    while (!unreferenced.empty()) {
+        const ResourceHandle handle = unreferenced.back();
+        unreferenced.pop_back();
+        for (uint32_t producerIndex : mResources[handle].producers) {
+            Pass& producer = mPasses[producerIndex];
+            if (producer.bSideEffect || producer.refCount == 0) continue;
+            if (--producer.refCount > 0) continue;
+            for (ResourceHandle read : producer.reads) {
+                if (--mResources[read].refCount == 0) unreferenced.push_back(read);
+            }
+        }
+    }
+    for (Pass& pass : mPasses) {
+        pass.bCulled = !pass.bSideEffect && pass.refCount == 0;
+    }
+
+    // Execution order and resource lifetimes
+    for (uint32_t passIndex = 0; passIndex < mPasses.size(); ++passIndex) {
+        const Pass& pass = mPasses[passIndex];
+        if (pass.bCulled) continue;
+
+        const uint32_t position = static_cast<uint32_t>(mOrder.size());
+        mOrder.push_back(passIndex);
+        auto touch = [&](ResourceHandle handle) {
+            Resource& resource = mResources[handle];
+            resource.firstUse = std::min(resource.firstUse, position);
+            resource.lastUse = std::max(resource.lastUse, position);
+        };
+        for (const Attachment& color : pass.colorWrites) touch(color.resource);
+        if (pass.depthWrite.resource != InvalidResource) touch(pass.depthWrite.resource);
+        for (ResourceHandle read : pass.reads) touch(read);
+    }
+
+    // Merge consecutive passes rendering to the same attachments
+    for (uint32_t position = 0; position < mOrder.size(); ++position) {
+        if (!mGroups.empty()) {
+            PassGroup& group = mGroups.back();
+            if (CanMerge(mPasses[mOrder[group.first]], mPasses[mOrder[position]])) {
+                group.last = position;
+                continue;
+            }
+        }
+        mGroups.push_back({position, position});
+    }
+
+    mCompiled = true;
+}
+
+SDL_GPURenderPass* FrameGraph::BeginGroup(const PassGroup& group, SDL_GPUCommandBuffer* commandBuffer, RenderPassStats& outStats) {
+    const Pass& firstPass = mPasses[mOrder[group.first]];
+
+    // Contents are needed on entry if an earlier pass touched the attachment (or it's imported and not cleared),
+    // and needed on exit if a later pass touches it or it's imported.
+    auto getLoadOp = [&](const Attachment& attachment, bool bHasClear) {
+        const Resource& resource = mResources[attachment.resource];
+        if (resource.firstUse < group.first) return SDL_GPU_LOADOP_LOAD;
+        if (bHasClear) return SDL_GPU_LOADOP_CLEAR;
+        return resource.bImported ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_DONT_CARE;
+    };
+    auto getStoreOp = [&](const Attachment& attachment) {
+        const Resource& resource = mResources[attachment.resource];
+        return (resource.bImported || resource.lastUse > group.last) ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE;
+    };
+    auto countOps = [&](SDL_GPULoadOp loadOp, SDL_GPUStoreOp storeOp) {
+        if (loadOp == SDL_GPU_LOADOP_LOAD) ++outStats.numAttachmentLoads;
+        if (loadOp == SDL_GPU_LOADOP_CLEAR) ++outStats.numAttachmentClears;
+        if (storeOp != SDL_GPU_STOREOP_DONT_CARE) ++outStats.numAttachmentStores;
+    };
+
+    std::vector<SDL_GPUColorTargetInfo> colorTargets;
+    for (const Attachment& color : firstPass.colorWrites) {
+        SDL_GPUColorTargetInfo colorTarget{};
+        colorTarget.texture = mResources[color.resource].texture;
+        colorTarget.load_op = getLoadOp(color, color.clearColor.has_value());
+        colorTarget.store_op = getStoreOp(color);
+        colorTarget.clear_color = color.clearColor.value_or(SDL_FColor{0.0f, 0.0f, 0.0f, 0.0f});
+        countOps(colorTarget.load_op, colorTarget.store_op);
+        colorTargets.push_back(colorTarget);
+    }
+
+    SDL_GPUDepthStencilTargetInfo depthStencilTarget{};
+    const bool bHasDepth = firstPass.depthWrite.resource != InvalidResource;
+    if (bHasDepth) {
+        const Attachment& depth = firstPass.depthWrite;
+        depthStencilTarget.texture = mResources[depth.resource].texture;
+        depthStencilTarget.load_op = getLoadOp(depth, depth.clearDepth.has_value());
+        depthStencilTarget.store_op = getStoreOp(depth);
+        depthStencilTarget.clear_depth = depth.clearDepth.value_or(1.0f);
+        // Stencil is not used by any pass yet
+        depthStencilTarget.stencil_load_op = (depthStencilTarget.load_op == SDL_GPU_LOADOP_LOAD) ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_DONT_CARE;
+        depthStencilTarget.stencil_store_op = depthStencilTarget.store_op;
+        depthStencilTarget.clear_stencil = 0;
+        countOps(depthStencilTarget.load_op, depthStencilTarget.store_op);
+    }
+
+    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(
+        commandBuffer,
+        colorTargets.data(),
+        static_cast<Uint32>(colorTargets.size()),
+        bHasDepth ? &depthStencilTarget : nullptr);
+    if (!renderPass) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_BeginGPURenderPass (%s) failed: %s", firstPass.name.c_str(), SDL_GetError());
+        return nullptr;
+    }
+    ++outStats.numRenderPasses;
+    return renderPass;
+}
+
+void FrameGraph::Execute(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer, RenderPassStats& outStats) {
+    if (!mCompiled) Compile();
+
+    for (const Pass& pass : mPasses) {
+        if (pass.bCulled) ++outStats.numPassesCulled;
+    }
+    for (const Resource& resource : mResources) {
+        if (!resource.bImported && resource.firstUse != UINT32_MAX) ++outStats.numTransientTextures;
+    }
+
+    for (const PassGroup& group : mGroups) {
+        // Transients get a pooled texture for exactly the span of passes that use them
+        for (Resource& resource : mResources) {
+            if (!resource.bImported && resource.firstUse >= group.first && resource.firstUse <= group.last) {
+                resource.texture = AcquirePooledTexture(device, resource.desc, resource.name);
+            }
+        }
+
+        PassContext passContext{};
+        passContext.commandBuffer = commandBuffer;
+        passContext.graph = this;
+
+        const bool bRenderPass = HasAttachments(mPasses[mOrder[group.first]]);
+        if (bRenderPass) {
+            passContext.renderPass = BeginGroup(group, commandBuffer, outStats);
+        }
+        if (!bRenderPass || passContext.renderPass) {
+            for (uint32_t position = group.first; position <= group.last; ++position) {
+                const Pass& pass = mPasses[mOrder[position]];
+                if (pass.execute) pass.execute(passContext);
+            }
+        }
+        if (passContext.renderPass) {
+            SDL_EndGPURenderPass(passContext.renderPass);
+        }
+
+        for (Resource& resource : mResources) {
+            if (!resource.bImported && resource.texture && resource.lastUse >= group.first && resource.lastUse <= group.last) {
+                // The pool hands it to the next transient, GetTexture must not return it for this one
+                ReleasePooledTexture(resource.texture);
+                resource.texture = nullptr;
+            }
+        }
+    }
+
+    TrimPool(device);
+    outStats.numPooledTextures = static_cast<uint32_t>(mPool.size());
+    outStats.pooledTextureBytes = 0;
+    for (const PooledTexture& pooled : mPool) {
+        outStats.pooledTextureBytes += SDL_CalculateGPUTextureFormatSize(pooled.desc.format, pooled.desc.width, pooled.desc.height, 1);
+    }
+}
+
+SDL_GPUTexture* FrameGraph::AcquirePooledTexture(SDL_GPUDevice* device, const TextureDesc& desc, const std::string& name) {
+    for (PooledTexture& pooled : mPool) {
+        if (!pooled.bInUse && pooled.desc == desc) {
+            pooled.bInUse = true;
+            pooled.framesUnused = 0;
+            return pooled.texture;
+        }
+    }
+
+    SDL_GPUTextureCreateInfo textureCreateInfo{
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = desc.format,
+        .usage = desc.usage,
+        .width = desc.width,
+        .height = desc.height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+    };
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &textureCreateInfo);
+    if (!texture) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create transient texture '%s': %s", name.c_str(), SDL_GetError());
+        return nullptr;
+    }
+    SDL_SetGPUTextureName(device, texture, name.c_str());
+
+    PooledTexture pooled{};
+    pooled.desc = desc;
+    pooled.texture = texture;
+    pooled.bInUse = true;
+    mPool.push_back(pooled);
+    return texture;
+}
+
+void FrameGraph::ReleasePooledTexture(SDL_GPUTexture* texture) {
+    for (PooledTexture& pooled : mPool) {
+        if (pooled.texture == texture) {
+            pooled.bInUse = false;
+            return;
+        }
+    }
+}
+
+void FrameGraph::TrimPool(SDL_GPUDevice* device) {
+    for (PooledTexture& pooled : mPool) {
+        SDL_assert(!pooled.bInUse);
+        if (++pooled.framesUnused > s_MaxUnusedFrames) {
+            // SDL defers the destruction until the GPU is done with the texture
+            SDL_ReleaseGPUTexture(device, pooled.texture);
+            pooled.texture = nullptr;
+        }
+    }
+    std::erase_if(mPool, [](const PooledTexture& pooled) { return pooled.texture == nullptr; });
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <Render/RenderStructs.h>
+#include <SDL3/SDL_gpu.h>
+#include <string>
+#include <vector>
+
+// Per-frame render graph.
+// Passes declare the attachments they write and the textures they sample, then the graph
+//  - culls passes whose results are never consumed,
+//  - merges consecutive passes with the same attachments into one SDL render pass,
+//  - derives load/store ops from the first and last use of every attachment,
+//  - backs transient textures with pooled GPU textures, reusing the same texture for
+//    transients whose lifetimes don't overlap.
+// The graph is rebuilt every frame: Reset, declare resources and passes, Compile, Execute.
+class FrameGraph {
+public:
+    using ResourceHandle = uint32_t;
+    static constexpr ResourceHandle InvalidResource = UINT32_MAX;
+
+    struct TextureDesc {
+        Uint32 width = 0;
+        Uint32 height = 0;
+        SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        SDL_GPUTextureUsageFlags usage = 0;
+
+        bool operator==(const TextureDesc& other) const = default;
+    };
+
+    // Handed to pass callbacks. renderPass is null for passes without attachments (copy work).
+    struct PassContext {
+        SDL_GPUCommandBuffer* commandBuffer = nullptr;
+        SDL_GPURenderPass* renderPass = nullptr;
+        const FrameGraph* graph = nullptr;
+
+        SDL_GPUTexture* GetTexture(ResourceHandle handle) const { return graph->GetTexture(handle); }
+    };
+    using ExecuteFn = std::function<void(const PassContext&)>;
+
+    class PassBuilder {
+    public:
+        // The clear value is only used when this pass is the first to write the attachment this frame
+        PassBuilder& WriteColor(ResourceHandle handle, std::optional<SDL_FColor> clearColor = std::nullopt);
+        PassBuilder& WriteDepth(ResourceHandle handle, std::optional<float> clearDepth = std::nullopt);
+        PassBuilder& Read(ResourceHandle handle);
+        // Never culled, for passes whose effects are outside the graph (uploads, readbacks)
+        PassBuilder& SetSideEffect();
+
+    private:
+        friend class FrameGraph;
+        PassBuilder(FrameGraph& graph, uint32_t passIndex) : mGraph(graph), mPassIndex(passIndex) {}
+        FrameGraph& mGraph;
+        uint32_t mPassIndex;
+    };
+
+    FrameGraph() = default;
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    void Release(SDL_GPUDevice* device);
+
+    void Reset();
+    // Imported textures live outside the graph, their contents are always kept
+    ResourceHandle ImportTexture(const std::string& name, SDL_GPUTexture* texture, const TextureDesc& desc);
+    ResourceHandle CreateTexture(const std::string& name, const TextureDesc& desc);
+    PassBuilder AddPass(const std::string& name, ExecuteFn execute);
+
+    void Compile();
+    void Execute(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer, RenderPassStats& outStats);
+
+    SDL_GPUTexture* GetTexture(ResourceHandle handle) const;
+
+private:
+    struct Attachment {
+        ResourceHandle resource = InvalidResource;
+        std::optional<SDL_FColor> clearColor;
+        std::optional<float> clearDepth;
+    };
+
+    struct Pass {
+        std::string name;
+        ExecuteFn execute;
+        std::vector<Attachment> colorWrites;
+        Attachment depthWrite;
+        std::vector<ResourceHandle> reads;
+        bool bSideEffect = false;
+
+        // compiled
+        uint32_t refCount = 0;
+        bool bCulled = false;
+    };
+
+    struct Resource {
+        std::string name;
+        TextureDesc desc;
+        SDL_GPUTexture* texture = nullptr; // imported, or from the pool for the passes that use it
+        bool bImported = false;
+
+        // compiled
+        std::vector<uint32_t> producers;
+        uint32_t refCount = 0;
+        uint32_t firstUse = UINT32_MAX; // positions in mOrder
+        uint32_t lastUse = 0;
+    };
+
+    // A run of consecutive passes sharing the same attachments, recorded as one SDL render pass.
+    // Indices are positions in mOrder.
+    struct PassGroup {
+        uint32_t first = 0;
+        uint32_t last = 0;
+    };
+
+    struct PooledTexture {
+        TextureDesc desc;
+        SDL_GPUTexture* texture = nullptr;
+        bool bInUse = false;
+        uint32_t framesUnused = 0;
+    };
+
+    bool HasAttachments(const Pass& pass) const;
+    bool CanMerge(const Pass& groupPass, const Pass& pass) const;
+    SDL_GPURenderPass* BeginGroup(const PassGroup& group, SDL_GPUCommandBuffer* commandBuffer, RenderPassStats& outStats);
+
+    SDL_GPUTexture* AcquirePooledTexture(SDL_GPUDevice* device, const TextureDesc& desc, const std::string& name);
+    void ReleasePooledTexture(SDL_GPUTexture* texture);
+    void TrimPool(SDL_GPUDevice* device);
+
+    std::vector<Pass> mPasses;
+    std::vector<Resource> mResources;
+    std::vector<uint32_t> mOrder; // non-culled passes in declaration order
+    std::vector<PassGroup> mGroups;
+    std::vector<PooledTexture> mPool;
+    bool mCompiled = false;
+};
@@ -0,0 +1,316 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <bit>
+#include <SDL3/SDL.h>
+
+// Rounds size up to the smallest size class whose every block fits it
+static uint32_t RoundUpToBin(const uint32_t size, const uint32_t secondLevelLog2) {
+    if (size < (1u << secondLevelLog2)) {
+        return size;
+    }
+    const uint32_t log2 = static_cast<uint32_t>(std::bit_width(size)) - 1;
+    const uint64_t rounded = static_cast<uint64_t>(size) + (1ull << (log2 - secondLevelLog2)) - 1;
+    return static_cast<uint32_t>(std::min<uint64_t>(rounded, UINT32_MAX));
+}
+
+bool GeometryArena::Init(SDL_GPUDevice* device, const SDL_GPUBufferUsageFlags usage, const char* name, const uint32_t granularity, const uint32_t initialSize) {
+    mDevice = device;
+    mUsage = usage;
+    mName = name;
+    mGranularity = granularity;
+    mFreeLists.fill(NO_BLOCK);
+    const uint32_t capacity = std::max((initialSize + granularity - 1) / granularity, 1u);
+    if (!Reallocate(capacity, {})) {
+        return false;
+    }
+    mLastBlock = NewBlock(0, capacity);
+    InsertFree(mLastBlock);
+    return true;
+}
+
+void GeometryArena::Release() {
+    if (!mDevice) return;
+    if (mBuffer) SDL_ReleaseGPUBuffer(mDevice, mBuffer);
+    mBuffer = nullptr;
+    mCapacity = 0;
+    mLastBlock = NO_BLOCK;
+    mBlocks.clear();
+    mUnusedBlocks.clear();
+    mFirstLevelBitmap = 0;
+    mSecondLevelBitmaps.fill(0);
+    mFreeLists.fill(NO_BLOCK);
+    mStats = {};
+    mDevice = nullptr;
+}
+
+GeometryRange GeometryArena::Allocate(const uint32_t size) {
+    const uint32_t numGranules = std::max((size + mGranularity - 1) / mGranularity, 1u);
+    uint32_t index = FindFree(numGranules);
+    if (index == NO_BLOCK) {
+        if (!Grow(numGranules) || (index = FindFree(numGranules)) == NO_BLOCK) {
+            return {};
+        }
+    }
+    RemoveFree(index);
+
+    // The rest of the block goes back as a free block of its own
+    if (mBlocks[index].size > numGranules) {
+        const uint32_t rest = NewBlock(mBlocks[index].offset + numGranules, mBlocks[index].size - numGranules);
+        const uint32_t next = mBlocks[index].nextPhysical;
+        mBlocks[rest].prevPhysical = index;
+        mBlocks[rest].nextPhysical = next;
+        if (next != NO_BLOCK) mBlocks[next].prevPhysical = rest;
+        else mLastBlock = rest;
+        mBlocks[index].nextPhysical = rest;
+        mBlocks[index].size = numGranules;
+        InsertFree(rest);
+    }
+
+    mBlocks[index].bFree = false;
+    ++mStats.numRanges;
+    mStats.usedBytes += static_cast<uint64_t>(numGranules) * mGranularity;
+    return GeometryRange{ .id = index, .offset = mBlocks[index].offset * mGranularity, .size = numGranules * mGranularity };
+}
+
+void GeometryArena::Free(GeometryRange& range) {
+    if (!range.IsValid()) return;
+    --mStats.numRanges;
+    mStats.usedBytes -= static_cast<uint64_t>(mBlocks[range.id].size) * mGranularity;
+    MergeFree(range.id);
+    range = {};
+}
+
+bool GeometryArena::IsFragmented() {
+    mStats.largestFreeBlock = 0;
+    if (mFirstLevelBitmap == 0) {
+        return false;
+    }
+    // The largest block is in the highest non-empty bin
+    const uint32_t firstLevel = 31 - static_cast<uint32_t>(std::countl_zero(mFirstLevelBitmap));
+    const uint32_t secondLevel = 31 - static_cast<uint32_t>(std::countl_zero(mSecondLevelBitmaps[firstLevel]));
+    uint32_t largest = 0;
+    for (uint32_t i = mFreeLists[firstLevel * SECOND_LEVEL_COUNT + secondLevel]; i != NO_BLOCK; i = mBlocks[i].nextFree) {
+        largest = std::max(largest, mBlocks[i].size);
+    }
+    mStats.largestFreeBlock = static_cast<uint64_t>(largest) * mGranularity;
+    const uint64_t freeBytes = mStats.capacity - mStats.usedBytes;
+    return mStats.numFreeBlocks > 1 && mStats.largestFreeBlock < freeBytes / 2;
+}
+
+bool GeometryArena::Compact() {
+    std::vector<uint32_t> blocks;
+    for (uint32_t i = mLastBlock; i != NO_BLOCK; i = mBlocks[i].prevPhysical) {
+        blocks.push_back(i);
+    }
+    std::reverse(blocks.begin(), blocks.end());
+
+    // Live ranges keep their order, packed from the start
+    std::vector<Copy> copies;
+    std::vector<uint32_t> liveBlocks;
+    uint32_t offset = 0;
+    bool bMoved = false;
+    for (const uint32_t i : blocks) {
+        if (mBlocks[i].bFree) continue;
+        bMoved |= mBlocks[i].offset != offset;
+        copies.push_back({ mBlocks[i].offset * mGranularity, offset * mGranularity, mBlocks[i].size * mGranularity });
+        liveBlocks.push_back(i);
+        offset += mBlocks[i].size;
+    }
+    if (!bMoved || !Reallocate(mCapacity, copies)) {
+        return false;
+    }
+
+    // Rebuilt around the moved ranges, whose ids stay the same
+    for (const uint32_t i : blocks) {
+        if (mBlocks[i].bFree) {
+            RemoveFree(i);
+            mUnusedBlocks.push_back(i);
+        }
+    }
+    uint32_t previous = NO_BLOCK;
+    offset = 0;
+    for (const uint32_t i : liveBlocks) {
+        mBlocks[i].offset = offset;
+        mBlocks[i].prevPhysical = previous;
+        mBlocks[i].nextPhysical = NO_BLOCK;
+        if (previous != NO_BLOCK) mBlocks[previous].nextPhysical = i;
+        offset += mBlocks[i].size;
+        previous = i;
+    }
+    mLastBlock = previous;
+    if (offset < mCapacity) {
+        const uint32_t rest = NewBlock(offset, mCapacity - offset);
+        mBlocks[rest].prevPhysical = previous;
+        if (previous != NO_BLOCK) mBlocks[previous].nextPhysical = rest;
+        mLastBlock = rest;
+        InsertFree(rest);
+    }
+    ++mStats.numCompactions;
+    return true;
+}
+
+void GeometryArena::GetBin(const uint32_t size, uint32_t& outFirstLevel, uint32_t& outSecondLevel) {
+    // Sizes below SECOND_LEVEL_COUNT get a bin each, above that every power of two is split in
+    // SECOND_LEVEL_COUNT linear steps
+    if (size < SECOND_LEVEL_COUNT) {
+        outFirstLevel = 0;
+        outSecondLevel = size;
+        return;
+    }
+    const uint32_t log2 = static_cast<uint32_t>(std::bit_width(size)) - 1;
+    outFirstLevel = log2 - SECOND_LEVEL_LOG2 + 1;
+    outSecondLevel = (size >> (log2 - SECOND_LEVEL_LOG2)) - SECOND_LEVEL_COUNT;
+}
+
+uint32_t GeometryArena::NewBlock(const uint32_t offset, const uint32_t size) {
+    uint32_t index;
+    if (!mUnusedBlocks.empty()) {
+        index = mUnusedBlocks.back();
+        mUnusedBlocks.pop_back();
+    }
+    else {
+        index = static_cast<uint32_t>(mBlocks.size());
+        mBlocks.emplace_back();
+    }
+    mBlocks[index] = Block{ .offset = offset, .size = size };
+    return index;
+}
+
+void GeometryArena::InsertFree(const uint32_t index) {
+    uint32_t firstLevel, secondLevel;
+    GetBin(mBlocks[index].size, firstLevel, secondLevel);
+    uint32_t& head = mFreeLists[firstLevel * SECOND_LEVEL_COUNT + secondLevel];
+    mBlocks[index].bFree = true;
+    mBlocks[index].prevFree = NO_BLOCK;
+    mBlocks[index].nextFree = head;
+    if (head != NO_BLOCK) mBlocks[head].prevFree = index;
+    head = index;
+    mFirstLevelBitmap |= 1u << firstLevel;
+    mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    ++mStats.numFreeBlocks;
+}
+
+void GeometryArena::RemoveFree(const uint32_t index) {
+    uint32_t firstLevel, secondLevel;
+    GetBin(mBlocks[index].size, firstLevel, secondLevel);
+    Block& block = mBlocks[index];
+    if (block.prevFree != NO_BLOCK) mBlocks[block.prevFree].nextFree = block.nextFree;
+    else mFreeLists[firstLevel * SECOND_LEVEL_COUNT + secondLevel] = block.nextFree;
+    if (block.nextFree != NO_BLOCK) mBlocks[block.nextFree].prevFree = block.prevFree;
+    if (mFreeLists[firstLevel * SECOND_LEVEL_COUNT + secondLevel] == NO_BLOCK) {
+        mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (mSecondLevelBitmaps[firstLevel] == 0) mFirstLevelBitmap &= ~(1u << firstLevel);
+    }
+    block.prevFree = block.nextFree = NO_BLOCK;
+    block.bFree = false;
+    --mStats.numFreeBlocks;
+}
+
+uint32_t GeometryArena::FindFree(const uint32_t size) const {
+    uint32_t firstLevel, secondLevel;
+    GetBin(RoundUpToBin(size, SECOND_LEVEL_LOG2), firstLevel, secondLevel);
+    uint32_t secondLevelMap = mSecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0) {
+        // Any block of a larger first level fits
+        const uint32_t firstLevelMap = firstLevel + 1 < 32 ? mFirstLevelBitmap & (~0u << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0) {
+            return NO_BLOCK;
+        }
+        firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+        secondLevelMap = mSecondLevelBitmaps[firstLevel];
+    }
+    secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+    return mFreeLists[firstLevel * SECOND_LEVEL_COUNT + secondLevel];
+}
+
+void GeometryArena::MergeFree(uint32_t index) {
+    const uint32_t previous = mBlocks[index].prevPhysical;
+    if (previous != NO_BLOCK && mBlocks[previous].bFree) {
+        RemoveFree(previous);
+        mBlocks[previous].size += mBlocks[index].size;
+        mBlocks[previous].nextPhysical = mBlocks[index].nextPhysical;
+        if (mBlocks[index].nextPhysical != NO_BLOCK) mBlocks[mBlocks[index].nextPhysical].prevPhysical = previous;
+        else mLastBlock = previous;
+        mUnusedBlocks.push_back(index);
+        index = previous;
+    }
+    const uint32_t next = mBlocks[index].nextPhysical;
+    if (next != NO_BLOCK && mBlocks[next].bFree) {
+        RemoveFree(next);
+        mBlocks[index].size += mBlocks[next].size;
+        mBlocks[index].nextPhysical = mBlocks[next].nextPhysical;
+        if (mBlocks[next].nextPhysical != NO_BLOCK) mBlocks[mBlocks[next].nextPhysical].prevPhysical = index;
+        else mLastBlock = index;
+        mUnusedBlocks.push_back(next);
+    }
+    InsertFree(index);
+}
+
+bool GeometryArena::Grow(const uint32_t minFreeSize) {
+    // At least doubles, and leaves a free block at the end that FindFree takes for minFreeSize
+    const uint64_t added = std::max<uint64_t>(mCapacity, RoundUpToBin(minFreeSize, SECOND_LEVEL_LOG2));
+    const uint64_t capacity = mCapacity + added;
+    if (capacity * mGranularity > UINT32_MAX) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s is full (%u bytes)", mName, mCapacity * mGranularity);
+        return false;
+    }
+    const uint32_t oldCapacity = mCapacity;
+    if (!Reallocate(static_cast<uint32_t>(capacity), { { 0, 0, oldCapacity * mGranularity } })) {
+        return false;
+    }
+
+    if (mLastBlock != NO_BLOCK && mBlocks[mLastBlock].bFree) {
+        RemoveFree(mLastBlock);
+        mBlocks[mLastBlock].size += static_cast<uint32_t>(added);
+        InsertFree(mLastBlock);
+    }
+    else {
+        const uint32_t rest = NewBlock(oldCapacity, static_cast<uint32_t>(added));
+        mBlocks[rest].prevPhysical = mLastBlock;
+        if (mLastBlock != NO_BLOCK) mBlocks[mLastBlock].nextPhysical = rest;
+        mLastBlock = rest;
+        InsertFree(rest);
+    }
+    ++mStats.numGrows;
+    SDL_Log("%s grew to %.1f MB", mName, static_cast<double>(mStats.capacity) / (1024.0 * 1024.0));
+    return true;
+}
+
+bool GeometryArena::Reallocate(const uint32_t capacity, const std::vector<Copy>& copies) {
+    SDL_GPUBufferCreateInfo createInfo{
+        .usage = mUsage,
+        .size = capacity * mGranularity,
+    };
+    SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer(mDevice, &createInfo);
+    if (!buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create %s: %s", mName, SDL_GetError());
+        return false;
+    }
+    SDL_SetGPUBufferName(mDevice, buffer, mName);
+
+    // Submitted right away: uploads submitted before this are carried over, the ones recorded
+    // after it go to the new buffer
+    if (!copies.empty()) {
+        SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(mDevice);
+        if (!commandBuffer) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to acquire a command buffer to move %s: %s", mName, SDL_GetError());
+            SDL_ReleaseGPUBuffer(mDevice, buffer);
+            return false;
+        }
+        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+        for (const Copy& copy : copies) {
+            const SDL_GPUBufferLocation source{ mBuffer, copy.source };
+            const SDL_GPUBufferLocation destination{ buffer, copy.destination };
+            SDL_CopyGPUBufferToBuffer(copyPass, &source, &destination, copy.size, false);
+        }
+        SDL_EndGPUCopyPass(copyPass);
+        SDL_SubmitGPUCommandBuffer(commandBuffer);
+    }
+    // Freed once the copies out of it have executed
+    if (mBuffer) SDL_ReleaseGPUBuffer(mDevice, mBuffer);
+    mBuffer = buffer;
+    mCapacity = capacity;
+    mStats.capacity = static_cast<uint64_t>(capacity) * mGranularity;
+    return true;
+}
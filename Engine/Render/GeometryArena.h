@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <SDL3/SDL_gpu.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// One large GPU buffer the geometry of every mesh is sub-allocated from, so a pass binds it once
+// instead of a buffer per mesh.
+//  - Ranges come from a TLSF (two level segregated fit) allocator: free blocks are binned by size
+//    class, so allocating and freeing are constant time and freed blocks merge with free neighbours.
+//  - Ranges are in granules of a fixed size and their offsets a multiple of it. The vertex arena
+//    uses the vertex stride, so an offset is always a whole base vertex.
+//  - When no free block fits, the buffer grows: recreated larger with the old contents copied on
+//    the GPU. Offsets stay the same.
+//  - Compact moves every live range to the front when frees left the buffer fragmented. Offsets
+//    change, owners re-read theirs with GetOffset.
+// Growing and compacting submit their own command buffer, so the buffer returned by GetBuffer
+// must be fetched after the frame's allocations, like MaterialTable's arrays.
+class GeometryArena {
+public:
+    bool Init(SDL_GPUDevice* device, const SDL_GPUBufferUsageFlags usage, const char* name, const uint32_t granularity, const uint32_t initialSize);
+    void Release();
+
+    // size in bytes, rounded up to the granularity. Invalid if the buffer couldn't grow.
+    GeometryRange Allocate(const uint32_t size);
+    void Free(GeometryRange& range);
+    // Current offset of a live range, in bytes
+    uint32_t GetOffset(const GeometryRange& range) const { return mBlocks[range.id].offset * mGranularity; }
+
+    // Whether the free space is split up enough to be worth a copy of the whole buffer
+    bool IsFragmented();
+    // False if nothing moved
+    bool Compact();
+
+    SDL_GPUBuffer* GetBuffer() const { return mBuffer; }
+    const GeometryArenaStats* GetStats() const { return &mStats; }
+
+private:
+    static constexpr uint32_t SECOND_LEVEL_LOG2 = 4;
+    static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_LOG2;
+    static constexpr uint32_t FIRST_LEVEL_COUNT = 32 - SECOND_LEVEL_LOG2 + 1;
+    static constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+    // A range of granules, either handed out or in a free list. Physical links are in offset order.
+    struct Block {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint32_t prevPhysical = NO_BLOCK;
+        uint32_t nextPhysical = NO_BLOCK;
+        uint32_t prevFree = NO_BLOCK;
+        uint32_t nextFree = NO_BLOCK;
+        bool bFree = false;
+    };
+
+    struct Copy {
+        uint32_t source = 0; // bytes
+        uint32_t destination = 0;
+        uint32_t size = 0;
+    };
+
+    static void GetBin(const uint32_t size, uint32_t& outFirstLevel, uint32_t& outSecondLevel);
+    uint32_t NewBlock(const uint32_t offset, const uint32_t size);
+    void InsertFree(const uint32_t index);
+    void RemoveFree(const uint32_t index);
+    uint32_t FindFree(const uint32_t size) const;
+    // Frees block index, merging it with free physical neighbours
+    void MergeFree(uint32_t index);
+    bool Grow(const uint32_t minFreeSize);
+    // Moves the contents into a new buffer of capacity granules
+    bool Reallocate(const uint32_t capacity, const std::vector<Copy>& copies);
+
+    SDL_GPUDevice* mDevice = nullptr;
+    SDL_GPUBuffer* mBuffer = nullptr;
+    SDL_GPUBufferUsageFlags mUsage = 0;
+    const char* mName = "";
+    uint32_t mGranularity = 1; // bytes
+    uint32_t mCapacity = 0;    // granules
+    uint32_t mLastBlock = NO_BLOCK; // physically, the one ending at mCapacity
+
+    std::vector<Block> mBlocks;
+    std::vector<uint32_t> mUnusedBlocks; // slots of mBlocks to reuse
+    uint32_t mFirstLevelBitmap = 0;
+    std::array<uint32_t, FIRST_LEVEL_COUNT> mSecondLevelBitmaps{};
+    std::array<uint32_t, FIRST_LEVEL_COUNT * SECOND_LEVEL_COUNT> mFreeLists;
+    GeometryArenaStats mStats;
+};
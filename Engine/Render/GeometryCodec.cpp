@@ -0,0 +1,444 @@
+#include "GeometryCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define GEOMETRY_CODEC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Vertex stream: per block, per byte column, a 2 bit width per group of 16 values then the
+    // groups themselves
+    constexpr size_t s_GroupSize = 16;
+    constexpr size_t s_MaxBlockVertices = 256;
+    // A decoded block, all its columns, stays in L1
+    constexpr size_t s_MaxBlockBytes = 8192;
+    // Payload bytes of a group for each width: 0, 2, 4 and 8 bits a value
+    constexpr size_t s_GroupBytes[4] = { 0, 4, 8, 16 };
+
+    // Index stream: a code byte per triangle, 2 bits of rotation per triangle, then the data the
+    // codes refer to
+    constexpr uint32_t s_EdgeFifoSize = 16;
+    constexpr uint32_t s_VertexFifoSize = 16;
+    // Code nibbles
+    constexpr uint32_t s_EdgeMiss = 15;      // no recent edge, the triangle is coded vertex by vertex
+    constexpr uint32_t s_VertexNext = 0;     // the next unused index
+    constexpr uint32_t s_VertexExplicit = 15; // a varint delta follows in the data
+    // Kinds 1 to 14 name a vertex FIFO entry, most recent first
+    constexpr uint32_t s_MaxVertexFifoHits = 14;
+
+    size_t GetBlockVertices(const size_t stride) {
+        return std::min(s_MaxBlockVertices, (s_MaxBlockBytes / stride) & ~(s_GroupSize - 1));
+    }
+
+    uint8_t ZigZag(const uint8_t delta) {
+        return static_cast<uint8_t>((delta << 1) ^ (static_cast<int8_t>(delta) >> 7));
+    }
+
+    void WriteGroup(const uint8_t* values, const uint32_t width, std::vector<uint8_t>& out) {
+        switch (width) {
+            case 1:
+                for (size_t i = 0; i < s_GroupSize; i += 4) {
+                    out.push_back(static_cast<uint8_t>(values[i] | (values[i + 1] << 2) | (values[i + 2] << 4) | (values[i + 3] << 6)));
+                }
+                break;
+            case 2:
+                for (size_t i = 0; i < s_GroupSize; i += 2) {
+                    out.push_back(static_cast<uint8_t>(values[i] | (values[i + 1] << 4)));
+                }
+                break;
+            case 3:
+                out.insert(out.end(), values, values + s_GroupSize);
+                break;
+        }
+    }
+
+#if !GEOMETRY_CODEC_SSE2
+    uint8_t UnZigZag(const uint8_t value) {
+        return static_cast<uint8_t>((value >> 1) ^ -(value & 1));
+    }
+#endif
+
+    // Decodes a group of 16 deltas on top of previous into out (16 byte aligned), returns the last value
+    uint8_t DecodeGroup(const uint8_t* data, const uint32_t width, const uint8_t previous, uint8_t* out) {
+#if GEOMETRY_CODEC_SSE2
+        __m128i values;
+        switch (width) {
+            case 0:
+                values = _mm_setzero_si128();
+                break;
+            case 1: {
+                // Every byte repeated 4 times, lane i then takes bits 2 * (i % 4)
+                int32_t packed;
+                std::memcpy(&packed, data, sizeof(packed));
+                __m128i repeated = _mm_cvtsi32_si128(packed);
+                repeated = _mm_unpacklo_epi8(repeated, repeated);
+                repeated = _mm_unpacklo_epi16(repeated, repeated);
+                const __m128i mask = _mm_set1_epi8(3);
+                values = _mm_and_si128(_mm_and_si128(repeated, mask), _mm_set1_epi32(0x000000FF));
+                values = _mm_or_si128(values, _mm_and_si128(_mm_and_si128(_mm_srli_epi16(repeated, 2), mask), _mm_set1_epi32(0x0000FF00)));
+                values = _mm_or_si128(values, _mm_and_si128(_mm_and_si128(_mm_srli_epi16(repeated, 4), mask), _mm_set1_epi32(0x00FF0000)));
+                values = _mm_or_si128(values, _mm_and_si128(_mm_and_si128(_mm_srli_epi16(repeated, 6), mask), _mm_set1_epi32(static_cast<int>(0xFF000000))));
+                break;
+            }
+            case 2: {
+                const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+                const __m128i mask = _mm_set1_epi8(0x0F);
+                values = _mm_unpacklo_epi8(_mm_and_si128(packed, mask), _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+                break;
+            }
+            default:
+                values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                break;
+        }
+        // (z >> 1) ^ -(z & 1), then a prefix sum over the 16 deltas
+        const __m128i odd = _mm_and_si128(values, _mm_set1_epi8(1));
+        __m128i sum = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(values, 1), _mm_set1_epi8(0x7F)), _mm_sub_epi8(_mm_setzero_si128(), odd));
+        sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 1));
+        sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 2));
+        sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+        sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+        sum = _mm_add_epi8(sum, _mm_set1_epi8(static_cast<char>(previous)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), sum);
+        return static_cast<uint8_t>(_mm_extract_epi16(sum, 7) >> 8);
+#else
+        uint8_t value = previous;
+        for (size_t i = 0; i < s_GroupSize; ++i) {
+            uint8_t zigZag = 0;
+            switch (width) {
+                case 1: zigZag = (data[i / 4] >> ((i % 4) * 2)) & 3; break;
+                case 2: zigZag = (data[i / 2] >> ((i % 2) * 4)) & 15; break;
+                case 3: zigZag = data[i]; break;
+            }
+            value = static_cast<uint8_t>(value + UnZigZag(zigZag));
+            out[i] = value;
+        }
+        return value;
+#endif
+    }
+
+    // Columns of blockVertices bytes each back to count vertices of stride bytes
+    void Transpose(const uint8_t* columns, const size_t blockVertices, const size_t count, const size_t stride, uint8_t* out) {
+#if GEOMETRY_CODEC_SSE2
+        if (stride % 4 == 0) {
+            for (size_t column = 0; column < stride; column += 4) {
+                const uint8_t* source = columns + column * blockVertices;
+                for (size_t first = 0; first < count; first += s_GroupSize) {
+                    const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(source + first));
+                    const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(source + blockVertices + first));
+                    const __m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(source + 2 * blockVertices + first));
+                    const __m128i d = _mm_load_si128(reinterpret_cast<const __m128i*>(source + 3 * blockVertices + first));
+                    const __m128i ab0 = _mm_unpacklo_epi8(a, b);
+                    const __m128i ab1 = _mm_unpackhi_epi8(a, b);
+                    const __m128i cd0 = _mm_unpacklo_epi8(c, d);
+                    const __m128i cd1 = _mm_unpackhi_epi8(c, d);
+                    // 4 bytes of each of 16 vertices, 4 vertices a register
+                    __m128i rows[4] = { _mm_unpacklo_epi16(ab0, cd0), _mm_unpackhi_epi16(ab0, cd0), _mm_unpacklo_epi16(ab1, cd1), _mm_unpackhi_epi16(ab1, cd1) };
+                    const size_t numVertices = std::min(s_GroupSize, count - first);
+                    uint8_t* destination = out + first * stride + column;
+                    if (numVertices == s_GroupSize) {
+                        for (size_t row = 0; row < 4; ++row) {
+                            const int32_t bytes[4] = { _mm_cvtsi128_si32(rows[row]), _mm_cvtsi128_si32(_mm_shuffle_epi32(rows[row], 1)),
+                                _mm_cvtsi128_si32(_mm_shuffle_epi32(rows[row], 2)), _mm_cvtsi128_si32(_mm_shuffle_epi32(rows[row], 3)) };
+                            for (size_t i = 0; i < 4; ++i) {
+                                std::memcpy(destination + (row * 4 + i) * stride, &bytes[i], sizeof(int32_t));
+                            }
+                        }
+                        continue;
+                    }
+                    for (size_t i = 0; i < numVertices; ++i) {
+                        const int32_t bytes = _mm_cvtsi128_si32(rows[i / 4]);
+                        rows[i / 4] = _mm_srli_si128(rows[i / 4], 4);
+                        std::memcpy(destination + i * stride, &bytes, sizeof(bytes));
+                    }
+                }
+            }
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t column = 0; column < stride; ++column) {
+                out[i * stride + column] = columns[column * blockVertices + i];
+            }
+        }
+    }
+
+    uint32_t ZigZag32(const int32_t delta) {
+        return (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+    }
+
+    void WriteVarint(uint32_t value, std::vector<uint8_t>& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool ReadVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& outValue) {
+        outValue = 0;
+        for (uint32_t shift = 0; shift < 35 && cursor < end; shift += 7) {
+            const uint8_t byte = *cursor++;
+            outValue |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    struct Edge {
+        uint32_t a = 0;
+        uint32_t b = 0;
+    };
+
+    // What the encoder and decoder track in step, the decoder's view has to match exactly
+    struct IndexState {
+        Edge edges[s_EdgeFifoSize];
+        uint32_t vertices[s_VertexFifoSize] = {};
+        uint32_t numEdges = 0;    // pushed so far, the FIFOs wrap
+        uint32_t numVertices = 0;
+        uint32_t next = 0;        // the lowest index not yet used
+        uint32_t last = 0;        // the last explicit index
+
+        void PushEdge(const uint32_t a, const uint32_t b) {
+            edges[numEdges++ % s_EdgeFifoSize] = { a, b };
+        }
+        void PushVertex(const uint32_t vertex) {
+            vertices[numVertices++ % s_VertexFifoSize] = vertex;
+        }
+        // i = 0 is the most recent
+        const Edge& GetEdge(const uint32_t i) const {
+            return edges[(numEdges - 1 - i) % s_EdgeFifoSize];
+        }
+        uint32_t GetVertex(const uint32_t i) const {
+            return vertices[(numVertices - 1 - i) % s_VertexFifoSize];
+        }
+        uint32_t GetNumEdgeHits() const {
+            return std::min(numEdges, s_EdgeMiss);
+        }
+        uint32_t GetNumVertexHits() const {
+            return std::min(numVertices, s_MaxVertexFifoHits);
+        }
+    };
+
+    // Returns the vertex's code nibble, explicit deltas go to data
+    uint32_t EncodeVertex(IndexState& state, const uint32_t vertex, std::vector<uint8_t>& data) {
+        if (vertex == state.next) {
+            ++state.next;
+            state.PushVertex(vertex);
+            return s_VertexNext;
+        }
+        for (uint32_t i = 0; i < state.GetNumVertexHits(); ++i) {
+            if (state.GetVertex(i) == vertex) return i + 1;
+        }
+        WriteVarint(ZigZag32(static_cast<int32_t>(vertex - state.last)), data);
+        state.last = vertex;
+        state.PushVertex(vertex);
+        return s_VertexExplicit;
+    }
+
+    bool DecodeVertex(IndexState& state, const uint32_t kind, const uint8_t*& data, const uint8_t* end, uint32_t& outVertex) {
+        if (kind == s_VertexNext) {
+            outVertex = state.next++;
+            state.PushVertex(outVertex);
+            return true;
+        }
+        if (kind != s_VertexExplicit) {
+            if (kind > state.GetNumVertexHits()) return false;
+            outVertex = state.GetVertex(kind - 1);
+            return true;
+        }
+        uint32_t zigZag;
+        if (!ReadVarint(data, end, zigZag)) return false;
+        outVertex = state.last + ((zigZag >> 1) ^ (0u - (zigZag & 1)));
+        state.last = outVertex;
+        state.PushVertex(outVertex);
+        return true;
+    }
+}
+
+bool GeometryCodec::EncodeVertices(const void* vertices, const size_t numVertices, const size_t stride, std::vector<uint8_t>& out) {
+    if (stride == 0 || stride > s_MaxVertexStride) {
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+    const size_t blockVertices = GetBlockVertices(stride);
+    uint8_t last[s_MaxVertexStride] = {};
+    uint8_t deltas[s_MaxBlockVertices];
+    for (size_t first = 0; first < numVertices; first += blockVertices) {
+        const size_t count = std::min(blockVertices, numVertices - first);
+        const size_t numGroups = (count + s_GroupSize - 1) / s_GroupSize;
+        for (size_t column = 0; column < stride; ++column) {
+            // Deltas past the last vertex are zero, they decode to copies of it
+            uint8_t previous = last[column];
+            std::fill(deltas + count, deltas + numGroups * s_GroupSize, uint8_t(0));
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t value = bytes[(first + i) * stride + column];
+                deltas[i] = ZigZag(static_cast<uint8_t>(value - previous));
+                previous = value;
+            }
+            last[column] = previous;
+
+            const size_t headerOffset = out.size();
+            out.resize(out.size() + (numGroups + 3) / 4, 0);
+            for (size_t group = 0; group < numGroups; ++group) {
+                const uint8_t* values = deltas + group * s_GroupSize;
+                uint8_t bits = 0;
+                for (size_t i = 0; i < s_GroupSize; ++i) {
+                    bits |= values[i];
+                }
+                const uint32_t width = bits == 0 ? 0 : bits < 4 ? 1 : bits < 16 ? 2 : 3;
+                out[headerOffset + group / 4] |= static_cast<uint8_t>(width << ((group % 4) * 2));
+                WriteGroup(values, width, out);
+            }
+        }
+    }
+    return true;
+}
+
+bool GeometryCodec::DecodeVertices(void* dst, const size_t numVertices, const size_t stride, const uint8_t* src, const size_t srcSize) {
+    if (stride == 0 || stride > s_MaxVertexStride) {
+        return false;
+    }
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    const uint8_t* cursor = src;
+    const uint8_t* end = src + srcSize;
+    const size_t blockVertices = GetBlockVertices(stride);
+    alignas(16) uint8_t columns[s_MaxBlockBytes];
+    uint8_t last[s_MaxVertexStride] = {};
+    for (size_t first = 0; first < numVertices; first += blockVertices) {
+        const size_t count = std::min(blockVertices, numVertices - first);
+        const size_t numGroups = (count + s_GroupSize - 1) / s_GroupSize;
+        const size_t headerSize = (numGroups + 3) / 4;
+        for (size_t column = 0; column < stride; ++column) {
+            if (static_cast<size_t>(end - cursor) < headerSize) return false;
+            const uint8_t* header = cursor;
+            cursor += headerSize;
+            uint8_t* values = columns + column * blockVertices;
+            uint8_t previous = last[column];
+            for (size_t group = 0; group < numGroups; ++group) {
+                const uint32_t width = (header[group / 4] >> ((group % 4) * 2)) & 3;
+                const size_t groupBytes = s_GroupBytes[width];
+                if (static_cast<size_t>(end - cursor) < groupBytes) return false;
+                previous = DecodeGroup(cursor, width, previous, values + group * s_GroupSize);
+                cursor += groupBytes;
+            }
+            last[column] = values[count - 1];
+        }
+        Transpose(columns, blockVertices, count, stride, out + first * stride);
+    }
+    return cursor == end;
+}
+
+void GeometryCodec::EncodeIndices(const uint32_t* indices, const size_t numIndices, std::vector<uint8_t>& out) {
+    const size_t numTriangles = numIndices / 3;
+    std::vector<uint8_t> codes(numTriangles);
+    std::vector<uint8_t> rotations((numTriangles + 3) / 4, 0);
+    std::vector<uint8_t> data;
+    data.reserve(numTriangles);
+    std::vector<uint8_t> deltas;
+    IndexState state;
+    for (size_t triangle = 0; triangle < numTriangles; ++triangle) {
+        const uint32_t* corners = indices + triangle * 3;
+        // The first rotation whose leading edge is in the FIFO
+        uint32_t edge = s_EdgeMiss;
+        uint32_t rotation = 0;
+        for (uint32_t r = 0; r < 3 && edge == s_EdgeMiss; ++r) {
+            const uint32_t a = corners[r];
+            const uint32_t b = corners[(r + 1) % 3];
+            for (uint32_t i = 0; i < state.GetNumEdgeHits(); ++i) {
+                const Edge& candidate = state.GetEdge(i);
+                if (candidate.a == a && candidate.b == b) {
+                    edge = i;
+                    rotation = r;
+                    break;
+                }
+            }
+        }
+
+        if (edge != s_EdgeMiss) {
+            const uint32_t a = corners[rotation];
+            const uint32_t b = corners[(rotation + 1) % 3];
+            const uint32_t c = corners[(rotation + 2) % 3];
+            codes[triangle] = static_cast<uint8_t>((edge << 4) | EncodeVertex(state, c, data));
+            rotations[triangle / 4] |= static_cast<uint8_t>(rotation << ((triangle % 4) * 2));
+            state.PushEdge(c, b);
+            state.PushEdge(a, c);
+        }
+        else {
+            // The kinds byte goes ahead of the deltas, which are only known once every corner is coded
+            deltas.clear();
+            const uint32_t kindA = EncodeVertex(state, corners[0], deltas);
+            const uint32_t kindB = EncodeVertex(state, corners[1], deltas);
+            const uint32_t kindC = EncodeVertex(state, corners[2], deltas);
+            codes[triangle] = static_cast<uint8_t>((s_EdgeMiss << 4) | kindA);
+            data.push_back(static_cast<uint8_t>((kindB << 4) | kindC));
+            data.insert(data.end(), deltas.begin(), deltas.end());
+            state.PushEdge(corners[1], corners[0]);
+            state.PushEdge(corners[2], corners[1]);
+            state.PushEdge(corners[0], corners[2]);
+        }
+    }
+    out.insert(out.end(), codes.begin(), codes.end());
+    out.insert(out.end(), rotations.begin(), rotations.end());
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+bool GeometryCodec::DecodeIndices(void* dst, const size_t numIndices, const size_t indexSize, const uint8_t* src, const size_t srcSize) {
+    if (numIndices % 3 != 0 || (indexSize != 2 && indexSize != 4)) {
+        return false;
+    }
+    const size_t numTriangles = numIndices / 3;
+    const size_t rotationsSize = (numTriangles + 3) / 4;
+    if (srcSize < numTriangles + rotationsSize) {
+        return false;
+    }
+    const uint8_t* codes = src;
+    const uint8_t* rotations = src + numTriangles;
+    const uint8_t* data = rotations + rotationsSize;
+    const uint8_t* end = src + srcSize;
+    const uint32_t maxIndex = indexSize == 2 ? UINT16_MAX : UINT32_MAX;
+    IndexState state;
+    for (size_t triangle = 0; triangle < numTriangles; ++triangle) {
+        const uint32_t code = codes[triangle];
+        const uint32_t edge = code >> 4;
+        uint32_t corners[3];
+        if (edge != s_EdgeMiss) {
+            const uint32_t rotation = (rotations[triangle / 4] >> ((triangle % 4) * 2)) & 3;
+            if (edge >= state.GetNumEdgeHits() || rotation > 2) return false;
+            const Edge shared = state.GetEdge(edge);
+            uint32_t c;
+            if (!DecodeVertex(state, code & 15, data, end, c)) return false;
+            corners[rotation] = shared.a;
+            corners[(rotation + 1) % 3] = shared.b;
+            corners[(rotation + 2) % 3] = c;
+            state.PushEdge(c, shared.b);
+            state.PushEdge(shared.a, c);
+        }
+        else {
+            if (data >= end) return false;
+            const uint32_t kinds = *data++;
+            if (!DecodeVertex(state, code & 15, data, end, corners[0])
+                || !DecodeVertex(state, kinds >> 4, data, end, corners[1])
+                || !DecodeVertex(state, kinds & 15, data, end, corners[2])) {
+                return false;
+            }
+            state.PushEdge(corners[1], corners[0]);
+            state.PushEdge(corners[2], corners[1]);
+            state.PushEdge(corners[0], corners[2]);
+        }
+
+        if (corners[0] > maxIndex || corners[1] > maxIndex || corners[2] > maxIndex) {
+            return false;
+        }
+        if (indexSize == 2) {
+            const uint16_t values[3] = { static_cast<uint16_t>(corners[0]), static_cast<uint16_t>(corners[1]), static_cast<uint16_t>(corners[2]) };
+            std::memcpy(static_cast<uint8_t*>(dst) + triangle * sizeof(values), values, sizeof(values));
+        }
+        else {
+            std::memcpy(static_cast<uint8_t*>(dst) + triangle * sizeof(corners), corners, sizeof(corners));
+        }
+    }
+    return data == end;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless compression of cooked vertex and index buffers, decoded at load straight into the
+// staging memory they're uploaded from.
+//  - Vertices are coded in blocks of up to 256. Every byte of a vertex is delta coded against the
+//    same byte of the previous vertex and zigzagged, and the block is transposed so each byte
+//    column is contiguous. Columns are stored in groups of 16 values, each group at the fewest
+//    bits (0, 2, 4 or 8) that hold all of its values. Vertices in fetch order change little from
+//    one to the next, so most groups take 2 or 4 bits a value.
+//  - Triangles are coded against a FIFO of recently seen edges and one of recent vertices. After
+//    vertex cache optimization most triangles share an edge with a recent one, which costs a
+//    byte naming the edge and how to find the third vertex, plus 2 bits for which of the
+//    triangle's edges it was. The third vertex is mostly the next unused index or a recent one,
+//    anything else is a varint delta from the last one coded that way. Triangle order and
+//    rotation are kept, decoding gives back the exact input.
+// The vertex decoder uses SSE2 where available: 16 vertices of a column at a time, then 4 columns
+// by 16 vertices transposed back to vertex order. The index decoder is scalar, a byte per triangle.
+namespace GeometryCodec {
+    // Largest vertex stride the codec handles
+    constexpr size_t s_MaxVertexStride = 256;
+
+    // Appends the encoding of numVertices vertices of stride bytes to out. False for a stride
+    // over s_MaxVertexStride.
+    bool EncodeVertices(const void* vertices, const size_t numVertices, const size_t stride, std::vector<uint8_t>& out);
+    // Writes numVertices vertices to dst. False if src is truncated or corrupt.
+    bool DecodeVertices(void* dst, const size_t numVertices, const size_t stride, const uint8_t* src, const size_t srcSize);
+
+    // indices is a triangle list. Appends its encoding to out.
+    void EncodeIndices(const uint32_t* indices, const size_t numIndices, std::vector<uint8_t>& out);
+    // Writes numIndices indices of indexSize bytes (2 or 4) to dst. False if src is truncated or
+    // corrupt, or an index doesn't fit in indexSize.
+    bool DecodeIndices(void* dst, const size_t numIndices, const size_t indexSize, const uint8_t* src, const size_t srcSize);
+}
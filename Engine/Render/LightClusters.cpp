@@ -0,0 +1,266 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <array>
+#include <glm/gtc/matrix_transform.hpp>
+#include <limits>
+#include <SDL3/SDL.h>
+
+static constexpr Uint32 s_LightBufferSize      = MAX_LIGHTS * sizeof(PointLight);
+static constexpr Uint32 s_ClusterRangeBufferSize = NUM_CLUSTERS * sizeof(ClusterRangeGPU);
+static constexpr Uint32 s_LightIndexBufferSize = MAX_CLUSTER_LIGHT_INDICES * sizeof(uint32_t);
+
+bool LightClusters::Init(SDL_GPUDevice* device) {
+    SDL_GPUBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+
+    bufferCreateInfo.size = s_LightBufferSize;
+    mLightBuffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+    bufferCreateInfo.size = s_ClusterRangeBufferSize;
+    mClusterRangeBuffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+    bufferCreateInfo.size = s_LightIndexBufferSize;
+    mLightIndexBuffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+    if (!mLightBuffer || !mClusterRangeBuffer || !mLightIndexBuffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create light cluster buffers: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetGPUBufferName(device, mLightBuffer, "Light Buffer");
+    SDL_SetGPUBufferName(device, mClusterRangeBuffer, "Cluster Range Buffer");
+    SDL_SetGPUBufferName(device, mLightIndexBuffer, "Cluster Light Index Buffer");
+
+    SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo{};
+    transferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    transferBufferCreateInfo.size = s_LightBufferSize + s_ClusterRangeBufferSize + s_LightIndexBufferSize;
+    mTransferBuffer = SDL_CreateGPUTransferBuffer(device, &transferBufferCreateInfo);
+    if (!mTransferBuffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create light cluster transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    mRanges.resize(NUM_CLUSTERS);
+    return true;
+}
+
+void LightClusters::Release(SDL_GPUDevice* device) {
+    if (mLightBuffer) SDL_ReleaseGPUBuffer(device, mLightBuffer);
+    if (mClusterRangeBuffer) SDL_ReleaseGPUBuffer(device, mClusterRangeBuffer);
+    if (mLightIndexBuffer) SDL_ReleaseGPUBuffer(device, mLightIndexBuffer);
+    if (mTransferBuffer) SDL_ReleaseGPUTransferBuffer(device, mTransferBuffer);
+    mLightBuffer = nullptr;
+    mClusterRangeBuffer = nullptr;
+    mLightIndexBuffer = nullptr;
+    mTransferBuffer = nullptr;
+}
+
+float LightClusters::SliceDepth(const uint32_t slice) const {
+    return mParams.zNear * glm::pow(mParams.zFar / mParams.zNear, static_cast<float>(slice) / CLUSTER_GRID_Z);
+}
+
+void LightClusters::RebuildClusterBounds(const glm::mat4& projection) {
+    mCachedProjection = projection;
+    mClusterBounds.resize(NUM_CLUSTERS);
+
+    // Unproject the tile corners at the NDC near and far planes, then clip the resulting rays
+    // against each slice's depth range. Works for both perspective and orthographic projections.
+    const glm::mat4 invProjection = glm::inverse(projection);
+    auto unproject = [&invProjection](const glm::vec2 ndc, const float ndcZ) {
+        glm::vec4 p = invProjection * glm::vec4(ndc, ndcZ, 1.0f);
+        return glm::vec3(p) / p.w;
+    };
+
+    for (uint32_t y = 0; y < CLUSTER_GRID_Y; ++y) {
+        for (uint32_t x = 0; x < CLUSTER_GRID_X; ++x) {
+            // Tiles are laid out from the top-left of the framebuffer, NDC y points up
+            const float ndcX0 = (static_cast<float>(x)     / CLUSTER_GRID_X) * 2.0f - 1.0f;
+            const float ndcX1 = (static_cast<float>(x + 1) / CLUSTER_GRID_X) * 2.0f - 1.0f;
+            const float ndcY0 = 1.0f - (static_cast<float>(y + 1) / CLUSTER_GRID_Y) * 2.0f;
+            const float ndcY1 = 1.0f - (static_cast<float>(y)     / CLUSTER_GRID_Y) * 2.0f;
+            const std::array<glm::vec2, 4> corners = {
+                glm::vec2{ndcX0, ndcY0}, glm::vec2{ndcX1, ndcY0},
+                glm::vec2{ndcX0, ndcY1}, glm::vec2{ndcX1, ndcY1},
+            };
+            std::array<glm::vec3, 4> rayStart;
+            std::array<glm::vec3, 4> rayEnd;
+            for (size_t c = 0; c < corners.size(); ++c) {
+                rayStart[c] = unproject(corners[c], 0.0f);
+                rayEnd[c]   = unproject(corners[c], 1.0f);
+            }
+
+            for (uint32_t z = 0; z < CLUSTER_GRID_Z; ++z) {
+                const float sliceNear = SliceDepth(z);
+                const float sliceFar  = SliceDepth(z + 1);
+                ClusterBounds& bounds = mClusterBounds[x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z)];
+                bounds.min = glm::vec3(std::numeric_limits<float>::max());
+                bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+                for (size_t c = 0; c < corners.size(); ++c) {
+                    const glm::vec3 dir = rayEnd[c] - rayStart[c];
+                    for (const float depth : {sliceNear, sliceFar}) {
+                        const float t = (depth - rayStart[c].z) / dir.z;
+                        const glm::vec3 p = rayStart[c] + dir * t;
+                        bounds.min = glm::min(bounds.min, p);
+                        bounds.max = glm::max(bounds.max, p);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void LightClusters::Build(
+    const std::vector<PointLight>& lights,
+    const glm::mat4& view,
+    const glm::mat4& projection,
+    const float nearPlane,
+    const float farPlane,
+    const glm::vec2 screenSize) {
+
+    const bool bBoundsDirty = mClusterBounds.empty()
+        || projection != mCachedProjection
+        || nearPlane != mParams.zNear
+        || farPlane != mParams.zFar;
+
+    const float logDepthRatio = glm::log(farPlane / nearPlane);
+    mParams.screenSize = glm::max(screenSize, glm::vec2(1.0f));
+    mParams.zNear = nearPlane;
+    mParams.zFar = farPlane;
+    mParams.logDepthScale = CLUSTER_GRID_Z / logDepthRatio;
+    mParams.logDepthBias = -(CLUSTER_GRID_Z * glm::log(nearPlane)) / logDepthRatio;
+    if (bBoundsDirty) {
+        RebuildClusterBounds(projection);
+    }
+
+    const size_t numLights = std::min(lights.size(), static_cast<size_t>(MAX_LIGHTS));
+    if (numLights < lights.size()) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_RENDER, "Light count %zu exceeds MAX_LIGHTS (%d), extra lights are ignored", lights.size(), MAX_LIGHTS);
+    }
+    mLights.assign(lights.begin(), lights.begin() + numLights);
+    mParams.numLights = static_cast<uint32_t>(numLights);
+
+    auto sliceFromDepth = [this](const float depth) {
+        const int slice = static_cast<int>(glm::floor(glm::log(depth) * mParams.logDepthScale + mParams.logDepthBias));
+        return static_cast<uint32_t>(glm::clamp(slice, 0, static_cast<int>(CLUSTER_GRID_Z) - 1));
+    };
+    auto tileFromNDC = [](const float ndc, const uint32_t gridSize) {
+        const int tile = static_cast<int>(glm::floor((ndc * 0.5f + 0.5f) * gridSize));
+        return static_cast<uint32_t>(glm::clamp(tile, 0, static_cast<int>(gridSize) - 1));
+    };
+
+    // Gather (cluster, light) pairs. Lights are visited in order, so every cluster list ends up sorted.
+    mLightClusterPairs.clear();
+    for (uint32_t lightIndex = 0; lightIndex < numLights; ++lightIndex) {
+        const PointLight& light = mLights[lightIndex];
+        const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        const float radius = light.radius;
+        if (center.z + radius < nearPlane || center.z - radius > farPlane) continue;
+
+        const uint32_t sliceMin = sliceFromDepth(glm::max(center.z - radius, nearPlane));
+        const uint32_t sliceMax = sliceFromDepth(glm::min(center.z + radius, farPlane));
+
+        uint32_t tileMinX = 0, tileMaxX = CLUSTER_GRID_X - 1;
+        uint32_t tileMinY = 0, tileMaxY = CLUSTER_GRID_Y - 1;
+        if (center.z - radius > nearPlane) {
+            // Project the sphere's view space AABB, which conservatively bounds its screen footprint
+            glm::vec2 ndcMin(std::numeric_limits<float>::max());
+            glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+            for (int corner = 0; corner < 8; ++corner) {
+                const glm::vec3 offset{
+                    (corner & 1) ? radius : -radius,
+                    (corner & 2) ? radius : -radius,
+                    (corner & 4) ? radius : -radius,
+                };
+                const glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue;
+            tileMinX = tileFromNDC(ndcMin.x, CLUSTER_GRID_X);
+            tileMaxX = tileFromNDC(ndcMax.x, CLUSTER_GRID_X);
+            // tile rows start at the top of the screen
+            tileMinY = tileFromNDC(-ndcMax.y, CLUSTER_GRID_Y);
+            tileMaxY = tileFromNDC(-ndcMin.y, CLUSTER_GRID_Y);
+        }
+
+        const float radiusSq = radius * radius;
+        for (uint32_t z = sliceMin; z <= sliceMax; ++z) {
+            for (uint32_t y = tileMinY; y <= tileMaxY; ++y) {
+                for (uint32_t x = tileMinX; x <= tileMaxX; ++x) {
+                    const uint32_t clusterIndex = x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z);
+                    const ClusterBounds& bounds = mClusterBounds[clusterIndex];
+                    const glm::vec3 closest = glm::clamp(center, bounds.min, bounds.max);
+                    const glm::vec3 delta = closest - center;
+                    if (glm::dot(delta, delta) <= radiusSq) {
+                        mLightClusterPairs.push_back({clusterIndex, lightIndex});
+                    }
+                }
+            }
+        }
+    }
+
+    // Count, prefix sum, then scatter into the flat light index list
+    mRanges.assign(NUM_CLUSTERS, ClusterRangeGPU{});
+    for (const glm::uvec2& pair : mLightClusterPairs) {
+        ++mRanges[pair.x].count;
+    }
+    uint32_t offset = 0;
+    for (ClusterRangeGPU& range : mRanges) {
+        range.offset = offset;
+        if (offset + range.count > MAX_CLUSTER_LIGHT_INDICES) {
+            range.count = MAX_CLUSTER_LIGHT_INDICES - offset;
+            if (!mWarnedOverflow) {
+                mWarnedOverflow = true;
+                SDL_LogWarn(SDL_LOG_CATEGORY_RENDER, "Cluster light index list overflow, some lights are dropped");
+            }
+        }
+        offset += range.count;
+    }
+    mLightIndices.resize(offset);
+    std::vector<uint32_t> written(NUM_CLUSTERS, 0);
+    for (const glm::uvec2& pair : mLightClusterPairs) {
+        const ClusterRangeGPU& range = mRanges[pair.x];
+        uint32_t& cursor = written[pair.x];
+        if (cursor < range.count) {
+            mLightIndices[range.offset + cursor++] = pair.y;
+        }
+    }
+}
+
+void LightClusters::Upload(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer) {
+    Uint8* transferData = static_cast<Uint8*>(SDL_MapGPUTransferBuffer(device, mTransferBuffer, true));
+    if (!transferData) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to map light cluster transfer buffer: %s", SDL_GetError());
+        return;
+    }
+    const Uint32 lightsSize  = static_cast<Uint32>(mLights.size() * sizeof(PointLight));
+    const Uint32 indicesSize = static_cast<Uint32>(mLightIndices.size() * sizeof(uint32_t));
+    const Uint32 rangesOffset  = s_LightBufferSize;
+    const Uint32 indicesOffset = s_LightBufferSize + s_ClusterRangeBufferSize;
+    SDL_memcpy(transferData, mLights.data(), lightsSize);
+    SDL_memcpy(transferData + rangesOffset, mRanges.data(), s_ClusterRangeBufferSize);
+    SDL_memcpy(transferData + indicesOffset, mLightIndices.data(), indicesSize);
+    SDL_UnmapGPUTransferBuffer(device, mTransferBuffer);
+
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    if (lightsSize > 0) {
+        SDL_GPUTransferBufferLocation source{ mTransferBuffer, 0 };
+        SDL_GPUBufferRegion destination{ mLightBuffer, 0, lightsSize };
+        SDL_UploadToGPUBuffer(copyPass, &source, &destination, true);
+    }
+    {
+        SDL_GPUTransferBufferLocation source{ mTransferBuffer, rangesOffset };
+        SDL_GPUBufferRegion destination{ mClusterRangeBuffer, 0, s_ClusterRangeBufferSize };
+        SDL_UploadToGPUBuffer(copyPass, &source, &destination, true);
+    }
+    if (indicesSize > 0) {
+        SDL_GPUTransferBufferLocation source{ mTransferBuffer, indicesOffset };
+        SDL_GPUBufferRegion destination{ mLightIndexBuffer, 0, indicesSize };
+        SDL_UploadToGPUBuffer(copyPass, &source, &destination, true);
+    }
+    SDL_EndGPUCopyPass(copyPass);
+}
+
+void LightClusters::Bind(SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass) const {
+    SDL_GPUBuffer* storageBuffers[] = { mLightBuffer, mClusterRangeBuffer, mLightIndexBuffer };
+    SDL_BindGPUFragmentStorageBuffers(renderPass, 0, storageBuffers, SDL_arraysize(storageBuffers));
+    SDL_PushGPUFragmentUniformData(commandBuffer, 0, &mParams, sizeof(ClusterParamsGPU));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <Render/RenderStructs.h>
+#include <SDL3/SDL_gpu.h>
+#include <vector>
+
+// Clustered forward lighting.
+// The view frustum is split into a froxel grid (screen tiles x exponential depth slices).
+// Every frame the point lights are binned into the froxels they touch on the CPU and the
+// resulting per-cluster light index lists are uploaded to storage buffers, so the PBR
+// fragment shader only walks the lights of its own cluster.
+class LightClusters {
+public:
+    bool Init(SDL_GPUDevice* device);
+    void Release(SDL_GPUDevice* device);
+
+    // Bins the lights into the cluster grid for the given camera.
+    void Build(
+        const std::vector<PointLight>& lights,
+        const glm::mat4& view,
+        const glm::mat4& projection,
+        const float nearPlane,
+        const float farPlane,
+        const glm::vec2 screenSize);
+
+    // Records a copy pass that uploads the lights and cluster lists built this frame.
+    void Upload(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer);
+
+    // Binds the light, cluster range and light index buffers to the fragment storage slots
+    // following the material samplers and pushes the ClusterParams fragment uniform.
+    void Bind(SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass) const;
+
+    const ClusterParamsGPU& GetParams() const { return mParams; }
+    uint32_t GetNumLightIndices() const { return static_cast<uint32_t>(mLightIndices.size()); }
+
+private:
+    void RebuildClusterBounds(const glm::mat4& projection);
+    float SliceDepth(const uint32_t slice) const;
+
+    struct ClusterBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    ClusterParamsGPU mParams{};
+    std::vector<PointLight> mLights;
+    std::vector<ClusterRangeGPU> mRanges;
+    std::vector<uint32_t> mLightIndices;
+    std::vector<ClusterBounds> mClusterBounds; // view space, rebuilt when the projection changes
+    std::vector<glm::uvec2> mLightClusterPairs; // scratch: (cluster, light)
+
+    glm::mat4 mCachedProjection = glm::mat4(0.0f);
+    bool mWarnedOverflow = false;
+
+    SDL_GPUBuffer* mLightBuffer = nullptr;
+    SDL_GPUBuffer* mClusterRangeBuffer = nullptr;
+    SDL_GPUBuffer* mLightIndexBuffer = nullptr;
+    SDL_GPUTransferBuffer* mTransferBuffer = nullptr;
+};
@@ -0,0 +1,297 @@
+#include "MaterialTable.h"
+
+#include <algorithm>
+#include <format>
+#include <Render/TextureUtils.h>
+#include <SDL3/SDL.h>
+
+static constexpr uint32_t s_InitialArrayLayers = 4;
+static constexpr uint32_t s_InitialMaterialCapacity = 64;
+
+static uint32_t GetGrownLayerCount(const uint32_t numLayers) {
+    return std::min(std::max(numLayers * 2, s_InitialArrayLayers), MaterialTable::MAX_ARRAY_LAYERS);
+}
+
+void MaterialTable::Init(SDL_GPUDevice* device) {
+    mDevice = device;
+}
+
+void MaterialTable::Release() {
+    if (!mDevice) return;
+    for (TextureArray& textureArray : mArrays) {
+        if (textureArray.texture) SDL_ReleaseGPUTexture(mDevice, textureArray.texture);
+    }
+    mArrays.clear();
+    if (mMaterialBuffer) SDL_ReleaseGPUBuffer(mDevice, mMaterialBuffer);
+    mMaterialBuffer = nullptr;
+    mMaterialBufferCapacity = 0;
+    mMaterials.clear();
+    mFreeMaterials.clear();
+    mNumUploadedMaterials = 0;
+}
+
+SDL_GPUTexture* MaterialTable::CreateArray(const TextureArray& textureArray, const uint32_t numLayers, const uint16_t index) const {
+    // Uncompressed arrays get their mip chains generated on the GPU, which blits between levels
+    const bool bGenerateMips = textureArray.format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM && textureArray.numLevels > 1;
+    SDL_GPUTextureCreateInfo createInfo = {
+        .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+        .format = textureArray.format,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | (bGenerateMips ? SDL_GPU_TEXTUREUSAGE_COLOR_TARGET : 0u),
+        .width = textureArray.width,
+        .height = textureArray.height,
+        .layer_count_or_depth = numLayers,
+        .num_levels = textureArray.numLevels,
+    };
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture(mDevice, &createInfo);
+    if (!texture) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create texture array: %s", SDL_GetError());
+        return nullptr;
+    }
+    const std::string name = std::format("Texture Array {} ({}x{}, {} layers)", index, textureArray.width, textureArray.height, numLayers);
+    SDL_SetGPUTextureName(mDevice, texture, name.c_str());
+    return texture;
+}
+
+bool MaterialTable::Resize(TextureArray& textureArray, const uint32_t numLayers, const uint16_t index) {
+    SDL_assert(numLayers >= textureArray.numUsedLayers);
+    SDL_GPUTexture* texture = CreateArray(textureArray, numLayers, index);
+    if (!texture) {
+        return false;
+    }
+
+    // Carry the used layers over. Submitted right away so any upload recorded after this,
+    // which targets the new array, lands on top of the copy.
+    if (textureArray.texture && textureArray.numUsedLayers > 0) {
+        SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(mDevice);
+        if (!commandBuffer) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to acquire command buffer to resize a texture array: %s", SDL_GetError());
+            SDL_ReleaseGPUTexture(mDevice, texture);
+            return false;
+        }
+        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+        for (uint32_t layer = 0; layer < textureArray.numUsedLayers; ++layer) {
+            for (uint32_t level = 0; level < textureArray.numLevels; ++level) {
+                const SDL_GPUTextureLocation source{ .texture = textureArray.texture, .mip_level = level, .layer = layer };
+                const SDL_GPUTextureLocation destination{ .texture = texture, .mip_level = level, .layer = layer };
+                SDL_CopyGPUTextureToTexture(copyPass, &source, &destination,
+                    std::max(textureArray.width >> level, 1u), std::max(textureArray.height >> level, 1u), 1, false);
+            }
+        }
+        SDL_EndGPUCopyPass(copyPass);
+        SDL_SubmitGPUCommandBuffer(commandBuffer);
+    }
+    if (textureArray.texture) SDL_ReleaseGPUTexture(mDevice, textureArray.texture);
+    textureArray.texture = texture;
+    textureArray.numLayers = numLayers;
+    return true;
+}
+
+bool MaterialTable::Grow(TextureArray& textureArray, const uint16_t index) {
+    const uint32_t numLayers = GetGrownLayerCount(textureArray.numLayers);
+    return numLayers > textureArray.numLayers && Resize(textureArray, numLayers, index);
+}
+
+size_t MaterialTable::FindArray(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels) const {
+    auto it = std::find_if(mArrays.begin(), mArrays.end(), [&](const TextureArray& textureArray) {
+        return textureArray.format == format && textureArray.width == width && textureArray.height == height && textureArray.numLevels == numLevels;
+    });
+    return static_cast<size_t>(it - mArrays.begin());
+}
+
+TextureSlot MaterialTable::AllocateTexture(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels) {
+    auto it = mArrays.begin() + FindArray(format, width, height, numLevels);
+    if (it == mArrays.end()) {
+        // The index of a released array is reused first, the arrays after it keep theirs
+        it = std::find_if(mArrays.begin(), mArrays.end(), [](const TextureArray& textureArray) { return !textureArray.texture; });
+        if (it == mArrays.end()) {
+            if (mArrays.size() >= MAX_TEXTURE_ARRAYS) {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Out of texture arrays for a %ux%u texture with %u levels (format %d)",
+                    width, height, numLevels, static_cast<int>(format));
+                return {};
+            }
+            it = mArrays.insert(mArrays.end(), TextureArray{});
+        }
+        *it = TextureArray{ .format = format, .width = width, .height = height, .numLevels = numLevels };
+    }
+    TextureArray& textureArray = *it;
+    const uint16_t index = static_cast<uint16_t>(it - mArrays.begin());
+
+    if (!textureArray.freeLayers.empty()) {
+        const uint16_t layer = textureArray.freeLayers.front();
+        textureArray.freeLayers.erase(textureArray.freeLayers.begin());
+        return { .array = index, .layer = layer };
+    }
+    if (textureArray.numUsedLayers == textureArray.numLayers && !Grow(textureArray, index)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Texture array %u (%ux%u) is full", index, width, height);
+        if (!textureArray.texture) {
+            textureArray = TextureArray{};
+            PopReleasedArrays();
+        }
+        return {};
+    }
+    return { .array = index, .layer = static_cast<uint16_t>(textureArray.numUsedLayers++) };
+}
+
+void MaterialTable::FreeTexture(const TextureSlot slot) {
+    SDL_assert(slot.IsValid() && slot.array < mArrays.size());
+    // Kept sorted: allocations take the lowest layer, which keeps the used ones packed at the
+    // start of the array for Trim to cut the rest off
+    std::vector<uint16_t>& freeLayers = mArrays[slot.array].freeLayers;
+    freeLayers.insert(std::upper_bound(freeLayers.begin(), freeLayers.end(), slot.layer), slot.layer);
+}
+
+void MaterialTable::Trim() {
+    for (uint16_t index = 0; index < mArrays.size(); ++index) {
+        TextureArray& textureArray = mArrays[index];
+        if (!textureArray.texture) continue;
+        // Free layers at the end are as good as untouched
+        while (!textureArray.freeLayers.empty() && textureArray.freeLayers.back() + 1u == textureArray.numUsedLayers) {
+            textureArray.freeLayers.pop_back();
+            --textureArray.numUsedLayers;
+        }
+        if (textureArray.numUsedLayers == 0) {
+            SDL_ReleaseGPUTexture(mDevice, textureArray.texture);
+            textureArray = TextureArray{};
+            continue;
+        }
+        // Halved while at most a quarter is used, so an array doesn't shrink and regrow back and forth
+        uint32_t numLayers = textureArray.numLayers;
+        while (numLayers > s_InitialArrayLayers && textureArray.numUsedLayers <= numLayers / 4) {
+            numLayers /= 2;
+        }
+        if (numLayers < textureArray.numLayers) {
+            Resize(textureArray, numLayers, index);
+        }
+    }
+    PopReleasedArrays();
+}
+
+bool MaterialTable::IsTrimBlockedBy(const TextureSlot slot) const {
+    SDL_assert(slot.IsValid() && slot.array < mArrays.size());
+    const TextureArray& textureArray = mArrays[slot.array];
+    const uint32_t numLiveLayers = textureArray.numUsedLayers - static_cast<uint32_t>(textureArray.freeLayers.size());
+    return textureArray.numLayers > s_InitialArrayLayers && numLiveLayers <= textureArray.numLayers / 4 && slot.layer >= textureArray.numLayers / 4;
+}
+
+uint64_t MaterialTable::GetAllocationBytes(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels) const {
+    const uint64_t layerBytes = TextureUtils::GetTextureSize(format, width, height, numLevels);
+    const size_t index = FindArray(format, width, height, numLevels);
+    if (index == mArrays.size()) {
+        const bool bHasIndex = mArrays.size() < MAX_TEXTURE_ARRAYS
+            || std::any_of(mArrays.begin(), mArrays.end(), [](const TextureArray& textureArray) { return !textureArray.texture; });
+        return bHasIndex ? layerBytes * s_InitialArrayLayers : UINT64_MAX;
+    }
+    const TextureArray& textureArray = mArrays[index];
+    if (!textureArray.freeLayers.empty() || textureArray.numUsedLayers < textureArray.numLayers) {
+        return 0;
+    }
+    const uint32_t numLayers = GetGrownLayerCount(textureArray.numLayers);
+    return numLayers > textureArray.numLayers ? layerBytes * (numLayers - textureArray.numLayers) : UINT64_MAX;
+}
+
+void MaterialTable::PopReleasedArrays() {
+    while (!mArrays.empty() && !mArrays.back().texture) {
+        mArrays.pop_back();
+    }
+}
+
+uint32_t MaterialTable::AddMaterial(const MaterialGPU& material) {
+    if (!mFreeMaterials.empty()) {
+        const uint32_t index = mFreeMaterials.back();
+        mFreeMaterials.pop_back();
+        mMaterials[index] = material;
+        mNumUploadedMaterials = std::min(mNumUploadedMaterials, index);
+        return index;
+    }
+    mMaterials.push_back(material);
+    return static_cast<uint32_t>(mMaterials.size() - 1);
+}
+
+void MaterialTable::FreeMaterial(const uint32_t index) {
+    SDL_assert(index < mMaterials.size());
+    mFreeMaterials.push_back(index);
+}
+
+void MaterialTable::ReplaceTexture(const TextureSlot from, const TextureSlot to) {
+    const uint32_t packedFrom = from.Pack();
+    for (uint32_t i = 0; i < mMaterials.size(); ++i) {
+        for (uint32_t& texture : mMaterials[i].textures) {
+            if (texture != packedFrom) continue;
+            texture = to.Pack();
+            mNumUploadedMaterials = std::min(mNumUploadedMaterials, i);
+        }
+    }
+}
+
+bool MaterialTable::Upload(SDL_GPUCopyPass* copyPass, StagingRing& stagingRing) {
+    if (mNumUploadedMaterials == mMaterials.size()) {
+        return true;
+    }
+
+    // A new buffer is filled from the first row, an existing one only gets the new and changed rows
+    uint32_t firstMaterial = mNumUploadedMaterials;
+    if (mMaterials.size() > mMaterialBufferCapacity) {
+        uint32_t capacity = std::max(mMaterialBufferCapacity, s_InitialMaterialCapacity);
+        while (capacity < mMaterials.size()) capacity *= 2;
+        SDL_GPUBufferCreateInfo bufferCreateInfo{
+            .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+            .size = static_cast<Uint32>(capacity * sizeof(MaterialGPU)),
+        };
+        SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer(mDevice, &bufferCreateInfo);
+        if (!buffer) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create material buffer: %s", SDL_GetError());
+            return false;
+        }
+        SDL_SetGPUBufferName(mDevice, buffer, "Material Buffer");
+        if (mMaterialBuffer) SDL_ReleaseGPUBuffer(mDevice, mMaterialBuffer);
+        mMaterialBuffer = buffer;
+        mMaterialBufferCapacity = capacity;
+        firstMaterial = 0;
+    }
+
+    const Uint32 size = static_cast<Uint32>((mMaterials.size() - firstMaterial) * sizeof(MaterialGPU));
+    const StagingRing::Allocation staging = stagingRing.Allocate(size);
+    if (!staging.IsValid()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to stage material rows");
+        return false;
+    }
+    SDL_memcpy(staging.data, mMaterials.data() + firstMaterial, size);
+    stagingRing.Upload(copyPass, staging, mMaterialBuffer, static_cast<Uint32>(firstMaterial * sizeof(MaterialGPU)));
+
+    mNumUploadedMaterials = static_cast<uint32_t>(mMaterials.size());
+    return true;
+}
+
+bool MaterialTable::Bind(SDL_GPURenderPass* renderPass, SDL_GPUSampler* sampler, const uint32_t storageBufferSlot) const {
+    auto firstArray = std::find_if(mArrays.begin(), mArrays.end(), [](const TextureArray& textureArray) { return textureArray.texture; });
+    if (firstArray == mArrays.end() || !mMaterialBuffer) {
+        return false;
+    }
+    // Every declared slot has to be bound, the unused and released ones repeat the first array
+    SDL_GPUTextureSamplerBinding bindings[MAX_TEXTURE_ARRAYS];
+    for (uint32_t i = 0; i < MAX_TEXTURE_ARRAYS; ++i) {
+        bindings[i] = { (i < mArrays.size() && mArrays[i].texture) ? mArrays[i].texture : firstArray->texture, sampler };
+    }
+    SDL_BindGPUFragmentSamplers(renderPass, 0, bindings, MAX_TEXTURE_ARRAYS);
+    SDL_BindGPUFragmentStorageBuffers(renderPass, storageBufferSlot, &mMaterialBuffer, 1);
+    return true;
+}
+
+uint32_t MaterialTable::GetNumArrays() const {
+    return static_cast<uint32_t>(std::count_if(mArrays.begin(), mArrays.end(), [](const TextureArray& textureArray) { return textureArray.texture; }));
+}
+
+uint64_t MaterialTable::GetReservedBytes() const {
+    uint64_t bytes = 0;
+    for (const TextureArray& textureArray : mArrays) {
+        if (!textureArray.texture) continue;
+        bytes += TextureUtils::GetTextureSize(textureArray.format, textureArray.width, textureArray.height, textureArray.numLevels) * textureArray.numLayers;
+    }
+    return bytes;
+}
+
+uint64_t MaterialTable::GetLayerBytes(const TextureSlot slot, const uint32_t numLevels) const {
+    SDL_assert(slot.IsValid() && slot.array < mArrays.size());
+    const TextureArray& textureArray = mArrays[slot.array];
+    return TextureUtils::GetTextureSize(textureArray.format, textureArray.width, textureArray.height, std::min(numLevels, textureArray.numLevels));
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <Render/StagingRing.h>
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+// Bindless style material storage for the PBR pass.
+//  - Every material texture is a layer of a 2D texture array. Textures of the same format, size
+//    and level count share an array, which grows (recreated with twice the layers, existing
+//    layers copied on the GPU) when it runs out of room.
+//  - Freed layers are reused lowest first. Trim releases the arrays left empty and halves the
+//    mostly free ones, so the memory and sampler slots of shapes no longer in use come back.
+//  - Materials are rows of a storage buffer holding the packed TextureSlot of each texture type.
+// Bind sets all arrays, the sampler and the material buffer once per pass; draws only select
+// their material by index, so a material change needs no rebinding.
+class MaterialTable {
+public:
+    // Fragment sampler slots the arrays occupy, which is also the number of distinct
+    // format/size combinations a scene can use
+    static constexpr uint32_t MAX_TEXTURE_ARRAYS = 16;
+    // The lowest array layer limit among the backends (Vulkan guarantees 256)
+    static constexpr uint32_t MAX_ARRAY_LAYERS = 256;
+
+    void Init(SDL_GPUDevice* device);
+    void Release();
+
+    // Reserves a layer for a texture of this shape, growing its array if needed. Layers are
+    // uninitialized until uploaded. Invalid if every array is taken by other shapes or full.
+    TextureSlot AllocateTexture(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels);
+    // Returns the layer to its array for reuse
+    void FreeTexture(const TextureSlot slot);
+    // Releases the arrays without allocated layers and shrinks the ones whose allocated layers
+    // fit in a quarter of them. Slots stay valid. Arrays are recreated, so nothing recorded but
+    // not yet submitted may use them.
+    void Trim();
+    // Whether moving the texture in the slot to a newly allocated slot of its shape would let
+    // Trim shrink its array: the array is mostly free and the slot past its first quarter
+    bool IsTrimBlockedBy(const TextureSlot slot) const;
+
+    // The array holding a slot. Arrays are recreated when they grow, don't keep this across allocations.
+    SDL_GPUTexture* GetArray(const TextureSlot slot) const { return mArrays[slot.array].texture; }
+
+    // Adds a material row, returns its index. Uploaded by the next Upload.
+    uint32_t AddMaterial(const MaterialGPU& material);
+    // Returns the row for reuse by a later AddMaterial
+    void FreeMaterial(const uint32_t index);
+    // Points every material row sampling from at to instead (a texture moved layers, see
+    // TextureStreamer). Uploaded by the next Upload.
+    void ReplaceTexture(const TextureSlot from, const TextureSlot to);
+    // Uploads the material rows added or changed since the last call, staged in the ring
+    bool Upload(SDL_GPUCopyPass* copyPass, StagingRing& stagingRing);
+
+    // Binds the arrays to fragment sampler slots 0..MAX_TEXTURE_ARRAYS-1 and the material
+    // buffer to the given fragment storage buffer slot. False if there's nothing to bind yet.
+    bool Bind(SDL_GPURenderPass* renderPass, SDL_GPUSampler* sampler, const uint32_t storageBufferSlot) const;
+
+    uint32_t GetNumArrays() const;
+    uint32_t GetNumMaterials() const { return static_cast<uint32_t>(mMaterials.size() - mFreeMaterials.size()); }
+    // Memory of every array layer, allocated or not
+    uint64_t GetReservedBytes() const;
+    // Memory of the first numLevels levels of a layer of the slot's array (all of them by default)
+    uint64_t GetLayerBytes(const TextureSlot slot, const uint32_t numLevels = UINT32_MAX) const;
+    // Memory allocating a texture of this shape would add to the arrays right now, 0 if there's a
+    // free layer. UINT64_MAX if it can't be allocated.
+    uint64_t GetAllocationBytes(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels) const;
+
+private:
+    struct TextureArray {
+        SDL_GPUTexture* texture = nullptr;
+        SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t numLevels = 0;
+        uint32_t numLayers = 0;     // allocated in the texture
+        uint32_t numUsedLayers = 0; // handed out at least once, the rest are untouched
+        std::vector<uint16_t> freeLayers; // below numUsedLayers, ascending
+    };
+
+    // Index of the array for the shape, mArrays.size() if there's none
+    size_t FindArray(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels) const;
+    SDL_GPUTexture* CreateArray(const TextureArray& textureArray, const uint32_t numLayers, const uint16_t index) const;
+    // Recreates the array with numLayers layers, copying the used ones over
+    bool Resize(TextureArray& textureArray, const uint32_t numLayers, const uint16_t index);
+    bool Grow(TextureArray& textureArray, const uint16_t index);
+    // Drops the released arrays at the end, released ones in between keep the indices after them
+    void PopReleasedArrays();
+
+    SDL_GPUDevice* mDevice = nullptr;
+    std::vector<TextureArray> mArrays; // released ones stay as holes with no texture
+
+    std::vector<MaterialGPU> mMaterials;
+    std::vector<uint32_t> mFreeMaterials;
+    uint32_t mNumUploadedMaterials = 0; // rows up to date on the GPU, from the first
+    SDL_GPUBuffer* mMaterialBuffer = nullptr;
+    uint32_t mMaterialBufferCapacity = 0; // in materials
+};
@@ -0,0 +1,477 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <Render/GeometryCodec.h>
+#include <SDL3/SDL.h>
+#include <type_traits>
+
+namespace {
+    constexpr uint32_t s_Magic = 0x534D4353; // "SCMS"
+    constexpr size_t s_SectionAlignment = 16;
+
+    enum Section : uint32_t {
+        Sources = 0,
+        Materials,
+        Textures,
+        Submeshes,
+        Meshlets,
+        Nodes,
+        Strings,
+        Vertices,
+        Indices,
+        NumSections,
+    };
+
+    struct SectionRange {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    struct Header {
+        uint32_t magic = s_Magic;
+        uint32_t version = MeshFile::VERSION;
+        uint64_t settingsHash = 0;
+        uint32_t numVertices = 0; // before packing, for stats
+        uint32_t numIndices = 0;  // every LOD
+        uint32_t submeshSize = sizeof(SubMeshData); // raw structs, must match the reader's
+        uint32_t meshletSize = sizeof(Meshlet);
+        uint8_t bDoNotRender = 0;
+        uint8_t bCompressedGeometry = 0; // Vertices and Indices are GeometryCodec encoded
+        uint8_t padding[6] = {};
+        uint32_t vertexDataSize = 0; // decoded
+        uint32_t indexDataSize = 0;
+        SectionRange sections[NumSections];
+    };
+
+    struct SourceRecord {
+        uint32_t nameOffset = 0; // into Strings
+        uint32_t nameLength = 0;
+        uint64_t size = 0;
+        int64_t modifiedTime = 0; // file_time_type ticks
+    };
+
+    struct MaterialRecord {
+        uint32_t bDoubleSided = 0;
+        uint32_t firstTexture = 0; // into Textures
+        uint32_t numTextures = 0;
+        uint32_t padding = 0;
+    };
+
+    struct TextureRecord {
+        uint32_t type = 0;
+        uint32_t nameOffset = 0;
+        uint32_t nameLength = 0;
+        uint32_t bUseFallback = 0;
+    };
+
+    struct NodeRecord {
+        int32_t id = 0;
+        int32_t parentId = -1;
+        uint32_t padding[2] = {};
+        glm::mat4 transformation = glm::mat4(1.0f);
+    };
+
+    static_assert(std::is_trivially_copyable_v<SubMeshData> && std::is_trivially_copyable_v<Meshlet>);
+
+    // Appends sections to a byte buffer, each one aligned
+    class Writer {
+    public:
+        Writer() : mBytes(sizeof(Header)) {}
+
+        template<typename T>
+        void AddSection(Header& header, const Section section, const T* data, const size_t count) {
+            AddSection(header, section, data, count * sizeof(T));
+        }
+
+        void AddSection(Header& header, const Section section, const void* data, const size_t size) {
+            mBytes.resize((mBytes.size() + s_SectionAlignment - 1) & ~(s_SectionAlignment - 1));
+            header.sections[section] = { mBytes.size(), size };
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            mBytes.insert(mBytes.end(), bytes, bytes + size);
+        }
+
+        uint32_t AddString(const std::string& string) {
+            const uint32_t offset = static_cast<uint32_t>(mStrings.size());
+            mStrings.insert(mStrings.end(), string.begin(), string.end());
+            return offset;
+        }
+
+        const std::vector<char>& GetStrings() const { return mStrings; }
+        std::vector<uint8_t>& GetBytes() { return mBytes; }
+
+    private:
+        std::vector<uint8_t> mBytes;
+        std::vector<char> mStrings;
+    };
+
+    template<typename T>
+    bool ReadSection(const Header& header, const Section section, const uint8_t* data, std::vector<T>& out) {
+        const SectionRange& range = header.sections[section];
+        if (range.size % sizeof(T) != 0) {
+            return false;
+        }
+        out.resize(range.size / sizeof(T));
+        if (range.size > 0) {
+            std::memcpy(out.data(), data + range.offset, range.size);
+        }
+        return true;
+    }
+
+    size_t GetIndexSize(const SubMeshData& submesh) {
+        return submesh.indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    // Indices in a submesh's region of the index buffer, every LOD back to back
+    size_t GetNumRegionIndices(const SubMeshData& submesh) {
+        size_t numIndices = 0;
+        for (uint32_t i = 0; i < submesh.numLods; ++i) {
+            numIndices += submesh.lods[i].numIndices;
+        }
+        return numIndices;
+    }
+
+    // A GeometryCodec stream per submesh region, each after its size
+    void EncodeIndexData(const std::vector<SubMeshData>& submeshes, const std::vector<uint8_t>& indexData, std::vector<uint8_t>& out) {
+        std::vector<uint32_t> indices;
+        for (const SubMeshData& submesh : submeshes) {
+            const size_t indexSize = GetIndexSize(submesh);
+            const uint8_t* region = indexData.data() + submesh.indexBufferOffset;
+            indices.resize(GetNumRegionIndices(submesh));
+            for (size_t i = 0; i < indices.size(); ++i) {
+                if (indexSize == sizeof(uint16_t)) {
+                    uint16_t index;
+                    std::memcpy(&index, region + i * indexSize, sizeof(index));
+                    indices[i] = index;
+                }
+                else {
+                    std::memcpy(&indices[i], region + i * indexSize, sizeof(uint32_t));
+                }
+            }
+            const size_t sizeOffset = out.size();
+            out.resize(out.size() + sizeof(uint32_t));
+            GeometryCodec::EncodeIndices(indices.data(), indices.size(), out);
+            const uint32_t size = static_cast<uint32_t>(out.size() - sizeOffset - sizeof(uint32_t));
+            std::memcpy(out.data() + sizeOffset, &size, sizeof(size));
+        }
+    }
+
+    bool DecodeIndexData(const std::vector<SubMeshData>& submeshes, const uint8_t* src, const size_t srcSize, uint8_t* dst, const size_t dstSize) {
+        size_t offset = 0;
+        for (const SubMeshData& submesh : submeshes) {
+            const size_t indexSize = GetIndexSize(submesh);
+            const size_t numIndices = GetNumRegionIndices(submesh);
+            const size_t regionSize = (numIndices * indexSize + 3) & ~size_t(3);
+            uint32_t size;
+            if (srcSize - offset < sizeof(size) || submesh.indexBufferOffset > dstSize || regionSize > dstSize - submesh.indexBufferOffset) {
+                return false;
+            }
+            std::memcpy(&size, src + offset, sizeof(size));
+            offset += sizeof(size);
+            uint8_t* region = dst + submesh.indexBufferOffset;
+            if (size > srcSize - offset || !GeometryCodec::DecodeIndices(region, numIndices, indexSize, src + offset, size)) {
+                return false;
+            }
+            // Padding up to the next region, zero as the cooker leaves it
+            std::memset(region + numIndices * indexSize, 0, regionSize - numIndices * indexSize);
+            offset += size;
+        }
+        return offset == srcSize;
+    }
+
+    bool GetFileStamp(const std::filesystem::path& path, uint64_t& outSize, int64_t& outModifiedTime) {
+        std::error_code error;
+        outSize = std::filesystem::file_size(path, error);
+        if (error) return false;
+        outModifiedTime = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        return !error;
+    }
+}
+
+std::string MeshFile::GetCookedPath(const std::string& sourcePath) {
+    std::filesystem::path path = sourcePath;
+    path.replace_extension(EXTENSION);
+    return path.string();
+}
+
+bool MeshFile::Load(const std::string& path) {
+    if (!std::filesystem::exists(path) || !mFile.Open(path)) {
+        return false;
+    }
+    if (!Parse(mFile.GetData(), mFile.GetSize())) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't read cooked mesh %s", path.c_str());
+        mFile.Close();
+        return false;
+    }
+    mDirectory = std::filesystem::path(path).parent_path().string();
+    mIsPacked = false;
+    return true;
+}
+
+bool MeshFile::Load(const std::string& path, const ContentPack& contentPack) {
+    size_t size = 0;
+    const uint8_t* data = contentPack.Find(path, size);
+    if (!data) {
+        return false;
+    }
+    mFile.Close();
+    if (!Parse(data, size)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't read packed cooked mesh %s", path.c_str());
+        return false;
+    }
+    mDirectory = std::filesystem::path(path).parent_path().string();
+    mIsPacked = true;
+    return true;
+}
+
+bool MeshFile::Parse(const uint8_t* data, const size_t size) {
+    Header header;
+    if (!data || size < sizeof(Header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != s_Magic) {
+        return false;
+    }
+    // Anything else is stale rather than broken, the caller cooks it again
+    if (header.version != VERSION || header.submeshSize != sizeof(SubMeshData) || header.meshletSize != sizeof(Meshlet)) {
+        mSettingsHash = 0;
+        return true;
+    }
+    for (const SectionRange& range : header.sections) {
+        if (range.offset > size || range.size > size - range.offset) {
+            return false;
+        }
+    }
+
+    std::vector<SourceRecord> sources;
+    std::vector<MaterialRecord> materials;
+    std::vector<TextureRecord> textures;
+    std::vector<NodeRecord> nodes;
+    std::vector<char> strings;
+    if (!ReadSection(header, Sources, data, sources) ||
+        !ReadSection(header, Materials, data, materials) ||
+        !ReadSection(header, Textures, data, textures) ||
+        !ReadSection(header, Submeshes, data, mSubmeshes) ||
+        !ReadSection(header, Meshlets, data, mMeshlets) ||
+        !ReadSection(header, Nodes, data, nodes) ||
+        !ReadSection(header, Strings, data, strings)) {
+        return false;
+    }
+    auto getString = [&](const uint32_t offset, const uint32_t length, std::string& out) {
+        if (offset > strings.size() || length > strings.size() - offset) return false;
+        out.assign(strings.data() + offset, length);
+        return true;
+    };
+
+    mSources.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!getString(sources[i].nameOffset, sources[i].nameLength, mSources[i].filename)) return false;
+        mSources[i].size = sources[i].size;
+        mSources[i].modifiedTime = sources[i].modifiedTime;
+    }
+    mMaterials.resize(materials.size());
+    for (size_t i = 0; i < materials.size(); ++i) {
+        const MaterialRecord& record = materials[i];
+        if (record.firstTexture > textures.size() || record.numTextures > textures.size() - record.firstTexture) return false;
+        mMaterials[i].bDoubleSided = record.bDoubleSided != 0;
+        mMaterials[i].textures.resize(record.numTextures);
+        for (uint32_t t = 0; t < record.numTextures; ++t) {
+            const TextureRecord& texture = textures[record.firstTexture + t];
+            TextureReference& reference = mMaterials[i].textures[t];
+            reference.type = static_cast<aiTextureType>(texture.type);
+            reference.bUseFallback = texture.bUseFallback != 0;
+            if (!getString(texture.nameOffset, texture.nameLength, reference.filename)) return false;
+        }
+    }
+    mNodes.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        mNodes[i].parentId = nodes[i].parentId;
+        mNodes[i].id = nodes[i].id;
+        mNodes[i].transformation = nodes[i].transformation;
+    }
+
+    // The vertex and index blobs are used in place, or decoded from it
+    mIsCompressed = header.bCompressedGeometry != 0;
+    mVertexData = data + header.sections[Vertices].offset;
+    mVertexSectionSize = header.sections[Vertices].size;
+    mIndexData = data + header.sections[Indices].offset;
+    mIndexSectionSize = header.sections[Indices].size;
+    mVertexDataSize = header.vertexDataSize;
+    mIndexDataSize = header.indexDataSize;
+    if (mVertexDataSize % sizeof(PackedVertex) != 0) {
+        return false;
+    }
+    if (!mIsCompressed && (mVertexSectionSize != mVertexDataSize || mIndexSectionSize != mIndexDataSize)) {
+        return false;
+    }
+
+    mSettingsHash = header.settingsHash;
+    mNumVertices = header.numVertices;
+    mNumIndices = header.numIndices;
+    mDoNotRender = header.bDoNotRender != 0;
+    return true;
+}
+
+bool MeshFile::ReadVertexData(void* dst) const {
+    if (!mIsCompressed) {
+        std::memcpy(dst, mVertexData, mVertexDataSize);
+        return true;
+    }
+    return GeometryCodec::DecodeVertices(dst, mVertexDataSize / sizeof(PackedVertex), sizeof(PackedVertex), mVertexData, mVertexSectionSize);
+}
+
+bool MeshFile::ReadIndexData(void* dst) const {
+    if (!mIsCompressed) {
+        std::memcpy(dst, mIndexData, mIndexDataSize);
+        return true;
+    }
+    return DecodeIndexData(mSubmeshes, mIndexData, mIndexSectionSize, static_cast<uint8_t*>(dst), mIndexDataSize);
+}
+
+bool MeshFile::IsCurrent(const uint64_t settingsHash) const {
+    if (mSettingsHash == 0 || mSettingsHash != settingsHash) {
+        return false;
+    }
+    if (mIsPacked) {
+        return true;
+    }
+    // Nothing is read, the sources would cost as much as loading them. SandCastleCook's mirror
+    // keeps modification times, and hashes contents itself before cooking.
+    for (const Source& source : mSources) {
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        if (!GetFileStamp(std::filesystem::path(mDirectory) / source.filename, size, modifiedTime)
+            || size != source.size || modifiedTime != source.modifiedTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MeshFile::GetMesh(MeshData& outMesh) const {
+    outMesh.submeshes = mSubmeshes;
+    outMesh.meshlets = mMeshlets;
+    outMesh.nodeMap.clear();
+    for (const SceneNode& node : mNodes) {
+        outMesh.nodeMap[node.id] = node;
+    }
+    for (const SceneNode& node : mNodes) {
+        if (node.parentId >= 0) outMesh.nodeMap[node.parentId].childIds.push_back(node.id);
+    }
+    outMesh.materials.resize(mMaterials.size());
+    for (size_t i = 0; i < mMaterials.size(); ++i) {
+        outMesh.materials[i].isDoubleSided = mMaterials[i].bDoubleSided;
+    }
+    outMesh.indexBufferSize = mIndexDataSize;
+    outMesh.numVertices = mNumVertices;
+    outMesh.numIndices = mNumIndices;
+    outMesh.bDoNotRender = mDoNotRender;
+}
+
+bool MeshFile::Write(const std::string& path, const MeshData& mesh, const std::vector<uint8_t>& indexData,
+        const std::vector<Material>& materials, const std::vector<std::string>& sources, const uint64_t settingsHash,
+        const bool bCompressGeometry) {
+    if (mesh.packedVertices.empty() || indexData.empty()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Can't cook %s, the mesh has no packed vertices or index layout", path.c_str());
+        return false;
+    }
+
+    Header header;
+    header.settingsHash = settingsHash;
+    header.numVertices = mesh.numVertices;
+    header.numIndices = static_cast<uint32_t>(mesh.indices.size());
+    header.bDoNotRender = mesh.bDoNotRender ? 1 : 0;
+    header.vertexDataSize = static_cast<uint32_t>(mesh.packedVertices.size() * sizeof(PackedVertex));
+    header.indexDataSize = static_cast<uint32_t>(indexData.size());
+    Writer writer;
+
+    std::vector<uint8_t> encodedVertices;
+    std::vector<uint8_t> encodedIndices;
+    if (bCompressGeometry) {
+        GeometryCodec::EncodeVertices(mesh.packedVertices.data(), mesh.packedVertices.size(), sizeof(PackedVertex), encodedVertices);
+        EncodeIndexData(mesh.submeshes, indexData, encodedIndices);
+        // Decoded again here, a codec bug would otherwise only show as broken geometry at load
+        std::vector<uint8_t> decodedVertices(header.vertexDataSize);
+        std::vector<uint8_t> decodedIndices(header.indexDataSize);
+        const bool bExact = GeometryCodec::DecodeVertices(decodedVertices.data(), mesh.packedVertices.size(), sizeof(PackedVertex), encodedVertices.data(), encodedVertices.size())
+            && DecodeIndexData(mesh.submeshes, encodedIndices.data(), encodedIndices.size(), decodedIndices.data(), decodedIndices.size())
+            && std::memcmp(decodedVertices.data(), mesh.packedVertices.data(), decodedVertices.size()) == 0
+            && std::memcmp(decodedIndices.data(), indexData.data(), decodedIndices.size()) == 0;
+        if (bExact) {
+            header.bCompressedGeometry = 1;
+        }
+        else {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Geometry of %s doesn't decode back exactly, storing it uncompressed", path.c_str());
+        }
+    }
+
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    std::vector<SourceRecord> sourceRecords;
+    for (const std::string& source : sources) {
+        SourceRecord& record = sourceRecords.emplace_back();
+        record.nameOffset = writer.AddString(source);
+        record.nameLength = static_cast<uint32_t>(source.size());
+        if (!GetFileStamp(directory / source, record.size, record.modifiedTime)) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Can't cook %s, source %s is unreadable", path.c_str(), source.c_str());
+            return false;
+        }
+    }
+
+    std::vector<MaterialRecord> materialRecords;
+    std::vector<TextureRecord> textureRecords;
+    for (const Material& material : materials) {
+        materialRecords.push_back({
+            .bDoubleSided = material.bDoubleSided ? 1u : 0u,
+            .firstTexture = static_cast<uint32_t>(textureRecords.size()),
+            .numTextures = static_cast<uint32_t>(material.textures.size()),
+        });
+        for (const TextureReference& texture : material.textures) {
+            textureRecords.push_back({
+                .type = static_cast<uint32_t>(texture.type),
+                .nameOffset = writer.AddString(texture.filename),
+                .nameLength = static_cast<uint32_t>(texture.filename.size()),
+                .bUseFallback = texture.bUseFallback ? 1u : 0u,
+            });
+        }
+    }
+
+    std::vector<NodeRecord> nodeRecords;
+    nodeRecords.reserve(mesh.nodeMap.size());
+    for (const auto& [id, node] : mesh.nodeMap) {
+        nodeRecords.push_back({ .id = node.id, .parentId = node.parentId, .transformation = node.transformation });
+    }
+
+    writer.AddSection(header, Sources, sourceRecords.data(), sourceRecords.size());
+    writer.AddSection(header, Materials, materialRecords.data(), materialRecords.size());
+    writer.AddSection(header, Textures, textureRecords.data(), textureRecords.size());
+    writer.AddSection(header, Submeshes, mesh.submeshes.data(), mesh.submeshes.size());
+    writer.AddSection(header, Meshlets, mesh.meshlets.data(), mesh.meshlets.size());
+    writer.AddSection(header, Nodes, nodeRecords.data(), nodeRecords.size());
+    writer.AddSection(header, Strings, writer.GetStrings().data(), writer.GetStrings().size());
+    if (header.bCompressedGeometry) {
+        writer.AddSection(header, Vertices, encodedVertices.data(), encodedVertices.size());
+        writer.AddSection(header, Indices, encodedIndices.data(), encodedIndices.size());
+    }
+    else {
+        writer.AddSection(header, Vertices, mesh.packedVertices.data(), mesh.packedVertices.size());
+        writer.AddSection(header, Indices, indexData.data(), indexData.size());
+    }
+    std::vector<uint8_t>& bytes = writer.GetBytes();
+    std::memcpy(bytes.data(), &header, sizeof(Header));
+
+    // Written aside and moved into place, so a reader never maps a half written file
+    const std::string tempPath = path + ".tmp";
+    if (!SDL_SaveFile(tempPath.c_str(), bytes.data(), bytes.size())) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write cooked mesh %s: %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write cooked mesh %s: %s", path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <assimp/material.h>
+#include <ContentPack.h>
+#include <MappedFile.h>
+#include <Render/RenderStructs.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A model cooked down to what MeshData is built from, so loading it needs neither Assimp nor
+// any per-vertex work.
+//  - Load maps the file. Vertex and index data are read straight from the mapping, already in
+//    their GPU layout: packed vertices, and the index buffer as LayoutIndexBuffer arranges it.
+//    Given a ContentPack holding the file, it's read from the pack's mapping instead.
+//  - Write stores a loaded mesh along with its material texture references. The vertex and index
+//    data can be stored GeometryCodec encoded, which ReadVertexData and ReadIndexData decode into
+//    the caller's (staging) memory instead of copying.
+//  - A file is stale when its version or settings hash differ, or when any source it was cooked
+//    from (files next to it) changed size or modification time. Sources aren't read, checking
+//    would cost as much as the import the cooked file saves. A packed file only checks its
+//    version and settings, packs hold cooked files without their sources.
+// Sections start 16 byte aligned so the blobs can be copied into transfer buffers as they are.
+class MeshFile {
+public:
+    static constexpr uint32_t VERSION = 5;
+    static constexpr const char* EXTENSION = ".scmesh";
+
+    // A texture a material samples, by the name the source model uses
+    struct TextureReference {
+        aiTextureType type = aiTextureType_NONE;
+        std::string filename;
+        bool bUseFallback = false;
+    };
+
+    struct Material {
+        bool bDoubleSided = false;
+        std::vector<TextureReference> textures;
+    };
+
+    // Where the cooked file for a source model lives: next to it, with the cooked extension
+    static std::string GetCookedPath(const std::string& sourcePath);
+
+    bool Load(const std::string& path);
+    // False if the pack doesn't have the file either
+    bool Load(const std::string& path, const ContentPack& contentPack);
+    // Whether the file matches the settings and the sources on disk
+    bool IsCurrent(const uint64_t settingsHash) const;
+
+    // Fills in everything but the vertex and index data, which stay in the mapping
+    void GetMesh(MeshData& outMesh) const;
+    const std::vector<Material>& GetMaterials() const { return mMaterials; }
+    // Sizes as uploaded, whether or not the file is compressed
+    uint32_t GetVertexDataSize() const { return mVertexDataSize; }
+    uint32_t GetIndexDataSize() const { return mIndexDataSize; }
+    // Write GetVertexDataSize / GetIndexDataSize bytes to dst. False if compressed data is corrupt.
+    bool ReadVertexData(void* dst) const;
+    bool ReadIndexData(void* dst) const;
+    bool IsCompressed() const { return mIsCompressed; }
+    // What the vertex and index data take in the file
+    uint64_t GetStoredGeometrySize() const { return mVertexSectionSize + mIndexSectionSize; }
+
+    // indexData is the mesh's index buffer as uploaded. sources are file names in the directory
+    // of path, checked by IsCurrent. With bCompressGeometry the vertex and index data are stored
+    // encoded, unless the encoding doesn't decode back to them exactly.
+    static bool Write(const std::string& path, const MeshData& mesh, const std::vector<uint8_t>& indexData,
+        const std::vector<Material>& materials, const std::vector<std::string>& sources, const uint64_t settingsHash,
+        const bool bCompressGeometry = false);
+
+private:
+    struct Source {
+        std::string filename;
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+    };
+
+    bool Parse(const uint8_t* data, const size_t size);
+
+    MappedFile mFile;
+    std::string mDirectory;
+    bool mIsPacked = false;
+    uint64_t mSettingsHash = 0;
+    std::vector<Source> mSources;
+    std::vector<Material> mMaterials;
+    std::vector<SubMeshData> mSubmeshes;
+    std::vector<Meshlet> mMeshlets;
+    std::vector<SceneNode> mNodes;
+    uint32_t mNumVertices = 0;
+    uint32_t mNumIndices = 0;
+    bool mDoNotRender = false;
+    bool mIsCompressed = false;
+    const uint8_t* mVertexData = nullptr; // the sections in the mapping
+    uint64_t mVertexSectionSize = 0;
+    const uint8_t* mIndexData = nullptr;
+    uint64_t mIndexSectionSize = 0;
+    uint32_t mVertexDataSize = 0;
+    uint32_t mIndexDataSize = 0;
+};
@@ -0,0 +1,202 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    // Triangles adjacent to each vertex (CSR)
+    struct Adjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        Adjacency(const std::vector<uint32_t>& indices, const size_t vertexCount) : offsets(vertexCount + 1, 0) {
+            for (uint32_t index : indices) ++offsets[index + 1];
+            for (size_t i = 0; i < vertexCount; ++i) offsets[i + 1] += offsets[i];
+            triangles.resize(indices.size());
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) {
+                triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+    };
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount) {
+    std::vector<uint32_t> clusters;
+    const size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0) return clusters;
+
+    const Adjacency adjacency(indices, vertexCount);
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) liveTriangles[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> bEmitted(numTriangles, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    const uint32_t cacheSize = s_VertexCacheSize;
+    uint32_t time = cacheSize + 1;
+    uint32_t cursor = 0;
+
+    // Vertices still waiting on triangles, most recently pushed first, then in input order
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty()) {
+            const uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0) return vertex;
+        }
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) return cursor;
+            ++cursor;
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    bool bNewCluster = true;
+    while (fanning >= 0) {
+        if (bNewCluster) clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+
+        candidates.clear();
+        const uint32_t vertex = static_cast<uint32_t>(fanning);
+        for (uint32_t a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; ++a) {
+            const uint32_t triangle = adjacency.triangles[a];
+            if (bEmitted[triangle]) continue;
+            bEmitted[triangle] = true;
+            for (uint32_t k = 0; k < 3; ++k) {
+                const uint32_t v = indices[triangle * 3 + k];
+                result.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+
+        // Next fanning vertex: the one-ring vertex that will still be in the cache after its
+        // remaining triangles are emitted, preferring the oldest such entry
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) continue;
+            int64_t priority = 0;
+            if (static_cast<int64_t>(time) - cacheTime[v] + 2 * static_cast<int64_t>(liveTriangles[v]) <= cacheSize) {
+                priority = time - cacheTime[v];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        bNewCluster = next < 0;
+        fanning = bNewCluster ? skipDeadEnd() : next;
+    }
+
+    indices = std::move(result);
+    return clusters;
+}
+
+void MeshOptimizer::OptimizeOverdraw(
+        std::vector<uint32_t>& indices,
+        const Vertex* vertices,
+        const size_t vertexCount,
+        const std::vector<uint32_t>& clusters) {
+    const size_t numTriangles = indices.size() / 3;
+    if (clusters.size() <= 1 || vertexCount == 0) return;
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    struct Cluster {
+        uint32_t first = 0;
+        uint32_t last = 0; // exclusive
+        float sortKey = 0.0f;
+    };
+    std::vector<Cluster> sortedClusters(clusters.size());
+    std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster& cluster = sortedClusters[c];
+        cluster.first = clusters[c];
+        cluster.last = (c + 1 < clusters.size()) ? clusters[c + 1] : static_cast<uint32_t>(numTriangles);
+
+        float clusterArea = 0.0f;
+        for (uint32_t t = cluster.first; t < cluster.last; ++t) {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            const glm::vec3 n = glm::cross(p1 - p0, p2 - p0); // length = 2 * area
+            const float area = glm::length(n);
+            const glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+            centroids[c] += center * area;
+            normals[c] += n;
+            clusterArea += area;
+            meshCentroid += center * area;
+            meshArea += area;
+        }
+        if (clusterArea > 0.0f) centroids[c] /= clusterArea;
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+    // Clusters far out along their own normal are likely on the outside of the mesh
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        const float length = glm::length(normals[c]);
+        const glm::vec3 normal = length > 0.0f ? normals[c] / length : glm::vec3(0.0f);
+        sortedClusters[c].sortKey = glm::dot(centroids[c] - meshCentroid, normal);
+    }
+    std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& l, const Cluster& r) {
+        return l.sortKey > r.sortKey;
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster : sortedClusters) {
+        result.insert(result.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.last * 3);
+    }
+    indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, Vertex* vertices, const size_t vertexCount) {
+    constexpr uint32_t unassigned = UINT32_MAX;
+    std::vector<uint32_t> remap(vertexCount, unassigned);
+    uint32_t nextVertex = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == unassigned) remap[index] = nextVertex++;
+        index = remap[index];
+    }
+    for (uint32_t& target : remap) {
+        if (target == unassigned) target = nextVertex++;
+    }
+
+    std::vector<Vertex> reordered(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) reordered[remap[i]] = vertices[i];
+    std::copy(reordered.begin(), reordered.end(), vertices);
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount) {
+    VertexCacheStats stats{};
+    if (indexCount < 3 || vertexCount == 0) return stats;
+
+    // A vertex is in the FIFO while fewer than s_VertexCacheSize misses happened since it was loaded
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    std::vector<bool> bReferenced(vertexCount, false);
+    uint32_t numReferenced = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        const uint32_t index = indices[i];
+        if (!bReferenced[index]) {
+            bReferenced[index] = true;
+            ++numReferenced;
+        }
+        if (loadedAt[index] == 0 || stats.numTransformed - loadedAt[index] >= s_VertexCacheSize) {
+            ++stats.numTransformed;
+            loadedAt[index] = stats.numTransformed;
+        }
+    }
+    stats.acmr = static_cast<float>(stats.numTransformed) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(stats.numTransformed) / static_cast<float>(numReferenced);
+    return stats;
+}
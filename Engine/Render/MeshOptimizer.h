@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <vector>
+
+// Import time reordering of triangle lists for the GPU.
+// Run per submesh in this order: vertex cache, overdraw, vertex fetch.
+//  - OptimizeVertexCache reorders triangles with Tipsify (Sander et al. 2007) so consecutive
+//    triangles reuse recently transformed vertices, and reports where the order had to jump.
+//  - OptimizeOverdraw sorts those clusters so outward facing clusters on the hull of the mesh
+//    are drawn first and occlude the rest, keeping the order inside each cluster.
+//  - OptimizeVertexFetch renumbers vertices in first use order so fetches walk memory linearly.
+namespace MeshOptimizer {
+    // Post-transform cache size assumed by the optimizer and the analyzer
+    constexpr uint32_t s_VertexCacheSize = 16;
+
+    struct VertexCacheStats {
+        uint32_t numTransformed = 0; // cache misses
+        float acmr = 0.0f;           // average cache miss ratio, transformed vertices per triangle (0.5 .. 3)
+        float atvr = 0.0f;           // average transform to vertex ratio, transformed / referenced vertices (1 is optimal)
+    };
+
+    // Returns the first triangle of each cluster (a run of triangles emitted without a cache flush)
+    std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount);
+
+    void OptimizeOverdraw(
+        std::vector<uint32_t>& indices,
+        const Vertex* vertices,
+        const size_t vertexCount,
+        const std::vector<uint32_t>& clusters);
+
+    // Reorders vertices and rewrites indices. Vertices that are never referenced are moved to the end.
+    void OptimizeVertexFetch(std::vector<uint32_t>& indices, Vertex* vertices, const size_t vertexCount);
+
+    // Simulates a FIFO post-transform cache
+    VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount);
+}
@@ -0,0 +1,268 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+    // Symmetric 4x4 error quadric, weighted so that Evaluate()/weight is a mean squared distance
+    struct Quadric {
+        float a2 = 0, ab = 0, ac = 0, ad = 0;
+        float b2 = 0, bc = 0, bd = 0;
+        float c2 = 0, cd = 0;
+        float d2 = 0;
+        float weight = 0;
+
+        void AddPlane(const glm::vec3& n, const float d, const float w) {
+            a2 += n.x * n.x * w; ab += n.x * n.y * w; ac += n.x * n.z * w; ad += n.x * d * w;
+            b2 += n.y * n.y * w; bc += n.y * n.z * w; bd += n.y * d * w;
+            c2 += n.z * n.z * w; cd += n.z * d * w;
+            d2 += d * d * w;
+            weight += w;
+        }
+
+        void Add(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+            weight += q.weight;
+        }
+
+        float Evaluate(const glm::vec3& p) const {
+            const float rx = a2 * p.x + ab * p.y + ac * p.z + ad;
+            const float ry = ab * p.x + b2 * p.y + bc * p.z + bd;
+            const float rz = ac * p.x + bc * p.y + c2 * p.z + cd;
+            const float r = rx * p.x + ry * p.y + rz * p.z + ad * p.x + bd * p.y + cd * p.z + d2;
+            return std::max(r, 0.0f);
+        }
+    };
+
+    struct Collapse {
+        uint32_t from = 0; // welded vertex ids
+        uint32_t to = 0;
+        float errorSq = 0.0f;
+    };
+
+    // Boundary planes are weighted up so borders keep their silhouette
+    constexpr float s_BorderWeight = 10.0f;
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b) {
+        if (a > b) std::swap(a, b);
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const {
+            return (Bits(p.x) * 73856093u) ^ (Bits(p.y) * 19349663u) ^ (Bits(p.z) * 83492791u);
+        }
+        // -0 and 0 compare equal, so they have to hash the same
+        static uint32_t Bits(const float c) { return std::bit_cast<uint32_t>(c == 0.0f ? 0.0f : c); }
+    };
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(
+        const Vertex* vertices,
+        const size_t vertexCount,
+        const std::vector<uint32_t>& indices,
+        const size_t targetIndexCount,
+        const float maxError,
+        float& outError) {
+    outError = 0.0f;
+    std::vector<uint32_t> result = indices;
+    if (indices.size() <= targetIndexCount || vertexCount == 0) return result;
+
+    // Weld vertices by position, the error metric and topology work on welded ids
+    std::vector<uint32_t> weld(vertexCount);
+    std::vector<glm::vec3> positions;
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash> positionIds;
+        positionIds.reserve(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            auto [it, bInserted] = positionIds.try_emplace(vertices[i].position, static_cast<uint32_t>(positions.size()));
+            if (bInserted) positions.push_back(vertices[i].position);
+            weld[i] = it->second;
+        }
+    }
+    const size_t numWelded = positions.size();
+
+    // Face quadrics, area weighted
+    std::vector<Quadric> quadrics(numWelded);
+    for (size_t t = 0; t + 2 < result.size(); t += 3) {
+        const glm::vec3& p0 = positions[weld[result[t + 0]]];
+        const glm::vec3& p1 = positions[weld[result[t + 1]]];
+        const glm::vec3& p2 = positions[weld[result[t + 2]]];
+        const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float area2 = glm::length(n);
+        if (area2 <= 0.0f) continue;
+        const glm::vec3 normal = n / area2;
+        const float d = -glm::dot(normal, p0);
+        for (size_t k = 0; k < 3; ++k) {
+            quadrics[weld[result[t + k]]].AddPlane(normal, d, area2 * 0.5f);
+        }
+    }
+
+    // Border edges (only one adjacent triangle in welded space) get a perpendicular constraint plane
+    std::vector<bool> bBorderVertex(numWelded, false);
+    std::unordered_map<uint64_t, uint32_t> edgeCounts;
+    auto countEdges = [&](const std::vector<uint32_t>& tris) {
+        edgeCounts.clear();
+        edgeCounts.reserve(tris.size());
+        for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                ++edgeCounts[EdgeKey(weld[tris[t + k]], weld[tris[t + (k + 1) % 3]])];
+            }
+        }
+    };
+    countEdges(result);
+    for (size_t t = 0; t + 2 < result.size(); t += 3) {
+        const glm::vec3& p0 = positions[weld[result[t + 0]]];
+        const glm::vec3& p1 = positions[weld[result[t + 1]]];
+        const glm::vec3& p2 = positions[weld[result[t + 2]]];
+        const glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+        for (size_t k = 0; k < 3; ++k) {
+            const uint32_t a = weld[result[t + k]];
+            const uint32_t b = weld[result[t + (k + 1) % 3]];
+            if (edgeCounts[EdgeKey(a, b)] != 1) continue;
+            bBorderVertex[a] = true;
+            bBorderVertex[b] = true;
+
+            const glm::vec3 edge = positions[b] - positions[a];
+            const glm::vec3 n = glm::cross(edge, faceNormal);
+            const float length = glm::length(n);
+            if (length <= 0.0f) continue;
+            const glm::vec3 normal = n / length;
+            const float d = -glm::dot(normal, positions[a]);
+            const float w = glm::dot(edge, edge) * s_BorderWeight;
+            quadrics[a].AddPlane(normal, d, w);
+            quadrics[b].AddPlane(normal, d, w);
+        }
+    }
+
+    const float maxErrorSq = maxError * maxError;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> ringOffsets(numWelded + 1);
+    std::vector<uint32_t> ringTriangles;
+    std::vector<bool> bLocked(numWelded);
+    std::vector<uint32_t> vertexTarget(vertexCount);
+
+    while (result.size() > targetIndexCount) {
+        const size_t numTriangles = result.size() / 3;
+
+        // Triangle rings per welded vertex (CSR)
+        std::fill(ringOffsets.begin(), ringOffsets.end(), 0);
+        for (uint32_t index : result) ++ringOffsets[weld[index] + 1];
+        for (size_t i = 0; i < numWelded; ++i) ringOffsets[i + 1] += ringOffsets[i];
+        ringTriangles.resize(result.size());
+        {
+            std::vector<uint32_t> cursor(ringOffsets.begin(), ringOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i) {
+                ringTriangles[cursor[weld[result[i]]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+        countEdges(result);
+
+        // Candidate half-edge collapses, both directions of every edge
+        collapses.clear();
+        for (size_t t = 0; t < numTriangles; ++t) {
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t a = weld[result[t * 3 + k]];
+                const uint32_t b = weld[result[t * 3 + (k + 1) % 3]];
+                if (a == b) continue;
+                const bool bBorderEdge = edgeCounts[EdgeKey(a, b)] == 1;
+                for (const auto& [from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+                    // Border vertices may only slide along the border
+                    if (bBorderVertex[from] && !(bBorderEdge && bBorderVertex[to])) continue;
+                    Quadric q = quadrics[from];
+                    q.Add(quadrics[to]);
+                    const float errorSq = (q.weight > 0.0f) ? q.Evaluate(positions[to]) / q.weight : 0.0f;
+                    if (errorSq > maxErrorSq) continue;
+                    collapses.push_back({from, to, errorSq});
+                }
+            }
+        }
+        if (collapses.empty()) break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) {
+            return l.errorSq < r.errorSq;
+        });
+
+        std::fill(bLocked.begin(), bLocked.end(), false);
+        for (size_t i = 0; i < vertexCount; ++i) vertexTarget[i] = static_cast<uint32_t>(i);
+
+        size_t trianglesLeft = numTriangles;
+        const size_t targetTriangles = targetIndexCount / 3;
+        size_t numApplied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (trianglesLeft <= targetTriangles) break;
+            if (bLocked[collapse.from] || bLocked[collapse.to]) continue;
+
+            // Pair every attribute variant of 'from' with a variant of 'to' it shares a triangle with,
+            // and make sure no remaining triangle flips
+            bool bValid = true;
+            size_t numRemoved = 0;
+            std::vector<std::pair<uint32_t, uint32_t>> pairs;
+            for (uint32_t r = ringOffsets[collapse.from]; r < ringOffsets[collapse.from + 1] && bValid; ++r) {
+                const uint32_t* tri = &result[ringTriangles[r] * 3];
+                uint32_t fromCorner = 3;
+                uint32_t toCorner = 3;
+                for (uint32_t k = 0; k < 3; ++k) {
+                    if (weld[tri[k]] == collapse.from) fromCorner = k;
+                    if (weld[tri[k]] == collapse.to) toCorner = k;
+                }
+                if (fromCorner == 3) continue; // degenerate leftover
+                if (toCorner != 3) {
+                    pairs.emplace_back(tri[fromCorner], tri[toCorner]);
+                    ++numRemoved;
+                    continue;
+                }
+
+                const glm::vec3 p0 = positions[weld[tri[0]]];
+                const glm::vec3 p1 = positions[weld[tri[1]]];
+                const glm::vec3 p2 = positions[weld[tri[2]]];
+                const glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+                glm::vec3 moved[3] = {p0, p1, p2};
+                moved[fromCorner] = positions[collapse.to];
+                const glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                if (glm::dot(before, after) <= 0.0f) bValid = false;
+            }
+            if (!bValid || pairs.empty()) continue;
+
+            for (uint32_t r = ringOffsets[collapse.from]; r < ringOffsets[collapse.from + 1] && bValid; ++r) {
+                const uint32_t* tri = &result[ringTriangles[r] * 3];
+                for (uint32_t k = 0; k < 3; ++k) {
+                    if (weld[tri[k]] != collapse.from) continue;
+                    const bool bPaired = std::any_of(pairs.begin(), pairs.end(), [&](const auto& pair) { return pair.first == tri[k]; });
+                    if (!bPaired) bValid = false;
+                }
+            }
+            if (!bValid) continue;
+
+            for (const auto& [from, to] : pairs) vertexTarget[from] = to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            for (uint32_t r = ringOffsets[collapse.from]; r < ringOffsets[collapse.from + 1]; ++r) {
+                const uint32_t* tri = &result[ringTriangles[r] * 3];
+                for (uint32_t k = 0; k < 3; ++k) bLocked[weld[tri[k]]] = true;
+            }
+            trianglesLeft -= numRemoved;
+            outError = std::max(outError, std::sqrt(collapse.errorSq));
+            ++numApplied;
+        }
+        if (numApplied == 0) break;
+
+        // Apply the collapses and drop triangles that became degenerate
+        size_t write = 0;
+        for (size_t t = 0; t < numTriangles; ++t) {
+            const uint32_t i0 = vertexTarget[result[t * 3 + 0]];
+            const uint32_t i1 = vertexTarget[result[t * 3 + 1]];
+            const uint32_t i2 = vertexTarget[result[t * 3 + 2]];
+            if (weld[i0] == weld[i1] || weld[i1] == weld[i2] || weld[i0] == weld[i2]) continue;
+            result[write++] = i0;
+            result[write++] = i1;
+            result[write++] = i2;
+        }
+        result.resize(write);
+    }
+
+    return result;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <vector>
+
+// Quadric error mesh simplification (Garland & Heckbert) using half-edge collapses.
+// Vertices are never moved or created, a collapse u -> v rewires u's triangles to v,
+// so the simplified index buffer can be drawn against the original vertex buffer.
+//  - Vertices sharing a position (UV/normal seams) are welded for the error metric, and a
+//    collapse is only accepted if every attribute variant of u has a matching variant of v
+//    along the collapsed edge, which keeps seams intact.
+//  - Open borders only collapse along the border and carry extra boundary planes.
+//  - Collapses that would flip a triangle are rejected.
+namespace MeshSimplifier {
+    // Simplifies the triangle list until it has at most targetIndexCount indices or no collapse
+    // is possible within maxError (object space distance).
+    // Returns the new index list, outError receives the largest collapse error that was applied.
+    std::vector<uint32_t> Simplify(
+        const Vertex* vertices,
+        const size_t vertexCount,
+        const std::vector<uint32_t>& indices,
+        const size_t targetIndexCount,
+        const float maxError,
+        float& outError);
+}
@@ -0,0 +1,150 @@
+#include "MeshletCuller.h"
+
+#include <algorithm>
+#include <SDL3/SDL.h>
+
+static constexpr uint32_t s_MinDrawCapacity = 1024;
+
+void MeshletCuller::Release(SDL_GPUDevice* device) {
+    if (mDrawBuffer) SDL_ReleaseGPUBuffer(device, mDrawBuffer);
+    if (mTransferBuffer) SDL_ReleaseGPUTransferBuffer(device, mTransferBuffer);
+    mDrawBuffer = nullptr;
+    mTransferBuffer = nullptr;
+    mCapacity = 0;
+}
+
+void MeshletCuller::Begin(const glm::mat4& viewProjection, const glm::vec3& cameraPosition) {
+    mCommands.clear();
+    mCameraPosition = cameraPosition;
+
+    // Gribb/Hartmann plane extraction for a 0..1 depth range
+    auto row = [&](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+    mFrustumPlanes = {
+        row(3) + row(0), // left
+        row(3) - row(0), // right
+        row(3) + row(1), // bottom
+        row(3) - row(1), // top
+        row(2),          // near
+        row(3) - row(2), // far
+    };
+    for (glm::vec4& plane : mFrustumPlanes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool MeshletCuller::IsSphereVisible(const glm::vec3& center, const float radius) const {
+    for (const glm::vec4& plane : mFrustumPlanes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+    }
+    return true;
+}
+
+MeshletCuller::DrawRange MeshletCuller::CullSubmesh(
+        const MeshData& mesh,
+        const SubMeshData& submesh,
+        const glm::mat4& modelMatrix,
+        const bool bBackfaceCulling,
+        RenderPassStats& outStats) {
+    DrawRange range{};
+    range.firstCommand = static_cast<uint32_t>(mCommands.size());
+
+    const float scale = glm::max(glm::length(glm::vec3(modelMatrix[0])),
+        glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    // Cone axes are normals, so they go through the inverse transpose.
+    // Under non-uniform scale the cone angle isn't preserved exactly, which is fine for the scales used here.
+    const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+    const uint32_t lodFirstIndex = submesh.lods[0].firstIndex;
+
+    for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.numMeshlets; ++m) {
+        const Meshlet& meshlet = mesh.meshlets[m];
+        ++outStats.numMeshlets;
+
+        const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(meshlet.center, 1.0f));
+        const float radius = meshlet.radius * scale;
+        if (!IsSphereVisible(center, radius)) continue;
+
+        if (bBackfaceCulling && meshlet.coneCutoff < 1.0f) {
+            // Every triangle faces away when the camera is inside the cone opposite to the normal cone
+            const glm::vec3 axis = glm::normalize(normalMatrix * meshlet.coneAxis);
+            const glm::vec3 toCenter = center - mCameraPosition;
+            if (glm::dot(toCenter, axis) >= meshlet.coneCutoff * glm::length(toCenter) + radius) continue;
+        }
+        ++outStats.numMeshletsVisible;
+
+        // Meshlets are consecutive in the index buffer, so neighbours extend the previous draw
+        const uint32_t firstIndex = submesh.baseIndex + lodFirstIndex + meshlet.firstIndex;
+        if (range.numCommands > 0) {
+            SDL_GPUIndexedIndirectDrawCommand& previous = mCommands.back();
+            if (previous.first_index + previous.num_indices == firstIndex) {
+                previous.num_indices += meshlet.numIndices;
+                range.numIndices += meshlet.numIndices;
+                continue;
+            }
+        }
+        SDL_GPUIndexedIndirectDrawCommand command{};
+        command.num_indices = meshlet.numIndices;
+        command.num_instances = 1;
+        command.first_index = firstIndex;
+        command.vertex_offset = static_cast<Sint32>(submesh.baseVertex);
+        command.first_instance = 0;
+        mCommands.push_back(command);
+        ++range.numCommands;
+        range.numIndices += meshlet.numIndices;
+    }
+    return range;
+}
+
+bool MeshletCuller::Reserve(SDL_GPUDevice* device, const uint32_t numCommands) {
+    if (numCommands <= mCapacity && mDrawBuffer) return true;
+
+    Release(device);
+    uint32_t capacity = std::max(mCapacity, s_MinDrawCapacity);
+    while (capacity < numCommands) capacity *= 2;
+
+    SDL_GPUBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.usage = SDL_GPU_BUFFERUSAGE_INDIRECT;
+    bufferCreateInfo.size = capacity * sizeof(SDL_GPUIndexedIndirectDrawCommand);
+    mDrawBuffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+    if (!mDrawBuffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create meshlet draw buffer: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetGPUBufferName(device, mDrawBuffer, "Meshlet Draw Buffer");
+
+    SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo{};
+    transferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    transferBufferCreateInfo.size = bufferCreateInfo.size;
+    mTransferBuffer = SDL_CreateGPUTransferBuffer(device, &transferBufferCreateInfo);
+    if (!mTransferBuffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create meshlet draw transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    mCapacity = capacity;
+    return true;
+}
+
+bool MeshletCuller::Upload(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer) {
+    if (mCommands.empty()) return true;
+    if (!Reserve(device, static_cast<uint32_t>(mCommands.size()))) {
+        Release(device);
+        return false;
+    }
+
+    void* transferData = SDL_MapGPUTransferBuffer(device, mTransferBuffer, true);
+    if (!transferData) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to map meshlet draw transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    const Uint32 size = static_cast<Uint32>(mCommands.size() * sizeof(SDL_GPUIndexedIndirectDrawCommand));
+    SDL_memcpy(transferData, mCommands.data(), size);
+    SDL_UnmapGPUTransferBuffer(device, mTransferBuffer);
+
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    SDL_GPUTransferBufferLocation source{ mTransferBuffer, 0 };
+    SDL_GPUBufferRegion destination{ mDrawBuffer, 0, size };
+    SDL_UploadToGPUBuffer(copyPass, &source, &destination, true);
+    SDL_EndGPUCopyPass(copyPass);
+    return true;
+}
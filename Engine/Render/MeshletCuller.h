@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+#include <Render/RenderStructs.h>
+#include <SDL3/SDL_gpu.h>
+#include <vector>
+
+// CPU meshlet culling.
+// Every frame the meshlets of the submeshes drawn at full detail are tested against the view
+// frustum and their normal cone, and the survivors are written as indexed indirect draws
+// (adjacent survivors merged into one draw). The draws are uploaded before the scene passes,
+// which then issue one SDL_DrawGPUIndexedPrimitivesIndirect per submesh.
+class MeshletCuller {
+public:
+    // A submesh's slice of this frame's indirect draws
+    struct DrawRange {
+        uint32_t firstCommand = 0;
+        uint32_t numCommands = 0;
+        uint32_t numIndices = 0; // sum over the commands
+    };
+
+    void Release(SDL_GPUDevice* device);
+
+    // Starts a new frame of draws for the given camera
+    void Begin(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+    // World space sphere against the view frustum
+    bool IsSphereVisible(const glm::vec3& center, const float radius) const;
+
+    // Culls the meshlets of a submesh drawn with modelMatrix at LOD0 and appends draws for the visible ones.
+    // Backface (cone) culling is skipped for double sided materials.
+    DrawRange CullSubmesh(
+        const MeshData& mesh,
+        const SubMeshData& submesh,
+        const glm::mat4& modelMatrix,
+        const bool bBackfaceCulling,
+        RenderPassStats& outStats);
+
+    // Records a copy pass that uploads this frame's draws, growing the buffers when needed.
+    // On failure this frame's ranges must not be drawn.
+    bool Upload(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer);
+
+    SDL_GPUBuffer* GetDrawBuffer() const { return mDrawBuffer; }
+
+private:
+    bool Reserve(SDL_GPUDevice* device, const uint32_t numCommands);
+
+    std::array<glm::vec4, 6> mFrustumPlanes{}; // world space, xyz points inside
+    glm::vec3 mCameraPosition = {0.0f, 0.0f, 0.0f};
+    std::vector<SDL_GPUIndexedIndirectDrawCommand> mCommands;
+
+    SDL_GPUBuffer* mDrawBuffer = nullptr;
+    SDL_GPUTransferBuffer* mTransferBuffer = nullptr;
+    uint32_t mCapacity = 0; // in commands
+};
@@ -0,0 +1,88 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::vector<Meshlet> Meshlets::Build(const Vertex* vertices, const size_t vertexCount, const std::vector<uint32_t>& indices) {
+    std::vector<Meshlet> meshlets;
+    // Which meshlet last used a vertex, to count unique vertices without clearing a set
+    std::vector<uint32_t> vertexMeshlet(vertexCount, UINT32_MAX);
+    Meshlet current{};
+    uint32_t numVertices = 0;
+
+    auto flush = [&]() {
+        if (current.numIndices == 0) return;
+        ComputeBounds(vertices, indices, current);
+        meshlets.push_back(current);
+        current = Meshlet{};
+        current.firstIndex = static_cast<uint32_t>(meshlets.back().firstIndex + meshlets.back().numIndices);
+        numVertices = 0;
+    };
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+        uint32_t newVertices = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            newVertices += vertexMeshlet[indices[t + k]] != meshletId ? 1 : 0;
+        }
+        if (numVertices + newVertices > MESHLET_MAX_VERTICES || current.numIndices / 3 + 1 > MESHLET_MAX_TRIANGLES) {
+            flush();
+        }
+
+        const uint32_t id = static_cast<uint32_t>(meshlets.size());
+        for (size_t k = 0; k < 3; ++k) {
+            if (vertexMeshlet[indices[t + k]] != id) {
+                vertexMeshlet[indices[t + k]] = id;
+                ++numVertices;
+            }
+        }
+        current.numIndices += 3;
+    }
+    flush();
+    return meshlets;
+}
+
+void Meshlets::ComputeBounds(const Vertex* vertices, const std::vector<uint32_t>& indices, Meshlet& meshlet) {
+    const uint32_t first = meshlet.firstIndex;
+    const uint32_t last = meshlet.firstIndex + meshlet.numIndices;
+
+    // Sphere around the AABB center, tight enough for meshlets of this size
+    glm::vec3 boundsMin = vertices[indices[first]].position;
+    glm::vec3 boundsMax = boundsMin;
+    for (uint32_t i = first; i < last; ++i) {
+        boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+        boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+    }
+    meshlet.center = (boundsMin + boundsMax) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (uint32_t i = first; i < last; ++i) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+    }
+
+    // Normal cone: average face normal, opened up to the face normal furthest from it.
+    // Faces are oriented by their vertex normals, the winding isn't reliable after flipped imports.
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.numIndices / 3);
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = first; i + 2 < last; i += 3) {
+        const glm::vec3& p0 = vertices[indices[i + 0]].position;
+        const glm::vec3& p1 = vertices[indices[i + 1]].position;
+        const glm::vec3& p2 = vertices[indices[i + 2]].position;
+        const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float length = glm::length(n);
+        if (length <= 0.0f) continue;
+        const glm::vec3 shadingNormal = vertices[indices[i]].normal + vertices[indices[i + 1]].normal + vertices[indices[i + 2]].normal;
+        normals.push_back(glm::dot(n, shadingNormal) < 0.0f ? -n / length : n / length);
+        axis += normals.back();
+    }
+    meshlet.coneCutoff = 1.0f;
+    const float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength <= 0.0f) return;
+    meshlet.coneAxis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec3& n : normals) minDot = std::min(minDot, glm::dot(n, meshlet.coneAxis));
+    // Normals spread over more than a hemisphere can always have a front face
+    if (minDot <= 0.0f) return;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <vector>
+
+namespace Meshlets {
+    // Splits a triangle list into meshlets of at most MESHLET_MAX_VERTICES unique vertices and
+    // MESHLET_MAX_TRIANGLES triangles. Triangles are taken in order, so the index list should
+    // already be sorted for locality (see MeshOptimizer) and every meshlet stays a contiguous range.
+    std::vector<Meshlet> Build(const Vertex* vertices, const size_t vertexCount, const std::vector<uint32_t>& indices);
+
+    // Bounding sphere and normal cone of indices[firstIndex, firstIndex + numIndices)
+    void ComputeBounds(const Vertex* vertices, const std::vector<uint32_t>& indices, Meshlet& meshlet);
+}
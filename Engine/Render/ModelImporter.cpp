@@ -0,0 +1,542 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/MemoryIOWrapper.h>
+#include <assimp/mesh.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <bit>
+#include <cmath>
+#include <ContentPack.h>
+#include <filesystem>
+#include <queue>
+#include <Render/MeshFile.h>
+#include <Render/MeshOptimizer.h>
+#include <Render/Meshlets.h>
+#include <Render/MeshSimplifier.h>
+#include <Render/TextureCache.h>
+#include <Render/VertexPacking.h>
+#include <SDL3/SDL.h>
+#include <ThreadPool.h>
+
+static unsigned int s_ModelLoadingFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace;
+                                        //| aiProcess_TransformUVCoords | aiProcess_GenBoundingBoxes | aiProcess_CalcTangentSpace;
+// Mesh LOD generation stops below this many triangles, or past this fraction of the submesh bounds diagonal
+static constexpr size_t s_MinLodTriangles = 64;
+static constexpr float s_LodMaxRelativeError = 0.05f;
+
+// Hands Assimp files straight out of a ContentPack's mapping, and loose files it doesn't have
+class ContentPackIOSystem : public Assimp::DefaultIOSystem {
+public:
+    explicit ContentPackIOSystem(const ContentPack* contentPack) : mContentPack(contentPack) {}
+
+    bool Exists(const char* path) const override {
+        return mContentPack->Contains(path) || Assimp::DefaultIOSystem::Exists(path);
+    }
+
+    Assimp::IOStream* Open(const char* path, const char* mode = "rb") override {
+        size_t size = 0;
+        const uint8_t* data = mContentPack->Find(path, size);
+        if (data && mode[0] == 'r') {
+            // Doesn't own or copy the bytes
+            return new Assimp::MemoryIOStream(data, size, false);
+        }
+        return Assimp::DefaultIOSystem::Open(path, mode);
+    }
+
+private:
+    const ContentPack* mContentPack;
+};
+
+void ModelImporter::Init(ThreadPool* threadPool, const ContentPack* contentPack) {
+    mThreadPool = threadPool;
+    mContentPack = contentPack;
+}
+
+uint64_t ModelImporter::GetSettingsHash(const ImportSettings& settings) {
+    const uint64_t values[] = {
+        MeshFile::VERSION,
+        s_ModelLoadingFlags,
+        (settings.flipX ? 1u : 0u) | (settings.flipY ? 2u : 0u) | (settings.flipZ ? 4u : 0u),
+        s_MinLodTriangles,
+        std::bit_cast<uint32_t>(s_LodMaxRelativeError),
+        MAX_MESH_LODS,
+        MESHLET_MAX_VERTICES,
+        MESHLET_MAX_TRIANGLES,
+    };
+    // Never 0, which marks an unusable file
+    return TextureCache::HashContent(values, sizeof(values)) | 1;
+}
+
+std::vector<std::string> ModelImporter::GetSources(const std::string& path) {
+    const std::filesystem::path modelPath = path;
+    std::vector<std::string> sources{ modelPath.filename().string() };
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(modelPath.parent_path(), error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".bin") {
+            sources.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(sources.begin() + 1, sources.end());
+    return sources;
+}
+
+// glTF packs metalness, roughness and occlusion in one image, so shared images stay full color
+// to keep every channel.
+TextureEncoder::TextureRole ModelImporter::GetTextureRole(const std::set<aiTextureType>& types) {
+    if (types.size() == 1 && types.contains(aiTextureType_NORMALS)) {
+        return TextureEncoder::TextureRole::Normal;
+    }
+    if (types.size() == 1 && types.contains(aiTextureType_LIGHTMAP)) {
+        return TextureEncoder::TextureRole::SingleChannel;
+    }
+    return TextureEncoder::TextureRole::Color;
+}
+
+bool ModelImporter::Import(const std::string& path, const ImportSettings& settings, MeshData& outMesh, MeshLoadingContext& outContext) {
+    // Load the model. The importer owns and deletes the IO system.
+    if (mContentPack && mContentPack->IsOpen()) {
+        outContext.importer.SetIOHandler(new ContentPackIOSystem(mContentPack));
+    }
+    const aiScene* scene = outContext.importer.ReadFile(path, s_ModelLoadingFlags);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->HasMeshes()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load model: %s \nmodel filepath: %s", outContext.importer.GetErrorString(), path.c_str());
+        return false;
+    }
+    outContext.scene = scene;
+
+    ParseVertices(scene, settings.flipX, settings.flipY, settings.flipZ, outMesh, outContext);
+    OptimizeMeshIndices(outMesh);
+    BuildMeshlets(outMesh);
+    GenerateMeshLods(outMesh);
+    outMesh.numVertices = static_cast<uint32_t>(outMesh.vertices.size());
+    PackMeshVertices(outMesh);
+    LayoutIndexBuffer(outMesh);
+    ParseNodes(outMesh, outContext);
+    ParseMaterials(scene, outMesh, outContext);
+    ParseTextures(scene, outMesh, outContext);
+    //SDL_assert(outMesh.textureIdMap.size() == outContext.textureInfoMap.size());
+    outMesh.filepath = path;
+    outMesh.numIndices = static_cast<uint32_t>(outMesh.indices.size());
+    outMesh.bDoNotRender = scene->mNumTextures > 0;
+    return true;
+}
+
+bool ModelImporter::LoadCooked(const std::string& path, const ImportSettings& settings, MeshData& outMesh, MeshLoadingContext& outContext) {
+    // The packed file, unless it's stale: a model cooked again since the pack was built has the
+    // current file next to its source
+    const std::string cookedPath = MeshFile::GetCookedPath(path);
+    const uint64_t settingsHash = GetSettingsHash(settings);
+    auto cookedFile = std::make_shared<MeshFile>();
+    if (!mContentPack || !cookedFile->Load(cookedPath, *mContentPack) || !cookedFile->IsCurrent(settingsHash)) {
+        cookedFile = std::make_shared<MeshFile>();
+        if (!cookedFile->Load(cookedPath)) {
+            return false;
+        }
+        if (!cookedFile->IsCurrent(settingsHash)) {
+            SDL_Log("Cooked mesh of %s is stale", path.c_str());
+            return false;
+        }
+    }
+
+    cookedFile->GetMesh(outMesh);
+    for (const MeshFile::Material& material : cookedFile->GetMaterials()) {
+        MaterialLoadingContext& materialContext = outContext.materialInfos.emplace_back();
+        for (const MeshFile::TextureReference& texture : material.textures) {
+            TextureLoadingContext& textureContext = materialContext.textureContextMap[texture.type];
+            textureContext.type = texture.type;
+            textureContext.filename = texture.filename;
+            textureContext.bUseFallback = texture.bUseFallback;
+        }
+    }
+    outMesh.filepath = path;
+    outMesh.cookedFile = std::move(cookedFile);
+    SDL_Log("Loaded cooked mesh of %s: %u submeshes, %.1f KB of vertices, %.1f KB of indices%s (%.1f KB stored)",
+        path.c_str(),
+        static_cast<uint32_t>(outMesh.submeshes.size()),
+        static_cast<double>(outMesh.cookedFile->GetVertexDataSize()) / 1024.0,
+        static_cast<double>(outMesh.cookedFile->GetIndexDataSize()) / 1024.0,
+        outMesh.cookedFile->IsCompressed() ? ", compressed" : "",
+        static_cast<double>(outMesh.cookedFile->GetStoredGeometrySize()) / 1024.0);
+    return true;
+}
+
+bool ModelImporter::Cook(const std::string& path, const ImportSettings& settings, const MeshData& mesh, const MeshLoadingContext& context,
+        const bool bCompressGeometry) {
+    std::vector<MeshFile::Material> materials(context.materialInfos.size());
+    for (size_t i = 0; i < context.materialInfos.size(); ++i) {
+        materials[i].bDoubleSided = mesh.materials[i].isDoubleSided;
+        for (aiTextureType type : s_TextureTypes) {
+            const TextureLoadingContext& textureContext = context.materialInfos[i].textureContextMap.at(type);
+            materials[i].textures.push_back({ .type = type, .filename = textureContext.filename, .bUseFallback = textureContext.bUseFallback });
+        }
+    }
+
+    std::vector<uint8_t> indexData(mesh.indexBufferSize);
+    WriteIndexBuffer(mesh, indexData.data());
+    const std::string cookedPath = MeshFile::GetCookedPath(path);
+    if (!MeshFile::Write(cookedPath, mesh, indexData, materials, GetSources(path), GetSettingsHash(settings), bCompressGeometry)) {
+        return false;
+    }
+    SDL_Log("Cooked %s to %s", path.c_str(), cookedPath.c_str());
+    return true;
+}
+
+void ModelImporter::ParseNodes(MeshData& outMesh, MeshLoadingContext& outContext) {
+    int totalChildMeshes = 0;
+    int parentId = -1;
+    int nodeId = 0;
+    NodeLoadingContext rootNode(outContext.scene->mRootNode);
+    std::queue<NodeLoadingContext> queue;
+    queue.push(rootNode);
+    while (!queue.empty()) {
+        NodeLoadingContext& curr = queue.front();
+        outContext.nodeInfoMap.emplace(curr.pNode->mName.C_Str(), curr);
+        queue.pop();
+
+        SceneNode scenenode{parentId, nodeId};
+
+        // Assign this node's ID to its meshes
+        for (unsigned int m = 0; m < curr.pNode->mNumMeshes; ++m) {
+            unsigned int meshIndex = curr.pNode->mMeshes[m];
+            if (meshIndex < outMesh.submeshes.size()) {
+                outMesh.submeshes[meshIndex].nodeId = nodeId;
+            }
+        }
+        totalChildMeshes += curr.pNode->mNumMeshes;
+        // Copy Assimp's row-major matrix to GLM's column-major format
+        const aiMatrix4x4& m = curr.pNode->mTransformation;
+        glm::mat4 nodeTransform(
+            m.a1, m.b1, m.c1, m.d1,
+            m.a2, m.b2, m.c2, m.d2,
+            m.a3, m.b3, m.c3, m.d3,
+            m.a4, m.b4, m.c4, m.d4
+        );
+        scenenode.transformation = nodeTransform;
+
+        outMesh.nodeMap.emplace(nodeId, scenenode);
+        parentId = nodeId;
+        ++nodeId;
+
+        // Queue child nodes
+        for (size_t i = 0; i < curr.pNode->mNumChildren; ++i) {
+            NodeLoadingContext child(curr.pNode->mChildren[i]);
+            queue.push(child);
+        }
+    }
+    //SDL_assert(totalChildMeshes == outContext.scene->mNumMeshes);
+    if (totalChildMeshes == outContext.scene->mNumMeshes) {
+        UpdateCachedTransformations(outMesh);
+    }
+    else {
+        SDL_LogWarn(SDL_LOG_CATEGORY_CUSTOM, "WARNING: Model has mismatch between number of meshes and meshes in nodes [%i] != [%i]", outContext.scene->mNumMeshes, totalChildMeshes);
+        
+        for (size_t i = 0; i < outContext.scene->mNumMeshes; ++i) {
+            outMesh.submeshes[i].transformation = glm::mat4(1.0f);
+        }
+    }
+}
+
+void ModelImporter::ParseVertices(const aiScene* scene, const bool flipX, const bool flipY, const bool flipZ, MeshData& outMesh, MeshLoadingContext& outContext) {
+    const float xMod = flipX ? -1.0f : 1.0f;
+    const float yMod = flipY ? -1.0f : 1.0f;
+    const float zMod = flipZ ? -1.0f : 1.0f;
+
+    uint32_t totalVertices = 0;
+    uint32_t totalIndices = 0;
+
+    // Offsets first, so the arrays are sized once and every submesh converts straight into its range
+    outMesh.submeshes.resize(scene->mNumMeshes);
+    for (size_t i = 0; i < outMesh.submeshes.size(); ++i) {
+        auto mesh = scene->mMeshes[i];
+        outMesh.submeshes[i].materialIndex = mesh->mMaterialIndex;
+        outMesh.submeshes[i].numVertices = mesh->mNumVertices;
+        outMesh.submeshes[i].numIndices = mesh->mNumFaces * 3;
+        outMesh.submeshes[i].baseVertex = totalVertices;
+        outMesh.submeshes[i].baseIndex = totalIndices;
+
+        totalVertices += outMesh.submeshes[i].numVertices;
+        totalIndices  += outMesh.submeshes[i].numIndices;
+    }
+    outMesh.vertices.resize(totalVertices);
+    outMesh.indices.resize(totalIndices);
+
+    auto convertSubmesh = [&](size_t i) {
+        auto mesh = scene->mMeshes[i];
+        SubMeshData& submesh = outMesh.submeshes[i];
+        Vertex* vertices = outMesh.vertices.data() + submesh.baseVertex;
+        Uint32* indices = outMesh.indices.data() + submesh.baseIndex;
+        if (mesh->HasPositions()) {
+            const aiVector3D zero3D(0.0f, 0.0f, 0.0f);
+            for (size_t j = 0; j < mesh->mNumVertices; ++j) {
+                aiVector3D position = mesh->mVertices[j];
+                aiVector3D normal = (mesh->HasNormals()) ? mesh->mNormals[j] : aiVector3D(0.0f, 1.0f, 0.0f);
+                aiVector3D tangent = (mesh->HasTangentsAndBitangents()) ? mesh->mTangents[j] : aiVector3D(0.0f);
+                aiVector3D bitangent = (mesh->HasTangentsAndBitangents()) ? mesh->mBitangents[j] : aiVector3D(0.0f);
+                aiVector3D uv = (mesh->HasTextureCoords(0)) ? mesh->mTextureCoords[0][j] : zero3D;
+                vertices[j] = { 
+                    .position = {
+                        position.x * xMod,
+                        position.y * yMod,
+                        position.z * zMod
+                    },
+                    .normal = {
+                        normal.x * xMod,
+                        normal.y * yMod,
+                        normal.z * zMod
+                    },
+                    .tangent = {
+                        tangent.x * xMod,
+                        tangent.y * yMod,
+                        tangent.z * zMod
+                    },
+                    .bitangent = {
+                        bitangent.x * xMod,
+                        bitangent.y * yMod,
+                        bitangent.z * zMod
+                    },
+                    .uv = {
+                        uv.x, 
+                        uv.y
+                    }
+                };
+                // TODO: Convert from Array-Of-Vertices to Mesh-of-Arrays
+                // v_positions.pushback(info);
+                // v_normals.pushback(info);
+                // v_uv.pushback(info);
+            }
+            for (size_t j = 0; j < mesh->mNumFaces; ++j) {
+                auto face = mesh->mFaces[j];
+                SDL_assert(face.mNumIndices == 3);
+                indices[j * 3 + 0] = face.mIndices[0];
+                indices[j * 3 + 1] = face.mIndices[1];
+                indices[j * 3 + 2] = face.mIndices[2];
+            }
+        }
+
+        // Object space bounds, used for LOD selection and vertex quantization
+        if (submesh.numVertices > 0) {
+            submesh.boundsMin = vertices[0].position;
+            submesh.boundsMax = vertices[0].position;
+            for (uint32_t j = 1; j < submesh.numVertices; ++j) {
+                submesh.boundsMin = glm::min(submesh.boundsMin, vertices[j].position);
+                submesh.boundsMax = glm::max(submesh.boundsMax, vertices[j].position);
+            }
+        }
+
+        // Average texture coordinate scale, from the total UV and object space areas of the
+        // triangles. Texture streaming turns it into the resolution the submesh needs on screen.
+        double uvArea = 0.0;
+        double objectArea = 0.0;
+        for (uint32_t j = 0; j + 2 < submesh.numIndices; j += 3) {
+            const Vertex& v0 = vertices[indices[j + 0]];
+            const Vertex& v1 = vertices[indices[j + 1]];
+            const Vertex& v2 = vertices[indices[j + 2]];
+            const glm::vec2 uvEdge1 = v1.uv - v0.uv;
+            const glm::vec2 uvEdge2 = v2.uv - v0.uv;
+            uvArea += 0.5 * std::abs(uvEdge1.x * uvEdge2.y - uvEdge1.y * uvEdge2.x);
+            objectArea += 0.5 * glm::length(glm::cross(v1.position - v0.position, v2.position - v0.position));
+        }
+        submesh.uvDensity = (uvArea > 0.0 && objectArea > 0.0) ? static_cast<float>(std::sqrt(uvArea / objectArea)) : 0.0f;
+    };
+    if (mThreadPool) {
+        mThreadPool->ParallelFor(outMesh.submeshes.size(), convertSubmesh);
+    }
+    else {
+        for (size_t i = 0; i < outMesh.submeshes.size(); ++i) convertSubmesh(i);
+    }
+}
+
+void ModelImporter::OptimizeMeshIndices(MeshData& outMesh) {
+    // Runs before LOD generation, which relies on the final vertex order
+    MeshOptimizer::VertexCacheStats before{};
+    MeshOptimizer::VertexCacheStats after{};
+    uint32_t numTriangles = 0;
+    uint32_t numVertices = 0;
+    for (const SubMeshData& submesh : outMesh.submeshes) {
+        std::vector<uint32_t> indices(
+            outMesh.indices.begin() + submesh.baseIndex,
+            outMesh.indices.begin() + submesh.baseIndex + submesh.numIndices);
+        Vertex* vertices = outMesh.vertices.data() + submesh.baseVertex;
+        before.numTransformed += MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), submesh.numVertices).numTransformed;
+
+        const std::vector<uint32_t> clusters = MeshOptimizer::OptimizeVertexCache(indices, submesh.numVertices);
+        MeshOptimizer::OptimizeOverdraw(indices, vertices, submesh.numVertices, clusters);
+        MeshOptimizer::OptimizeVertexFetch(indices, vertices, submesh.numVertices);
+
+        after.numTransformed += MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), submesh.numVertices).numTransformed;
+        std::ranges::copy(indices, outMesh.indices.begin() + submesh.baseIndex);
+        numTriangles += submesh.numIndices / 3;
+        numVertices += submesh.numVertices;
+    }
+    if (numTriangles == 0 || numVertices == 0) return;
+
+    for (MeshOptimizer::VertexCacheStats* stats : {&before, &after}) {
+        stats->acmr = static_cast<float>(stats->numTransformed) / static_cast<float>(numTriangles);
+        stats->atvr = static_cast<float>(stats->numTransformed) / static_cast<float>(numVertices);
+    }
+    SDL_Log("Optimized %u triangles for a %u entry vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+        numTriangles, MeshOptimizer::s_VertexCacheSize, before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+void ModelImporter::BuildMeshlets(MeshData& outMesh) {
+    // Meshlets are carved out of the optimized LOD0 order, so they stay contiguous index ranges
+    outMesh.meshlets.clear();
+    for (SubMeshData& submesh : outMesh.submeshes) {
+        const std::vector<uint32_t> indices(
+            outMesh.indices.begin() + submesh.baseIndex,
+            outMesh.indices.begin() + submesh.baseIndex + submesh.numIndices);
+        std::vector<Meshlet> meshlets = Meshlets::Build(outMesh.vertices.data() + submesh.baseVertex, submesh.numVertices, indices);
+        submesh.firstMeshlet = static_cast<uint32_t>(outMesh.meshlets.size());
+        submesh.numMeshlets = static_cast<uint32_t>(meshlets.size());
+        outMesh.meshlets.insert(outMesh.meshlets.end(), meshlets.begin(), meshlets.end());
+    }
+    SDL_Log("Built %zu meshlets (%.1f triangles on average)", outMesh.meshlets.size(),
+        outMesh.meshlets.empty() ? 0.0 : static_cast<double>(outMesh.indices.size() / 3) / static_cast<double>(outMesh.meshlets.size()));
+}
+
+void ModelImporter::GenerateMeshLods(MeshData& outMesh) {
+    // LOD indices are appended after every submesh's LOD0 range, so the whole chain
+    // lives in the same index buffer and keeps drawing against the submesh's baseVertex
+    const size_t sourceIndexCount = outMesh.indices.size();
+    for (SubMeshData& submesh : outMesh.submeshes) {
+        const Vertex* vertices = outMesh.vertices.data() + submesh.baseVertex;
+        submesh.lods[0] = {submesh.baseIndex, submesh.numIndices, 0, 0.0f};
+        submesh.numLods = 1;
+
+        const float maxError = glm::length(submesh.boundsMax - submesh.boundsMin) * s_LodMaxRelativeError;
+        std::vector<uint32_t> lodIndices(
+            outMesh.indices.begin() + submesh.baseIndex,
+            outMesh.indices.begin() + submesh.baseIndex + submesh.numIndices);
+        float lodError = 0.0f;
+        while (submesh.numLods < MAX_MESH_LODS && lodIndices.size() / 3 > s_MinLodTriangles) {
+            // Each level is simplified from the previous one, errors are accumulated as an upper bound
+            float stepError = 0.0f;
+            std::vector<uint32_t> simplified = MeshSimplifier::Simplify(
+                vertices, submesh.numVertices, lodIndices, lodIndices.size() / 2, maxError - lodError, stepError);
+            // Stop once the simplifier stalls, a LOD that barely saves triangles isn't worth a range
+            if (simplified.empty() || simplified.size() > lodIndices.size() * 3 / 4) break;
+            MeshOptimizer::OptimizeVertexCache(simplified, submesh.numVertices);
+
+            lodError += stepError;
+            SubMeshLod& lod = submesh.lods[submesh.numLods++];
+            lod.baseIndex = static_cast<uint32_t>(outMesh.indices.size());
+            lod.numIndices = static_cast<uint32_t>(simplified.size());
+            lod.error = lodError;
+            outMesh.indices.insert(outMesh.indices.end(), simplified.begin(), simplified.end());
+            lodIndices = std::move(simplified);
+        }
+    }
+    SDL_Log("Generated mesh LODs: %zu source indices, %zu with LODs", sourceIndexCount, outMesh.indices.size());
+}
+
+void ModelImporter::LayoutIndexBuffer(MeshData& outMesh) {
+    // Each submesh gets its LOD chain back to back, in 16 bit indices when they're local indices below 65536.
+    // Regions start 4 byte aligned so they can be bound with either element size.
+    uint32_t offset = 0;
+    uint32_t num16BitSubmeshes = 0;
+    for (SubMeshData& submesh : outMesh.submeshes) {
+        const bool b16Bit = submesh.numVertices <= UINT16_MAX + 1;
+        submesh.indexElementSize = b16Bit ? SDL_GPU_INDEXELEMENTSIZE_16BIT : SDL_GPU_INDEXELEMENTSIZE_32BIT;
+        submesh.indexBufferOffset = offset;
+
+        uint32_t numIndices = 0;
+        for (uint32_t i = 0; i < submesh.numLods; ++i) {
+            submesh.lods[i].firstIndex = numIndices;
+            numIndices += submesh.lods[i].numIndices;
+        }
+        const uint32_t indexSize = b16Bit ? sizeof(Uint16) : sizeof(Uint32);
+        offset += (numIndices * indexSize + 3) & ~3u;
+        num16BitSubmeshes += b16Bit ? 1 : 0;
+    }
+    outMesh.indexBufferSize = offset;
+    SDL_Log("Index buffer: %u of %zu submeshes use 16 bit indices, %.1f KB (%.1f KB as 32 bit)",
+        num16BitSubmeshes, outMesh.submeshes.size(),
+        static_cast<double>(outMesh.indexBufferSize) / 1024.0,
+        static_cast<double>(outMesh.indices.size() * sizeof(Uint32)) / 1024.0);
+}
+
+void ModelImporter::WriteIndexBuffer(const MeshData& mesh, void* dst) {
+    Uint8* bytes = static_cast<Uint8*>(dst);
+    for (const SubMeshData& submesh : mesh.submeshes) {
+        for (uint32_t i = 0; i < submesh.numLods; ++i) {
+            const SubMeshLod& lod = submesh.lods[i];
+            const auto source = mesh.indices.begin() + lod.baseIndex;
+            if (submesh.indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT) {
+                Uint16* destination = reinterpret_cast<Uint16*>(bytes + submesh.indexBufferOffset) + lod.firstIndex;
+                std::transform(source, source + lod.numIndices, destination, [](Uint32 index) { return static_cast<Uint16>(index); });
+            }
+            else {
+                Uint32* destination = reinterpret_cast<Uint32*>(bytes + submesh.indexBufferOffset) + lod.firstIndex;
+                std::copy(source, source + lod.numIndices, destination);
+            }
+        }
+    }
+}
+
+void ModelImporter::PackMeshVertices(MeshData& outMesh) {
+    const VertexPacking::PackingError error = VertexPacking::PackMesh(outMesh);
+    SDL_Log("Packed %zu vertices: %.1f KB -> %.1f KB. Max error: position %f, normal %.3f deg, tangent %.3f deg, uv %f",
+        outMesh.vertices.size(),
+        static_cast<double>(outMesh.vertices.size() * sizeof(Vertex)) / 1024.0,
+        static_cast<double>(outMesh.packedVertices.size() * sizeof(PackedVertex)) / 1024.0,
+        error.position, error.normalDegrees, error.tangentDegrees, error.uv);
+    // Nothing reads the full precision vertices once packed, the packed ones are uploaded and cooked
+    outMesh.vertices = {};
+}
+
+// TODO: Is this necessary? How do I detect information rather than hardcode?
+void ModelImporter::ParseMaterials(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext) {
+    // const bool bIsBinary = (scene->mNumTextures > 0);
+    // for (size_t i = 0; i < scene->mNumMaterials; ++i) {
+    //     auto material = scene->mMaterials[i];
+    //     if (material) {
+    //         aiColor4D baseColor;
+    //         material->Get(AI_MATKEY_BASE_COLOR, baseColor);
+    //         bool bUseMetallic;
+    //         if (material->Get(AI_MATKEY_USE_METALLIC_MAP, bUseMetallic) == aiReturn_SUCCESS) {
+    //             material->Get(AI_MATKEY_METALLIC_TEXTURE, bUseMetallic);
+    //         }
+    //         bool bUseRoughness;
+    //         material->Get(AI_MATKEY_USE_ROUGHNESS_MAP, bUseRoughness);
+    //         if (bUseRoughness) {
+    //             material->Get(AI_MATKEY_ROUGHNESS_FACTOR, )
+    //         }
+    //     }
+    // }
+}
+
+void ModelImporter::ParseTextures(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext) {
+    outMesh.materials.resize(scene->mNumMaterials);
+    for (size_t i = 0; i < outMesh.materials.size(); ++i) {
+        auto material = scene->mMaterials[i];
+        if (material) {
+            int twoSided = 0;
+            if (material->Get(AI_MATKEY_TWOSIDED, twoSided) == AI_SUCCESS) {
+                outMesh.materials[i].isDoubleSided = twoSided != 0;
+            }
+            MaterialLoadingContext materialContext{};
+            aiString texturePath;
+            for (aiTextureType type : s_TextureTypes) {
+                TextureLoadingContext textureContext{};
+                textureContext.type = type;
+                if (material->GetTexture(type, 0, &texturePath) == AI_SUCCESS) {
+                    textureContext.filename = texturePath.data;
+                    SDL_Log("  [%s] Texture found: %s (type %d)", material->GetName().C_Str(), texturePath.C_Str(), type);
+                }
+                else {
+                    textureContext.bUseFallback = true;
+                    textureContext.filename = aiTextureTypeToString(type);
+                    SDL_Log("  [%s] FALLBACK for type %d (%s)", material->GetName().C_Str(), type, aiTextureTypeToString(type));
+                }
+                materialContext.textureContextMap.emplace(type, textureContext);
+            }
+            SDL_assert(materialContext.textureContextMap.size() == s_TextureTypes.size());
+
+            outContext.materialInfos.push_back(materialContext);
+        }
+    }
+    SDL_assert(outMesh.materials.size() == outContext.materialInfos.size());
+}
+
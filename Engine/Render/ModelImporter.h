@@ -0,0 +1,93 @@
+#pragma once
+
+#include <assimp/Importer.hpp>
+#include <assimp/material.h>
+#include <Render/RenderStructs.h>
+#include <Render/TextureEncoder.h>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct aiNode;
+struct aiScene;
+class ContentPack;
+class ThreadPool;
+
+// Turns a source model into MeshData, shared by the renderer (which imports and cooks models it
+// finds stale) and the offline cooker.
+//  - Import runs Assimp and the whole geometry pipeline: conversion, vertex cache and overdraw
+//    optimization, meshlets, LODs, vertex packing and the index buffer layout.
+//  - LoadCooked reads the MeshFile next to the source instead, when it's current.
+//  - Cook writes that MeshFile for an imported mesh.
+// Submeshes convert in parallel on the thread pool given to Init, or serially without one, so
+// callers already running on a pool thread can import without nesting ParallelFor. With a
+// ContentPack, cooked files and the files Assimp opens are read from it when it has them.
+class ModelImporter {
+public:
+    struct TextureLoadingContext {
+        bool bUseFallback = false;
+        aiTextureType          type = aiTextureType_NONE;
+        std::string            filename;
+    };
+
+    struct MaterialLoadingContext {
+        std::unordered_map<aiTextureType, TextureLoadingContext> textureContextMap;
+    };
+
+    struct NodeLoadingContext {
+        NodeLoadingContext() {}
+        NodeLoadingContext(const aiNode* n) { pNode = n;}
+        const aiNode* pNode = nullptr;
+        bool isRequired = false;
+    };
+
+    struct MeshLoadingContext {
+        // Scene info
+        std::unordered_map<std::string, NodeLoadingContext> nodeInfoMap;
+        std::unordered_map<std::string, TextureLoadingContext> textureInfoMap;
+        std::vector<MaterialLoadingContext> materialInfos; // we use indices for identifying materials
+
+        Assimp::Importer importer;
+        const aiScene* scene = nullptr; // not set for cooked models
+    };
+
+    // Everything per model that changes the imported geometry
+    struct ImportSettings {
+        bool flipX = false;
+        bool flipY = false;
+        bool flipZ = false;
+    };
+
+    void Init(ThreadPool* threadPool, const ContentPack* contentPack = nullptr);
+
+    bool Import(const std::string& path, const ImportSettings& settings, MeshData& outMesh, MeshLoadingContext& outContext);
+    bool LoadCooked(const std::string& path, const ImportSettings& settings, MeshData& outMesh, MeshLoadingContext& outContext);
+    // bCompressGeometry stores the vertex and index data GeometryCodec encoded, see MeshFile::Write
+    bool Cook(const std::string& path, const ImportSettings& settings, const MeshData& mesh, const MeshLoadingContext& context,
+        const bool bCompressGeometry = false);
+
+    // Everything the cooked geometry of a model depends on besides its sources. Never 0.
+    static uint64_t GetSettingsHash(const ImportSettings& settings);
+    // The model and the buffers it references, which glTF keeps next to it. File names, in the
+    // directory of path.
+    static std::vector<std::string> GetSources(const std::string& path);
+    // What a texture compresses to, from every material slot it's bound to
+    static TextureEncoder::TextureRole GetTextureRole(const std::set<aiTextureType>& types);
+    static void WriteIndexBuffer(const MeshData& mesh, void* dst);
+
+private:
+    void ParseNodes(MeshData& outMesh, MeshLoadingContext& outContext);
+    void ParseVertices(const aiScene* scene, const bool flipX, const bool flipY, const bool flipZ, MeshData& outMesh, MeshLoadingContext& outContext);
+    void OptimizeMeshIndices(MeshData& outMesh);
+    void BuildMeshlets(MeshData& outMesh);
+    void GenerateMeshLods(MeshData& outMesh);
+    void PackMeshVertices(MeshData& outMesh);
+    void LayoutIndexBuffer(MeshData& outMesh);
+    void ParseMaterials(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext);
+    void ParseTextures(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext);
+
+    ThreadPool* mThreadPool = nullptr;
+    const ContentPack* mContentPack = nullptr;
+};
@@ -0,0 +1,302 @@
+#include "PipelineCache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <Render/RenderStructs.h>
+#include <SDL3/SDL.h>
+#include <ThreadPool.h>
+
+namespace {
+    inline void HashCombine(size_t& seed, const size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+
+    size_t HashResources(const ShaderResources& resources) {
+        return (static_cast<size_t>(resources.numSamplers) << 24)
+             ^ (static_cast<size_t>(resources.numUniformBuffers) << 16)
+             ^ (static_cast<size_t>(resources.numStorageBuffers) << 8)
+             ^  static_cast<size_t>(resources.numStorageTextures);
+    }
+
+    SDL_GPUColorTargetBlendState GetBlendState(const BlendMode mode) {
+        SDL_GPUColorTargetBlendState blendState{};
+        blendState.enable_color_write_mask = true;
+        switch (mode) {
+        case BlendMode::AlphaBlend:
+            blendState.color_write_mask = SDL_GPU_COLORCOMPONENT_R | SDL_GPU_COLORCOMPONENT_G | SDL_GPU_COLORCOMPONENT_B | SDL_GPU_COLORCOMPONENT_A;
+            blendState.enable_blend = true;
+            blendState.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+            blendState.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+            blendState.color_blend_op = SDL_GPU_BLENDOP_ADD;
+            blendState.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+            blendState.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
+            blendState.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+            break;
+        case BlendMode::NoColorWrite:
+            blendState.color_write_mask = 0;
+            break;
+        }
+        return blendState;
+    }
+
+    // Fills the attributes for a layout and returns the vertex pitch, 0 for no vertex input
+    Uint32 GetVertexAttributes(const VertexLayout layout, std::vector<SDL_GPUVertexAttribute>& outAttributes) {
+        switch (layout) {
+        case VertexLayout::None:
+            return 0;
+        case VertexLayout::Vertex:
+            outAttributes = {
+                { 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(Vertex, position)},
+                { 1, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(Vertex, normal)},
+                { 2, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(Vertex, tangent)},
+                { 3, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(Vertex, bitangent)},
+                { 4, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, offsetof(Vertex, uv)},
+            };
+            return sizeof(Vertex);
+        case VertexLayout::PackedVertex:
+            outAttributes = {
+                { 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM, offsetof(PackedVertex, position)},
+                { 1, 0, SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM,  offsetof(PackedVertex, normal)},
+                { 2, 0, SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM,  offsetof(PackedVertex, tangent)},
+                { 3, 0, SDL_GPU_VERTEXELEMENTFORMAT_HALF2,        offsetof(PackedVertex, uv)},
+            };
+            return sizeof(PackedVertex);
+        case VertexLayout::PackedPosition:
+            outAttributes = {
+                { 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM, offsetof(PackedVertex, position)},
+            };
+            return sizeof(PackedVertex);
+        }
+        return 0;
+    }
+}
+
+bool GraphicsPipelineDesc::operator==(const GraphicsPipelineDesc& other) const {
+    return vertexShader == other.vertexShader
+        && vertexResources == other.vertexResources
+        && fragmentShader == other.fragmentShader
+        && fragmentResources == other.fragmentResources
+        && vertexLayout == other.vertexLayout
+        && blendMode == other.blendMode
+        && fillMode == other.fillMode
+        && cullMode == other.cullMode
+        && depthCompareOp == other.depthCompareOp
+        && bDepthTest == other.bDepthTest
+        && bDepthWrite == other.bDepthWrite
+        && colorFormat == other.colorFormat
+        && depthStencilFormat == other.depthStencilFormat;
+}
+
+size_t GraphicsPipelineDescHash::operator()(const GraphicsPipelineDesc& desc) const {
+    size_t seed = std::hash<std::string>{}(desc.vertexShader);
+    HashCombine(seed, HashResources(desc.vertexResources));
+    HashCombine(seed, std::hash<std::string>{}(desc.fragmentShader));
+    HashCombine(seed, HashResources(desc.fragmentResources));
+    const size_t state =
+          (static_cast<size_t>(desc.vertexLayout) << 0)
+        | (static_cast<size_t>(desc.blendMode) << 4)
+        | (static_cast<size_t>(desc.fillMode) << 8)
+        | (static_cast<size_t>(desc.cullMode) << 12)
+        | (static_cast<size_t>(desc.depthCompareOp) << 16)
+        | (static_cast<size_t>(desc.bDepthTest) << 20)
+        | (static_cast<size_t>(desc.bDepthWrite) << 21);
+    HashCombine(seed, state);
+    HashCombine(seed, (static_cast<size_t>(desc.colorFormat) << 16) | static_cast<size_t>(desc.depthStencilFormat));
+    return seed;
+}
+
+void PipelineCache::Init(SDL_GPUDevice* device, ThreadPool* threadPool, ShaderLibrary* shaderLibrary) {
+    mDevice = device;
+    mThreadPool = threadPool;
+    mShaderLibrary = shaderLibrary;
+}
+
+void PipelineCache::Release() {
+    if (!mDevice) return;
+    for (auto& [desc, pipeline] : mPipelines) {
+        if (pipeline) SDL_ReleaseGPUGraphicsPipeline(mDevice, pipeline);
+    }
+    mPipelines.clear();
+}
+
+bool PipelineCache::Prewarm(const std::vector<GraphicsPipelineDesc>& descs) {
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+
+    // Unique pipelines that still need creating, and the shaders they use
+    std::vector<const GraphicsPipelineDesc*> pending;
+    std::vector<std::pair<std::string, ShaderResources>> shaders;
+    {
+        std::lock_guard lock(mMutex);
+        for (const GraphicsPipelineDesc& desc : descs) {
+            if (mPipelines.contains(desc)) continue;
+            const bool bDuplicate = std::any_of(pending.begin(), pending.end(), [&](const GraphicsPipelineDesc* other) { return *other == desc; });
+            if (bDuplicate) continue;
+            pending.push_back(&desc);
+
+            for (const auto& shader : {std::pair{desc.vertexShader, desc.vertexResources}, std::pair{desc.fragmentShader, desc.fragmentResources}}) {
+                if (std::find(shaders.begin(), shaders.end(), shader) != shaders.end()) continue;
+                shaders.push_back(shader);
+            }
+        }
+    }
+    if (pending.empty()) return true;
+
+    // Shaders first so pipelines sharing a shader don't race to load it
+    auto loadShader = [&](size_t i) {
+        mShaderLibrary->Get(shaders[i].first, shaders[i].second);
+    };
+    if (mThreadPool) {
+        mThreadPool->ParallelFor(shaders.size(), loadShader);
+    }
+    else {
+        for (size_t i = 0; i < shaders.size(); ++i) loadShader(i);
+    }
+
+    std::vector<double> milliseconds;
+    const std::vector<SDL_GPUGraphicsPipeline*> created = CreatePipelines(pending, milliseconds);
+
+    bool bSuccess = true;
+    {
+        std::lock_guard lock(mMutex);
+        for (size_t i = 0; i < pending.size(); ++i) {
+            mPipelines.emplace(*pending[i], created[i]);
+            if (created[i]) {
+                SDL_Log("  Pipeline '%s' created in %.2f ms", pending[i]->name.c_str(), milliseconds[i]);
+            }
+            else {
+                bSuccess = false;
+            }
+        }
+    }
+
+    const double totalMilliseconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    SDL_Log("Prewarmed %zu pipelines (%zu requested, %zu shaders) in %.2f ms on %u threads",
+        pending.size(), descs.size(), shaders.size(), totalMilliseconds,
+        mThreadPool ? mThreadPool->GetNumThreads() + 1 : 1);
+    return bSuccess;
+}
+
+void PipelineCache::Rebuild(const std::vector<std::string>& shaderNames) {
+    auto usesShader = [&](const GraphicsPipelineDesc& desc) {
+        return std::any_of(shaderNames.begin(), shaderNames.end(), [&](const std::string& name) {
+            return desc.vertexShader == name || desc.fragmentShader == name;
+        });
+    };
+
+    std::vector<const GraphicsPipelineDesc*> affected;
+    {
+        std::lock_guard lock(mMutex);
+        for (const auto& [desc, pipeline] : mPipelines) {
+            if (usesShader(desc)) affected.push_back(&desc);
+        }
+    }
+    if (affected.empty()) return;
+
+    // Map nodes are stable, the descs stay valid while the pipelines are created
+    std::vector<double> milliseconds;
+    const std::vector<SDL_GPUGraphicsPipeline*> created = CreatePipelines(affected, milliseconds);
+
+    std::lock_guard lock(mMutex);
+    size_t numRebuilt = 0;
+    for (size_t i = 0; i < affected.size(); ++i) {
+        if (!created[i]) continue;
+        SDL_GPUGraphicsPipeline*& pipeline = mPipelines[*affected[i]];
+        // SDL defers the destruction until in-flight command buffers are done with it
+        if (pipeline) SDL_ReleaseGPUGraphicsPipeline(mDevice, pipeline);
+        pipeline = created[i];
+        ++numRebuilt;
+        SDL_Log("  Pipeline '%s' rebuilt in %.2f ms", affected[i]->name.c_str(), milliseconds[i]);
+    }
+    SDL_Log("Rebuilt %zu of %zu pipelines using the reloaded shaders", numRebuilt, affected.size());
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::Get(const GraphicsPipelineDesc& desc) {
+    {
+        std::lock_guard lock(mMutex);
+        auto it = mPipelines.find(desc);
+        if (it != mPipelines.end()) return it->second;
+    }
+
+    double milliseconds = 0.0;
+    SDL_GPUGraphicsPipeline* pipeline = CreatePipeline(desc, milliseconds);
+    if (pipeline) {
+        SDL_Log("Pipeline '%s' created on first use in %.2f ms", desc.name.c_str(), milliseconds);
+    }
+
+    std::lock_guard lock(mMutex);
+    auto [it, bInserted] = mPipelines.emplace(desc, pipeline);
+    if (!bInserted && pipeline) {
+        SDL_ReleaseGPUGraphicsPipeline(mDevice, pipeline);
+    }
+    return it->second;
+}
+
+std::vector<SDL_GPUGraphicsPipeline*> PipelineCache::CreatePipelines(const std::vector<const GraphicsPipelineDesc*>& descs, std::vector<double>& outMilliseconds) {
+    std::vector<SDL_GPUGraphicsPipeline*> created(descs.size(), nullptr);
+    outMilliseconds.assign(descs.size(), 0.0);
+    auto createPipeline = [&](size_t i) {
+        created[i] = CreatePipeline(*descs[i], outMilliseconds[i]);
+    };
+    if (mThreadPool) {
+        mThreadPool->ParallelFor(descs.size(), createPipeline);
+    }
+    else {
+        for (size_t i = 0; i < descs.size(); ++i) createPipeline(i);
+    }
+    return created;
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::CreatePipeline(const GraphicsPipelineDesc& desc, double& outMilliseconds) {
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+
+    SDL_GPUShader* vertexShader = mShaderLibrary->Get(desc.vertexShader, desc.vertexResources);
+    SDL_GPUShader* fragmentShader = mShaderLibrary->Get(desc.fragmentShader, desc.fragmentResources);
+    if (!vertexShader || !fragmentShader) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create '%s' graphics pipeline: missing shader", desc.name.c_str());
+        return nullptr;
+    }
+
+    SDL_GPUColorTargetDescription colorTargetDescription{};
+    colorTargetDescription.format = desc.colorFormat;
+    colorTargetDescription.blend_state = GetBlendState(desc.blendMode);
+
+    SDL_GPUGraphicsPipelineTargetInfo pipelineTargetInfo{};
+    pipelineTargetInfo.color_target_descriptions = &colorTargetDescription;
+    pipelineTargetInfo.num_color_targets = 1;
+    pipelineTargetInfo.has_depth_stencil_target = desc.depthStencilFormat != SDL_GPU_TEXTUREFORMAT_INVALID;
+    pipelineTargetInfo.depth_stencil_format = desc.depthStencilFormat;
+
+    std::vector<SDL_GPUVertexAttribute> vertexAttributes;
+    SDL_GPUVertexBufferDescription vertexBufferDescription{};
+    vertexBufferDescription.slot = 0;
+    vertexBufferDescription.pitch = GetVertexAttributes(desc.vertexLayout, vertexAttributes);
+    vertexBufferDescription.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
+    vertexBufferDescription.instance_step_rate = 0;
+
+    SDL_GPUVertexInputState vertexInputState{};
+    if (!vertexAttributes.empty()) {
+        vertexInputState.vertex_buffer_descriptions = &vertexBufferDescription;
+        vertexInputState.num_vertex_buffers = 1;
+        vertexInputState.vertex_attributes = vertexAttributes.data();
+        vertexInputState.num_vertex_attributes = static_cast<Uint32>(vertexAttributes.size());
+    }
+
+    SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+    pipelineCreateInfo.vertex_shader = vertexShader;
+    pipelineCreateInfo.fragment_shader = fragmentShader;
+    pipelineCreateInfo.target_info = pipelineTargetInfo;
+    pipelineCreateInfo.vertex_input_state = vertexInputState;
+    pipelineCreateInfo.depth_stencil_state.compare_op = desc.depthCompareOp;
+    pipelineCreateInfo.depth_stencil_state.enable_depth_test = desc.bDepthTest;
+    pipelineCreateInfo.depth_stencil_state.enable_depth_write = desc.bDepthWrite;
+    pipelineCreateInfo.rasterizer_state.fill_mode = desc.fillMode;
+    pipelineCreateInfo.rasterizer_state.cull_mode = desc.cullMode;
+
+    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(mDevice, &pipelineCreateInfo);
+    if (!pipeline) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create '%s' graphics pipeline: %s", desc.name.c_str(), SDL_GetError());
+    }
+    outMilliseconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    return pipeline;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <mutex>
+#include <Render/ShaderLibrary.h>
+#include <SDL3/SDL_gpu.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+// Vertex buffer layouts the engine draws with
+enum class VertexLayout : Uint8 {
+    None = 0,       // vertices generated from SV_VertexID
+    Vertex,         // full float Vertex
+    PackedVertex,   // quantized PackedVertex
+    PackedPosition, // PackedVertex buffer, position only
+};
+
+enum class BlendMode : Uint8 {
+    AlphaBlend = 0,
+    NoColorWrite, // color target declared but masked off, for depth only passes
+};
+
+// Everything that identifies a graphics pipeline. Two descs that compare equal share one pipeline.
+struct GraphicsPipelineDesc {
+    std::string name; // for logging only, not part of the identity
+
+    std::string vertexShader;
+    ShaderResources vertexResources{};
+    std::string fragmentShader;
+    ShaderResources fragmentResources{};
+
+    VertexLayout vertexLayout = VertexLayout::None;
+    BlendMode blendMode = BlendMode::AlphaBlend;
+    SDL_GPUFillMode fillMode = SDL_GPU_FILLMODE_FILL;
+    SDL_GPUCullMode cullMode = SDL_GPU_CULLMODE_NONE;
+    SDL_GPUCompareOp depthCompareOp = SDL_GPU_COMPAREOP_LESS;
+    bool bDepthTest = true;
+    bool bDepthWrite = true;
+
+    SDL_GPUTextureFormat colorFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+    SDL_GPUTextureFormat depthStencilFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+
+    bool operator==(const GraphicsPipelineDesc& other) const;
+};
+
+struct GraphicsPipelineDescHash {
+    size_t operator()(const GraphicsPipelineDesc& desc) const;
+};
+
+// Owns every graphics pipeline, shaders come from the ShaderLibrary.
+//  - Pipelines are looked up by desc, identical state is created once.
+//  - Prewarm creates a set of pipelines up front on the thread pool (SDL GPU resource
+//    creation is thread safe); anything not prewarmed is created on first Get.
+//  - Rebuild recreates only the pipelines using a set of (hot reloaded) shaders.
+// A pipeline that failed to create is remembered as null so it is only reported once.
+class PipelineCache {
+public:
+    void Init(SDL_GPUDevice* device, ThreadPool* threadPool, ShaderLibrary* shaderLibrary);
+    void Release();
+
+    // Creates all pipelines not in the cache yet. Returns false if any of them failed.
+    bool Prewarm(const std::vector<GraphicsPipelineDesc>& descs);
+
+    // Recreates the pipelines built from any of the named shaders. A pipeline that fails to
+    // rebuild keeps its previous version.
+    void Rebuild(const std::vector<std::string>& shaderNames);
+
+    // Cached pipeline for desc, created on first use. Null if creation failed.
+    SDL_GPUGraphicsPipeline* Get(const GraphicsPipelineDesc& desc);
+
+    size_t GetNumPipelines() const { return mPipelines.size(); }
+
+private:
+    SDL_GPUGraphicsPipeline* CreatePipeline(const GraphicsPipelineDesc& desc, double& outMilliseconds);
+    std::vector<SDL_GPUGraphicsPipeline*> CreatePipelines(const std::vector<const GraphicsPipelineDesc*>& descs, std::vector<double>& outMilliseconds);
+
+    SDL_GPUDevice* mDevice = nullptr;
+    ThreadPool* mThreadPool = nullptr;
+    ShaderLibrary* mShaderLibrary = nullptr;
+
+    std::mutex mMutex;
+    std::unordered_map<GraphicsPipelineDesc, SDL_GPUGraphicsPipeline*, GraphicsPipelineDescHash> mPipelines;
+};
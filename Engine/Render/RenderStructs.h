@@ -5,8 +5,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_gpu.h>
+#include <array>
+#include <memory>
 #include <stack>
 
+class MeshFile;
+
 #define IDENTITY_MATRIX	  glm::mat4(1.0f, 0.0f, 0.0f, 0.0f, \
 									0.0f, 1.0f, 0.0f, 0.0f, \
 									0.0f, 0.0f, 1.0f, 0.0f, \
@@ -28,25 +32,111 @@ struct SunLight {
 	bool enabled = false;
 };
 
-constexpr int MAX_LIGHTS = 16;
+constexpr int MAX_LIGHTS = 4096;
 
+// Mirrors the Light struct in Common.hlsl
 struct PointLight {
 	glm::vec3 position = {0.0f, 0.0f, 0.0f};
-	float _pad0 = 0.0f;
+	float radius       = 15.0f;
 	glm::vec3 color    = {1.0f, 1.0f, 1.0f};
-	float _pad1 = 0.0f;
+	float _pad0 = 0.0f;
 };
 
-// Mirrors the Lights cbuffer on the GPU
-struct LightsUniform {
+// Froxel grid used for clustered light culling
+constexpr uint32_t CLUSTER_GRID_X = 16;
+constexpr uint32_t CLUSTER_GRID_Y = 9;
+constexpr uint32_t CLUSTER_GRID_Z = 24;
+constexpr uint32_t NUM_CLUSTERS = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+constexpr uint32_t MAX_CLUSTER_LIGHT_INDICES = NUM_CLUSTERS * 64;
+
+// Mirrors the ClusterParams cbuffer in PBR.frag
+struct ClusterParamsGPU {
+	glm::vec2 screenSize = {1.0f, 1.0f};
+	float zNear = 0.1f;
+	float zFar = 1000.0f;
+	glm::uvec3 gridSize = {CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z};
+	float logDepthScale = 0.0f; // slice = log(viewZ) * scale + bias
+	float logDepthBias = 0.0f;
 	uint32_t numLights = 0;
-	uint32_t _pad[3] = {};
-	PointLight lights[MAX_LIGHTS] = {};
+	float _pad[2] = {};
+};
+
+// Mirrors the ClusterRanges StructuredBuffer element: a slice of the light index list
+struct ClusterRangeGPU {
+	uint32_t offset = 0;
+	uint32_t count = 0;
+};
+
+// Render pass and draw bookkeeping for the current frame
+struct RenderPassStats {
+	uint32_t numRenderPasses = 0;
+	uint32_t numAttachmentLoads = 0;
+	uint32_t numAttachmentClears = 0;
+	uint32_t numAttachmentStores = 0;
+	uint32_t numPassesCulled = 0;
+	uint32_t numTransientTextures = 0; // declared by the frame graph
+	uint32_t numPooledTextures = 0;    // actually allocated to back them
+	uint64_t pooledTextureBytes = 0;
+	uint32_t numMeshlets = 0;        // tested this frame
+	uint32_t numMeshletsVisible = 0;
+	uint32_t numDrawCalls = 0;       // mesh pass only
+	uint64_t numTriangles = 0;       // after culling and LOD selection
+	uint64_t numTrianglesLod0 = 0;   // every submitted submesh at full detail, without culling
+};
+
+// Sampled texture memory, mip levels included
+struct TextureMemoryStats {
+	uint32_t numTextures = 0;
+	uint64_t bytes = 0;          // all levels
+	uint64_t baseLevelBytes = 0; // level 0 only
+};
+
+// Mip residency of streamed textures, see TextureStreamer
+struct TextureStreamingStats {
+	uint64_t budget = 0;
+	uint64_t reservedBytes = 0;   // of the material texture arrays, what the budget caps
+	uint64_t residentBytes = 0;   // every level of the streamed textures on the GPU
+	uint64_t wantedBytes = 0;     // what the last frame's requests would make resident
+	uint64_t bytesStreamedIn = 0; // total
+	uint32_t numTextures = 0;
+	uint32_t numStreamedIn = 0;   // moves to finer levels, total
+	uint32_t numEvicted = 0;      // moves to coarser levels, total
+};
+
+// Upload staging, see StagingRing
+struct StagingStats {
+	uint64_t capacity = 0;
+	uint64_t bytesInFlight = 0;     // allocated and not yet reclaimed
+	uint64_t peakBytesInFlight = 0;
+	uint64_t bytesUploaded = 0;     // total, dedicated buffers included
+	uint32_t numBatches = 0;        // submitted
+	uint32_t numStalls = 0;         // allocations that had to wait for the GPU
+	uint32_t numDedicated = 0;      // allocations too large for the ring
+};
+
+// Mesh geometry storage, see GeometryArena
+struct GeometryArenaStats {
+	uint64_t capacity = 0;
+	uint64_t usedBytes = 0;
+	uint64_t largestFreeBlock = 0; // updated by IsFragmented
+	uint32_t numRanges = 0;
+	uint32_t numFreeBlocks = 0;
+	uint32_t numGrows = 0;
+	uint32_t numCompactions = 0;
+};
+
+// Texture sharing across meshes, see TextureCache
+struct TextureCacheStats {
+	uint32_t numTextures = 0;     // alive in the cache
+	uint32_t numRequests = 0;     // textures asked for, fallbacks included
+	uint32_t numHits = 0;         // requests served by an already loaded texture
+	uint32_t numFallbackHits = 0; // of which fallbacks
+	uint64_t bytesSaved = 0;      // GPU memory the hits would otherwise have allocated
 };
 
 struct SceneLighting {
 	glm::vec3 ambientLight;
-	LightsUniform lightsUniform;
+	std::vector<PointLight> pointLights;
 	bool inited = false;
 };
 
@@ -58,28 +148,91 @@ struct Vertex {
 	glm::vec2 uv;
 };
 
+// GPU vertex layout of loaded models, 20 bytes (see VertexPacking.h)
+//  position:  xyz unorm16 within the submesh bounds, w = bitangent sign (0 = -1, 1 = +1)
+//  normal:    octahedral snorm16
+//  tangent:   octahedral snorm16
+//  uv:        half2
+struct PackedVertex {
+	uint16_t position[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t uv[2];
+};
+static_assert(sizeof(PackedVertex) == 20);
+
+// Mirrors the Model cbuffer in PBR.vert and DepthOnly.vert
+struct ModelUniformGPU {
+	glm::mat4 model = glm::mat4(1.0f);
+	glm::vec4 positionOffset = {0.0f, 0.0f, 0.0f, 0.0f}; // dequantization: offset + unorm * scale
+	glm::vec4 positionScale  = {1.0f, 1.0f, 1.0f, 0.0f};
+	glm::uvec4 material      = {0, 0, 0, 0}; // x: index into the material table (PBR only)
+};
+
+// Where a texture lives: a layer of one of the MaterialTable texture arrays
+struct TextureSlot {
+	uint16_t array = UINT16_MAX;
+	uint16_t layer = 0;
+
+	bool IsValid() const { return array != UINT16_MAX; }
+	// As stored in MaterialGPU
+	uint32_t Pack() const { return (static_cast<uint32_t>(array) << 16) | layer; }
+	bool operator==(const TextureSlot& other) const = default;
+};
+
+// Mirrors Material in PBR.frag. One packed TextureSlot per texture type, in s_TextureTypes order.
+constexpr uint32_t NUM_MATERIAL_TEXTURES = 6;
+struct MaterialGPU {
+	uint32_t textures[NUM_MATERIAL_TEXTURES];
+	uint32_t padding[2];
+};
+static_assert(sizeof(MaterialGPU) == 32);
+
 struct Texture {
 	Texture() {}
 	Texture(aiTextureType type) { type = type; }
-	Texture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler) {
-		texture = texture;
-		sampler = sampler;
-	}
 	Texture(const Texture& other) {
 		type = other.type;
-		texture = other.texture;
-		sampler = other.sampler;
+		slot = other.slot;
 	}
 	aiTextureType type = aiTextureType_NONE;
-	SDL_GPUTexture* texture = nullptr;
-	SDL_GPUSampler* sampler = nullptr;
+	TextureSlot slot;
 };
 
 struct PBRMaterial {
 	bool isValid    = false;
+	bool isDoubleSided = false; // back faces are visible, no backface culling
+	uint32_t tableIndex = 0;    // in the MaterialTable
 	std::unordered_map<aiTextureType, Texture> textureMap;
 };
 
+// LOD0 is the source mesh, each further level roughly halves the triangle count
+constexpr uint32_t MAX_MESH_LODS = 5;
+
+// A range of the mesh indices, drawn with the submesh's baseVertex
+struct SubMeshLod {
+	uint32_t baseIndex  = 0; // into MeshData::indices
+	uint32_t numIndices = 0;
+	uint32_t firstIndex = 0; // into the submesh's region of the GPU index buffer
+	float error 		= 0.0f; // object space deviation from LOD0
+};
+
+// Meshlets are runs of consecutive LOD0 triangles, small enough to be culled individually
+constexpr uint32_t MESHLET_MAX_VERTICES  = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+	uint32_t firstIndex = 0; // relative to the submesh's LOD0 range
+	uint32_t numIndices = 0;
+	glm::vec3 center 	= {0.0f, 0.0f, 0.0f}; // object space bounding sphere
+	float radius 		= 0.0f;
+	glm::vec3 coneAxis  = {0.0f, 0.0f, 1.0f}; // normal cone, see MeshletCuller
+	float coneCutoff 	= 1.0f; // 1 = never backface culled
+};
+
+// baseVertex and baseIndex index MeshData::vertices and indices while a mesh is imported. Once its
+// geometry is uploaded they're absolute into the renderer's geometry arenas, baseIndex in elements
+// of indexElementSize, so draws of every mesh share one vertex and index buffer binding.
 struct SubMeshData {
 	uint32_t baseVertex  = 0;
 	uint32_t baseIndex 	 = 0;
@@ -89,6 +242,16 @@ struct SubMeshData {
 	int nodeId 	 		 = 0;
 	int materialIndex    = -1;
 	glm::mat4 transformation; // cached & pre-transformed
+	std::array<SubMeshLod, MAX_MESH_LODS> lods{};
+	uint32_t numLods 	 = 0;
+	glm::vec3 boundsMin  = {0.0f, 0.0f, 0.0f}; // object space
+	glm::vec3 boundsMax  = {0.0f, 0.0f, 0.0f};
+	float uvDensity 	 = 0.0f; // texture coordinate units per object space unit, 0 without usable UVs
+	uint32_t firstMeshlet = 0; // into MeshData::meshlets
+	uint32_t numMeshlets  = 0;
+	// All LODs of a submesh share one region of the GPU index buffer, 16 bit when the vertex count allows
+	uint32_t indexBufferOffset = 0; // bytes, from the start of the index arena once uploaded
+	SDL_GPUIndexElementSize indexElementSize = SDL_GPU_INDEXELEMENTSIZE_32BIT;
 };
 
 // TODO: Put these elsewhere, like a SceneManager
@@ -104,19 +267,34 @@ struct SceneNode {
 	std::vector<int> childIds;
 };
 
+// A mesh's range of one of the renderer's geometry arenas, see GeometryArena
+struct GeometryRange {
+	uint32_t id 	= UINT32_MAX; // the arena's handle, stable while the range lives
+	uint32_t offset = 0; // bytes, changes when the arena compacts
+	uint32_t size 	= 0;
+	bool IsValid() const { return id != UINT32_MAX; }
+};
+
 struct MeshData {
-	std::vector<Vertex> vertices;
+	std::vector<Vertex> vertices; // emptied once packed, only unpacked meshes (the grid) keep them
+	std::vector<PackedVertex> packedVertices; // uploaded instead of vertices when present
 	std::vector<Uint32> indices;
 	uint8_t samplerTypeIndex = 0;
-	SDL_GPUBuffer* vertexBuffer = nullptr;
-	SDL_GPUBuffer* indexBuffer = nullptr;
+	GeometryRange vertexRange;
+	GeometryRange indexRange;
+	uint32_t indexBufferSize = 0; // bytes, 0 = indices uploaded as is (32 bit)
 	std::unordered_map<std::string, Texture> textureIdMap;
 	std::vector<SubMeshData> submeshes;
+	std::vector<Meshlet> meshlets;
 	std::vector<PBRMaterial> materials;
 	std::unordered_map<uint32_t, SceneNode> nodeMap;
 	std::string filepath;
 	glm::mat4 globalTransform;
+	uint32_t numVertices = 0; // source vertices and indices (every LOD), also known when only cooked data was loaded
+	uint32_t numIndices = 0;
+	std::shared_ptr<const MeshFile> cookedFile; // holds the vertex and index data until uploaded, see MeshFile
 	bool bDoNotRender = false;
+	bool bLoaded = false; // GPU resources ready to draw, models stream in after startup
 };
 
 // mirrors camera buffer on GPU
@@ -156,13 +334,11 @@ static void UpdateCachedTransformations(MeshData& mesh) {
 	}
 }
 
-static void GetValidTextureBindings(const PBRMaterial& material, std::vector<SDL_GPUTextureSamplerBinding>& outBindings) {
-	// for (auto& [type, texture] : material.textureMap) {
-	// 	outBindings.push_back({texture.texture, texture.sampler});
-	// }
-	for (auto type : s_TextureTypes) {
-		const Texture& texture = material.textureMap.at(type);
-		outBindings.push_back({texture.texture, texture.sampler});
+static MaterialGPU GetMaterialGPU(const PBRMaterial& material) {
+	SDL_assert(s_TextureTypes.size() == NUM_MATERIAL_TEXTURES);
+	MaterialGPU materialGPU{};
+	for (size_t i = 0; i < NUM_MATERIAL_TEXTURES; ++i) {
+		materialGPU.textures[i] = material.textureMap.at(s_TextureTypes[i]).slot.Pack();
 	}
-	SDL_assert(outBindings.size() == material.textureMap.size());
+	return materialGPU;
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ContentPack.h>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <MappedFile.h>
+#include <SDL3/SDL.h>
+#include <ThreadPool.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Timestamps are polled at this interval where inotify isn't available
+    constexpr Uint64 s_PollIntervalNS = 500'000'000;
+
+    SDL_GPUShaderStage GetStage(const std::string& name, bool& outValid) {
+        outValid = true;
+        if (name.contains(".vert")) return SDL_GPU_SHADERSTAGE_VERTEX;
+        if (name.contains(".frag")) return SDL_GPU_SHADERSTAGE_FRAGMENT;
+        outValid = false;
+        return SDL_GPU_SHADERSTAGE_VERTEX;
+    }
+
+    bool IsStageSource(const std::string& filename) {
+        return filename.ends_with(".vert.hlsl") || filename.ends_with(".frag.hlsl");
+    }
+}
+
+size_t ShaderLibrary::ShaderKeyHash::operator()(const ShaderKey& key) const {
+    size_t seed = std::hash<std::string>{}(key.name);
+    seed ^= static_cast<size_t>(key.stage) << 32;
+    seed ^= (static_cast<size_t>(key.resources.numSamplers) << 24)
+          ^ (static_cast<size_t>(key.resources.numUniformBuffers) << 16)
+          ^ (static_cast<size_t>(key.resources.numStorageBuffers) << 8)
+          ^  static_cast<size_t>(key.resources.numStorageTextures);
+    return seed;
+}
+
+ShaderLibrary::~ShaderLibrary() {
+    Release();
+}
+
+bool ShaderLibrary::Init(SDL_GPUDevice* device, ThreadPool* threadPool, const std::string& compiledPath, const ContentPack* contentPack) {
+    mDevice = device;
+    mThreadPool = threadPool;
+    mContentPack = contentPack;
+    mCompiledPath = compiledPath;
+
+    const SDL_GPUShaderFormat backendFormats = SDL_GetGPUShaderFormats(device);
+    if (backendFormats & SDL_GPU_SHADERFORMAT_SPIRV) {
+        mFormat = SDL_GPU_SHADERFORMAT_SPIRV;
+        mFormatFolder = "SPIRV";
+        mFormatExtension = "spv";
+        mEntrypoint = "main";
+    }
+    else if (backendFormats & SDL_GPU_SHADERFORMAT_MSL) {
+        mFormat = SDL_GPU_SHADERFORMAT_MSL;
+        mFormatFolder = "MSL";
+        mFormatExtension = "msl";
+        mEntrypoint = "main0";
+    }
+    else if (backendFormats & SDL_GPU_SHADERFORMAT_DXIL) {
+        mFormat = SDL_GPU_SHADERFORMAT_DXIL;
+        mFormatFolder = "DXIL";
+        mFormatExtension = "dxil";
+        mEntrypoint = "main";
+    }
+    else {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s", "Unrecognized backend shader format!");
+        return false;
+    }
+    return true;
+}
+
+void ShaderLibrary::Release() {
+    if (mCompileJob.valid()) mCompileJob.wait();
+    mCompileJob = {};
+#ifdef __linux__
+    if (mWatchFd >= 0) close(mWatchFd);
+#endif
+    mWatchFd = -1;
+    mSourcePath.clear();
+
+    std::lock_guard lock(mMutex);
+    if (!mDevice) return;
+    for (auto& [key, shader] : mShaders) {
+        if (shader) SDL_ReleaseGPUShader(mDevice, shader);
+    }
+    mShaders.clear();
+}
+
+SDL_GPUShader* ShaderLibrary::Get(const std::string& name, const ShaderResources& resources) {
+    bool bValidStage = false;
+    const SDL_GPUShaderStage stage = GetStage(name, bValidStage);
+    if (!bValidStage) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid shader stage for %s!", name.c_str());
+        return nullptr;
+    }
+
+    ShaderKey key{name, stage, resources};
+    bool bRecompiled = false;
+    {
+        std::lock_guard lock(mMutex);
+        auto it = mShaders.find(key);
+        if (it != mShaders.end()) return it->second;
+        bRecompiled = mRecompiled.contains(name);
+    }
+
+    // Created outside the lock so different shaders load in parallel.
+    // Failures are cached as null too, a hot reload retries them.
+    SDL_GPUShader* shader = CreateShader(key, bRecompiled);
+
+    std::lock_guard lock(mMutex);
+    auto [it, bInserted] = mShaders.emplace(std::move(key), shader);
+    if (!bInserted && shader) {
+        SDL_ReleaseGPUShader(mDevice, shader);
+    }
+    return it->second;
+}
+
+std::string ShaderLibrary::GetCompiledPath(const std::string& name) const {
+    return std::format("{}/{}/{}.{}", mCompiledPath, mFormatFolder, name, mFormatExtension);
+}
+
+SDL_GPUShader* ShaderLibrary::CreateShader(const ShaderKey& key, const bool bRecompiled) const {
+    const std::string path = GetCompiledPath(key.name);
+    MappedFile file;
+    size_t codeSize = 0;
+    const uint8_t* code = (mContentPack && !bRecompiled) ? mContentPack->Find(path, codeSize) : nullptr;
+    if (!code) {
+        if (!file.Open(path)) {
+            return nullptr;
+        }
+        code = file.GetData();
+        codeSize = file.GetSize();
+    }
+    if (codeSize == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Shader file is empty: %s", path.c_str());
+        return nullptr;
+    }
+
+    // SDL copies or compiles the code during creation, the mapping can go right after
+    SDL_GPUShaderCreateInfo shaderInfo{};
+    shaderInfo.code = code;
+    shaderInfo.code_size = codeSize;
+    shaderInfo.entrypoint = mEntrypoint;
+    shaderInfo.format = mFormat;
+    shaderInfo.stage = key.stage;
+    shaderInfo.num_samplers = key.resources.numSamplers;
+    shaderInfo.num_uniform_buffers = key.resources.numUniformBuffers;
+    shaderInfo.num_storage_buffers = key.resources.numStorageBuffers;
+    shaderInfo.num_storage_textures = key.resources.numStorageTextures;
+
+    SDL_GPUShader* shader = SDL_CreateGPUShader(mDevice, &shaderInfo);
+    if (!shader) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create shader %s: %s", key.name.c_str(), SDL_GetError());
+    }
+    return shader;
+}
+
+bool ShaderLibrary::EnableHotReload(const std::string& sourcePath) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(sourcePath, error)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Shader hot reload: source directory not found: %s", sourcePath.c_str());
+        return false;
+    }
+    mSourcePath = sourcePath;
+    ScanIncludes();
+
+#ifdef __linux__
+    mWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    // Editors either write in place or write a temporary and rename it over the original
+    if (mWatchFd < 0 || inotify_add_watch(mWatchFd, mSourcePath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Shader hot reload: failed to watch %s", mSourcePath.c_str());
+        if (mWatchFd >= 0) close(mWatchFd);
+        mWatchFd = -1;
+        mSourcePath.clear();
+        return false;
+    }
+#else
+    for (const auto& entry : std::filesystem::directory_iterator(mSourcePath, error)) {
+        if (entry.path().extension() != ".hlsl") continue;
+        mSourceTimes[entry.path().filename().string()] = entry.last_write_time(error).time_since_epoch().count();
+    }
+#endif
+    SDL_Log("Shader hot reload: watching %s", mSourcePath.c_str());
+    return true;
+}
+
+void ShaderLibrary::ScanIncludes() {
+    mIncludedBy.clear();
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(mSourcePath, error)) {
+        if (entry.path().extension() != ".hlsl") continue;
+        const std::string filename = entry.path().filename().string();
+        std::ifstream file{entry.path()};
+        std::string line;
+        while (std::getline(file, line)) {
+            const size_t directive = line.find("#include");
+            if (directive == std::string::npos) continue;
+            const size_t openQuote = line.find('"', directive);
+            const size_t closeQuote = (openQuote != std::string::npos) ? line.find('"', openQuote + 1) : std::string::npos;
+            if (closeQuote == std::string::npos) continue;
+            mIncludedBy[line.substr(openQuote + 1, closeQuote - openQuote - 1)].insert(filename);
+        }
+    }
+}
+
+void ShaderLibrary::CollectChangedSources(std::set<std::string>& outChanged) {
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        const ssize_t length = read(mWatchFd, buffer, sizeof(buffer));
+        if (length <= 0) break; // EAGAIN, nothing pending
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0) {
+                const std::string filename = event->name;
+                if (filename.ends_with(".hlsl")) outChanged.insert(filename);
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+#else
+    const Uint64 now = SDL_GetTicksNS();
+    if (now - mLastPollTime < s_PollIntervalNS) return;
+    mLastPollTime = now;
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(mSourcePath, error)) {
+        if (entry.path().extension() != ".hlsl") continue;
+        const std::string filename = entry.path().filename().string();
+        const long long time = entry.last_write_time(error).time_since_epoch().count();
+        auto [it, bInserted] = mSourceTimes.try_emplace(filename, time);
+        if (bInserted || it->second != time) {
+            it->second = time;
+            outChanged.insert(filename);
+        }
+    }
+#endif
+}
+
+std::vector<std::string> ShaderLibrary::Poll() {
+    std::vector<std::string> reloaded;
+    if (mSourcePath.empty()) return reloaded;
+
+    std::set<std::string> changed;
+    CollectChangedSources(changed);
+    if (!changed.empty()) {
+        ScanIncludes();
+        // Follow includes to every stage source depending on a changed file
+        std::vector<std::string> toVisit(changed.begin(), changed.end());
+        std::set<std::string> affected;
+        while (!toVisit.empty()) {
+            const std::string filename = toVisit.back();
+            toVisit.pop_back();
+            if (!affected.insert(filename).second) continue;
+            auto it = mIncludedBy.find(filename);
+            if (it == mIncludedBy.end()) continue;
+            toVisit.insert(toVisit.end(), it->second.begin(), it->second.end());
+        }
+
+        // Only recompile shaders something actually uses
+        std::lock_guard lock(mMutex);
+        for (const std::string& filename : affected) {
+            if (!IsStageSource(filename)) continue;
+            const std::string name = filename.substr(0, filename.size() - std::string_view(".hlsl").size());
+            const bool bInUse = std::any_of(mShaders.begin(), mShaders.end(), [&](const auto& entry) { return entry.first.name == name; });
+            if (bInUse) mPendingSources.insert(filename);
+        }
+    }
+
+    if (mCompileJob.valid() && mCompileJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        reloaded = ReloadShaders(mCompileJob.get());
+    }
+    if (!mCompileJob.valid() && !mPendingSources.empty()) {
+        StartCompile(std::move(mPendingSources));
+        mPendingSources.clear();
+    }
+    return reloaded;
+}
+
+void ShaderLibrary::StartCompile(std::set<std::string> sources) {
+    std::string sourcePath = mSourcePath;
+    std::vector<std::pair<std::string, std::string>> jobs; // source file, shader name
+    for (const std::string& filename : sources) {
+        jobs.emplace_back(filename, filename.substr(0, filename.size() - std::string_view(".hlsl").size()));
+    }
+
+    // shadercross only for the format this device consumes
+    auto compile = [this, sourcePath, jobs]() {
+        std::vector<std::string> compiled;
+        for (const auto& [filename, name] : jobs) {
+            const std::string command = std::format("shadercross \"{}/{}\" -I \"{}\" -o \"{}\"",
+                sourcePath, filename, sourcePath, GetCompiledPath(name));
+            const Uint64 startTime = SDL_GetTicksNS();
+            if (std::system(command.c_str()) != 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Shader hot reload: failed to compile %s", filename.c_str());
+                continue;
+            }
+            SDL_Log("Shader hot reload: compiled %s in %.1f ms", filename.c_str(), static_cast<double>(SDL_GetTicksNS() - startTime) / 1e6);
+            compiled.push_back(name);
+        }
+        return compiled;
+    };
+    if (mThreadPool) {
+        mCompileJob = mThreadPool->Submit(std::move(compile));
+    }
+    else {
+        std::promise<std::vector<std::string>> result;
+        result.set_value(compile());
+        mCompileJob = result.get_future();
+    }
+}
+
+std::vector<std::string> ShaderLibrary::ReloadShaders(const std::vector<std::string>& names) {
+    std::vector<std::string> reloaded;
+    std::lock_guard lock(mMutex);
+    for (const std::string& name : names) {
+        bool bReloaded = false;
+        mRecompiled.insert(name);
+        for (auto& [key, shader] : mShaders) {
+            if (key.name != name) continue;
+            // A broken shader keeps the previous version running
+            SDL_GPUShader* newShader = CreateShader(key, true);
+            if (!newShader) continue;
+            if (shader) SDL_ReleaseGPUShader(mDevice, shader);
+            shader = newShader;
+            bReloaded = true;
+        }
+        if (bReloaded) reloaded.push_back(name);
+    }
+    return reloaded;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <future>
+#include <mutex>
+#include <SDL3/SDL_gpu.h>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ContentPack;
+class ThreadPool;
+
+// Resource counts a shader was compiled against, part of the shader's identity for SDL
+struct ShaderResources {
+    Uint32 numSamplers = 0;
+    Uint32 numUniformBuffers = 0;
+    Uint32 numStorageBuffers = 0;
+    Uint32 numStorageTextures = 0;
+
+    bool operator==(const ShaderResources& other) const = default;
+};
+
+// Owns every SDL_GPUShader.
+//  - Compiled blobs are memory mapped from Content/Shaders/Compiled/<format>, or read from the
+//    ContentPack holding them, and handed to SDL directly. Shaders are cached by name, stage
+//    and resource counts.
+//  - With hot reload enabled the HLSL source directory is watched (inotify on Linux, polling
+//    timestamps elsewhere). Changed sources, and the sources including a changed file, are
+//    recompiled with shadercross on the thread pool. Poll() swaps the new shaders in and
+//    returns their names so the pipelines built from them can be recreated. Recompiled shaders
+//    are read from their loose blobs from then on, the pack has the old ones.
+// Thread safe, pipelines are created from worker threads.
+class ShaderLibrary {
+public:
+    ShaderLibrary() = default;
+    ~ShaderLibrary();
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    bool Init(SDL_GPUDevice* device, ThreadPool* threadPool, const std::string& compiledPath, const ContentPack* contentPack = nullptr);
+    void Release();
+
+    // Shader by file name without extension ("PBR.frag"), the stage comes from the name.
+    // Null if the blob is missing or SDL rejected it.
+    SDL_GPUShader* Get(const std::string& name, const ShaderResources& resources);
+
+    // Starts watching sourcePath for changes. Returns false if watching is unavailable.
+    bool EnableHotReload(const std::string& sourcePath);
+
+    // Call once per frame. Returns the names of shaders that were reloaded since the last call.
+    std::vector<std::string> Poll();
+
+private:
+    struct ShaderKey {
+        std::string name;
+        SDL_GPUShaderStage stage;
+        ShaderResources resources;
+
+        bool operator==(const ShaderKey& other) const = default;
+    };
+    struct ShaderKeyHash {
+        size_t operator()(const ShaderKey& key) const;
+    };
+
+    // bRecompiled reads the loose blob even if the pack has one
+    SDL_GPUShader* CreateShader(const ShaderKey& key, const bool bRecompiled) const;
+    std::string GetCompiledPath(const std::string& name) const;
+    void ScanIncludes();
+    void CollectChangedSources(std::set<std::string>& outChanged);
+    void StartCompile(std::set<std::string> sources);
+    std::vector<std::string> ReloadShaders(const std::vector<std::string>& names);
+
+    SDL_GPUDevice* mDevice = nullptr;
+    ThreadPool* mThreadPool = nullptr;
+    const ContentPack* mContentPack = nullptr;
+    std::string mCompiledPath;
+    SDL_GPUShaderFormat mFormat = SDL_GPU_SHADERFORMAT_INVALID;
+    const char* mFormatFolder = "";
+    const char* mFormatExtension = "";
+    const char* mEntrypoint = "main";
+
+    std::mutex mMutex;
+    std::unordered_map<ShaderKey, SDL_GPUShader*, ShaderKeyHash> mShaders;
+
+    // Hot reload
+    std::string mSourcePath;
+    std::unordered_map<std::string, std::set<std::string>> mIncludedBy; // include file -> sources including it
+    std::set<std::string> mPendingSources; // changed while a compile was running
+    std::set<std::string> mRecompiled; // names of the shaders hot reload compiled, guarded by mMutex
+    std::future<std::vector<std::string>> mCompileJob; // names of the shaders that compiled
+    std::unordered_map<std::string, long long> mSourceTimes; // polling fallback
+    Uint64 mLastPollTime = 0;
+    int mWatchFd = -1;
+};
@@ -0,0 +1,175 @@
+#include "StagingRing.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+bool StagingRing::Init(SDL_GPUDevice* device, const Uint32 capacity) {
+    mDevice = device;
+    SDL_GPUTransferBufferCreateInfo createInfo{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = capacity,
+    };
+    mTransferBuffer = SDL_CreateGPUTransferBuffer(mDevice, &createInfo);
+    if (!mTransferBuffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create staging ring: %s", SDL_GetError());
+        return false;
+    }
+    mCapacity = capacity;
+    mStats.capacity = capacity;
+    return true;
+}
+
+void StagingRing::Release() {
+    if (!mDevice) return;
+    Unmap();
+    for (const Batch& batch : mBatches) {
+        if (batch.fence) {
+            SDL_WaitForGPUFences(mDevice, true, &batch.fence, 1);
+            SDL_ReleaseGPUFence(mDevice, batch.fence);
+        }
+    }
+    mBatches.clear();
+    for (SDL_GPUTransferBuffer* buffer : mDedicatedBuffers) {
+        SDL_ReleaseGPUTransferBuffer(mDevice, buffer);
+    }
+    mDedicatedBuffers.clear();
+    mNumUnmappedDedicated = 0;
+    if (mTransferBuffer) SDL_ReleaseGPUTransferBuffer(mDevice, mTransferBuffer);
+    mTransferBuffer = nullptr;
+    mHead = mUsedBytes = mOpenBytes = 0;
+    mDevice = nullptr;
+}
+
+StagingRing::Allocation StagingRing::Allocate(const Uint32 size, const Uint32 alignment) {
+    Reclaim();
+    Allocation allocation{ .size = size };
+    mStats.bytesUploaded += size;
+
+    bool bFits = size <= mCapacity;
+    while (bFits) {
+        // At the head if it fits before the end of the ring, otherwise wrapped to the start with
+        // the tail end counted as used until the batch is reclaimed
+        const Uint32 aligned = (mHead + alignment - 1) / alignment * alignment;
+        const bool bWrap = static_cast<uint64_t>(aligned) + size > mCapacity;
+        const Uint32 offset = bWrap ? 0 : aligned;
+        const Uint32 needed = bWrap ? (mCapacity - mHead) + size : (aligned - mHead) + size;
+        if (static_cast<uint64_t>(mUsedBytes) + needed <= mCapacity) {
+            mHead = offset + size;
+            mUsedBytes += needed;
+            mOpenBytes += needed;
+            allocation.transferBuffer = mTransferBuffer;
+            allocation.offset = offset;
+            break;
+        }
+        // Only batches already submitted can free room, the open one is still being filled
+        bFits = WaitForOldestBatch();
+    }
+
+    if (allocation.transferBuffer) {
+        Uint8* data = Map();
+        allocation.data = data ? data + allocation.offset : nullptr;
+        mStats.bytesInFlight = mUsedBytes;
+        mStats.peakBytesInFlight = std::max<uint64_t>(mStats.peakBytesInFlight, mUsedBytes);
+        return allocation;
+    }
+
+    // Larger than the ring, or than what the open batch left of it
+    ++mStats.numDedicated;
+    SDL_GPUTransferBufferCreateInfo createInfo{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = size,
+    };
+    SDL_GPUTransferBuffer* buffer = SDL_CreateGPUTransferBuffer(mDevice, &createInfo);
+    Uint8* data = buffer ? static_cast<Uint8*>(SDL_MapGPUTransferBuffer(mDevice, buffer, false)) : nullptr;
+    if (!data) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create a %u byte staging buffer: %s", size, SDL_GetError());
+        if (buffer) SDL_ReleaseGPUTransferBuffer(mDevice, buffer);
+        return {};
+    }
+    // Mapped until the next Unmap, which unmaps the whole batch
+    mDedicatedBuffers.push_back(buffer);
+    allocation.transferBuffer = buffer;
+    allocation.data = data;
+    return allocation;
+}
+
+void StagingRing::Upload(SDL_GPUCopyPass* copyPass, const Allocation& allocation, SDL_GPUBuffer* buffer, const Uint32 bufferOffset) {
+    Unmap();
+    const SDL_GPUTransferBufferLocation source{ allocation.transferBuffer, allocation.offset };
+    const SDL_GPUBufferRegion destination{ buffer, bufferOffset, allocation.size };
+    SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
+}
+
+void StagingRing::UploadLevel(SDL_GPUCopyPass* copyPass, const Allocation& allocation, const Uint32 offset, const SDL_GPUTextureRegion& region) {
+    Unmap();
+    const SDL_GPUTextureTransferInfo source{ .transfer_buffer = allocation.transferBuffer, .offset = allocation.offset + offset };
+    SDL_UploadToGPUTexture(copyPass, &source, &region, false);
+}
+
+bool StagingRing::Submit(SDL_GPUCommandBuffer* commandBuffer) {
+    Unmap();
+    SDL_GPUFence* fence = (mOpenBytes > 0) ? SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer) : nullptr;
+    const bool bSubmitted = (mOpenBytes > 0) ? fence != nullptr : SDL_SubmitGPUCommandBuffer(commandBuffer);
+    if (!bSubmitted) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to submit staged uploads: %s", SDL_GetError());
+    }
+    // A failed submission never reads its range, the batch is reclaimed right away (null fence)
+    if (mOpenBytes > 0) {
+        mBatches.push_back({ .fence = fence, .bytes = mOpenBytes });
+        mOpenBytes = 0;
+        ++mStats.numBatches;
+    }
+    // Released once the copies out of them have executed
+    for (SDL_GPUTransferBuffer* buffer : mDedicatedBuffers) {
+        SDL_ReleaseGPUTransferBuffer(mDevice, buffer);
+    }
+    mDedicatedBuffers.clear();
+    mNumUnmappedDedicated = 0;
+    return bSubmitted;
+}
+
+void StagingRing::Reclaim() {
+    while (!mBatches.empty() && (!mBatches.front().fence || SDL_QueryGPUFence(mDevice, mBatches.front().fence))) {
+        if (mBatches.front().fence) SDL_ReleaseGPUFence(mDevice, mBatches.front().fence);
+        mUsedBytes -= mBatches.front().bytes;
+        mBatches.pop_front();
+    }
+    // Nothing in flight, start over so the next batch doesn't straddle the end
+    if (mUsedBytes == 0) {
+        mHead = 0;
+    }
+    mStats.bytesInFlight = mUsedBytes;
+}
+
+bool StagingRing::WaitForOldestBatch() {
+    if (mBatches.empty()) {
+        return false;
+    }
+    ++mStats.numStalls;
+    if (mBatches.front().fence) {
+        SDL_WaitForGPUFences(mDevice, true, &mBatches.front().fence, 1);
+    }
+    Reclaim();
+    return true;
+}
+
+Uint8* StagingRing::Map() {
+    if (!mMappedData) {
+        // Not cycled: ranges still being read belong to batches in flight, which are never written
+        mMappedData = static_cast<Uint8*>(SDL_MapGPUTransferBuffer(mDevice, mTransferBuffer, false));
+        if (!mMappedData) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to map staging ring: %s", SDL_GetError());
+        }
+    }
+    return mMappedData;
+}
+
+void StagingRing::Unmap() {
+    if (mMappedData) {
+        SDL_UnmapGPUTransferBuffer(mDevice, mTransferBuffer);
+        mMappedData = nullptr;
+    }
+    for (; mNumUnmappedDedicated < mDedicatedBuffers.size(); ++mNumUnmappedDedicated) {
+        SDL_UnmapGPUTransferBuffer(mDevice, mDedicatedBuffers[mNumUnmappedDedicated]);
+    }
+}
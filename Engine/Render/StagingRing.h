@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// One persistently allocated upload transfer buffer that every buffer and texture upload is
+// sub-allocated from, in place of a transfer buffer created and released per upload.
+//  - Allocate hands out the next aligned range of the ring, mapped for writing. Upload/UploadLevel
+//    record the copy out of it (unmapping first, SDL can't encode copies from a mapped buffer).
+//  - Submit submits the command buffer holding the copies and fences everything allocated since
+//    the previous Submit as one batch. Batches are reclaimed in order once their fence signals.
+//  - When the ring is full Allocate waits for the oldest batch. A request larger than the whole
+//    ring gets a dedicated transfer buffer, released with its batch.
+// Callers allocate, fill and record a batch at a time, and must Submit every command buffer that
+// recorded copies out of the ring through it.
+class StagingRing {
+public:
+    struct Allocation {
+        SDL_GPUTransferBuffer* transferBuffer = nullptr;
+        Uint32 offset = 0;
+        Uint32 size = 0;
+        Uint8* data = nullptr; // writable until the next Upload/UploadLevel/Submit
+        bool IsValid() const { return data != nullptr; }
+    };
+
+    bool Init(SDL_GPUDevice* device, const Uint32 capacity);
+    // Waits for every batch in flight
+    void Release();
+
+    Allocation Allocate(const Uint32 size, const Uint32 alignment = 16);
+
+    void Upload(SDL_GPUCopyPass* copyPass, const Allocation& allocation, SDL_GPUBuffer* buffer, const Uint32 bufferOffset = 0);
+    // offset is from the start of the allocation
+    void UploadLevel(SDL_GPUCopyPass* copyPass, const Allocation& allocation, const Uint32 offset, const SDL_GPUTextureRegion& region);
+
+    // Submits commandBuffer and fences the current batch with it
+    bool Submit(SDL_GPUCommandBuffer* commandBuffer);
+    // Frees the batches the GPU is done with. Allocate does this as needed.
+    void Reclaim();
+
+    const StagingStats* GetStats() const { return &mStats; }
+
+private:
+    struct Batch {
+        SDL_GPUFence* fence = nullptr;
+        Uint32 bytes = 0; // of the ring, alignment and wrap padding included
+    };
+
+    Uint8* Map();
+    void Unmap();
+    bool WaitForOldestBatch();
+
+    SDL_GPUDevice* mDevice = nullptr;
+    SDL_GPUTransferBuffer* mTransferBuffer = nullptr;
+    Uint8* mMappedData = nullptr;
+    Uint32 mCapacity = 0;
+    Uint32 mHead = 0;      // next free byte
+    Uint32 mUsedBytes = 0; // from the oldest batch in flight to mHead
+    Uint32 mOpenBytes = 0; // allocated since the last Submit
+    std::deque<Batch> mBatches; // submitted, oldest first
+    std::vector<SDL_GPUTransferBuffer*> mDedicatedBuffers; // of the open batch
+    size_t mNumUnmappedDedicated = 0; // the rest are still mapped
+    StagingStats mStats;
+};
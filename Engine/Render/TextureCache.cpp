@@ -0,0 +1,153 @@
+#include "TextureCache.h"
+
+#include <Render/MaterialTable.h>
+#include <SDL3/SDL.h>
+#include <cstring>
+
+namespace {
+    constexpr uint64_t s_Prime1 = 0x9e3779b185ebca87ull;
+    constexpr uint64_t s_Prime2 = 0xc2b2ae3d27d4eb4full;
+    constexpr uint64_t s_Prime3 = 0x165667b19e3779f9ull;
+
+    inline uint64_t RotateLeft(const uint64_t value, const int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t ReadWord(const uint8_t* data) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+
+    inline uint64_t Round(const uint64_t accumulator, const uint64_t word) {
+        return RotateLeft(accumulator + word * s_Prime2, 31) * s_Prime1;
+    }
+
+    inline uint64_t Avalanche(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= s_Prime2;
+        hash ^= hash >> 29;
+        hash *= s_Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
+
+void TextureCache::Init(MaterialTable* materialTable) {
+    mMaterialTable = materialTable;
+}
+
+void TextureCache::Release() {
+    if (!mMaterialTable) return;
+    for (auto& [key, entry] : mEntries) {
+        mMaterialTable->FreeTexture(entry.slot);
+    }
+    mEntries.clear();
+    mKeys.clear();
+    mStats.numTextures = 0;
+}
+
+// Four independent lanes of 8 byte words so large images hash at memory speed
+uint64_t TextureCache::HashContent(const void* data, const size_t size, const uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint8_t* end = bytes + size;
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t lanes[4] = { seed + s_Prime1 + s_Prime2, seed + s_Prime2, seed, seed - s_Prime1 };
+        for (; end - bytes >= 32; bytes += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                lanes[lane] = Round(lanes[lane], ReadWord(bytes + lane * 8));
+            }
+        }
+        hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+        for (const uint64_t lane : lanes) {
+            hash = (hash ^ Round(0, lane)) * s_Prime1 + s_Prime3;
+        }
+    }
+    else {
+        hash = seed + s_Prime3;
+    }
+    hash += static_cast<uint64_t>(size);
+
+    for (; end - bytes >= 8; bytes += 8) {
+        hash = RotateLeft(hash ^ Round(0, ReadWord(bytes)), 27) * s_Prime1 + s_Prime3;
+    }
+    for (; bytes < end; ++bytes) {
+        hash = RotateLeft(hash ^ (*bytes * s_Prime3), 11) * s_Prime1;
+    }
+    return Avalanche(hash);
+}
+
+TextureSlot TextureCache::Acquire(const uint64_t key) {
+    ++mStats.numRequests;
+    auto it = mEntries.find(key);
+    if (it == mEntries.end()) {
+        return {};
+    }
+    ++it->second.refCount;
+    ++mStats.numHits;
+    mStats.bytesSaved += it->second.bytes;
+    return it->second.slot;
+}
+
+void TextureCache::Add(const uint64_t key, const TextureSlot slot, const uint64_t bytes) {
+    SDL_assert(slot.IsValid() && !mEntries.contains(key));
+    mEntries[key] = { .slot = slot, .bytes = bytes, .refCount = 1 };
+    mKeys[slot.Pack()] = key;
+    ++mStats.numTextures;
+}
+
+TextureSlot TextureCache::AcquireFallback(const FallbackTexture kind) {
+    const TextureSlot slot = Acquire(GetFallbackKey(kind));
+    if (slot.IsValid()) {
+        ++mStats.numFallbackHits;
+    }
+    return slot;
+}
+
+void TextureCache::AddFallback(const FallbackTexture kind, const TextureSlot slot, const uint64_t bytes) {
+    Add(GetFallbackKey(kind), slot, bytes);
+}
+
+bool TextureCache::Release(const TextureSlot slot) {
+    auto keyIt = mKeys.find(slot.Pack());
+    if (keyIt == mKeys.end()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Released a texture that isn't in the texture cache");
+        return false;
+    }
+    auto entryIt = mEntries.find(keyIt->second);
+    SDL_assert(entryIt != mEntries.end() && entryIt->second.refCount > 0);
+    if (--entryIt->second.refCount > 0) {
+        return false;
+    }
+    mMaterialTable->FreeTexture(slot);
+    mEntries.erase(entryIt);
+    mKeys.erase(keyIt);
+    --mStats.numTextures;
+    return true;
+}
+
+uint64_t TextureCache::GetKey(const TextureSlot slot) const {
+    auto keyIt = mKeys.find(slot.Pack());
+    return (keyIt != mKeys.end()) ? keyIt->second : 0;
+}
+
+void TextureCache::Relocate(const TextureSlot from, const TextureSlot to, const int64_t byteDelta) {
+    auto keyIt = mKeys.find(from.Pack());
+    if (keyIt == mKeys.end()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Relocated a texture that isn't in the texture cache");
+        return;
+    }
+    const uint64_t key = keyIt->second;
+    mKeys.erase(keyIt);
+    mKeys[to.Pack()] = key;
+    Entry& entry = mEntries.at(key);
+    entry.slot = to;
+    entry.bytes = static_cast<uint64_t>(static_cast<int64_t>(entry.bytes) + byteDelta);
+}
+
+// Fallbacks share the key space with content hashes, under a seed no content key uses
+uint64_t TextureCache::GetFallbackKey(const FallbackTexture kind) {
+    const uint8_t value = static_cast<uint8_t>(kind);
+    return HashContent(&value, sizeof(value), s_Prime3);
+}
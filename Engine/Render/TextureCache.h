@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <cstdint>
+#include <unordered_map>
+
+class MaterialTable;
+
+// Constant textures standing in for maps a material doesn't have
+enum class FallbackTexture : uint8_t {
+    Black = 0,  // metalness, emissive
+    FlatNormal,
+    White,      // albedo, roughness, AO
+    Count,
+};
+
+// Renderer wide owner of material textures (MaterialTable layers), shared between every mesh
+// that uses them.
+//  - Textures are keyed by a hash of their source bytes (plus whatever changes how those bytes
+//    are turned into a texture), so the same image referenced by two models is decoded and
+//    uploaded once.
+//  - Fallbacks are keyed by kind, one 1x1 texture each.
+//  - Every Acquire/Add hands out one reference, Release drops it and frees the layer with the
+//    last one.
+// The key is a 64 bit hash and is trusted as is, a collision would share the wrong texture.
+class TextureCache {
+public:
+    void Init(MaterialTable* materialTable);
+    // Frees every texture still referenced
+    void Release();
+
+    static uint64_t HashContent(const void* data, const size_t size, const uint64_t seed = 0);
+
+    // Cached texture for the key with a new reference, or an invalid slot if it isn't loaded
+    TextureSlot Acquire(const uint64_t key);
+    // Adds a texture created for the key, holding one reference. bytes is its GPU size, for the stats.
+    void Add(const uint64_t key, const TextureSlot slot, const uint64_t bytes);
+
+    TextureSlot AcquireFallback(const FallbackTexture kind);
+    void AddFallback(const FallbackTexture kind, const TextureSlot slot, const uint64_t bytes);
+
+    // Drops a reference to a texture handed out by Acquire/Add. True if that freed the texture.
+    bool Release(const TextureSlot slot);
+    // The key a texture was added for, 0 if the slot isn't cached
+    uint64_t GetKey(const TextureSlot slot) const;
+    // A texture moved to another layer (see TextureStreamer), its size changing by byteDelta.
+    // References handed out for from are released through to from now on.
+    void Relocate(const TextureSlot from, const TextureSlot to, const int64_t byteDelta);
+
+    const TextureCacheStats* GetStats() const { return &mStats; }
+
+private:
+    struct Entry {
+        TextureSlot slot;
+        uint64_t bytes = 0;
+        uint32_t refCount = 0;
+    };
+
+    static uint64_t GetFallbackKey(const FallbackTexture kind);
+
+    MaterialTable* mMaterialTable = nullptr;
+    std::unordered_map<uint64_t, Entry> mEntries;
+    std::unordered_map<uint32_t, uint64_t> mKeys; // packed slot -> key
+    TextureCacheStats mStats;
+};
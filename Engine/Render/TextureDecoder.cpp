@@ -0,0 +1,382 @@
+#include "TextureDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <Render/BC7Tables.h>
+
+namespace {
+    struct BC7ModeInfo {
+        uint8_t numSubsets;
+        uint8_t partitionBits;
+        uint8_t rotationBits;
+        uint8_t indexSelectionBits;
+        uint8_t colorBits;
+        uint8_t alphaBits;
+        uint8_t endpointPBits; // one p-bit per endpoint
+        uint8_t sharedPBits;   // one p-bit per subset
+        uint8_t indexBits;
+        uint8_t secondaryIndexBits;
+    };
+
+    constexpr BC7ModeInfo s_BC7Modes[8] = {
+        {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+        {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+        {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+        {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+        {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+        {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+        {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+        {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+    };
+
+    // Reads a little endian bit stream, as BC7 blocks are laid out
+    class BitReader {
+    public:
+        explicit BitReader(const uint8_t* data) : mData(data) {}
+
+        uint32_t Read(const uint32_t numBits) {
+            uint32_t value = 0;
+            for (uint32_t bit = 0; bit < numBits; ++bit, ++mPosition) {
+                value |= ((mData[mPosition >> 3] >> (mPosition & 7)) & 1u) << bit;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* mData;
+        uint32_t mPosition = 0;
+    };
+
+    uint8_t ExpandBits(uint32_t value, const uint32_t numBits) {
+        value <<= 8 - numBits;
+        return static_cast<uint8_t>(value | (value >> numBits));
+    }
+
+    uint8_t Interpolate(const uint8_t e0, const uint8_t e1, const uint32_t weight) {
+        return static_cast<uint8_t>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+    }
+
+    const uint8_t* GetWeights(const uint32_t numBits) {
+        return numBits == 2 ? s_BC7Weights2 : (numBits == 3 ? s_BC7Weights3 : s_BC7Weights4);
+    }
+
+    uint16_t ReadU16(const uint8_t* data) {
+        return static_cast<uint16_t>(data[0] | (data[1] << 8));
+    }
+
+    // Color half of BC1/2/3. Only BC1 switches to 3 colors + transparent black when c0 <= c1.
+    void DecodeColorBlock(const uint8_t* block, uint8_t* outTexels, const bool bAllowPunchThrough) {
+        const uint16_t c0 = ReadU16(block);
+        const uint16_t c1 = ReadU16(block + 2);
+
+        uint8_t palette[4][4];
+        palette[0][0] = ExpandBits((c0 >> 11) & 0x1F, 5);
+        palette[0][1] = ExpandBits((c0 >> 5) & 0x3F, 6);
+        palette[0][2] = ExpandBits(c0 & 0x1F, 5);
+        palette[0][3] = 255;
+        palette[1][0] = ExpandBits((c1 >> 11) & 0x1F, 5);
+        palette[1][1] = ExpandBits((c1 >> 5) & 0x3F, 6);
+        palette[1][2] = ExpandBits(c1 & 0x1F, 5);
+        palette[1][3] = 255;
+
+        if (c0 > c1 || !bAllowPunchThrough) {
+            for (uint32_t channel = 0; channel < 3; ++channel) {
+                palette[2][channel] = static_cast<uint8_t>((2 * palette[0][channel] + palette[1][channel]) / 3);
+                palette[3][channel] = static_cast<uint8_t>((palette[0][channel] + 2 * palette[1][channel]) / 3);
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 255;
+        }
+        else {
+            for (uint32_t channel = 0; channel < 3; ++channel) {
+                palette[2][channel] = static_cast<uint8_t>((palette[0][channel] + palette[1][channel]) / 2);
+                palette[3][channel] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+
+        uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+        for (uint32_t texel = 0; texel < 16; ++texel, indices >>= 2) {
+            std::memcpy(outTexels + texel * 4, palette[indices & 3], 4);
+        }
+    }
+
+    // Single channel half of BC3/4/5, written to every 4th byte starting at outChannel
+    void DecodeChannelBlock(const uint8_t* block, uint8_t* outChannel) {
+        const uint8_t a0 = block[0];
+        const uint8_t a1 = block[1];
+
+        uint8_t palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (uint32_t i = 1; i < 7; ++i) {
+                palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7);
+            }
+        }
+        else {
+            for (uint32_t i = 1; i < 5; ++i) {
+                palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 6; ++i) {
+            indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+        }
+        for (uint32_t texel = 0; texel < 16; ++texel, indices >>= 3) {
+            outChannel[texel * 4] = palette[indices & 7];
+        }
+    }
+
+    uint32_t GetBlockSize(const SDL_GPUTextureFormat format) {
+        switch (format) {
+            case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+            case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB:
+            case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+                return 8;
+            default:
+                return 16;
+        }
+    }
+}
+
+void TextureDecoder::DecodeBC1Block(const uint8_t* block, uint8_t* outTexels) {
+    DecodeColorBlock(block, outTexels, true);
+}
+
+void TextureDecoder::DecodeBC2Block(const uint8_t* block, uint8_t* outTexels) {
+    DecodeColorBlock(block + 8, outTexels, false);
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        const uint8_t alpha = (block[texel / 2] >> ((texel & 1) * 4)) & 0xF;
+        outTexels[texel * 4 + 3] = static_cast<uint8_t>(alpha * 17);
+    }
+}
+
+void TextureDecoder::DecodeBC3Block(const uint8_t* block, uint8_t* outTexels) {
+    DecodeColorBlock(block + 8, outTexels, false);
+    DecodeChannelBlock(block, outTexels + 3);
+}
+
+void TextureDecoder::DecodeBC4Block(const uint8_t* block, uint8_t* outTexels) {
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        outTexels[texel * 4 + 1] = 0;
+        outTexels[texel * 4 + 2] = 0;
+        outTexels[texel * 4 + 3] = 255;
+    }
+    DecodeChannelBlock(block, outTexels);
+}
+
+void TextureDecoder::DecodeBC5Block(const uint8_t* block, uint8_t* outTexels) {
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        outTexels[texel * 4 + 2] = 0;
+        outTexels[texel * 4 + 3] = 255;
+    }
+    DecodeChannelBlock(block, outTexels);
+    DecodeChannelBlock(block + 8, outTexels + 1);
+}
+
+void TextureDecoder::DecodeBC7Block(const uint8_t* block, uint8_t* outTexels) {
+    uint32_t mode = 0;
+    while (mode < 8 && !(block[0] & (1u << mode))) {
+        ++mode;
+    }
+    // Reserved mode, decodes to transparent black
+    if (mode == 8) {
+        std::memset(outTexels, 0, 64);
+        return;
+    }
+
+    const BC7ModeInfo& info = s_BC7Modes[mode];
+    BitReader reader(block);
+    reader.Read(mode + 1);
+
+    const uint32_t partition = reader.Read(info.partitionBits);
+    const uint32_t rotation = reader.Read(info.rotationBits);
+    const uint32_t indexSelection = reader.Read(info.indexSelectionBits);
+
+    // endpoints[subset * 2 + end][channel]
+    uint8_t endpoints[6][4] = {};
+    const uint32_t numEndpoints = info.numSubsets * 2;
+    for (uint32_t channel = 0; channel < 3; ++channel) {
+        for (uint32_t endpoint = 0; endpoint < numEndpoints; ++endpoint) {
+            endpoints[endpoint][channel] = static_cast<uint8_t>(reader.Read(info.colorBits));
+        }
+    }
+    if (info.alphaBits) {
+        for (uint32_t endpoint = 0; endpoint < numEndpoints; ++endpoint) {
+            endpoints[endpoint][3] = static_cast<uint8_t>(reader.Read(info.alphaBits));
+        }
+    }
+
+    uint32_t pBits[6] = {};
+    if (info.endpointPBits) {
+        for (uint32_t endpoint = 0; endpoint < numEndpoints; ++endpoint) {
+            pBits[endpoint] = reader.Read(1);
+        }
+    }
+    else if (info.sharedPBits) {
+        for (uint32_t subset = 0; subset < info.numSubsets; ++subset) {
+            pBits[subset * 2] = pBits[subset * 2 + 1] = reader.Read(1);
+        }
+    }
+
+    const bool bHasPBits = info.endpointPBits || info.sharedPBits;
+    const uint32_t colorBits = info.colorBits + (bHasPBits ? 1 : 0);
+    const uint32_t alphaBits = info.alphaBits + (bHasPBits ? 1 : 0);
+    for (uint32_t endpoint = 0; endpoint < numEndpoints; ++endpoint) {
+        for (uint32_t channel = 0; channel < 3; ++channel) {
+            uint32_t value = endpoints[endpoint][channel];
+            if (bHasPBits) {
+                value = (value << 1) | pBits[endpoint];
+            }
+            endpoints[endpoint][channel] = ExpandBits(value, colorBits);
+        }
+        if (info.alphaBits) {
+            uint32_t value = endpoints[endpoint][3];
+            if (bHasPBits) {
+                value = (value << 1) | pBits[endpoint];
+            }
+            endpoints[endpoint][3] = ExpandBits(value, alphaBits);
+        }
+        else {
+            endpoints[endpoint][3] = 255;
+        }
+    }
+
+    const uint8_t* subsets = nullptr;
+    if (info.numSubsets == 2) {
+        subsets = s_Partitions2[partition];
+    }
+    else if (info.numSubsets == 3) {
+        subsets = s_Partitions3[partition];
+    }
+
+    auto isAnchor = [&](const uint32_t texel) {
+        if (texel == 0) {
+            return true;
+        }
+        if (info.numSubsets == 2) {
+            return texel == s_Anchors2[partition];
+        }
+        if (info.numSubsets == 3) {
+            return texel == s_Anchors3Second[partition] || texel == s_Anchors3Third[partition];
+        }
+        return false;
+    };
+
+    uint32_t indices[16];
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        indices[texel] = reader.Read(isAnchor(texel) ? info.indexBits - 1 : info.indexBits);
+    }
+    uint32_t secondaryIndices[16] = {};
+    if (info.secondaryIndexBits) {
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            secondaryIndices[texel] = reader.Read(texel == 0 ? info.secondaryIndexBits - 1 : info.secondaryIndexBits);
+        }
+    }
+
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        const uint32_t subset = subsets ? subsets[texel] : 0;
+        const uint8_t* e0 = endpoints[subset * 2];
+        const uint8_t* e1 = endpoints[subset * 2 + 1];
+        uint8_t* out = outTexels + texel * 4;
+
+        if (info.secondaryIndexBits) {
+            // Modes 4/5 index color and alpha separately, the selection bit swaps which set is which
+            uint32_t colorIndex = indices[texel];
+            uint32_t colorIndexBits = info.indexBits;
+            uint32_t alphaIndex = secondaryIndices[texel];
+            uint32_t alphaIndexBits = info.secondaryIndexBits;
+            if (indexSelection) {
+                std::swap(colorIndex, alphaIndex);
+                std::swap(colorIndexBits, alphaIndexBits);
+            }
+            const uint32_t colorWeight = GetWeights(colorIndexBits)[colorIndex];
+            for (uint32_t channel = 0; channel < 3; ++channel) {
+                out[channel] = Interpolate(e0[channel], e1[channel], colorWeight);
+            }
+            out[3] = Interpolate(e0[3], e1[3], GetWeights(alphaIndexBits)[alphaIndex]);
+        }
+        else {
+            const uint32_t weight = GetWeights(info.indexBits)[indices[texel]];
+            for (uint32_t channel = 0; channel < 4; ++channel) {
+                out[channel] = Interpolate(e0[channel], e1[channel], weight);
+            }
+        }
+
+        if (rotation) {
+            std::swap(out[3], out[rotation - 1]);
+        }
+    }
+}
+
+bool TextureDecoder::CanDecompress(const SDL_GPUTextureFormat format) {
+    switch (format) {
+        case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB:
+        case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM_SRGB:
+        case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM_SRGB:
+        case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool TextureDecoder::Decompress(const SDL_GPUTextureFormat format, const uint8_t* blocks, const uint32_t width, const uint32_t height, uint8_t* outPixels) {
+    void (*decodeBlock)(const uint8_t*, uint8_t*) = nullptr;
+    switch (format) {
+        case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB:
+            decodeBlock = DecodeBC1Block;
+            break;
+        case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM_SRGB:
+            decodeBlock = DecodeBC2Block;
+            break;
+        case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM_SRGB:
+            decodeBlock = DecodeBC3Block;
+            break;
+        case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+            decodeBlock = DecodeBC4Block;
+            break;
+        case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:
+            decodeBlock = DecodeBC5Block;
+            break;
+        case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB:
+            decodeBlock = DecodeBC7Block;
+            break;
+        default:
+            return false;
+    }
+
+    const uint32_t blockSize = GetBlockSize(format);
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    uint8_t texels[64];
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+            decodeBlock(blocks + (blockY * blocksX + blockX) * blockSize, texels);
+
+            // Edge blocks of non multiple of 4 sizes are clipped
+            const uint32_t rows = std::min(4u, height - blockY * 4);
+            const uint32_t columns = std::min(4u, width - blockX * 4);
+            for (uint32_t row = 0; row < rows; ++row) {
+                uint8_t* dst = outPixels + ((static_cast<size_t>(blockY) * 4 + row) * width + blockX * 4) * 4;
+                std::memcpy(dst, texels + row * 16, columns * 4);
+            }
+        }
+    }
+    return true;
+}
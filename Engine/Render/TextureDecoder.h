@@ -0,0 +1,22 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+// CPU decoders for block compressed textures, used where the GPU can't sample the format.
+// Blocks decode to 4x4 RGBA8 texels in row order. BC4/BC5 fill the unused channels like the
+// GPU would sample them (0 for G/B, 255 for alpha).
+namespace TextureDecoder {
+    void DecodeBC1Block(const uint8_t* block, uint8_t* outTexels);
+    void DecodeBC2Block(const uint8_t* block, uint8_t* outTexels);
+    void DecodeBC3Block(const uint8_t* block, uint8_t* outTexels);
+    void DecodeBC4Block(const uint8_t* block, uint8_t* outTexels);
+    void DecodeBC5Block(const uint8_t* block, uint8_t* outTexels);
+    void DecodeBC7Block(const uint8_t* block, uint8_t* outTexels);
+
+    // BC1/2/3/4/5/7, sRGB variants included. BC6H and ASTC have no CPU decoder.
+    bool CanDecompress(const SDL_GPUTextureFormat format);
+
+    // Decodes a width x height image into tightly packed RGBA8 (width * height * 4 bytes)
+    bool Decompress(const SDL_GPUTextureFormat format, const uint8_t* blocks, const uint32_t width, const uint32_t height, uint8_t* outPixels);
+}
@@ -0,0 +1,759 @@
+#include "TextureEncoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <Render/BC7Tables.h>
+#include <Render/TextureDecoder.h>
+#include <Render/TextureFile.h>
+#include <Render/TextureUtils.h>
+#include <ThreadPool.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define TEXTURE_ENCODER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // A 4x4 block split per channel, so four texels can be compared against a palette entry at once
+    struct BlockTexels {
+        alignas(16) float channels[4][16];
+    };
+
+    BlockTexels LoadBlock(const uint8_t* texels) {
+        BlockTexels block;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            for (uint32_t channel = 0; channel < 4; ++channel) {
+                block.channels[channel][texel] = texels[texel * 4 + channel];
+            }
+        }
+        return block;
+    }
+
+    // Picks the closest palette entry for every texel over the first numChannels channels.
+    // outErrors receives each texel's squared error so callers can sum over a subset.
+    void FindClosest(const BlockTexels& block, const float (*palette)[4], const uint32_t numEntries, const uint32_t numChannels,
+            uint8_t* outIndices, float* outErrors) {
+#if TEXTURE_ENCODER_SSE2
+        for (uint32_t group = 0; group < 16; group += 4) {
+            __m128 channels[4];
+            for (uint32_t channel = 0; channel < numChannels; ++channel) {
+                channels[channel] = _mm_load_ps(&block.channels[channel][group]);
+            }
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128i bestIndex = _mm_setzero_si128();
+            for (uint32_t entry = 0; entry < numEntries; ++entry) {
+                __m128 error = _mm_setzero_ps();
+                for (uint32_t channel = 0; channel < numChannels; ++channel) {
+                    const __m128 delta = _mm_sub_ps(channels[channel], _mm_set1_ps(palette[entry][channel]));
+                    error = _mm_add_ps(error, _mm_mul_ps(delta, delta));
+                }
+                const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(entry))), _mm_andnot_si128(closer, bestIndex));
+            }
+            alignas(16) int32_t indices[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+            _mm_storeu_ps(outErrors + group, bestError);
+            for (uint32_t i = 0; i < 4; ++i) {
+                outIndices[group + i] = static_cast<uint8_t>(indices[i]);
+            }
+        }
+#else
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            float bestError = FLT_MAX;
+            uint8_t bestIndex = 0;
+            for (uint32_t entry = 0; entry < numEntries; ++entry) {
+                float error = 0.0f;
+                for (uint32_t channel = 0; channel < numChannels; ++channel) {
+                    const float delta = block.channels[channel][texel] - palette[entry][channel];
+                    error += delta * delta;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = static_cast<uint8_t>(entry);
+                }
+            }
+            outIndices[texel] = bestIndex;
+            outErrors[texel] = bestError;
+        }
+#endif
+    }
+
+    // Endpoints spanning the texels of one subset along their principal axis.
+    // subsets == nullptr means every texel belongs to the subset.
+    void FitPrincipalAxis(const BlockTexels& block, const uint8_t* subsets, const uint32_t subset, const uint32_t numChannels,
+            float outEndpoints[2][4]) {
+        float mean[4] = {};
+        uint32_t count = 0;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            if (subsets && subsets[texel] != subset) continue;
+            for (uint32_t channel = 0; channel < numChannels; ++channel) {
+                mean[channel] += block.channels[channel][texel];
+            }
+            ++count;
+        }
+        for (uint32_t channel = 0; channel < numChannels; ++channel) {
+            mean[channel] /= static_cast<float>(std::max(count, 1u));
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            if (subsets && subsets[texel] != subset) continue;
+            for (uint32_t i = 0; i < numChannels; ++i) {
+                for (uint32_t j = i; j < numChannels; ++j) {
+                    covariance[i][j] += (block.channels[i][texel] - mean[i]) * (block.channels[j][texel] - mean[j]);
+                }
+            }
+        }
+        for (uint32_t i = 0; i < numChannels; ++i) {
+            for (uint32_t j = 0; j < i; ++j) {
+                covariance[i][j] = covariance[j][i];
+            }
+        }
+
+        // Power iteration converges quickly enough for 4x4 covariance matrices
+        float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t i = 0; i < numChannels; ++i) {
+                for (uint32_t j = 0; j < numChannels; ++j) {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                length = std::max(length, std::abs(next[i]));
+            }
+            if (length < 1e-6f) break;
+            for (uint32_t i = 0; i < numChannels; ++i) {
+                axis[i] = next[i] / length;
+            }
+        }
+        float axisLength = 0.0f;
+        for (uint32_t channel = 0; channel < numChannels; ++channel) {
+            axisLength += axis[channel] * axis[channel];
+        }
+        axisLength = std::sqrt(axisLength);
+        for (uint32_t channel = 0; channel < numChannels; ++channel) {
+            axis[channel] = axisLength > 0.0f ? axis[channel] / axisLength : 0.0f;
+        }
+
+        float minT = FLT_MAX;
+        float maxT = -FLT_MAX;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            if (subsets && subsets[texel] != subset) continue;
+            float t = 0.0f;
+            for (uint32_t channel = 0; channel < numChannels; ++channel) {
+                t += (block.channels[channel][texel] - mean[channel]) * axis[channel];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        if (count == 0) {
+            minT = maxT = 0.0f;
+        }
+        for (uint32_t channel = 0; channel < 4; ++channel) {
+            const float value = channel < numChannels ? mean[channel] : 255.0f;
+            const float direction = channel < numChannels ? axis[channel] : 0.0f;
+            outEndpoints[0][channel] = std::clamp(value + direction * minT, 0.0f, 255.0f);
+            outEndpoints[1][channel] = std::clamp(value + direction * maxT, 0.0f, 255.0f);
+        }
+    }
+
+    // Least squares endpoints for fixed indices, weights[texel] being the interpolation factor
+    // (0 = first endpoint, 1 = second). Leaves the endpoints alone if the system is singular.
+    void RefineEndpoints(const BlockTexels& block, const uint8_t* subsets, const uint32_t subset, const uint32_t numChannels,
+            const float* weights, float outEndpoints[2][4]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {};
+        float bx[4] = {};
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            if (subsets && subsets[texel] != subset) continue;
+            const float b = weights[texel];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t channel = 0; channel < numChannels; ++channel) {
+                ax[channel] += a * block.channels[channel][texel];
+                bx[channel] += b * block.channels[channel][texel];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) return;
+        for (uint32_t channel = 0; channel < numChannels; ++channel) {
+            outEndpoints[0][channel] = std::clamp((bb * ax[channel] - ab * bx[channel]) / determinant, 0.0f, 255.0f);
+            outEndpoints[1][channel] = std::clamp((aa * bx[channel] - ab * ax[channel]) / determinant, 0.0f, 255.0f);
+        }
+    }
+
+    uint32_t GetRefineIterations(const TextureEncoder::Quality quality) {
+        switch (quality) {
+            case TextureEncoder::Quality::Fast:   return 0;
+            case TextureEncoder::Quality::Normal: return 2;
+            default:                              return 4;
+        }
+    }
+
+    class BitWriter {
+    public:
+        explicit BitWriter(uint8_t* data, const size_t size) : mData(data) { std::memset(data, 0, size); }
+
+        void Write(const uint32_t value, const uint32_t numBits) {
+            for (uint32_t bit = 0; bit < numBits; ++bit, ++mPosition) {
+                mData[mPosition >> 3] |= static_cast<uint8_t>(((value >> bit) & 1u) << (mPosition & 7));
+            }
+        }
+
+    private:
+        uint8_t* mData;
+        uint32_t mPosition = 0;
+    };
+
+    uint8_t ExpandBits(uint32_t value, const uint32_t numBits) {
+        value <<= 8 - numBits;
+        return static_cast<uint8_t>(value | (value >> numBits));
+    }
+
+    uint8_t Interpolate(const uint8_t e0, const uint8_t e1, const uint32_t weight) {
+        return static_cast<uint8_t>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+    }
+
+    // BC1 -------------------------------------------------------------------------------------
+
+    uint16_t QuantizeRGB565(const float color[4]) {
+        const uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+        const uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+        const uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    // Palette exactly as TextureDecoder rebuilds it, four color mode (c0 > c1)
+    void BuildBC1Palette(const uint16_t c0, const uint16_t c1, float outPalette[4][4]) {
+        const uint8_t colors[2][3] = {
+            {ExpandBits((c0 >> 11) & 0x1F, 5), ExpandBits((c0 >> 5) & 0x3F, 6), ExpandBits(c0 & 0x1F, 5)},
+            {ExpandBits((c1 >> 11) & 0x1F, 5), ExpandBits((c1 >> 5) & 0x3F, 6), ExpandBits(c1 & 0x1F, 5)},
+        };
+        for (uint32_t channel = 0; channel < 3; ++channel) {
+            outPalette[0][channel] = colors[0][channel];
+            outPalette[1][channel] = colors[1][channel];
+            outPalette[2][channel] = static_cast<float>((2 * colors[0][channel] + colors[1][channel]) / 3);
+            outPalette[3][channel] = static_cast<float>((colors[0][channel] + 2 * colors[1][channel]) / 3);
+        }
+        for (uint32_t entry = 0; entry < 4; ++entry) {
+            outPalette[entry][3] = 255.0f;
+        }
+    }
+
+    // BC4/BC5 ---------------------------------------------------------------------------------
+
+    void BuildChannelPalette(const uint8_t a0, const uint8_t a1, float outPalette[8][4]) {
+        outPalette[0][0] = a0;
+        outPalette[1][0] = a1;
+        for (uint32_t i = 1; i < 7; ++i) {
+            outPalette[i + 1][0] = static_cast<float>(((7 - i) * a0 + i * a1) / 7);
+        }
+    }
+
+    // Encodes one channel of the block into an 8 byte BC4 block, eight value mode only
+    void EncodeChannelBlock(const uint8_t* texels, const uint32_t channel, const TextureEncoder::Quality quality, uint8_t* outBlock) {
+        BlockTexels block;
+        float minValue = 255.0f;
+        float maxValue = 0.0f;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            block.channels[0][texel] = texels[texel * 4 + channel];
+            minValue = std::min(minValue, block.channels[0][texel]);
+            maxValue = std::max(maxValue, block.channels[0][texel]);
+        }
+
+        uint8_t bestEndpoints[2] = {static_cast<uint8_t>(maxValue), static_cast<uint8_t>(minValue)};
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+
+        float palette[8][4];
+        uint8_t indices[16];
+        float errors[16];
+        auto tryEndpoints = [&](const int first, const int second) {
+            // a0 > a1 selects the eight value mode, equal endpoints decode the same in either mode
+            const uint8_t a0 = static_cast<uint8_t>(std::clamp(std::max(first, second), 0, 255));
+            const uint8_t a1 = static_cast<uint8_t>(std::clamp(std::min(first, second), 0, 255));
+            BuildChannelPalette(a0, a1, palette);
+            FindClosest(block, palette, a0 == a1 ? 1 : 8, 1, indices, errors);
+            float error = 0.0f;
+            for (uint32_t texel = 0; texel < 16; ++texel) {
+                error += errors[texel];
+            }
+            if (error < bestError) {
+                bestError = error;
+                bestEndpoints[0] = a0;
+                bestEndpoints[1] = a1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        };
+
+        tryEndpoints(static_cast<int>(maxValue), static_cast<int>(minValue));
+        const uint32_t numIterations = GetRefineIterations(quality);
+        for (uint32_t iteration = 0; iteration < numIterations && bestError > 0.0f; ++iteration) {
+            float weights[16];
+            for (uint32_t texel = 0; texel < 16; ++texel) {
+                weights[texel] = bestIndices[texel] == 0 ? 0.0f : (bestIndices[texel] == 1 ? 1.0f : (bestIndices[texel] - 1) / 7.0f);
+            }
+            float endpoints[2][4] = {{static_cast<float>(bestEndpoints[0])}, {static_cast<float>(bestEndpoints[1])}};
+            RefineEndpoints(block, nullptr, 0, 1, weights, endpoints);
+            tryEndpoints(static_cast<int>(std::lround(endpoints[0][0])), static_cast<int>(std::lround(endpoints[1][0])));
+        }
+        if (quality == TextureEncoder::Quality::High) {
+            const int a0 = bestEndpoints[0];
+            const int a1 = bestEndpoints[1];
+            for (int delta0 = -1; delta0 <= 1; ++delta0) {
+                for (int delta1 = -1; delta1 <= 1; ++delta1) {
+                    tryEndpoints(a0 + delta0, a1 + delta1);
+                }
+            }
+        }
+
+        outBlock[0] = bestEndpoints[0];
+        outBlock[1] = bestEndpoints[1];
+        uint64_t packed = 0;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            packed |= static_cast<uint64_t>(bestIndices[texel] & 7) << (texel * 3);
+        }
+        for (uint32_t i = 0; i < 6; ++i) {
+            outBlock[2 + i] = static_cast<uint8_t>(packed >> (i * 8));
+        }
+    }
+
+    // BC7 -------------------------------------------------------------------------------------
+
+    struct BC7Candidate {
+        float error = FLT_MAX;
+        uint8_t block[16] = {};
+    };
+
+    // Mode 6: one subset, RGBA 7 bits + a p-bit per endpoint, 4 bit indices
+    void EncodeBC7Mode6(const BlockTexels& block, const TextureEncoder::Quality quality, BC7Candidate& inOutBest) {
+        float endpoints[2][4];
+        FitPrincipalAxis(block, nullptr, 0, 4, endpoints);
+
+        float palette[16][4];
+        uint8_t indices[16];
+        float errors[16];
+        uint8_t bestValues[2][4] = {};
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+
+        const uint32_t numIterations = GetRefineIterations(quality);
+        for (uint32_t iteration = 0; iteration <= numIterations; ++iteration) {
+            // Quantize to 7 bits per channel with a shared p-bit per endpoint. Fast keeps the
+            // p-bit closest to the endpoint, the others try all four combinations on the block.
+            uint8_t candidates[2][2][4];
+            float quantizationError[2][2] = {};
+            for (uint32_t end = 0; end < 2; ++end) {
+                for (uint32_t pBit = 0; pBit < 2; ++pBit) {
+                    for (uint32_t channel = 0; channel < 4; ++channel) {
+                        const long q = std::clamp(std::lround((endpoints[end][channel] - pBit) / 2.0f), 0l, 127l);
+                        candidates[end][pBit][channel] = static_cast<uint8_t>((q << 1) | pBit);
+                        const float delta = endpoints[end][channel] - candidates[end][pBit][channel];
+                        quantizationError[end][pBit] += delta * delta;
+                    }
+                }
+            }
+
+            for (uint32_t combination = 0; combination < 4; ++combination) {
+                const uint32_t p0 = combination & 1;
+                const uint32_t p1 = combination >> 1;
+                if (quality == TextureEncoder::Quality::Fast
+                    && (quantizationError[0][p0] > quantizationError[0][p0 ^ 1] || quantizationError[1][p1] > quantizationError[1][p1 ^ 1])) {
+                    continue;
+                }
+                const uint8_t* e0 = candidates[0][p0];
+                const uint8_t* e1 = candidates[1][p1];
+                for (uint32_t entry = 0; entry < 16; ++entry) {
+                    for (uint32_t channel = 0; channel < 4; ++channel) {
+                        palette[entry][channel] = Interpolate(e0[channel], e1[channel], s_BC7Weights4[entry]);
+                    }
+                }
+                FindClosest(block, palette, 16, 4, indices, errors);
+                float error = 0.0f;
+                for (uint32_t texel = 0; texel < 16; ++texel) {
+                    error += errors[texel];
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    std::memcpy(bestValues[0], e0, 4);
+                    std::memcpy(bestValues[1], e1, 4);
+                    std::memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+
+            if (iteration == numIterations || bestError == 0.0f) break;
+            float weights[16];
+            for (uint32_t texel = 0; texel < 16; ++texel) {
+                weights[texel] = s_BC7Weights4[bestIndices[texel]] / 64.0f;
+            }
+            RefineEndpoints(block, nullptr, 0, 4, weights, endpoints);
+        }
+
+        if (bestError >= inOutBest.error) return;
+
+        // The anchor (texel 0) index has an implicit 0 top bit, flip the endpoints to get it
+        if (bestIndices[0] & 8) {
+            std::swap(bestValues[0], bestValues[1]);
+            for (uint8_t& index : bestIndices) {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        BitWriter writer(inOutBest.block, sizeof(inOutBest.block));
+        writer.Write(1u << 6, 7);
+        for (uint32_t channel = 0; channel < 4; ++channel) {
+            writer.Write(bestValues[0][channel] >> 1, 7);
+            writer.Write(bestValues[1][channel] >> 1, 7);
+        }
+        writer.Write(bestValues[0][0] & 1, 1);
+        writer.Write(bestValues[1][0] & 1, 1);
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            writer.Write(bestIndices[texel], texel == 0 ? 3 : 4);
+        }
+        inOutBest.error = bestError;
+    }
+
+    // Unquantized error of a two subset partition, used to rank partitions before encoding them
+    float EstimatePartitionError(const BlockTexels& block, const uint8_t* subsets) {
+        float palette[8][4];
+        uint8_t indices[16];
+        float errors[16];
+        float partitionError = 0.0f;
+        for (uint32_t subset = 0; subset < 2; ++subset) {
+            float endpoints[2][4];
+            FitPrincipalAxis(block, subsets, subset, 3, endpoints);
+            for (uint32_t entry = 0; entry < 8; ++entry) {
+                const float weight = s_BC7Weights3[entry] / 64.0f;
+                for (uint32_t channel = 0; channel < 3; ++channel) {
+                    palette[entry][channel] = endpoints[0][channel] + (endpoints[1][channel] - endpoints[0][channel]) * weight;
+                }
+            }
+            FindClosest(block, palette, 8, 3, indices, errors);
+            for (uint32_t texel = 0; texel < 16; ++texel) {
+                if (subsets[texel] == subset) partitionError += errors[texel];
+            }
+        }
+        return partitionError;
+    }
+
+    // Mode 1: two subsets, RGB 6 bits + a p-bit per subset, 3 bit indices. Opaque blocks only.
+    void EncodeBC7Mode1Partition(const BlockTexels& block, const uint32_t partition, const TextureEncoder::Quality quality, BC7Candidate& inOutBest) {
+        const uint8_t* subsets = s_Partitions2[partition];
+        float palette[8][4];
+        uint8_t indices[16];
+        float errors[16];
+        uint8_t values[2][2][3] = {};
+        uint8_t partitionIndices[16] = {};
+        uint32_t pBits[2] = {};
+        float partitionError = 0.0f;
+
+        for (uint32_t subset = 0; subset < 2 && partitionError < inOutBest.error; ++subset) {
+            float endpoints[2][4];
+            FitPrincipalAxis(block, subsets, subset, 3, endpoints);
+
+            float subsetBestError = FLT_MAX;
+            const uint32_t numIterations = GetRefineIterations(quality);
+            for (uint32_t iteration = 0; iteration <= numIterations; ++iteration) {
+                for (uint32_t pBit = 0; pBit < 2; ++pBit) {
+                    uint8_t candidate[2][3];
+                    for (uint32_t end = 0; end < 2; ++end) {
+                        for (uint32_t channel = 0; channel < 3; ++channel) {
+                            const float target = endpoints[end][channel] * 127.0f / 255.0f;
+                            const long q = std::clamp(std::lround((target - pBit) / 2.0f), 0l, 63l);
+                            candidate[end][channel] = ExpandBits(static_cast<uint32_t>((q << 1) | pBit), 7);
+                        }
+                    }
+                    for (uint32_t entry = 0; entry < 8; ++entry) {
+                        for (uint32_t channel = 0; channel < 3; ++channel) {
+                            palette[entry][channel] = Interpolate(candidate[0][channel], candidate[1][channel], s_BC7Weights3[entry]);
+                        }
+                    }
+                    FindClosest(block, palette, 8, 3, indices, errors);
+                    float error = 0.0f;
+                    for (uint32_t texel = 0; texel < 16; ++texel) {
+                        if (subsets[texel] == subset) error += errors[texel];
+                    }
+                    if (error < subsetBestError) {
+                        subsetBestError = error;
+                        pBits[subset] = pBit;
+                        std::memcpy(values[subset], candidate, sizeof(candidate));
+                        for (uint32_t texel = 0; texel < 16; ++texel) {
+                            if (subsets[texel] == subset) partitionIndices[texel] = indices[texel];
+                        }
+                    }
+                }
+
+                if (iteration == numIterations || subsetBestError == 0.0f) break;
+                float weights[16];
+                for (uint32_t texel = 0; texel < 16; ++texel) {
+                    weights[texel] = s_BC7Weights3[partitionIndices[texel]] / 64.0f;
+                }
+                RefineEndpoints(block, subsets, subset, 3, weights, endpoints);
+            }
+            partitionError += subsetBestError;
+        }
+
+        if (partitionError >= inOutBest.error) return;
+
+        const uint32_t anchors[2] = {0, s_Anchors2[partition]};
+        for (uint32_t subset = 0; subset < 2; ++subset) {
+            if (!(partitionIndices[anchors[subset]] & 4)) continue;
+            std::swap(values[subset][0], values[subset][1]);
+            for (uint32_t texel = 0; texel < 16; ++texel) {
+                if (subsets[texel] == subset) partitionIndices[texel] = static_cast<uint8_t>(7 - partitionIndices[texel]);
+            }
+        }
+
+        BitWriter writer(inOutBest.block, sizeof(inOutBest.block));
+        writer.Write(1u << 1, 2);
+        writer.Write(partition, 6);
+        for (uint32_t channel = 0; channel < 3; ++channel) {
+            for (uint32_t subset = 0; subset < 2; ++subset) {
+                // The stored 6 bits are the top of the 7 bit value, whose expansion is undone by >> 2
+                writer.Write(values[subset][0][channel] >> 2, 6);
+                writer.Write(values[subset][1][channel] >> 2, 6);
+            }
+        }
+        writer.Write(pBits[0], 1);
+        writer.Write(pBits[1], 1);
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            const bool bAnchor = texel == anchors[0] || texel == anchors[1];
+            writer.Write(partitionIndices[texel], bAnchor ? 2 : 3);
+        }
+        inOutBest.error = partitionError;
+    }
+
+    // Ranks all 64 partitions by their unquantized error and fully encodes the best few
+    void EncodeBC7Mode1(const BlockTexels& block, const TextureEncoder::Quality quality, BC7Candidate& inOutBest) {
+        const uint32_t numCandidates = quality == TextureEncoder::Quality::High ? 4 : 1;
+        std::array<std::pair<float, uint32_t>, 64> ranked;
+        for (uint32_t partition = 0; partition < 64; ++partition) {
+            ranked[partition] = {EstimatePartitionError(block, s_Partitions2[partition]), partition};
+        }
+        std::partial_sort(ranked.begin(), ranked.begin() + numCandidates, ranked.end());
+        for (uint32_t candidate = 0; candidate < numCandidates; ++candidate) {
+            // The estimate is a lower bound of sorts, quantization only adds error
+            if (ranked[candidate].first >= inOutBest.error) break;
+            EncodeBC7Mode1Partition(block, ranked[candidate].second, quality, inOutBest);
+        }
+    }
+
+    uint32_t GetBlockSize(const SDL_GPUTextureFormat format) {
+        return (format == SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM || format == SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM) ? 8 : 16;
+    }
+
+    uint32_t GetNumChannels(const SDL_GPUTextureFormat format) {
+        switch (format) {
+            case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM: return 3;
+            case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:    return 1;
+            case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:   return 2;
+            default:                                   return 4;
+        }
+    }
+}
+
+SDL_GPUTextureFormat TextureEncoder::GetFormatForRole(const TextureRole role) {
+    switch (role) {
+        case TextureRole::Normal:        return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+        case TextureRole::SingleChannel: return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+        default:                         return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+    }
+}
+
+bool TextureEncoder::CanEncode(const SDL_GPUTextureFormat format) {
+    return format == SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM
+        || format == SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM
+        || format == SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM
+        || format == SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+}
+
+void TextureEncoder::EncodeBC1Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock) {
+    const BlockTexels block = LoadBlock(texels);
+    float endpoints[2][4];
+    FitPrincipalAxis(block, nullptr, 0, 3, endpoints);
+
+    float palette[4][4];
+    uint8_t indices[16];
+    float errors[16];
+    uint16_t bestColors[2] = {};
+    uint8_t bestIndices[16] = {};
+    float bestError = FLT_MAX;
+
+    const uint32_t numIterations = GetRefineIterations(quality);
+    for (uint32_t iteration = 0; iteration <= numIterations; ++iteration) {
+        // Keep c0 > c1 for the four color mode, which also decides which endpoint is which below
+        uint16_t c0 = QuantizeRGB565(endpoints[0]);
+        uint16_t c1 = QuantizeRGB565(endpoints[1]);
+        if (c0 < c1) {
+            std::swap(c0, c1);
+            std::swap(endpoints[0], endpoints[1]);
+        }
+        BuildBC1Palette(c0, c1, palette);
+        FindClosest(block, palette, c0 == c1 ? 1 : 4, 3, indices, errors);
+        float error = 0.0f;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            error += errors[texel];
+        }
+        if (error < bestError) {
+            bestError = error;
+            bestColors[0] = c0;
+            bestColors[1] = c1;
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        if (iteration == numIterations || bestError == 0.0f) break;
+        constexpr float indexWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float weights[16];
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            weights[texel] = indexWeights[bestIndices[texel]];
+        }
+        RefineEndpoints(block, nullptr, 0, 3, weights, endpoints);
+    }
+
+    outBlock[0] = static_cast<uint8_t>(bestColors[0]);
+    outBlock[1] = static_cast<uint8_t>(bestColors[0] >> 8);
+    outBlock[2] = static_cast<uint8_t>(bestColors[1]);
+    outBlock[3] = static_cast<uint8_t>(bestColors[1] >> 8);
+    uint32_t packed = 0;
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        packed |= static_cast<uint32_t>(bestIndices[texel] & 3) << (texel * 2);
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+        outBlock[4 + i] = static_cast<uint8_t>(packed >> (i * 8));
+    }
+}
+
+void TextureEncoder::EncodeBC4Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock) {
+    EncodeChannelBlock(texels, 0, quality, outBlock);
+}
+
+void TextureEncoder::EncodeBC5Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock) {
+    EncodeChannelBlock(texels, 0, quality, outBlock);
+    EncodeChannelBlock(texels, 1, quality, outBlock + 8);
+}
+
+void TextureEncoder::EncodeBC7Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock) {
+    const BlockTexels block = LoadBlock(texels);
+    BC7Candidate best;
+    EncodeBC7Mode6(block, quality, best);
+
+    // Normal only searches partitions where mode 6 leaves a visible error (RMSE above ~2 per channel)
+    constexpr float normalPartitionSearchError = 16.0f * 3.0f * 4.0f;
+    const float partitionSearchError = quality == Quality::High ? 0.0f : normalPartitionSearchError;
+    if (quality != Quality::Fast && best.error > partitionSearchError) {
+        const bool bOpaque = std::all_of(std::begin(block.channels[3]), std::end(block.channels[3]), [](const float alpha) { return alpha == 255.0f; });
+        if (bOpaque) {
+            EncodeBC7Mode1(block, quality, best);
+        }
+    }
+    std::memcpy(outBlock, best.block, sizeof(best.block));
+}
+
+bool TextureEncoder::Encode(const SDL_GPUTextureFormat format, const uint8_t* pixels, const uint32_t width, const uint32_t height,
+        const Quality quality, ThreadPool* threadPool, uint8_t* outBlocks) {
+    void (*encodeBlock)(const uint8_t*, const Quality, uint8_t*) = nullptr;
+    switch (format) {
+        case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM: encodeBlock = EncodeBC1Block; break;
+        case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:    encodeBlock = EncodeBC4Block; break;
+        case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:   encodeBlock = EncodeBC5Block; break;
+        case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM: encodeBlock = EncodeBC7Block; break;
+        default: return false;
+    }
+
+    const uint32_t blockSize = GetBlockSize(format);
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    auto encodeRow = [&](const size_t blockY) {
+        uint8_t texels[64];
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+            // Edge blocks of non multiple of 4 sizes repeat the last row/column
+            for (uint32_t row = 0; row < 4; ++row) {
+                const uint32_t y = std::min(static_cast<uint32_t>(blockY) * 4 + row, height - 1);
+                for (uint32_t column = 0; column < 4; ++column) {
+                    const uint32_t x = std::min(blockX * 4 + column, width - 1);
+                    std::memcpy(texels + (row * 4 + column) * 4, pixels + (static_cast<size_t>(y) * width + x) * 4, 4);
+                }
+            }
+            encodeBlock(texels, quality, outBlocks + (blockY * blocksX + blockX) * blockSize);
+        }
+    };
+
+    if (threadPool) {
+        threadPool->ParallelFor(blocksY, encodeRow);
+    }
+    else {
+        for (uint32_t blockY = 0; blockY < blocksY; ++blockY) {
+            encodeRow(blockY);
+        }
+    }
+    return true;
+}
+
+bool TextureEncoder::EncodeTexture(const SDL_GPUTextureFormat format, const uint8_t* pixels, const uint32_t width, const uint32_t height,
+        const Quality quality, ThreadPool* threadPool, TextureFile& outFile, double* outPSNR) {
+    if (!CanEncode(format) || width == 0 || height == 0) {
+        return false;
+    }
+
+    const uint32_t numLevels = TextureUtils::GetNumMipLevels(width, height);
+    std::vector<TextureLevel> levels(numLevels);
+    size_t dataSize = 0;
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        levels[level].width = std::max(width >> level, 1u);
+        levels[level].height = std::max(height >> level, 1u);
+        levels[level].offset = dataSize;
+        levels[level].size = SDL_CalculateGPUTextureFormatSize(format, levels[level].width, levels[level].height, 1);
+        dataSize += levels[level].size;
+    }
+
+    std::vector<uint8_t> data(dataSize);
+    std::vector<uint8_t> levelPixels;
+    std::vector<uint8_t> nextLevelPixels;
+    const uint8_t* source = pixels;
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        const TextureLevel& textureLevel = levels[level];
+        Encode(format, source, textureLevel.width, textureLevel.height, quality, threadPool, data.data() + textureLevel.offset);
+        if (level == 0 && outPSNR) {
+            *outPSNR = ComputePSNR(format, pixels, width, height, data.data());
+        }
+        if (level + 1 < numLevels) {
+            nextLevelPixels.resize(static_cast<size_t>(levels[level + 1].width) * levels[level + 1].height * 4);
+            TextureUtils::DownsampleRGBA8(source, textureLevel.width, textureLevel.height, nextLevelPixels.data());
+            std::swap(levelPixels, nextLevelPixels);
+            source = levelPixels.data();
+        }
+    }
+
+    outFile.Create(format, width, height, std::move(levels), std::move(data));
+    return true;
+}
+
+double TextureEncoder::ComputePSNR(const SDL_GPUTextureFormat format, const uint8_t* pixels, const uint32_t width, const uint32_t height,
+        const uint8_t* blocks) {
+    std::vector<uint8_t> decoded(static_cast<size_t>(width) * height * 4);
+    if (!TextureDecoder::Decompress(format, blocks, width, height, decoded.data())) {
+        return 0.0;
+    }
+
+    const uint32_t numChannels = GetNumChannels(format);
+    double squaredError = 0.0;
+    for (size_t texel = 0; texel < static_cast<size_t>(width) * height; ++texel) {
+        for (uint32_t channel = 0; channel < numChannels; ++channel) {
+            const double delta = static_cast<double>(pixels[texel * 4 + channel]) - decoded[texel * 4 + channel];
+            squaredError += delta * delta;
+        }
+    }
+    const double meanSquaredError = squaredError / (static_cast<double>(width) * height * numChannels);
+    if (meanSquaredError == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+class TextureFile;
+class ThreadPool;
+
+// CPU block compression for textures that only exist as PNG/JPG, so they still reach the GPU
+// in a compressed format. Input is tightly packed RGBA8, blocks are encoded in parallel on the
+// thread pool.
+//  - BC1: RGB, alpha is dropped
+//  - BC4: red channel
+//  - BC5: red and green channels (tangent space normal xy, z is rebuilt in the shader)
+//  - BC7: RGBA, mode 6, and mode 1 for opaque blocks at Normal (where mode 6 leaves a visible
+//    error) and High quality
+namespace TextureEncoder {
+    // Speed/quality knob. Fast fits endpoints along the principal axis only, Normal refines
+    // them with least squares and tries BC7 mode 1 where mode 6 falls short, High refines further
+    // and tries mode 1, with more partitions, on every opaque block.
+    enum class Quality : uint8_t {
+        Fast = 0,
+        Normal,
+        High,
+    };
+
+    // What a texture holds, which decides the format it compresses to
+    enum class TextureRole : uint8_t {
+        Color = 0,     // BC7
+        Normal,        // BC5
+        SingleChannel, // BC4
+    };
+
+    SDL_GPUTextureFormat GetFormatForRole(const TextureRole role);
+    bool CanEncode(const SDL_GPUTextureFormat format);
+
+    // Encodes one 4x4 block of RGBA8 texels (row order) into outBlock
+    void EncodeBC1Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock);
+    void EncodeBC4Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock);
+    void EncodeBC5Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock);
+    void EncodeBC7Block(const uint8_t* texels, const Quality quality, uint8_t* outBlock);
+
+    // Encodes a width x height image into outBlocks (SDL_CalculateGPUTextureFormatSize bytes).
+    // threadPool may be null to encode on the calling thread.
+    bool Encode(const SDL_GPUTextureFormat format, const uint8_t* pixels, const uint32_t width, const uint32_t height,
+        const Quality quality, ThreadPool* threadPool, uint8_t* outBlocks);
+
+    // Builds the full mip chain of an image and encodes every level into outFile.
+    // outPSNR, if set, receives the PSNR of level 0.
+    bool EncodeTexture(const SDL_GPUTextureFormat format, const uint8_t* pixels, const uint32_t width, const uint32_t height,
+        const Quality quality, ThreadPool* threadPool, TextureFile& outFile, double* outPSNR = nullptr);
+
+    // Peak signal to noise ratio, in dB, of the encoded image over the channels the format stores.
+    // Infinite for a lossless encode.
+    double ComputePSNR(const SDL_GPUTextureFormat format, const uint8_t* pixels, const uint32_t width, const uint32_t height,
+        const uint8_t* blocks);
+}
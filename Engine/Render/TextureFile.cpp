@@ -0,0 +1,518 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <Render/TextureDecoder.h>
+#include <Render/TextureUtils.h>
+#include <SDL3/SDL.h>
+
+namespace {
+    constexpr std::array<SDL_GPUTextureFormat, 14> s_ASTCFormats = {
+        SDL_GPU_TEXTUREFORMAT_ASTC_4x4_UNORM,   SDL_GPU_TEXTUREFORMAT_ASTC_5x4_UNORM,   SDL_GPU_TEXTUREFORMAT_ASTC_5x5_UNORM,
+        SDL_GPU_TEXTUREFORMAT_ASTC_6x5_UNORM,   SDL_GPU_TEXTUREFORMAT_ASTC_6x6_UNORM,   SDL_GPU_TEXTUREFORMAT_ASTC_8x5_UNORM,
+        SDL_GPU_TEXTUREFORMAT_ASTC_8x6_UNORM,   SDL_GPU_TEXTUREFORMAT_ASTC_8x8_UNORM,   SDL_GPU_TEXTUREFORMAT_ASTC_10x5_UNORM,
+        SDL_GPU_TEXTUREFORMAT_ASTC_10x6_UNORM,  SDL_GPU_TEXTUREFORMAT_ASTC_10x8_UNORM,  SDL_GPU_TEXTUREFORMAT_ASTC_10x10_UNORM,
+        SDL_GPU_TEXTUREFORMAT_ASTC_12x10_UNORM, SDL_GPU_TEXTUREFORMAT_ASTC_12x12_UNORM,
+    };
+    // Block footprints, in the order of s_ASTCFormats (and of the GL/Vulkan enums)
+    constexpr std::array<std::array<uint8_t, 2>, 14> s_ASTCBlockSizes = {{
+        {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12},
+    }};
+
+    constexpr uint8_t s_KTXIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    constexpr uint8_t s_KTX2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    constexpr uint32_t s_ASTCMagic = 0x5CA1AB13;
+
+    // DDS header flags
+    constexpr uint32_t s_DDSMipMapCount = 0x20000;
+    constexpr uint32_t s_DDSFourCC = 0x4;
+    constexpr uint32_t s_DDSRGB = 0x40;
+    constexpr uint32_t s_DDSCubemapOrVolume = 0x200 | 0x200000;
+    constexpr uint32_t s_DDSTexture2D = 3;
+    constexpr uint32_t s_DDSMiscCube = 0x4;
+    // Header flags a writer sets: caps, height, width, pixel format, mip count, linear size
+    constexpr uint32_t s_DDSRequiredFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+    // Caps: texture, mipmap, complex
+    constexpr uint32_t s_DDSCaps = 0x1000 | 0x400000 | 0x8;
+
+    constexpr uint32_t MakeFourCC(const char a, const char b, const char c, const char d) {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    uint32_t ReadU32(const uint8_t* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint64_t ReadU64(const uint8_t* data) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    SDL_GPUTextureFormat GetDXGIFormat(const uint32_t dxgiFormat) {
+        switch (dxgiFormat) {
+            case 28: case 29: return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+            case 87: case 91: return SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM;
+            case 71: case 72: return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+            case 74: case 75: return SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM;
+            case 77: case 78: return SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+            case 80:          return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+            case 83:          return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+            case 95:          return SDL_GPU_TEXTUREFORMAT_BC6H_RGB_UFLOAT;
+            case 96:          return SDL_GPU_TEXTUREFORMAT_BC6H_RGB_FLOAT;
+            case 98: case 99: return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+            default:          return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+    }
+
+    // Inverse of GetDXGIFormat, 0 (DXGI_FORMAT_UNKNOWN) for formats DDS can't hold
+    uint32_t GetDXGIFormat(const SDL_GPUTextureFormat format) {
+        switch (format) {
+            case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM:   return 28;
+            case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM:   return 87;
+            case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:   return 71;
+            case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:   return 74;
+            case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:   return 77;
+            case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:      return 80;
+            case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:     return 83;
+            case SDL_GPU_TEXTUREFORMAT_BC6H_RGB_UFLOAT:  return 95;
+            case SDL_GPU_TEXTUREFORMAT_BC6H_RGB_FLOAT:   return 96;
+            case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:   return 98;
+            default:                                     return 0;
+        }
+    }
+
+    void WriteU32(std::vector<uint8_t>& bytes, const size_t offset, const uint32_t value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+
+    SDL_GPUTextureFormat GetFourCCFormat(const uint32_t fourCC) {
+        switch (fourCC) {
+            case MakeFourCC('D', 'X', 'T', '1'): return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+            case MakeFourCC('D', 'X', 'T', '2'):
+            case MakeFourCC('D', 'X', 'T', '3'): return SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM;
+            case MakeFourCC('D', 'X', 'T', '4'):
+            case MakeFourCC('D', 'X', 'T', '5'): return SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+            case MakeFourCC('A', 'T', 'I', '1'):
+            case MakeFourCC('B', 'C', '4', 'U'): return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'): return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+            default:                             return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+    }
+
+    SDL_GPUTextureFormat GetGLFormat(const uint32_t glInternalFormat) {
+        if (glInternalFormat >= 0x93B0 && glInternalFormat <= 0x93BD) {
+            return s_ASTCFormats[glInternalFormat - 0x93B0];
+        }
+        if (glInternalFormat >= 0x93D0 && glInternalFormat <= 0x93DD) {
+            return s_ASTCFormats[glInternalFormat - 0x93D0];
+        }
+        switch (glInternalFormat) {
+            case 0x8058: case 0x8C43:                       return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+            case 0x83F0: case 0x83F1: case 0x8C4C: case 0x8C4D: return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+            case 0x83F2: case 0x8C4E:                       return SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM;
+            case 0x83F3: case 0x8C4F:                       return SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+            case 0x8DBB:                                    return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+            case 0x8DBD:                                    return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+            case 0x8E8C: case 0x8E8D:                       return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+            case 0x8E8E:                                    return SDL_GPU_TEXTUREFORMAT_BC6H_RGB_FLOAT;
+            case 0x8E8F:                                    return SDL_GPU_TEXTUREFORMAT_BC6H_RGB_UFLOAT;
+            default:                                        return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+    }
+
+    SDL_GPUTextureFormat GetVulkanFormat(const uint32_t vkFormat) {
+        if (vkFormat >= 157 && vkFormat <= 184) {
+            return s_ASTCFormats[(vkFormat - 157) / 2];
+        }
+        switch (vkFormat) {
+            case 37:  case 43:                     return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+            case 44:  case 50:                     return SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM;
+            case 131: case 132: case 133: case 134: return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+            case 135: case 136:                    return SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM;
+            case 137: case 138:                    return SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+            case 139:                              return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+            case 141:                              return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+            case 143:                              return SDL_GPU_TEXTUREFORMAT_BC6H_RGB_UFLOAT;
+            case 144:                              return SDL_GPU_TEXTUREFORMAT_BC6H_RGB_FLOAT;
+            case 145: case 146:                    return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+            default:                               return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+    }
+}
+
+bool TextureFile::IsContainerExtension(const std::string& extension) {
+    std::string lower = extension;
+    std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (!lower.empty() && lower[0] == '.') {
+        lower.erase(0, 1);
+    }
+    return lower == "dds" || lower == "ktx" || lower == "ktx2" || lower == "astc";
+}
+
+bool TextureFile::IsContainerPath(const std::string& path) {
+    return IsContainerExtension(std::filesystem::path(path).extension().string());
+}
+
+bool TextureFile::Load(const std::string& path) {
+    Reset();
+    if (!mFile.Open(path)) {
+        return false;
+    }
+    if (!Parse(mFile.GetData(), mFile.GetSize())) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't read texture %s", path.c_str());
+        mFile.Close();
+        return false;
+    }
+    return true;
+}
+
+bool TextureFile::Parse(const uint8_t* data, const size_t size) {
+    mDecoded.clear();
+    mData = data;
+    mFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+    mWidth = mHeight = 0;
+    mLevels.clear();
+
+    bool bParsed = false;
+    if (size >= 4 && ReadU32(data) == MakeFourCC('D', 'D', 'S', ' ')) {
+        bParsed = ParseDDS(data, size);
+    }
+    else if (size >= sizeof(s_KTXIdentifier) && std::memcmp(data, s_KTXIdentifier, sizeof(s_KTXIdentifier)) == 0) {
+        bParsed = ParseKTX(data, size);
+    }
+    else if (size >= sizeof(s_KTX2Identifier) && std::memcmp(data, s_KTX2Identifier, sizeof(s_KTX2Identifier)) == 0) {
+        bParsed = ParseKTX2(data, size);
+    }
+    else if (size >= 4 && ReadU32(data) == s_ASTCMagic) {
+        bParsed = ParseASTC(data, size);
+    }
+    else {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unknown texture container");
+    }
+
+    if (!bParsed || mLevels.empty()) {
+        mData = nullptr;
+        mLevels.clear();
+        return false;
+    }
+    return true;
+}
+
+void TextureFile::Create(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height,
+        std::vector<TextureLevel> levels, std::vector<uint8_t> data) {
+    Reset();
+    mDecoded = std::move(data);
+    mData = mDecoded.data();
+    mFormat = format;
+    mWidth = width;
+    mHeight = height;
+    mLevels = std::move(levels);
+}
+
+bool TextureFile::Save(const std::string& path) const {
+    const uint32_t dxgiFormat = GetDXGIFormat(mFormat);
+    if (mLevels.empty() || dxgiFormat == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Can't save %s, DDS can't hold its format", path.c_str());
+        return false;
+    }
+
+    constexpr size_t headerSize = 128;
+    constexpr size_t dx10HeaderSize = 20;
+    size_t dataSize = 0;
+    for (const TextureLevel& level : mLevels) {
+        dataSize += level.size;
+    }
+    std::vector<uint8_t> bytes(headerSize + dx10HeaderSize + dataSize, 0);
+    WriteU32(bytes, 0, MakeFourCC('D', 'D', 'S', ' '));
+    WriteU32(bytes, 4, 124);
+    WriteU32(bytes, 8, s_DDSRequiredFlags);
+    WriteU32(bytes, 12, mHeight);
+    WriteU32(bytes, 16, mWidth);
+    WriteU32(bytes, 20, static_cast<uint32_t>(mLevels[0].size));
+    WriteU32(bytes, 28, static_cast<uint32_t>(mLevels.size()));
+    WriteU32(bytes, 76, 32); // pixel format size
+    WriteU32(bytes, 80, s_DDSFourCC);
+    WriteU32(bytes, 84, MakeFourCC('D', 'X', '1', '0'));
+    WriteU32(bytes, 108, s_DDSCaps);
+    WriteU32(bytes, 128, dxgiFormat);
+    WriteU32(bytes, 132, s_DDSTexture2D);
+    WriteU32(bytes, 140, 1); // array size
+
+    // Levels back to back, largest first, as ParseDDS reads them
+    size_t offset = headerSize + dx10HeaderSize;
+    for (size_t i = 0; i < mLevels.size(); ++i) {
+        std::memcpy(bytes.data() + offset, GetLevelData(i), mLevels[i].size);
+        offset += mLevels[i].size;
+    }
+
+    // Written aside and moved into place, so a reader never maps a half written file
+    const std::string tempPath = path + ".tmp";
+    if (!SDL_SaveFile(tempPath.c_str(), bytes.data(), bytes.size())) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write texture %s: %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't write texture %s: %s", path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool TextureFile::Decompress() {
+    if (mFormat == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM) {
+        return true;
+    }
+    if (!TextureDecoder::CanDecompress(mFormat)) {
+        return false;
+    }
+
+    std::vector<TextureLevel> levels = mLevels;
+    size_t decodedSize = 0;
+    for (TextureLevel& level : levels) {
+        level.offset = decodedSize;
+        level.size = static_cast<size_t>(level.width) * level.height * 4;
+        decodedSize += level.size;
+    }
+
+    std::vector<uint8_t> decoded(decodedSize);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        TextureDecoder::Decompress(mFormat, GetLevelData(i), levels[i].width, levels[i].height, decoded.data() + levels[i].offset);
+    }
+
+    mFile.Close();
+    mDecoded = std::move(decoded);
+    mData = mDecoded.data();
+    mLevels = std::move(levels);
+    mFormat = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    return true;
+}
+
+bool TextureFile::ParseDDS(const uint8_t* data, const size_t size) {
+    constexpr size_t headerSize = 128;
+    constexpr size_t dx10HeaderSize = 20;
+    if (size < headerSize || ReadU32(data + 4) != 124) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid DDS header");
+        return false;
+    }
+
+    const uint32_t flags = ReadU32(data + 8);
+    mHeight = ReadU32(data + 12);
+    mWidth = ReadU32(data + 16);
+    const uint32_t numLevels = (flags & s_DDSMipMapCount) ? std::max(ReadU32(data + 28), 1u) : 1u;
+    const uint32_t pixelFlags = ReadU32(data + 80);
+    const uint32_t fourCC = ReadU32(data + 84);
+    const uint32_t caps2 = ReadU32(data + 112);
+    if (caps2 & s_DDSCubemapOrVolume) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "DDS cubemaps and volume textures aren't supported");
+        return false;
+    }
+
+    size_t offset = headerSize;
+    if ((pixelFlags & s_DDSFourCC) && fourCC == MakeFourCC('D', 'X', '1', '0')) {
+        if (size < headerSize + dx10HeaderSize) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid DDS header");
+            return false;
+        }
+        const uint32_t dxgiFormat = ReadU32(data + 128);
+        if (ReadU32(data + 132) != s_DDSTexture2D || (ReadU32(data + 136) & s_DDSMiscCube) || ReadU32(data + 140) > 1) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Only single 2D DDS textures are supported");
+            return false;
+        }
+        mFormat = GetDXGIFormat(dxgiFormat);
+        if (mFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported DXGI format %u", dxgiFormat);
+            return false;
+        }
+        offset += dx10HeaderSize;
+    }
+    else if (pixelFlags & s_DDSFourCC) {
+        mFormat = GetFourCCFormat(fourCC);
+        if (mFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported DDS FourCC %.4s", reinterpret_cast<const char*>(data + 84));
+            return false;
+        }
+    }
+    else if ((pixelFlags & s_DDSRGB) && ReadU32(data + 88) == 32) {
+        const uint32_t redMask = ReadU32(data + 92);
+        mFormat = (redMask == 0x000000FF) ? SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM
+            : (redMask == 0x00FF0000) ? SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM
+            : SDL_GPU_TEXTUREFORMAT_INVALID;
+        if (mFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported DDS pixel layout");
+            return false;
+        }
+    }
+    else {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported DDS pixel format");
+        return false;
+    }
+
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        if (!AddLevel(offset, size)) {
+            return false;
+        }
+        offset += mLevels.back().size;
+    }
+    return true;
+}
+
+bool TextureFile::ParseKTX(const uint8_t* data, const size_t size) {
+    constexpr size_t headerSize = 64;
+    if (size < headerSize || ReadU32(data + 12) != 0x04030201) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid or big endian KTX header");
+        return false;
+    }
+
+    const uint32_t glInternalFormat = ReadU32(data + 28);
+    mWidth = ReadU32(data + 36);
+    mHeight = std::max(ReadU32(data + 40), 1u); // 1D textures have a height of 0
+    const uint32_t depth = ReadU32(data + 44);
+    const uint32_t numArrayElements = ReadU32(data + 48);
+    const uint32_t numFaces = ReadU32(data + 52);
+    const uint32_t numLevels = std::max(ReadU32(data + 56), 1u); // 0 asks the loader to generate them
+    const uint32_t keyValueBytes = ReadU32(data + 60);
+    if (depth > 1 || numArrayElements > 1 || numFaces != 1) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Only single 2D KTX textures are supported");
+        return false;
+    }
+
+    mFormat = GetGLFormat(glInternalFormat);
+    if (mFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported KTX format 0x%X", glInternalFormat);
+        return false;
+    }
+
+    // Each level is its byte size followed by the data, padded to 4 bytes
+    size_t offset = headerSize + keyValueBytes;
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        if (offset + 4 > size) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "KTX file is truncated");
+            return false;
+        }
+        const uint32_t imageSize = ReadU32(data + offset);
+        offset += 4;
+        if (!AddLevel(offset, size)) {
+            return false;
+        }
+        offset += (static_cast<size_t>(imageSize) + 3) & ~size_t(3);
+    }
+    return true;
+}
+
+bool TextureFile::ParseKTX2(const uint8_t* data, const size_t size) {
+    constexpr size_t headerSize = 80;
+    constexpr size_t levelIndexEntrySize = 24;
+    if (size < headerSize) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid KTX2 header");
+        return false;
+    }
+
+    const uint32_t vkFormat = ReadU32(data + 12);
+    mWidth = ReadU32(data + 20);
+    mHeight = std::max(ReadU32(data + 24), 1u);
+    const uint32_t depth = ReadU32(data + 28);
+    const uint32_t numLayers = ReadU32(data + 32);
+    const uint32_t numFaces = ReadU32(data + 36);
+    const uint32_t numLevels = std::max(ReadU32(data + 40), 1u);
+    const uint32_t supercompression = ReadU32(data + 44);
+    if (depth > 1 || numLayers > 1 || numFaces != 1) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Only single 2D KTX2 textures are supported");
+        return false;
+    }
+    if (supercompression != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Supercompressed KTX2 textures aren't supported");
+        return false;
+    }
+
+    mFormat = GetVulkanFormat(vkFormat);
+    if (mFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported KTX2 format %u", vkFormat);
+        return false;
+    }
+    if (headerSize + numLevels * levelIndexEntrySize > size) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "KTX2 file is truncated");
+        return false;
+    }
+
+    // The level index lists the base level first
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        const uint64_t levelOffset = ReadU64(data + headerSize + level * levelIndexEntrySize);
+        if (levelOffset > size || !AddLevel(static_cast<size_t>(levelOffset), size)) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid KTX2 level %u", level);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextureFile::ParseASTC(const uint8_t* data, const size_t size) {
+    constexpr size_t headerSize = 16;
+    if (size < headerSize) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid ASTC header");
+        return false;
+    }
+
+    const uint8_t blockX = data[4];
+    const uint8_t blockY = data[5];
+    const uint8_t blockZ = data[6];
+    mWidth = data[7] | (data[8] << 8) | (data[9] << 16);
+    mHeight = data[10] | (data[11] << 8) | (data[12] << 16);
+    const uint32_t depth = data[13] | (data[14] << 8) | (data[15] << 16);
+    if (blockZ != 1 || depth != 1) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "3D ASTC textures aren't supported");
+        return false;
+    }
+
+    for (size_t i = 0; i < s_ASTCBlockSizes.size(); ++i) {
+        if (s_ASTCBlockSizes[i][0] == blockX && s_ASTCBlockSizes[i][1] == blockY) {
+            mFormat = s_ASTCFormats[i];
+        }
+    }
+    if (mFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unsupported ASTC block size %ux%u", blockX, blockY);
+        return false;
+    }
+
+    // .astc files hold a single level
+    return AddLevel(headerSize, size);
+}
+
+bool TextureFile::AddLevel(const size_t offset, const size_t dataSize) {
+    const uint32_t level = static_cast<uint32_t>(mLevels.size());
+    if (mWidth == 0 || mHeight == 0 || level >= TextureUtils::GetNumMipLevels(mWidth, mHeight)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid texture size %ux%u with %u levels", mWidth, mHeight, level + 1);
+        return false;
+    }
+
+    TextureLevel textureLevel{
+        .width = std::max(mWidth >> level, 1u),
+        .height = std::max(mHeight >> level, 1u),
+        .offset = offset,
+    };
+    textureLevel.size = SDL_CalculateGPUTextureFormatSize(mFormat, textureLevel.width, textureLevel.height, 1);
+    if (offset > dataSize || textureLevel.size > dataSize - offset) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Texture level %u is truncated", level);
+        return false;
+    }
+    mLevels.push_back(textureLevel);
+    return true;
+}
+
+void TextureFile::Reset() {
+    mFile.Close();
+    mDecoded.clear();
+    mData = nullptr;
+    mFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+    mWidth = mHeight = 0;
+    mLevels.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <MappedFile.h>
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TextureLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t offset = 0; // from the start of the level data
+    size_t size = 0;
+};
+
+// A 2D texture read from a DDS, KTX, KTX2 or .astc container, with every level in the layout
+// the GPU expects so it can be copied into a transfer buffer as is.
+//  - Load maps the file, level data is read straight from the mapping.
+//  - Parse reads a container already in memory (embedded textures), which must outlive this.
+//  - Create adopts levels built in memory, e.g. by TextureEncoder.
+//  - Decompress converts block compressed levels to RGBA8 for devices that can't sample them.
+//  - Save writes the levels to a DDS (with a DX10 header), which is how textures are cooked.
+// sRGB formats load as their UNORM counterparts: every texture is sampled as UNORM and the
+// shaders apply gamma themselves, so this keeps compressed textures matching the PNG path.
+class TextureFile {
+public:
+    // Whether the extension is a container this can read (".dds", "ktx", ...)
+    static bool IsContainerExtension(const std::string& extension);
+    static bool IsContainerPath(const std::string& path);
+
+    bool Load(const std::string& path);
+    bool Parse(const uint8_t* data, const size_t size);
+    void Create(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height,
+        std::vector<TextureLevel> levels, std::vector<uint8_t> data);
+
+    // False for formats DDS can't hold (ASTC)
+    bool Save(const std::string& path) const;
+
+    // Replaces the levels with RGBA8 ones. False if there's no CPU decoder for the format.
+    bool Decompress();
+
+    SDL_GPUTextureFormat GetFormat() const { return mFormat; }
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    const std::vector<TextureLevel>& GetLevels() const { return mLevels; }
+    const uint8_t* GetLevelData(const size_t level) const { return mData + mLevels[level].offset; }
+
+private:
+    bool ParseDDS(const uint8_t* data, const size_t size);
+    bool ParseKTX(const uint8_t* data, const size_t size);
+    bool ParseKTX2(const uint8_t* data, const size_t size);
+    bool ParseASTC(const uint8_t* data, const size_t size);
+
+    // Validates a level of the current format against the data bounds before adding it
+    bool AddLevel(const size_t offset, const size_t dataSize);
+    void Reset();
+
+    MappedFile mFile;
+    std::vector<uint8_t> mDecoded;
+    const uint8_t* mData = nullptr;
+
+    SDL_GPUTextureFormat mFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    std::vector<TextureLevel> mLevels;
+};
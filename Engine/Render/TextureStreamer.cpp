@@ -0,0 +1,280 @@
+#include "TextureStreamer.h"
+
+#include <Render/MaterialTable.h>
+#include <Render/TextureUtils.h>
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+// Largest level, in texels along its longer side, textures are created with and evicted to
+static constexpr uint32_t s_InitialSize = 128;
+// Textures moved down their array per frame so it can shrink, each a GPU copy of every level
+static constexpr uint32_t s_MaxCompactionsPerFrame = 16;
+
+void TextureStreamer::Init(MaterialTable* materialTable, StagingRing* stagingRing, const uint64_t budget) {
+    mMaterialTable = materialTable;
+    mStagingRing = stagingRing;
+    SetBudget(budget);
+}
+
+void TextureStreamer::Release() {
+    mEntries.clear();
+    mMoves.clear();
+    mStats.residentBytes = 0;
+    mStats.wantedBytes = 0;
+    mStats.numTextures = 0;
+}
+
+void TextureStreamer::SetBudget(const uint64_t bytes) {
+    mBudget = bytes;
+    mStats.budget = bytes;
+}
+
+uint32_t TextureStreamer::GetInitialLevel(const TextureFile& textureFile) {
+    const std::vector<TextureLevel>& levels = textureFile.GetLevels();
+    for (uint32_t level = 0; level < levels.size(); ++level) {
+        if (std::max(levels[level].width, levels[level].height) <= s_InitialSize && IsFirstLevelValid(textureFile, level)) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+void TextureStreamer::Add(const TextureSlot slot, TextureFile textureFile, std::vector<uint8_t> fileData, const uint32_t firstLevel) {
+    SDL_assert(slot.IsValid() && firstLevel < textureFile.GetLevels().size() && !mEntries.contains(slot.Pack()));
+    Entry& entry = mEntries[slot.Pack()];
+    entry.textureFile = std::move(textureFile);
+    entry.fileData = std::move(fileData);
+    entry.slot = slot;
+    entry.residentLevel = firstLevel;
+    entry.initialLevel = firstLevel;
+    entry.wantedLevel = firstLevel;
+    mStats.residentBytes += GetResidentBytes(entry, firstLevel);
+    ++mStats.numTextures;
+}
+
+void TextureStreamer::Remove(const TextureSlot slot) {
+    auto it = mEntries.find(slot.Pack());
+    if (it == mEntries.end()) {
+        return;
+    }
+    mStats.residentBytes -= GetResidentBytes(it->second, it->second.residentLevel);
+    --mStats.numTextures;
+    mEntries.erase(it);
+}
+
+void TextureStreamer::Request(const TextureSlot slot, const float resolution) {
+    auto it = mEntries.find(slot.Pack());
+    if (it == mEntries.end()) {
+        return;
+    }
+    Entry& entry = it->second;
+    if (entry.lastUsedFrame != mFrame) {
+        entry.lastUsedFrame = mFrame;
+        entry.resolution = resolution;
+    }
+    else {
+        entry.resolution = std::max(entry.resolution, resolution);
+    }
+}
+
+void TextureStreamer::Update(const uint64_t uploadBudget, std::vector<Relocation>& outRelocations) {
+    std::vector<Entry*> streamIns;
+    std::vector<Entry*> evictions;
+    mStats.wantedBytes = 0;
+    mStats.reservedBytes = mMaterialTable->GetReservedBytes();
+    for (auto& [key, entry] : mEntries) {
+        entry.wantedLevel = GetWantedLevel(entry);
+        mStats.wantedBytes += GetResidentBytes(entry, entry.wantedLevel);
+        if (entry.wantedLevel < entry.residentLevel) {
+            streamIns.push_back(&entry);
+        }
+        else if (entry.wantedLevel > entry.residentLevel) {
+            evictions.push_back(&entry);
+        }
+    }
+    // Least recently used first. Textures used this frame come last and only drop the levels
+    // finer than they need.
+    std::sort(evictions.begin(), evictions.end(), [](const Entry* a, const Entry* b) {
+        return a->lastUsedFrame < b->lastUsedFrame;
+    });
+    // The ones furthest from what they need first
+    std::sort(streamIns.begin(), streamIns.end(), [](const Entry* a, const Entry* b) {
+        return a->residentLevel - a->wantedLevel > b->residentLevel - b->wantedLevel;
+    });
+
+    uint64_t uploadBytes = 0;
+    size_t numEvictions = 0;
+    // Room in the arrays for moving entry to level, or for nothing without one. Evictions allocate
+    // too, which can change what the move costs.
+    auto makeRoom = [&](const Entry* entry, const uint32_t level) {
+        auto fits = [&]() {
+            const uint64_t bytes = entry ? GetAllocationBytes(*entry, level) : 0;
+            return bytes != UINT64_MAX && mStats.reservedBytes + bytes <= mBudget;
+        };
+        while (!fits() && numEvictions < evictions.size()) {
+            Entry& eviction = *evictions[numEvictions++];
+            MoveTo(eviction, eviction.wantedLevel, uploadBytes, outRelocations);
+        }
+        return fits();
+    };
+    // Anything over a budget that was just lowered
+    makeRoom(nullptr, 0);
+
+    for (Entry* entry : streamIns) {
+        if (uploadBytes >= uploadBudget) break;
+        // The finest level that fits, a full budget may only have room for a step or two. Shapes
+        // without an array to go to are skipped, and tried again in a later frame.
+        for (uint32_t level = entry->wantedLevel; level < entry->residentLevel; ++level) {
+            if (!IsFirstLevelValid(entry->textureFile, level) || GetAllocationBytes(*entry, level) == UINT64_MAX) continue;
+            if (makeRoom(entry, level)) {
+                MoveTo(*entry, level, uploadBytes, outRelocations);
+                break;
+            }
+        }
+    }
+
+    // Textures left past the first quarter of a mostly free array move down, so Trim can shrink it
+    std::vector<Entry*> compactions;
+    for (auto& [key, entry] : mEntries) {
+        if (compactions.size() == s_MaxCompactionsPerFrame) break;
+        if (entry.movedFrame != mFrame && mMaterialTable->IsTrimBlockedBy(entry.slot)) {
+            compactions.push_back(&entry);
+        }
+    }
+    for (Entry* entry : compactions) {
+        // The moves before it take lower layers too
+        if (mMaterialTable->IsTrimBlockedBy(entry->slot)) {
+            MoveTo(*entry, entry->residentLevel, uploadBytes, outRelocations);
+        }
+    }
+    ++mFrame;
+}
+
+void TextureStreamer::Record(SDL_GPUCopyPass* copyPass) {
+    for (const Move& move : mMoves) {
+        // Resolved only now, arrays may have grown while the moves were allocated
+        SDL_GPUTexture* source = mMaterialTable->GetArray(move.from);
+        SDL_GPUTexture* destination = mMaterialTable->GetArray(move.to);
+        for (uint32_t i = 0; i < move.levels.size(); ++i) {
+            const uint32_t level = move.toLevel + i;
+            const TextureLevel& textureLevel = move.levels[i];
+            if (level < move.fromLevel) {
+                const SDL_GPUTextureRegion region{ .texture = destination, .mip_level = i, .layer = move.to.layer, .w = textureLevel.width, .h = textureLevel.height, .d = 1 };
+                mStagingRing->UploadLevel(copyPass, move.staging, static_cast<Uint32>(textureLevel.offset), region);
+            }
+            else {
+                const SDL_GPUTextureLocation sourceLocation{ .texture = source, .mip_level = level - move.fromLevel, .layer = move.from.layer };
+                const SDL_GPUTextureLocation destinationLocation{ .texture = destination, .mip_level = i, .layer = move.to.layer };
+                SDL_CopyGPUTextureToTexture(copyPass, &sourceLocation, &destinationLocation, textureLevel.width, textureLevel.height, 1, false);
+            }
+        }
+    }
+    // The copies out of them are recorded, later allocations can reuse the layers
+    for (const Move& move : mMoves) {
+        mMaterialTable->FreeTexture(move.from);
+    }
+    mMoves.clear();
+}
+
+uint64_t TextureStreamer::GetAllocationBytes(const Entry& entry, const uint32_t level) const {
+    const std::vector<TextureLevel>& levels = entry.textureFile.GetLevels();
+    return mMaterialTable->GetAllocationBytes(entry.textureFile.GetFormat(), levels[level].width, levels[level].height,
+        static_cast<uint32_t>(levels.size()) - level);
+}
+
+uint64_t TextureStreamer::GetResidentBytes(const Entry& entry, const uint32_t level) {
+    const std::vector<TextureLevel>& levels = entry.textureFile.GetLevels();
+    return TextureUtils::GetTextureSize(entry.textureFile.GetFormat(), levels[level].width, levels[level].height,
+        static_cast<uint32_t>(levels.size()) - level);
+}
+
+bool TextureStreamer::IsFirstLevelValid(const TextureFile& textureFile, const uint32_t level) {
+    if (level == 0) return true;
+    uint32_t blockWidth, blockHeight;
+    TextureUtils::GetBlockSize(textureFile.GetFormat(), blockWidth, blockHeight);
+    const TextureLevel& textureLevel = textureFile.GetLevels()[level];
+    return textureLevel.width % blockWidth == 0 && textureLevel.height % blockHeight == 0;
+}
+
+uint32_t TextureStreamer::GetWantedLevel(const Entry& entry) const {
+    // Unused textures can give up everything but their initial levels
+    if (entry.lastUsedFrame != mFrame) {
+        return entry.initialLevel;
+    }
+    // The coarsest level still as large as the requested resolution, or a finer one a texture can start at
+    const std::vector<TextureLevel>& levels = entry.textureFile.GetLevels();
+    uint32_t level = 0;
+    while (level < entry.initialLevel && static_cast<float>(std::max(levels[level + 1].width, levels[level + 1].height)) >= entry.resolution) {
+        ++level;
+    }
+    while (level > 0 && !IsFirstLevelValid(entry.textureFile, level)) {
+        --level;
+    }
+    return level;
+}
+
+bool TextureStreamer::MoveTo(Entry& entry, const uint32_t level, uint64_t& outUploadBytes, std::vector<Relocation>& outRelocations) {
+    const std::vector<TextureLevel>& levels = entry.textureFile.GetLevels();
+    const SDL_GPUTextureFormat format = entry.textureFile.GetFormat();
+    const bool bStreamIn = level < entry.residentLevel;
+    // No array for that shape has room while every sampler slot is taken or the array is at its
+    // layer limit. The texture stays where it is until a later Update finds one.
+    const uint64_t allocationBytes = GetAllocationBytes(entry, level);
+    if (allocationBytes == UINT64_MAX) {
+        return false;
+    }
+    const TextureSlot slot = mMaterialTable->AllocateTexture(format, levels[level].width, levels[level].height,
+        static_cast<uint32_t>(levels.size()) - level);
+    if (!slot.IsValid()) {
+        return false;
+    }
+    mStats.reservedBytes += allocationBytes;
+
+    Move move{ .from = entry.slot, .to = slot, .fromLevel = entry.residentLevel, .toLevel = level };
+    move.levels.assign(levels.begin() + level, levels.end());
+    if (bStreamIn) {
+        // The new levels go in one staging allocation, offsets kept aligned for the copy
+        constexpr size_t levelAlignment = 16;
+        const uint32_t numNewLevels = entry.residentLevel - level;
+        size_t stagingSize = 0;
+        for (uint32_t i = 0; i < numNewLevels; ++i) {
+            move.levels[i].offset = stagingSize;
+            stagingSize += (move.levels[i].size + levelAlignment - 1) & ~(levelAlignment - 1);
+        }
+        move.staging = mStagingRing->Allocate(static_cast<Uint32>(stagingSize), levelAlignment);
+        if (!move.staging.IsValid()) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to stage %u streamed texture levels", numNewLevels);
+            mMaterialTable->FreeTexture(slot);
+            return false;
+        }
+        for (uint32_t i = 0; i < numNewLevels; ++i) {
+            SDL_memcpy(move.staging.data + move.levels[i].offset, entry.textureFile.GetLevelData(level + i), move.levels[i].size);
+        }
+        outUploadBytes += stagingSize;
+        mStats.bytesStreamedIn += stagingSize;
+        ++mStats.numStreamedIn;
+    }
+    else if (level > entry.residentLevel) {
+        ++mStats.numEvicted;
+    }
+
+    const int64_t byteDelta = static_cast<int64_t>(GetResidentBytes(entry, level)) - static_cast<int64_t>(GetResidentBytes(entry, entry.residentLevel));
+    const int64_t baseLevelByteDelta =
+        static_cast<int64_t>(SDL_CalculateGPUTextureFormatSize(format, levels[level].width, levels[level].height, 1))
+        - static_cast<int64_t>(SDL_CalculateGPUTextureFormatSize(format, levels[entry.residentLevel].width, levels[entry.residentLevel].height, 1));
+    outRelocations.push_back({ .from = entry.slot, .to = slot, .byteDelta = byteDelta, .baseLevelByteDelta = baseLevelByteDelta });
+    mStats.residentBytes = static_cast<uint64_t>(static_cast<int64_t>(mStats.residentBytes) + byteDelta);
+    // The layer moved out of counts as released: it's reused by a later allocation or trimmed
+    mStats.reservedBytes -= mMaterialTable->GetLayerBytes(entry.slot);
+    mMoves.push_back(std::move(move));
+
+    // Keyed by its new slot from now on. The entry itself stays where it is.
+    const uint32_t oldKey = entry.slot.Pack();
+    entry.slot = slot;
+    entry.residentLevel = level;
+    entry.movedFrame = mFrame;
+    auto node = mEntries.extract(oldKey);
+    node.key() = slot.Pack();
+    mEntries.insert(std::move(node));
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+#include <Render/StagingRing.h>
+#include <Render/TextureFile.h>
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class MaterialTable;
+
+// Keeps the finer mip levels of material textures on the GPU only while something on screen
+// needs them, within a budget on the memory of the material texture arrays.
+//  - Textures loaded from a TextureFile are created from their levels up to s_InitialSize and
+//    handed over with Add. The streamer keeps the file (mapped, or its data in memory) to read
+//    finer levels from later.
+//  - Each frame the visible submeshes Request the resolution they sample their textures at.
+//    Update picks the level every texture wants, streams the most starved ones in within a per
+//    frame upload budget, and evicts levels of the least recently used textures, down to their
+//    initial ones, to keep the arrays under the budget. Array layers reserved but not allocated
+//    count against it too, MaterialTable::Trim hands them back.
+//  - A texture array layer has a fixed size and level count, so changing levels moves a texture
+//    to a layer of the array for its new shape: the levels it keeps are copied on the GPU, new
+//    ones uploaded from the file. Every reference to the old slot has to be switched over, which
+//    Update reports as Relocations. Textures also move down within a mostly free array, so Trim
+//    can shrink it.
+// Update allocates, Record records the copies, like the other users of MaterialTable arrays.
+class TextureStreamer {
+public:
+    // A texture that moved to another slot
+    struct Relocation {
+        TextureSlot from;
+        TextureSlot to;
+        int64_t byteDelta = 0;          // GPU memory, all levels
+        int64_t baseLevelByteDelta = 0; // of the finest level
+    };
+
+    void Init(MaterialTable* materialTable, StagingRing* stagingRing, const uint64_t budget);
+    // Forgets every texture, their slots belong to whoever created them
+    void Release();
+
+    void SetBudget(const uint64_t bytes);
+
+    // The level of the file to create a streamed texture from, 0 if it's small enough to be
+    // created whole (and isn't worth streaming)
+    static uint32_t GetInitialLevel(const TextureFile& textureFile);
+    // Takes over a texture created from levels firstLevel and coarser of textureFile.
+    // fileData is what textureFile was parsed from, if it doesn't own its data.
+    void Add(const TextureSlot slot, TextureFile textureFile, std::vector<uint8_t> fileData, const uint32_t firstLevel);
+    // Forgets a texture whose slot was freed
+    void Remove(const TextureSlot slot);
+
+    // A visible surface samples the texture at about resolution texels across this frame.
+    // Ignored for textures that aren't streamed.
+    void Request(const TextureSlot slot, const float resolution);
+
+    // Moves textures to the levels this frame's requests want, staging at most uploadBudget bytes
+    // (at least one texture). The new slots are allocated, and the old ones still valid, until Record.
+    void Update(const uint64_t uploadBudget, std::vector<Relocation>& outRelocations);
+    // Records the moves of the last Update and frees the slots the textures moved out of
+    void Record(SDL_GPUCopyPass* copyPass);
+
+    const TextureStreamingStats* GetStats() const { return &mStats; }
+
+private:
+    struct Entry {
+        TextureFile textureFile;
+        std::vector<uint8_t> fileData;
+        TextureSlot slot;
+        uint32_t residentLevel = 0; // finest level on the GPU
+        uint32_t initialLevel = 0;  // coarsest it gets evicted to
+        uint32_t wantedLevel = 0;
+        float resolution = 0.0f;    // largest requested in lastUsedFrame
+        uint64_t lastUsedFrame = 0;
+        uint64_t movedFrame = 0;    // moved again only in a later Update, its copies are recorded in order
+    };
+
+    struct Move {
+        TextureSlot from;
+        TextureSlot to;
+        uint32_t fromLevel = 0;
+        uint32_t toLevel = 0;
+        std::vector<TextureLevel> levels; // of the new slot, offsets into staging for the uploaded ones
+        StagingRing::Allocation staging;  // levels toLevel to fromLevel - 1, when streaming in
+    };
+
+    // What moving the texture to level adds to the arrays, UINT64_MAX if it can't move there now
+    uint64_t GetAllocationBytes(const Entry& entry, const uint32_t level) const;
+    static uint64_t GetResidentBytes(const Entry& entry, const uint32_t level);
+    // Whether the level can be the first of a texture: block compressed textures need whole blocks
+    static bool IsFirstLevelValid(const TextureFile& textureFile, const uint32_t level);
+    uint32_t GetWantedLevel(const Entry& entry) const;
+    // Moves the texture to start at level, or to a lower layer at the same level, adding the bytes
+    // staged for it to outUploadBytes. False if there's no layer or staging room for it.
+    bool MoveTo(Entry& entry, const uint32_t level, uint64_t& outUploadBytes, std::vector<Relocation>& outRelocations);
+
+    MaterialTable* mMaterialTable = nullptr;
+    StagingRing* mStagingRing = nullptr;
+    uint64_t mBudget = 0;
+    uint64_t mFrame = 1; // requests are made in it, Update ends it
+    std::unordered_map<uint32_t, Entry> mEntries; // by packed slot
+    std::vector<Move> mMoves; // of the last Update
+    TextureStreamingStats mStats;
+};
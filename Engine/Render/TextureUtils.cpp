@@ -0,0 +1,48 @@
+#include "TextureUtils.h"
+
+#include <algorithm>
+#include <bit>
+
+uint32_t TextureUtils::GetNumMipLevels(const uint32_t width, const uint32_t height) {
+    const uint32_t size = std::max(std::max(width, height), 1u);
+    return static_cast<uint32_t>(std::bit_width(size));
+}
+
+uint64_t TextureUtils::GetTextureSize(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels) {
+    uint64_t size = 0;
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        const uint32_t levelWidth = std::max(width >> level, 1u);
+        const uint32_t levelHeight = std::max(height >> level, 1u);
+        size += SDL_CalculateGPUTextureFormatSize(format, levelWidth, levelHeight, 1);
+    }
+    return size;
+}
+
+void TextureUtils::GetBlockSize(const SDL_GPUTextureFormat format, uint32_t& outWidth, uint32_t& outHeight) {
+    // A row (column) one texel past the block is the first to need a second block. ASTC blocks are at most 12x12.
+    constexpr uint32_t maxBlockSize = 12;
+    const Uint32 blockBytes = SDL_CalculateGPUTextureFormatSize(format, 1, 1, 1);
+    outWidth = 1;
+    while (outWidth < maxBlockSize && SDL_CalculateGPUTextureFormatSize(format, outWidth + 1, 1, 1) == blockBytes) ++outWidth;
+    outHeight = 1;
+    while (outHeight < maxBlockSize && SDL_CalculateGPUTextureFormatSize(format, 1, outHeight + 1, 1) == blockBytes) ++outHeight;
+}
+
+void TextureUtils::DownsampleRGBA8(const uint8_t* src, const uint32_t width, const uint32_t height, uint8_t* dst) {
+    const uint32_t dstWidth = std::max(width / 2, 1u);
+    const uint32_t dstHeight = std::max(height / 2, 1u);
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+        // Odd sizes clamp the last row/column instead of reading past it
+        const uint32_t y0 = std::min(y * 2, height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < dstWidth; ++x) {
+            const uint32_t x0 = std::min(x * 2, width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            for (uint32_t channel = 0; channel < 4; ++channel) {
+                const uint32_t sum = src[(y0 * width + x0) * 4 + channel] + src[(y0 * width + x1) * 4 + channel]
+                    + src[(y1 * width + x0) * 4 + channel] + src[(y1 * width + x1) * 4 + channel];
+                dst[(y * dstWidth + x) * 4 + channel] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+}
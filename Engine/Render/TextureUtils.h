@@ -0,0 +1,19 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+// Size and mip helpers shared by the texture loading paths
+namespace TextureUtils {
+    // Full chain down to 1x1
+    uint32_t GetNumMipLevels(const uint32_t width, const uint32_t height);
+
+    // Bytes of every level of a 2D texture (block compressed formats round up to whole blocks)
+    uint64_t GetTextureSize(const SDL_GPUTextureFormat format, const uint32_t width, const uint32_t height, const uint32_t numLevels);
+
+    // Texel dimensions of one block of the format, 1x1 for uncompressed ones
+    void GetBlockSize(const SDL_GPUTextureFormat format, uint32_t& outWidth, uint32_t& outHeight);
+
+    // 2x2 box filter of an RGBA8 image into the next mip level (max(size / 2, 1))
+    void DownsampleRGBA8(const uint8_t* src, const uint32_t width, const uint32_t height, uint8_t* dst);
+}
@@ -0,0 +1,135 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+    constexpr float s_Unorm16Max = 65535.0f;
+    constexpr float s_Snorm16Max = 32767.0f;
+
+    uint16_t ToUnorm16(const float value) {
+        return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * s_Unorm16Max));
+    }
+
+    int16_t ToSnorm16(const float value) {
+        return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * s_Snorm16Max));
+    }
+
+    float FromSnorm16(const int16_t value) {
+        return std::max(static_cast<float>(value) / s_Snorm16Max, -1.0f);
+    }
+
+    float SignNotZero(const float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Octahedral mapping of a unit vector onto [-1, 1]^2
+    glm::vec2 OctEncode(const glm::vec3& v) {
+        const glm::vec3 n = v / (std::abs(v.x) + std::abs(v.y) + std::abs(v.z));
+        if (n.z >= 0.0f) return {n.x, n.y};
+        return {(1.0f - std::abs(n.y)) * SignNotZero(n.x), (1.0f - std::abs(n.x)) * SignNotZero(n.y)};
+    }
+
+    glm::vec3 OctDecode(const glm::vec2& e) {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        const float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    // Rounding each component independently isn't always closest on the sphere,
+    // so try the four neighbouring snorm values and keep the best one
+    void PackUnitVector(const glm::vec3& v, int16_t out[2]) {
+        const glm::vec2 e = OctEncode(v);
+        float bestDot = -2.0f;
+        for (int i = 0; i < 4; ++i) {
+            const float x = (i & 1) ? std::ceil(e.x * s_Snorm16Max) : std::floor(e.x * s_Snorm16Max);
+            const float y = (i & 2) ? std::ceil(e.y * s_Snorm16Max) : std::floor(e.y * s_Snorm16Max);
+            const int16_t candidate[2] = {ToSnorm16(x / s_Snorm16Max), ToSnorm16(y / s_Snorm16Max)};
+            const float d = glm::dot(v, OctDecode({FromSnorm16(candidate[0]), FromSnorm16(candidate[1])}));
+            if (d > bestDot) {
+                bestDot = d;
+                out[0] = candidate[0];
+                out[1] = candidate[1];
+            }
+        }
+    }
+
+    // Any unit vector perpendicular to n, for vertices without a usable tangent
+    glm::vec3 Perpendicular(const glm::vec3& n) {
+        const glm::vec3 axis = std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(n, axis));
+    }
+
+    float AngleDegrees(const glm::vec3& a, const glm::vec3& b) {
+        return glm::degrees(std::acos(std::clamp(glm::dot(a, b), -1.0f, 1.0f)));
+    }
+}
+
+PackedVertex VertexPacking::Pack(const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    PackedVertex packed{};
+
+    const glm::vec3 extent = boundsMax - boundsMin;
+    for (int i = 0; i < 3; ++i) {
+        packed.position[i] = extent[i] > 0.0f ? ToUnorm16((vertex.position[i] - boundsMin[i]) / extent[i]) : 0;
+    }
+
+    const float normalLength = glm::length(vertex.normal);
+    const glm::vec3 normal = normalLength > 0.0f ? vertex.normal / normalLength : glm::vec3(0.0f, 1.0f, 0.0f);
+    // Gram-Schmidt, the decoded tangent is only meaningful perpendicular to the normal
+    glm::vec3 tangent = vertex.tangent - normal * glm::dot(normal, vertex.tangent);
+    const float tangentLength = glm::length(tangent);
+    tangent = tangentLength > 1e-6f ? tangent / tangentLength : Perpendicular(normal);
+    const float bitangentSign = SignNotZero(glm::dot(glm::cross(normal, tangent), vertex.bitangent));
+
+    PackUnitVector(normal, packed.normal);
+    PackUnitVector(tangent, packed.tangent);
+    packed.position[3] = bitangentSign > 0.0f ? static_cast<uint16_t>(s_Unorm16Max) : 0;
+    packed.uv[0] = glm::packHalf1x16(vertex.uv.x);
+    packed.uv[1] = glm::packHalf1x16(vertex.uv.y);
+    return packed;
+}
+
+Vertex VertexPacking::Unpack(const PackedVertex& packed, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    Vertex vertex{};
+    const glm::vec3 extent = boundsMax - boundsMin;
+    for (int i = 0; i < 3; ++i) {
+        vertex.position[i] = boundsMin[i] + static_cast<float>(packed.position[i]) / s_Unorm16Max * extent[i];
+    }
+    vertex.normal = OctDecode({FromSnorm16(packed.normal[0]), FromSnorm16(packed.normal[1])});
+    vertex.tangent = OctDecode({FromSnorm16(packed.tangent[0]), FromSnorm16(packed.tangent[1])});
+    const float bitangentSign = packed.position[3] > 0 ? 1.0f : -1.0f;
+    vertex.bitangent = glm::cross(vertex.normal, vertex.tangent) * bitangentSign;
+    vertex.uv = {glm::unpackHalf1x16(packed.uv[0]), glm::unpackHalf1x16(packed.uv[1])};
+    return vertex;
+}
+
+VertexPacking::PackingError VertexPacking::PackMesh(MeshData& mesh) {
+    PackingError error{};
+    mesh.packedVertices.resize(mesh.vertices.size());
+    for (const SubMeshData& submesh : mesh.submeshes) {
+        for (uint32_t i = submesh.baseVertex; i < submesh.baseVertex + submesh.numVertices; ++i) {
+            const Vertex& source = mesh.vertices[i];
+            mesh.packedVertices[i] = Pack(source, submesh.boundsMin, submesh.boundsMax);
+
+            const Vertex decoded = Unpack(mesh.packedVertices[i], submesh.boundsMin, submesh.boundsMax);
+            error.position = std::max(error.position, glm::length(decoded.position - source.position));
+            error.uv = std::max(error.uv, std::max(std::abs(decoded.uv.x - source.uv.x), std::abs(decoded.uv.y - source.uv.y)));
+            if (glm::length(source.normal) <= 0.0f) continue;
+            const glm::vec3 normal = glm::normalize(source.normal);
+            error.normalDegrees = std::max(error.normalDegrees, AngleDegrees(decoded.normal, normal));
+            const glm::vec3 tangent = source.tangent - normal * glm::dot(normal, source.tangent);
+            if (glm::length(tangent) > 1e-6f) {
+                error.tangentDegrees = std::max(error.tangentDegrees, AngleDegrees(decoded.tangent, glm::normalize(tangent)));
+            }
+        }
+    }
+    return error;
+}
+
+void VertexPacking::GetDequantization(const SubMeshData& submesh, glm::vec4& outOffset, glm::vec4& outScale) {
+    outOffset = glm::vec4(submesh.boundsMin, 0.0f);
+    outScale = glm::vec4(submesh.boundsMax - submesh.boundsMin, 0.0f);
+}
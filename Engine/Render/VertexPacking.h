@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Render/RenderStructs.h>
+
+// Quantizes model vertices into PackedVertex (56 -> 20 bytes).
+// Positions are stored relative to the submesh bounds, the tangent frame as two octahedral
+// unit vectors plus the bitangent sign, and UVs as half floats. The shaders rebuild the
+// bitangent as cross(normal, tangent) * sign.
+namespace VertexPacking {
+    // Largest round trip error over the packed vertices
+    struct PackingError {
+        float position = 0.0f;   // object space distance
+        float normalDegrees = 0.0f;
+        float tangentDegrees = 0.0f;
+        float uv = 0.0f;
+    };
+
+    PackedVertex Pack(const Vertex& vertex, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    Vertex Unpack(const PackedVertex& packed, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Fills mesh.packedVertices from mesh.vertices using each submesh's bounds
+    PackingError PackMesh(MeshData& mesh);
+
+    // Dequantization parameters for the Model cbuffer
+    void GetDequantization(const SubMeshData& submesh, glm::vec4& outOffset, glm::vec4& outScale);
+}
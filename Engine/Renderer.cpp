@@ -1,16 +1,17 @@
 #include "Renderer.h"
 
-#include <assimp/mesh.h>
-#include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui_impl_sdl3.h>
 #include <imgui_impl_sdlgpu3.h>
+#include <limits>
 #include <memory>
 #include <Nodes.h>
-#include <queue>
+#include <Render/MeshFile.h>
+#include <Render/TextureUtils.h>
+#include <Render/VertexPacking.h>
 #include <SDL3/SDL_vulkan.h>
 #include <SDL3_image/SDL_image.h>
 #include <span>
@@ -60,8 +61,28 @@ static std::vector<Uint32> s_GridIndices = {
 static std::vector<glm::vec3> s_PointLightPositions = {
     {0.0f, 2.0f, 0.0f},
 };
-static unsigned int s_ModelLoadingFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace;
-                                        //| aiProcess_TransformUVCoords | aiProcess_GenBoundingBoxes | aiProcess_CalcTangentSpace;
+// Samplers may use the whole mip chain
+static constexpr float s_SamplerMaxLod = 1000.0f;
+// Transfer bytes a frame spends finalizing streamed models, bounding the hitch when one lands
+static constexpr uint64_t s_StreamingUploadBudget = 32ull * 1024 * 1024;
+// Two frames of streaming uploads can be in flight before allocations wait on the GPU
+static constexpr Uint32 s_StagingRingSize = 2 * s_StreamingUploadBudget;
+// Initial sizes of the geometry arenas, which grow as models stream in
+static constexpr Uint32 s_VertexArenaSize = 32 * 1024 * 1024;
+static constexpr Uint32 s_IndexArenaSize = 16 * 1024 * 1024;
+// GPU memory the material texture arrays stay under by streaming levels out, and the transfer
+// bytes a frame spends streaming them in
+static constexpr uint64_t s_TextureStreamingBudget = 512ull * 1024 * 1024;
+static constexpr uint64_t s_TextureStreamingUploadBudget = 16ull * 1024 * 1024;
+
+static std::string GetModelPath(const Renderer::ModelDescriptor& modelDescriptor) {
+    std::filesystem::path modelPath = std::format("{}Content/Models/{}/{}/{}{}", BasePath, modelDescriptor.foldername, modelDescriptor.subFoldername, modelDescriptor.foldername, modelDescriptor.fileExtension);
+    return modelPath.make_preferred().string();
+}
+
+static ModelImporter::ImportSettings GetImportSettings(const Renderer::ModelDescriptor& modelDescriptor) {
+    return { .flipX = modelDescriptor.flipX, .flipY = modelDescriptor.flipY, .flipZ = modelDescriptor.flipZ };
+}
 
 Renderer::Renderer() {}
 
@@ -70,6 +91,7 @@ Renderer::~Renderer() {
 }
 
 bool Renderer::Init(const char* title, int width, int height) {
+    const Uint64 startTime = SDL_GetPerformanceCounter();
     InitAssetLoader();
 
     mWindow = SDL_CreateWindow(title, width, height, SDL_WINDOW_HIDDEN | SDL_WINDOW_RESIZABLE);
@@ -92,7 +114,7 @@ bool Renderer::Init(const char* title, int width, int height) {
         return false;
     }
     SDL_SetGPUSwapchainParameters(mSDLDevice, mWindow, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_MAILBOX);
-    ResizeWindow(); // Init color and depth targets and camera aspect ratio
+    ResizeWindow(); // Init camera aspect ratio
 
     if (!InitPipelines()) {
         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to initialize GPU Pipelines");
@@ -100,314 +122,141 @@ bool Renderer::Init(const char* title, int width, int height) {
     }
 
     InitSamplers();
-    InitMeshes();
-
-    SDL_ShowWindow(mWindow);
-
-    return true;
-}
-
-void Renderer::InitAssetLoader() {
-    std::filesystem::path basePath = SDL_GetBasePath();
-    BasePath = basePath.make_preferred().string() ;
-}
-
-bool Renderer::InitGridPipeline() {
-    SDL_GPUShader* gridVertShader = LoadShader(mSDLDevice, "Grid.vert", 0, 2, 0, 0);
-    if (!gridVertShader) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Grid Vertex Shader failed to load");
+    if (!mStagingRing.Init(mSDLDevice, s_StagingRingSize)) {
         return false;
     }
-    SDL_GPUShader* gridFragShader = LoadShader(mSDLDevice, "Grid.frag", 0, 1, 0, 0);
-    if (!gridFragShader) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Grid Fragment Shader failed to load");
+    // Vertex ranges are whole packed vertices, so their offsets convert to a base vertex. Index
+    // ranges are 4 byte aligned like the regions within them, for either element size.
+    if (!mVertexArena.Init(mSDLDevice, SDL_GPU_BUFFERUSAGE_VERTEX, "Vertex Arena", sizeof(PackedVertex), s_VertexArenaSize)
+        || !mIndexArena.Init(mSDLDevice, SDL_GPU_BUFFERUSAGE_INDEX, "Index Arena", sizeof(Uint32), s_IndexArenaSize)) {
         return false;
     }
-
-    SDL_GPUColorTargetBlendState colorBlendState{};
-    colorBlendState.color_write_mask = SDL_GPU_COLORCOMPONENT_R | SDL_GPU_COLORCOMPONENT_G | SDL_GPU_COLORCOMPONENT_B | SDL_GPU_COLORCOMPONENT_A;
-    colorBlendState.enable_color_write_mask = true;
-    colorBlendState.enable_blend = true;
-    colorBlendState.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
-    colorBlendState.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendState.color_blend_op = SDL_GPU_BLENDOP_ADD;
-    colorBlendState.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
-    colorBlendState.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
-    colorBlendState.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
-
-    SDL_GPUColorTargetDescription colorTargetDescription{};
-    colorTargetDescription.format = SDL_GetGPUSwapchainTextureFormat(mSDLDevice, mWindow);
-    colorTargetDescription.blend_state = colorBlendState;
-    std::vector colorTargetDescriptions{colorTargetDescription};
-    SDL_GPUGraphicsPipelineTargetInfo pipelineTargetInfo{};
-    pipelineTargetInfo.color_target_descriptions = colorTargetDescriptions.data();
-    pipelineTargetInfo.num_color_targets = static_cast<Uint32>(colorTargetDescriptions.size());
-    pipelineTargetInfo.has_depth_stencil_target = true;
-
-    if (SDL_GPUTextureSupportsFormat(
-        mSDLDevice, 
-        SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT, 
-        SDL_GPU_TEXTURETYPE_2D, 
-        SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
-        pipelineTargetInfo.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT;
-    }
-    else if (SDL_GPUTextureSupportsFormat(
-        mSDLDevice, 
-        SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT, 
-        SDL_GPU_TEXTURETYPE_2D, 
-        SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
-        pipelineTargetInfo.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT;
-    }
-    else {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No depth-stencil format supported");
+    if (!InitLighting()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to initialize lighting resources");
         return false;
     }
-    SDL_GPUDepthStencilState depthStencilState{
-        .compare_op = SDL_GPU_COMPAREOP_LESS,
-        .enable_depth_test = true,
-        .enable_depth_write = true,
-    };
+    InitMeshes();
 
-    SDL_GPUVertexBufferDescription vertexBufferDescription{};
-    vertexBufferDescription.slot = 0;
-    vertexBufferDescription.pitch = sizeof(Vertex);
-    vertexBufferDescription.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
-    vertexBufferDescription.instance_step_rate = 0;
-    std::vector<SDL_GPUVertexBufferDescription> vertexBufferDescriptions{vertexBufferDescription};
-
-    SDL_GPUVertexAttribute vertexPositionAttribute { 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 0};
-    SDL_GPUVertexAttribute vertexNormalAttribute   { 1, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,     sizeof(glm::vec3)};
-    SDL_GPUVertexAttribute vertexTangentAttribute  { 2, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 2 * sizeof(glm::vec3)};
-    SDL_GPUVertexAttribute vertexBiTangentAttribute{ 3, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 3 * sizeof(glm::vec3)};
-    SDL_GPUVertexAttribute vertexTextureAttribute  { 4, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, 4 * sizeof(glm::vec3)};
-    std::vector<SDL_GPUVertexAttribute> vertexAttributes{
-        vertexPositionAttribute,
-        vertexNormalAttribute,
-        vertexTangentAttribute,
-        vertexBiTangentAttribute,
-        vertexTextureAttribute
-    };
-    SDL_GPUVertexInputState vertexInputState{ vertexBufferDescriptions.data(), 1, vertexAttributes.data(), static_cast<Uint32>(vertexAttributes.size())};
-
-    SDL_GPUGraphicsPipelineCreateInfo gridPipelineCreateInfo{};
-    gridPipelineCreateInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
-    gridPipelineCreateInfo.vertex_shader = gridVertShader;
-    gridPipelineCreateInfo.fragment_shader = gridFragShader;
-    gridPipelineCreateInfo.target_info = pipelineTargetInfo;
-    gridPipelineCreateInfo.vertex_input_state = vertexInputState;
-    gridPipelineCreateInfo.depth_stencil_state = depthStencilState;
-    gridPipelineCreateInfo.rasterizer_state.fill_mode = SDL_GPU_FILLMODE_FILL;
-    gridPipelineCreateInfo.rasterizer_state.cull_mode = SDL_GPU_CULLMODE_NONE;
-    mGridPipeline = SDL_CreateGPUGraphicsPipeline(mSDLDevice, &gridPipelineCreateInfo);
-    if (!mGridPipeline) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create 'Grid' graphics pipeline");
-        return false;
-    }
+    SDL_ShowWindow(mWindow);
+    const double milliseconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    SDL_Log("Window shown %.1f ms after init", milliseconds);
 
-    SDL_ReleaseGPUShader(mSDLDevice, gridVertShader);
-    SDL_ReleaseGPUShader(mSDLDevice, gridFragShader);
-    
     return true;
 }
 
-bool Renderer::InitMeshPipeline() {
-    SDL_GPUShader* vertexShader = LoadShader(mSDLDevice, "PBR.vert", 0, 3, 0, 0);
-    if (!vertexShader) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Vertex Shader failed to load");
-        return false;
-    }
-
-    SDL_GPUShader* fragmentShader = LoadShader(mSDLDevice, "PBR.frag", static_cast<Uint32>(s_TextureTypes.size()), 1, 0, 0);
-    if (!fragmentShader) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Vertex Shader failed to load");
-        return false;
-    }
-
-    SDL_GPUColorTargetBlendState colorBlendState{};
-    colorBlendState.color_write_mask = SDL_GPU_COLORCOMPONENT_R | SDL_GPU_COLORCOMPONENT_G | SDL_GPU_COLORCOMPONENT_B | SDL_GPU_COLORCOMPONENT_A;
-    colorBlendState.enable_color_write_mask = true;
-    colorBlendState.enable_blend = true;
-    colorBlendState.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
-    colorBlendState.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendState.color_blend_op = SDL_GPU_BLENDOP_ADD;
-    colorBlendState.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
-    colorBlendState.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
-    colorBlendState.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
-
-    SDL_GPUColorTargetDescription colorTargetDescription{};
-    colorTargetDescription.format = SDL_GetGPUSwapchainTextureFormat(mSDLDevice, mWindow);
-    colorTargetDescription.blend_state = colorBlendState;
-    std::vector colorTargetDescriptions{colorTargetDescription};
-    SDL_GPUGraphicsPipelineTargetInfo pipelineTargetInfo{};
-    pipelineTargetInfo.color_target_descriptions = colorTargetDescriptions.data();
-    pipelineTargetInfo.num_color_targets = static_cast<Uint32>(colorTargetDescriptions.size());
-    pipelineTargetInfo.has_depth_stencil_target = true;
-
-    if (SDL_GPUTextureSupportsFormat(
-        mSDLDevice, 
-        SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT, 
-        SDL_GPU_TEXTURETYPE_2D, 
-        SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
-        pipelineTargetInfo.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT;
-    }
-    else if (SDL_GPUTextureSupportsFormat(
-        mSDLDevice, 
-        SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT, 
-        SDL_GPU_TEXTURETYPE_2D, 
-        SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
-        pipelineTargetInfo.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT;
-    }
-    else {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No depth-stencil format supported");
-        return false;
-    }
-    SDL_GPUDepthStencilState depthStencilState{
-        .compare_op = SDL_GPU_COMPAREOP_LESS,
-        .enable_depth_test = true,
-        .enable_depth_write = true,
-    };
+void Renderer::InitAssetLoader() {
+    std::filesystem::path basePath = SDL_GetBasePath();
+    BasePath = basePath.make_preferred().string() ;
 
-    SDL_GPUVertexBufferDescription vertexBufferDescription{};
-    vertexBufferDescription.slot = 0;
-    vertexBufferDescription.pitch = sizeof(Vertex);
-    vertexBufferDescription.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
-    vertexBufferDescription.instance_step_rate = 0;
-    std::vector<SDL_GPUVertexBufferDescription> vertexBufferDescriptions{vertexBufferDescription};
-
-    SDL_GPUVertexAttribute vertexPositionAttribute { 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 0};
-    SDL_GPUVertexAttribute vertexNormalAttribute   { 1, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,     sizeof(glm::vec3)};
-    SDL_GPUVertexAttribute vertexTangentAttribute  { 2, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 2 * sizeof(glm::vec3)};
-    SDL_GPUVertexAttribute vertexBiTangentAttribute{ 3, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 3 * sizeof(glm::vec3)};
-    SDL_GPUVertexAttribute vertexTextureAttribute  { 4, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, 4 * sizeof(glm::vec3)};
-    std::vector<SDL_GPUVertexAttribute> vertexAttributes{
-        vertexPositionAttribute,
-        vertexNormalAttribute,
-        vertexTangentAttribute,
-        vertexBiTangentAttribute,
-        vertexTextureAttribute
-    };
-    SDL_GPUVertexInputState vertexInputState{ vertexBufferDescriptions.data(), 1, vertexAttributes.data(), static_cast<Uint32>(vertexAttributes.size())};
-
-    SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo{};
-    pipelineCreateInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
-    pipelineCreateInfo.vertex_shader = vertexShader;
-    pipelineCreateInfo.fragment_shader = fragmentShader;
-    pipelineCreateInfo.target_info = pipelineTargetInfo;
-    pipelineCreateInfo.vertex_input_state = vertexInputState;
-    pipelineCreateInfo.depth_stencil_state = depthStencilState;
-
-    pipelineCreateInfo.rasterizer_state.fill_mode = SDL_GPU_FILLMODE_FILL;
-    mPipelines[RenderMode::Fill] = SDL_CreateGPUGraphicsPipeline(mSDLDevice, &pipelineCreateInfo);
-    if (!mPipelines[RenderMode::Fill]) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create 'Fill' graphics pipeline");
-        return false;
+    // Loads read from the pack first, files it doesn't have (or a missing pack) load loose
+    const std::string packPath = std::format("{}Content{}", BasePath, ContentPack::EXTENSION);
+    if (std::filesystem::exists(packPath) && mContentPack.Open(packPath, std::format("{}Content", BasePath))) {
+        // Shaders load right away and models soon after, read it in one go rather than asset by asset
+        mContentPack.Prefetch();
+        SDL_Log("Mounted content pack %s: %zu files, %.1f MB",
+            packPath.c_str(), mContentPack.GetNumFiles(), static_cast<double>(mContentPack.GetSize()) / (1024.0 * 1024.0));
     }
-    
-	pipelineCreateInfo.rasterizer_state.fill_mode = SDL_GPU_FILLMODE_LINE;
-    mPipelines[RenderMode::Line] = SDL_CreateGPUGraphicsPipeline(mSDLDevice, &pipelineCreateInfo);
-    if (!mPipelines[RenderMode::Line]) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create 'Line' graphics pipeline");
-        return false;
-    }
-
-    SDL_ReleaseGPUShader(mSDLDevice, vertexShader);
-    SDL_ReleaseGPUShader(mSDLDevice, fragmentShader);
-
-    return true;
 }
 
-bool Renderer::InitBillboardPipeline() {
-    SDL_GPUShader* vertShader = LoadShader(mSDLDevice, "Billboard.vert", 0, 2, 0, 0);
-    if (!vertShader) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Billboard Vertex Shader failed to load");
-        return false;
-    }
-    SDL_GPUShader* fragShader = LoadShader(mSDLDevice, "Billboard.frag", 0, 0, 0, 0);
-    if (!fragShader) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Billboard Fragment Shader failed to load");
-        return false;
-    }
-
-    SDL_GPUColorTargetBlendState colorBlendState{};
-    colorBlendState.color_write_mask = SDL_GPU_COLORCOMPONENT_R | SDL_GPU_COLORCOMPONENT_G | SDL_GPU_COLORCOMPONENT_B | SDL_GPU_COLORCOMPONENT_A;
-    colorBlendState.enable_color_write_mask = true;
-    colorBlendState.enable_blend = true;
-    colorBlendState.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
-    colorBlendState.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendState.color_blend_op = SDL_GPU_BLENDOP_ADD;
-    colorBlendState.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
-    colorBlendState.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
-    colorBlendState.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
-
-    SDL_GPUColorTargetDescription colorTargetDescription{};
-    colorTargetDescription.format = SDL_GetGPUSwapchainTextureFormat(mSDLDevice, mWindow);
-    colorTargetDescription.blend_state = colorBlendState;
-    std::vector colorTargetDescriptions{colorTargetDescription};
-    SDL_GPUGraphicsPipelineTargetInfo pipelineTargetInfo{};
-    pipelineTargetInfo.color_target_descriptions = colorTargetDescriptions.data();
-    pipelineTargetInfo.num_color_targets = static_cast<Uint32>(colorTargetDescriptions.size());
-    pipelineTargetInfo.has_depth_stencil_target = true;
-
+bool Renderer::InitPipelines() {
     if (SDL_GPUTextureSupportsFormat(
         mSDLDevice,
         SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT,
         SDL_GPU_TEXTURETYPE_2D,
         SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
-        pipelineTargetInfo.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT;
+        mDepthStencilFormat = SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT;
     }
     else if (SDL_GPUTextureSupportsFormat(
         mSDLDevice,
         SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT,
         SDL_GPU_TEXTURETYPE_2D,
         SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
-        pipelineTargetInfo.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT;
+        mDepthStencilFormat = SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT;
     }
     else {
         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No depth-stencil format supported");
         return false;
     }
 
-    SDL_GPUDepthStencilState depthStencilState{
-        .compare_op = SDL_GPU_COMPAREOP_LESS,
-        .enable_depth_test = true,
-        .enable_depth_write = false,
-    };
-
-    // No vertex input — we generate vertices from SV_VertexID
-    SDL_GPUVertexInputState vertexInputState{};
-
-    SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo{};
-    pipelineCreateInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
-    pipelineCreateInfo.vertex_shader = vertShader;
-    pipelineCreateInfo.fragment_shader = fragShader;
-    pipelineCreateInfo.target_info = pipelineTargetInfo;
-    pipelineCreateInfo.vertex_input_state = vertexInputState;
-    pipelineCreateInfo.depth_stencil_state = depthStencilState;
-    pipelineCreateInfo.rasterizer_state.fill_mode = SDL_GPU_FILLMODE_FILL;
-    pipelineCreateInfo.rasterizer_state.cull_mode = SDL_GPU_CULLMODE_NONE;
-    mBillboardPipeline = SDL_CreateGPUGraphicsPipeline(mSDLDevice, &pipelineCreateInfo);
-    if (!mBillboardPipeline) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create 'Billboard' graphics pipeline");
+    mThreadPool.Init();
+    mModelImporter.Init(&mThreadPool, &mContentPack);
+    if (!mShaderLibrary.Init(mSDLDevice, &mThreadPool, std::format("{}/Content/Shaders/Compiled", BasePath), &mContentPack)) {
         return false;
     }
-
-    SDL_ReleaseGPUShader(mSDLDevice, vertShader);
-    SDL_ReleaseGPUShader(mSDLDevice, fragShader);
-
-    return true;
+#ifdef SHADER_SOURCE_DIR
+    // Development builds recompile and reload shaders edited in the source tree
+    mShaderLibrary.EnableHotReload(SHADER_SOURCE_DIR);
+#endif
+    mPipelineCache.Init(mSDLDevice, &mThreadPool, &mShaderLibrary);
+    mMaterialTable.Init(mSDLDevice);
+    mTextureCache.Init(&mMaterialTable);
+    mTextureStreamer.Init(&mMaterialTable, &mStagingRing, s_TextureStreamingBudget);
+
+    // Every pipeline of the scene pass renders to the swapchain with the shared depth buffer
+    GraphicsPipelineDesc sceneDesc{};
+    sceneDesc.colorFormat = SDL_GetGPUSwapchainTextureFormat(mSDLDevice, mWindow);
+    sceneDesc.depthStencilFormat = mDepthStencilFormat;
+
+    // storage buffers: lights, cluster ranges, cluster light indices
+    mMeshPipelineDesc = sceneDesc;
+    mMeshPipelineDesc.name = "Mesh";
+    mMeshPipelineDesc.vertexShader = "PBR.vert";
+    mMeshPipelineDesc.vertexResources = {0, 2, 0, 0};
+    mMeshPipelineDesc.fragmentShader = "PBR.frag";
+    mMeshPipelineDesc.fragmentResources = {MaterialTable::MAX_TEXTURE_ARRAYS, 1, 4, 0};
+    mMeshPipelineDesc.vertexLayout = VertexLayout::PackedVertex;
+
+    // Depth only. The swapchain target is still declared (with writes masked off)
+    // so the pre-pass can share the scene render pass with the main mesh pass.
+    mDepthPrepassPipelineDesc = sceneDesc;
+    mDepthPrepassPipelineDesc.name = "DepthPrepass";
+    mDepthPrepassPipelineDesc.vertexShader = "DepthOnly.vert";
+    mDepthPrepassPipelineDesc.vertexResources = {0, 2, 0, 0};
+    mDepthPrepassPipelineDesc.fragmentShader = "DepthOnly.frag";
+    mDepthPrepassPipelineDesc.vertexLayout = VertexLayout::PackedPosition;
+    mDepthPrepassPipelineDesc.blendMode = BlendMode::NoColorWrite;
+
+    mGridPipelineDesc = sceneDesc;
+    mGridPipelineDesc.name = "Grid";
+    mGridPipelineDesc.vertexShader = "Grid.vert";
+    mGridPipelineDesc.vertexResources = {0, 2, 0, 0};
+    mGridPipelineDesc.fragmentShader = "Grid.frag";
+    mGridPipelineDesc.fragmentResources = {0, 1, 0, 0};
+    mGridPipelineDesc.vertexLayout = VertexLayout::Vertex;
+
+    // No vertex input, vertices are generated from SV_VertexID
+    mBillboardPipelineDesc = sceneDesc;
+    mBillboardPipelineDesc.name = "Billboard";
+    mBillboardPipelineDesc.vertexShader = "Billboard.vert";
+    mBillboardPipelineDesc.vertexResources = {0, 2, 0, 0};
+    mBillboardPipelineDesc.fragmentShader = "Billboard.frag";
+    mBillboardPipelineDesc.bDepthWrite = false;
+
+    // Everything reachable from the UI toggles, so switching modes never hitches
+    std::vector<GraphicsPipelineDesc> descs{
+        GetMeshPipelineDesc(RenderMode::Fill, false),
+        GetMeshPipelineDesc(RenderMode::Line, false),
+        GetMeshPipelineDesc(RenderMode::Fill, true),
+        mDepthPrepassPipelineDesc,
+        mGridPipelineDesc,
+        mBillboardPipelineDesc,
+    };
+    return mPipelineCache.Prewarm(descs);
 }
 
-bool Renderer::InitPipelines() {
-    if (!InitMeshPipeline()) {
-        return false;
+GraphicsPipelineDesc Renderer::GetMeshPipelineDesc(const RenderMode renderMode, const bool bDepthPrepassed) const {
+    GraphicsPipelineDesc desc = mMeshPipelineDesc;
+    if (bDepthPrepassed) {
+        // Main pass after the depth pre-pass: depth is already resolved, only shade the visible surface
+        desc.name = "MeshDepthEqual";
+        desc.depthCompareOp = SDL_GPU_COMPAREOP_EQUAL;
+        desc.bDepthWrite = false;
     }
-    if (!InitGridPipeline()) {
-        return false;
-    }
-    if (!InitBillboardPipeline()) {
-        return false;
+    else if (renderMode == RenderMode::Line) {
+        desc.name = "MeshLine";
+        desc.fillMode = SDL_GPU_FILLMODE_LINE;
     }
-    return true;
+    return desc;
 }
 
 void Renderer::InitSamplers() {
@@ -420,6 +269,7 @@ void Renderer::InitSamplers() {
         .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .max_lod = s_SamplerMaxLod,
     };
     mSamplers.emplace_back(SDL_CreateGPUSampler(mSDLDevice, &pointClampSamplerCreateInfo));
 	//"PointWrap",
@@ -430,6 +280,7 @@ void Renderer::InitSamplers() {
         .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .max_lod = s_SamplerMaxLod,
     };
     mSamplers.emplace_back(SDL_CreateGPUSampler(mSDLDevice, &pointWrapSamplerCreateInfo));
 	//"LinearClamp",
@@ -440,6 +291,7 @@ void Renderer::InitSamplers() {
         .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .max_lod = s_SamplerMaxLod,
     };
     mSamplers.emplace_back(SDL_CreateGPUSampler(mSDLDevice, &linearClampSamplerCreateInfo));
 	//"LinearWrap",
@@ -450,6 +302,7 @@ void Renderer::InitSamplers() {
         .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .max_lod = s_SamplerMaxLod,
     };
     mSamplers.emplace_back(SDL_CreateGPUSampler(mSDLDevice, &linearWrapSamplerCreateInfo));
 	//"AnisotropicClamp",
@@ -461,6 +314,7 @@ void Renderer::InitSamplers() {
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .max_anisotropy = 4.0f,
+        .max_lod = s_SamplerMaxLod,
         .enable_anisotropy = true,
     };
     mSamplers.emplace_back(SDL_CreateGPUSampler(mSDLDevice, &anisotropicClampSamplerCreateInfo));
@@ -473,281 +327,860 @@ void Renderer::InitSamplers() {
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
         .max_anisotropy = 4.0f,
+        .max_lod = s_SamplerMaxLod,
         .enable_anisotropy = true,
     };
     mSamplers.emplace_back(SDL_CreateGPUSampler(mSDLDevice, &anisotropicWrapSamplerCreateInfo));
 }
 
+bool Renderer::InitLighting() {
+    // TEMP
+    if (!mSceneLighting.inited) {
+        mSceneLighting.inited = true;
+        auto& lights = mSceneLighting.pointLights;
+        for (float z : {0.0f, 7.0f, -7.0f}) {
+            for (float x : {0.0f, 17.0f, -17.0f}) {
+                lights.push_back({ .position = {x, 5.0f, z} });
+            }
+        }
+    }
+    return mLightClusters.Init(mSDLDevice);
+}
+
 void Renderer::InitGrid() {
     // copy to mGridMesh
     mGridMesh.vertices = s_GridVertices;
     mGridMesh.indices = s_GridIndices;
+    mGridMesh.bLoaded = true;
 
     // Create GPU resources
-    SDL_GPUBufferCreateInfo vertexBufferCreateInfo{};
-    SDL_GPUTransferBuffer* vertexTransferBuffer = nullptr;
-    SDL_GPUBufferCreateInfo indexBufferCreateInfo{};
-    SDL_GPUTransferBuffer* indexTransferBuffer = nullptr;
-    CreateModelGPUResources(mGridMesh, vertexBufferCreateInfo, vertexTransferBuffer, indexBufferCreateInfo, indexTransferBuffer);
+    StagingRing::Allocation vertexStaging;
+    StagingRing::Allocation indexStaging;
+    if (!CreateModelGPUResources(mGridMesh, vertexStaging, indexStaging)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create grid GPU resources");
+        return;
+    }
 
-    // Upload the transfer data to the vertex buffer
+    // Upload the staged data to the geometry arenas
     SDL_GPUCommandBuffer* uploadCmdBuff = SDL_AcquireGPUCommandBuffer(mSDLDevice);
     SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuff);
-    {   // upload vertex data
-        SDL_GPUTransferBufferLocation transferBufferLocation{ vertexTransferBuffer, 0 };
-        SDL_GPUBufferRegion bufferRegion{ mGridMesh.vertexBuffer, 0, vertexBufferCreateInfo.size };
-        SDL_UploadToGPUBuffer(copyPass, &transferBufferLocation, &bufferRegion, false);
+    mStagingRing.Upload(copyPass, vertexStaging, mVertexArena.GetBuffer(), mGridMesh.vertexRange.offset);
+    mStagingRing.Upload(copyPass, indexStaging, mIndexArena.GetBuffer(), mGridMesh.indexRange.offset);
+    SDL_EndGPUCopyPass(copyPass);
+    mStagingRing.Submit(uploadCmdBuff);
+}
+
+void Renderer::InitMeshes() {
+    InitGrid();
+    // Models are only loaded once acquired, and show up once streamed in (see UpdateStreaming)
+    mLoaderThread.Init(1);
+}
+
+MeshHandle Renderer::AcquireMesh(const std::string& name) {
+    auto it = std::find_if(Models.begin(), Models.end(), [&](const ModelDescriptor& modelDescriptor) {
+        return modelDescriptor.foldername == name;
+    });
+    if (it == Models.end()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No model named %s", name.c_str());
+        return {};
+    }
+    // Requests for a mesh already loaded or loading share it
+    bool bCreated = false;
+    const MeshHandle handle = mMeshRegistry.Acquire(name, bCreated);
+    if (bCreated) {
+        RequestModel(*it, handle);
+    }
+    return handle;
+}
+
+void Renderer::ReleaseMesh(const MeshHandle handle) {
+    // Stays loaded until memory runs short, see UnloadMeshes
+    mMeshRegistry.Release(handle);
+}
+
+void Renderer::RequestModel(const ModelDescriptor& modelDescriptor, const MeshHandle handle) {
+    const Uint64 requestTime = SDL_GetPerformanceCounter();
+    mModelLoads.push_back(mLoaderThread.Submit([this, modelDescriptor, handle, requestTime]() {
+        std::unique_ptr<StreamedModel> model = LoadStreamedModel(modelDescriptor);
+        if (!model) {
+            // Comes back anyway, so the mesh can be dropped
+            model = std::make_unique<StreamedModel>();
+            model->name = modelDescriptor.foldername;
+            model->bFailed = true;
+        }
+        model->handle = handle;
+        model->requestTime = requestTime;
+        return model;
+    }));
+}
+
+Renderer::StreamedModel::~StreamedModel() {
+    for (StreamedTexture& texture : textures) {
+        SDL_DestroySurface(texture.imageData);
     }
-    {   // upload index data
-        SDL_GPUTransferBufferLocation transferBufferLocation{ indexTransferBuffer, 0 };
-        SDL_GPUBufferRegion bufferRegion{ mGridMesh.indexBuffer, 0, indexBufferCreateInfo.size };
-        SDL_UploadToGPUBuffer(copyPass, &transferBufferLocation, &bufferRegion, false);
+}
+
+// Loader thread: everything up to the GPU resources
+std::unique_ptr<Renderer::StreamedModel> Renderer::LoadStreamedModel(const ModelDescriptor& modelDescriptor) {
+    if (mCancelModelLoads) return nullptr;
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+
+    auto model = std::make_unique<StreamedModel>();
+    model->name = modelDescriptor.foldername;
+    model->descriptor = modelDescriptor;
+    ModelImporter::MeshLoadingContext context{};
+    // The cooked file when it's current, otherwise a full import which is cooked for next time.
+    // Models with embedded textures aren't cooked, their images live in the source.
+    const std::string modelPath = GetModelPath(modelDescriptor);
+    const ModelImporter::ImportSettings importSettings = GetImportSettings(modelDescriptor);
+    if (!mModelImporter.LoadCooked(modelPath, importSettings, model->mesh, context)) {
+        context.materialInfos.clear();
+        model->mesh = {};
+        if (!mModelImporter.Import(modelPath, importSettings, model->mesh, context)) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load model: %s", modelDescriptor.foldername.c_str());
+            return nullptr;
+        }
+        if (context.scene->mNumTextures == 0) {
+            mModelImporter.Cook(modelPath, importSettings, model->mesh, context);
+        }
+    }
+    model->mesh.samplerTypeIndex = modelDescriptor.samplerTypeIndex;
+
+    // Materials reference textures by filename, each one is decoded once
+    std::unordered_map<std::string, uint32_t> textureIndices;
+    std::unordered_map<std::string, std::set<aiTextureType>> textureTypes;
+    model->materialTextures.resize(context.materialInfos.size());
+    for (size_t i = 0; i < context.materialInfos.size(); ++i) {
+        for (const auto& [texType, texInfo] : context.materialInfos[i].textureContextMap) {
+            auto [it, bInserted] = textureIndices.try_emplace(texInfo.filename, static_cast<uint32_t>(model->textures.size()));
+            if (bInserted) {
+                StreamedTexture& texture = model->textures.emplace_back();
+                texture.filename = texInfo.filename;
+                texture.type = texType;
+                texture.bUseFallback = texInfo.bUseFallback;
+            }
+            model->materialTextures[i][texType] = it->second;
+            if (!texInfo.bUseFallback) {
+                textureTypes[texInfo.filename].insert(texType);
+            }
+        }
     }
 
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(uploadCmdBuff);
+    for (StreamedTexture& texture : model->textures) {
+        texture.role = ModelImporter::GetTextureRole(textureTypes[texture.filename]);
+    }
+
+    // Images decode independently, one per pool thread
+    const Uint64 decodeStartTime = SDL_GetPerformanceCounter();
+    mThreadPool.ParallelFor(model->textures.size(), [&](size_t i) {
+        StreamedTexture& texture = model->textures[i];
+        if (!texture.bUseFallback && !mCancelModelLoads) {
+            DecodeStreamedTexture(modelDescriptor, context.scene, true, texture);
+        }
+    });
+    if (mCancelModelLoads) return nullptr;
+    size_t numDecoded = 0;
+    {
+        std::lock_guard<std::mutex> lock(mDecodedTextureKeysMutex);
+        for (const StreamedTexture& texture : model->textures) {
+            if (texture.bHasTextureFile || texture.imageData) {
+                mDecodedTextureKeys.insert(texture.cacheKey);
+                ++numDecoded;
+            }
+        }
+    }
+    const double decodeMilliseconds = static_cast<double>(SDL_GetPerformanceCounter() - decodeStartTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    SDL_Log("Decoded %zu textures of %s in %.1f ms on %u threads",
+        numDecoded, model->name.c_str(), decodeMilliseconds, mThreadPool.GetNumThreads() + 1);
 
-    SDL_ReleaseGPUTransferBuffer(mSDLDevice, vertexTransferBuffer);
-    SDL_ReleaseGPUTransferBuffer(mSDLDevice, indexTransferBuffer);
+    // One at a time: the encoder already spreads each texture's blocks over the pool, and can't be
+    // nested in a pool job
+    for (StreamedTexture& texture : model->textures) {
+        if (mCancelModelLoads) return nullptr;
+        CompressStreamedTexture(texture);
+    }
+
+    model->loadMilliseconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    return model;
 }
 
-void Renderer::InitMeshes() {
-    InitGrid();
-    for (auto& model : Models) {
-        MeshData mesh;
-        if (InitMesh(model, mesh)) {
-            mMeshes[model.foldername] = mesh;
+void Renderer::DecodeStreamedTexture(const ModelDescriptor& modelDescriptor, const aiScene* scene, const bool bSkipDecoded, StreamedTexture& texture) {
+    // The source bytes: the embedded image, or the file it loads from
+    MappedFile sourceFile;
+    std::string sourcePath;
+    const uint8_t* sourceData = nullptr;
+    size_t sourceSize = 0;
+    std::string sourceFormat; // extension without the dot, for SDL_image and container detection
+    if (!texture.skippedSource.empty()) {
+        sourceData = texture.skippedSource.data();
+        sourceSize = texture.skippedSource.size();
+        sourceFormat = texture.skippedSourceFormat;
+    }
+    else if (scene && scene->mNumTextures > 0) {
+        if (const aiTexture* embedded = scene->GetEmbeddedTexture(texture.filename.c_str())) {
+            sourceData = reinterpret_cast<const uint8_t*>(embedded->pcData);
+            sourceSize = (embedded->mHeight == 0) ? embedded->mWidth : embedded->mWidth * embedded->mHeight;
+            sourceFormat = embedded->achFormatHint;
+        }
+    }
+    else {
+        sourcePath = GetTextureSourcePath(modelDescriptor.foldername, modelDescriptor.subFoldername, texture.filename);
+        sourceData = mContentPack.Find(sourcePath, sourceSize);
+        if (!sourceData && sourceFile.Open(sourcePath)) {
+            sourceData = sourceFile.GetData();
+            sourceSize = sourceFile.GetSize();
+        }
+        sourceFormat = std::filesystem::path(sourcePath).extension().string();
+        if (!sourceFormat.empty()) sourceFormat.erase(0, 1);
+    }
+    if (!sourceData) {
+        return;
+    }
+
+    // Identical bytes give an identical texture unless they're compressed differently
+    const uint64_t settings = (static_cast<uint64_t>(texture.role) << 16)
+        | (static_cast<uint64_t>(mCompressTextures) << 8)
+        | static_cast<uint64_t>(mTextureCompressionQuality);
+    texture.cacheKey = TextureCache::HashContent(sourceData, sourceSize, settings);
+    // Decoded for an earlier model, which reaches the texture cache first since models are finalized
+    // in order. Embedded bytes go away with the scene, a copy is kept in case the cache lost it by then.
+    if (bSkipDecoded) {
+        {
+            std::lock_guard<std::mutex> lock(mDecodedTextureKeysMutex);
+            texture.bDecodeSkipped = mDecodedTextureKeys.contains(texture.cacheKey);
         }
-        else{
-            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to initialize mesh of filename: %s", model.foldername.c_str());
+        if (texture.bDecodeSkipped) {
+            if (sourcePath.empty()) {
+                texture.skippedSource.assign(sourceData, sourceData + sourceSize);
+                texture.skippedSourceFormat = sourceFormat;
+            }
+            return;
+        }
+    }
+
+    // Block compressed containers are uploaded as is, anything else goes through SDL_image
+    // (and is block compressed afterwards unless disabled, see LoadStreamedModel)
+    if (TextureFile::IsContainerExtension(sourceFormat)) {
+        if (sourcePath.empty()) {
+            // The scene goes away with the loader, keep the bytes the parsed levels point into
+            texture.embeddedData.assign(sourceData, sourceData + sourceSize);
+            texture.bHasTextureFile = texture.textureFile.Parse(texture.embeddedData.data(), texture.embeddedData.size());
+        }
+        else if (!sourceFile.IsOpen()) {
+            // Packed, the levels point into the pack's mapping which outlives every texture
+            texture.bHasTextureFile = texture.textureFile.Parse(sourceData, sourceSize);
+        }
+        else {
+            texture.bHasTextureFile = texture.textureFile.Load(sourcePath);
+        }
+        texture.bHasTextureFile = texture.bHasTextureFile && PrepareTextureFile(texture.textureFile, texture.filename);
+    }
+    else if (SDL_IOStream* ioStream = SDL_IOFromConstMem(sourceData, sourceSize)) {
+        if (SDL_Surface* image = IMG_LoadTyped_IO(ioStream, true, sourceFormat.c_str())) {
+            texture.imageData = LoadImageShared(image, 4);
         }
     }
-    SDL_LogDebug(SDL_LOG_CATEGORY_CUSTOM, "Loaded %zu meshes", mMeshes.size());
 }
 
-bool Renderer::InitMesh(const ModelDescriptor& modelDescriptor, MeshData& mesh) {
-    MeshLoadingContext context{};
-    // Load the model
-    if (!LoadModel(modelDescriptor, mesh, context)) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load model: %s", SDL_GetError());
-        return false;
+void Renderer::CompressStreamedTexture(StreamedTexture& texture) {
+    if (!mCompressTextures || texture.bHasTextureFile || !texture.imageData) {
+        return;
     }
-    // Create MeshData resources
-    SDL_GPUBufferCreateInfo vertexBufferCreateInfo{};
-    SDL_GPUTransferBuffer* vertexTransferBuffer = nullptr;
-    SDL_GPUBufferCreateInfo indexBufferCreateInfo{};
-    SDL_GPUTransferBuffer* indexTransferBuffer = nullptr;
-    if (!CreateModelGPUResources(mesh, vertexBufferCreateInfo, vertexTransferBuffer, indexBufferCreateInfo, indexTransferBuffer)) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create model GPU resources");
-        return false;
+    texture.bHasTextureFile = CompressTexture(texture.imageData, texture.role, texture.filename, texture.textureFile);
+    if (texture.bHasTextureFile) {
+        SDL_DestroySurface(texture.imageData);
+        texture.imageData = nullptr;
     }
+}
 
-    const bool bTexturesEmbedded = context.scene->mNumTextures > 0;
-    for (size_t i = 0; i < mesh.materials.size(); ++i) {
-        MaterialLoadingContext& matInfo = context.materialInfos[i];
-        PBRMaterial& meshMat = mesh.materials[i];
-        for (auto& [texType, texInfo] : matInfo.textureContextMap) {
-            Texture& meshTexture = mesh.textureIdMap[texInfo.filename];
-            if (meshTexture.texture) { // We've already loaded it
-                aiTextureType otherType = texType;
-                aiTextureType typeToAdd = texType;
-                if (texType == aiTextureType_DIFFUSE_ROUGHNESS || texType == aiTextureType_METALNESS) {
-                    otherType = (texType == aiTextureType_DIFFUSE_ROUGHNESS) ? aiTextureType_METALNESS : aiTextureType_DIFFUSE_ROUGHNESS;
-                    typeToAdd = (meshMat.textureMap.contains(texType)) ? otherType : texType;
-                }
-                else {
-                    SDL_assert(meshTexture.type == texType);
-                }
-                meshMat.textureMap.emplace(typeToAdd, meshTexture);
-                matInfo.textureContextMap[typeToAdd] = context.textureInfoMap[matInfo.textureContextMap[otherType].filename];
-                continue;
+void Renderer::EraseDecodedTextureKey(const uint64_t key) {
+    std::lock_guard<std::mutex> lock(mDecodedTextureKeysMutex);
+    mDecodedTextureKeys.erase(key);
+}
+
+// Render thread, once per frame: turns loaded models into GPU resources, a budget's worth of
+// uploads at a time, and publishes each one into its mesh when it's complete
+void Renderer::UpdateStreaming() {
+    if (!mStreamingModel) {
+        while (!mModelLoads.empty() && mModelLoads.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            mStreamingModel = mModelLoads.front().get();
+            mModelLoads.pop_front();
+            if (!mStreamingModel->bFailed) break;
+            // Handles to it go stale, acquiring it again retries the load
+            mMeshRegistry.Remove(mStreamingModel->handle);
+            mStreamingModel.reset();
+        }
+        if (!mStreamingModel) return;
+    }
+    StreamedModel& model = *mStreamingModel;
+    ++model.numFrames;
+
+    // Allocate everything first: allocations can grow a texture array, which would drop uploads
+    // already recorded into the old one. At least one step per frame, however large.
+    std::vector<TextureUpload> textureUploads;
+    uint64_t uploadBytes = 0;
+    while (model.numTexturesCreated < model.textures.size() && uploadBytes < s_StreamingUploadBudget) {
+        StreamedTexture& texture = model.textures[model.numTexturesCreated++];
+        uploadBytes += CreateStreamedTexture(model.descriptor, texture, textureUploads);
+        if (!texture.slot.IsValid()) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create texture GPU resources");
+            model.bFailed = true;
+            break;
+        }
+    }
+
+    StagingRing::Allocation vertexStaging;
+    StagingRing::Allocation indexStaging;
+    const bool bCreateGeometry = !model.bFailed && model.numTexturesCreated == model.textures.size()
+        && !model.mesh.vertexRange.IsValid() && uploadBytes < s_StreamingUploadBudget;
+    if (bCreateGeometry) {
+        if (CreateModelGPUResources(model.mesh, vertexStaging, indexStaging)) {
+            uploadBytes += vertexStaging.size + indexStaging.size;
+        }
+        else {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create model GPU resources");
+            model.bFailed = true;
+        }
+    }
+    const bool bComplete = bCreateGeometry && !model.bFailed;
+    if (bComplete) {
+        AddStreamedMaterials(model);
+    }
+
+    if (!textureUploads.empty() || bComplete) {
+        SDL_GPUCommandBuffer* uploadCmdBuff = SDL_AcquireGPUCommandBuffer(mSDLDevice);
+        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuff);
+        for (const TextureUpload& upload : textureUploads) {
+            RecordTextureUpload(copyPass, upload);
+        }
+        if (bComplete) {
+            // The arenas are only fetched now, allocations may have grown them
+            mStagingRing.Upload(copyPass, vertexStaging, mVertexArena.GetBuffer(), model.mesh.vertexRange.offset);
+            mStagingRing.Upload(copyPass, indexStaging, mIndexArena.GetBuffer(), model.mesh.indexRange.offset);
+            if (!mMaterialTable.Upload(copyPass, mStagingRing)) {
+                SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to upload the material table");
             }
-            if (texInfo.bUseFallback) {
-                CreateFallbackTexture(texType, meshTexture.texture, texInfo.transferBuffer);
-                texInfo.imageSize = {1, 1};
+        }
+        SDL_EndGPUCopyPass(copyPass);
+
+        // Fill in the mip chains from the uploaded level 0, of the new layers only. Textures loaded
+        // from a TextureFile already uploaded their own levels.
+        for (const TextureUpload& upload : textureUploads) {
+            if (upload.bGenerateMips) {
+                RecordMipGeneration(uploadCmdBuff, upload);
             }
-            else {
-                if (bTexturesEmbedded) {
-                    if (const aiTexture* texture = context.scene->GetEmbeddedTexture(texInfo.filename.c_str())) {
-                        const size_t texSize = (texture->mHeight == 0) ? texture->mWidth : texture->mWidth * texture->mHeight;
-                        if (SDL_IOStream* ioStream = SDL_IOFromMem(texture->pcData, texSize)) {
-                            if (SDL_Surface* image = IMG_LoadTyped_IO(ioStream, true, texture->achFormatHint)) {
-                                texInfo.imageData = LoadImageShared(image, 4);
-                            }
-                        }
-                    }
-                }
-                else {
-                    texInfo.imageData = LoadImage(modelDescriptor.foldername, modelDescriptor.subFoldername, texInfo.filename, 4);
-                }
-                SDL_assert(texInfo.imageData);
-
-                texInfo.imageSize = {static_cast<Uint32>(texInfo.imageData->w), static_cast<Uint32>(texInfo.imageData->h)};
-                
-                if (!CreateTextureGPUResources(texInfo.imageData, texInfo.filename, meshTexture.texture, texInfo.transferBuffer)) {
-                    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create texture GPU resources");
-                    return false;
-                }
-                SDL_assert(meshTexture.texture);
+        }
+        // Submitted ahead of the frame's command buffer, so a model published now is drawn this
+        // frame. Fences this frame's staging, reclaimed once the copies have executed.
+        mStagingRing.Submit(uploadCmdBuff);
+    }
+
+    if (model.bFailed) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to initialize mesh of filename: %s", model.name.c_str());
+        ReleaseStreamedModel(model);
+        mMeshRegistry.Remove(model.handle);
+        mStreamingModel.reset();
+        CompactGeometry();
+        return;
+    }
+    if (!bComplete) {
+        return;
+    }
+
+    const double totalMilliseconds = static_cast<double>(SDL_GetPerformanceCounter() - model.requestTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    SDL_Log("Streamed %s in %.1f ms (%.1f ms loading, uploaded over %u frames)",
+        model.name.c_str(), totalMilliseconds, model.loadMilliseconds, model.numFrames);
+    SDL_Log("Texture memory: %u textures, %.1f MB (%.1f MB in mip levels)",
+        mTextureMemory.numTextures,
+        static_cast<double>(mTextureMemory.bytes) / (1024.0 * 1024.0),
+        static_cast<double>(mTextureMemory.bytes - mTextureMemory.baseLevelBytes) / (1024.0 * 1024.0));
+    const TextureCacheStats* cacheStats = mTextureCache.GetStats();
+    SDL_Log("Texture cache: %u textures, %u / %u requests shared (%u fallbacks), %.1f MB saved",
+        cacheStats->numTextures,
+        cacheStats->numHits,
+        cacheStats->numRequests,
+        cacheStats->numFallbackHits,
+        static_cast<double>(cacheStats->bytesSaved) / (1024.0 * 1024.0));
+    SDL_Log("Material table: %u materials, %u texture arrays, %.1f MB reserved",
+        mMaterialTable.GetNumMaterials(),
+        mMaterialTable.GetNumArrays(),
+        static_cast<double>(mMaterialTable.GetReservedBytes()) / (1024.0 * 1024.0));
+    const StagingStats* stagingStats = mStagingRing.GetStats();
+    SDL_Log("Staging ring: %.1f MB uploaded in %u batches, peak %.1f / %.1f MB in flight, %u stalls, %u dedicated",
+        static_cast<double>(stagingStats->bytesUploaded) / (1024.0 * 1024.0),
+        stagingStats->numBatches,
+        static_cast<double>(stagingStats->peakBytesInFlight) / (1024.0 * 1024.0),
+        static_cast<double>(stagingStats->capacity) / (1024.0 * 1024.0),
+        stagingStats->numStalls,
+        stagingStats->numDedicated);
+    const TextureStreamingStats* streamingStats = mTextureStreamer.GetStats();
+    SDL_Log("Texture streaming: %u textures, %.1f MB resident, arrays %.1f / %.1f MB",
+        streamingStats->numTextures,
+        static_cast<double>(streamingStats->residentBytes) / (1024.0 * 1024.0),
+        static_cast<double>(streamingStats->reservedBytes) / (1024.0 * 1024.0),
+        static_cast<double>(streamingStats->budget) / (1024.0 * 1024.0));
+    const GeometryArenaStats* vertexStats = mVertexArena.GetStats();
+    const GeometryArenaStats* indexStats = mIndexArena.GetStats();
+    SDL_Log("Geometry arenas: vertices %.1f / %.1f MB, indices %.1f / %.1f MB, %u meshes",
+        static_cast<double>(vertexStats->usedBytes) / (1024.0 * 1024.0),
+        static_cast<double>(vertexStats->capacity) / (1024.0 * 1024.0),
+        static_cast<double>(indexStats->usedBytes) / (1024.0 * 1024.0),
+        static_cast<double>(indexStats->capacity) / (1024.0 * 1024.0),
+        vertexStats->numRanges);
+
+    // Loading meshes are never unloaded, the handle is still good. The cooked file is unmapped,
+    // its data is on the GPU now.
+    MeshData* mesh = mMeshRegistry.Get(model.handle);
+    SDL_assert(mesh);
+    *mesh = std::move(model.mesh);
+    mesh->cookedFile.reset();
+    mesh->bLoaded = true;
+    mStreamingModel.reset();
+}
+
+// The texture from the cache, or a new one with its upload queued. Returns the bytes to upload.
+uint64_t Renderer::CreateStreamedTexture(const ModelDescriptor& modelDescriptor, StreamedTexture& texture, std::vector<TextureUpload>& outUploads) {
+    TextureUpload upload{};
+    if (!texture.bUseFallback && texture.cacheKey != 0) {
+        texture.slot = mTextureCache.Acquire(texture.cacheKey);
+        if (texture.slot.IsValid()) {
+            texture.skippedSource = {};
+            return 0;
+        }
+        if (texture.bDecodeSkipped) {
+            // Unloaded since the earlier model decoded it, or that model never got it into the cache
+            SDL_Log("Texture %s is no longer cached, decoding it again", texture.filename.c_str());
+            DecodeStreamedTexture(modelDescriptor, nullptr, false, texture);
+            CompressStreamedTexture(texture);
+            texture.skippedSource = {};
+        }
+
+        const uint64_t textureBytes = mTextureMemory.bytes;
+        bool bCreated = false;
+        uint32_t firstLevel = 0;
+        if (texture.bHasTextureFile) {
+            // Large textures start out with their coarse levels, the rest is streamed in once they're seen
+            firstLevel = TextureStreamer::GetInitialLevel(texture.textureFile);
+            const TextureLevel& level = texture.textureFile.GetLevels()[firstLevel];
+            upload.imageSize = {level.width, level.height};
+            bCreated = CreateTextureGPUResources(texture.textureFile, firstLevel, texture.filename, texture.slot, upload.staging, upload.levels);
+        }
+        else if (texture.imageData) {
+            upload.imageSize = {static_cast<Uint32>(texture.imageData->w), static_cast<Uint32>(texture.imageData->h)};
+            upload.bGenerateMips = TextureUtils::GetNumMipLevels(upload.imageSize.x, upload.imageSize.y) > 1;
+            bCreated = CreateTextureGPUResources(texture.imageData, texture.filename, texture.slot, upload.staging);
+        }
+        if (bCreated) {
+            mTextureCache.Add(texture.cacheKey, texture.slot, mTextureMemory.bytes - textureBytes);
+            if (firstLevel > 0) {
+                mTextureStreamer.Add(texture.slot, std::move(texture.textureFile), std::move(texture.embeddedData), firstLevel);
             }
-            SDL_assert(texInfo.transferBuffer);
-            
+        }
+        else {
+            // Whatever was staged is reclaimed with the batch, never uploaded. It won't reach the
+            // cache, later loads can't count on it.
+            upload = {};
+            EraseDecodedTextureKey(texture.cacheKey);
+        }
+    }
+    if (!texture.slot.IsValid()) {
+        if (!texture.bUseFallback) {
+            // Unreadable, or no room left in the texture arrays
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't load texture %s, using a fallback", texture.filename.c_str());
+        }
+        AcquireFallbackTexture(texture.type, texture.slot, upload.staging);
+        upload.imageSize = {1, 1};
+    }
+
+    // The decoded data is staged now, or kept by the streamer
+    SDL_DestroySurface(texture.imageData);
+    texture.imageData = nullptr;
+    texture.textureFile = TextureFile{};
+    texture.embeddedData = {};
+
+    if (!upload.staging.IsValid()) {
+        return 0;
+    }
+    upload.slot = texture.slot;
+    const uint64_t bytes = upload.levels.empty()
+        ? static_cast<uint64_t>(upload.imageSize.x) * upload.imageSize.y * 4
+        : upload.levels.back().offset + upload.levels.back().size;
+    outUploads.push_back(std::move(upload));
+    return bytes;
+}
+
+void Renderer::RecordTextureUpload(SDL_GPUCopyPass* copyPass, const TextureUpload& upload) {
+    // Resolved only now, arrays may have grown while the textures were allocated
+    SDL_GPUTexture* texture = mMaterialTable.GetArray(upload.slot);
+    if (upload.levels.empty()) {
+        SDL_GPUTextureRegion textureRegion{ .texture = texture, .layer = upload.slot.layer, .w = upload.imageSize.x, .h = upload.imageSize.y, .d = 1 };
+        mStagingRing.UploadLevel(copyPass, upload.staging, 0, textureRegion);
+        return;
+    }
+    for (size_t level = 0; level < upload.levels.size(); ++level) {
+        const TextureLevel& textureLevel = upload.levels[level];
+        SDL_GPUTextureRegion textureRegion{ .texture = texture, .mip_level = static_cast<Uint32>(level), .layer = upload.slot.layer, .w = textureLevel.width, .h = textureLevel.height, .d = 1 };
+        mStagingRing.UploadLevel(copyPass, upload.staging, static_cast<Uint32>(textureLevel.offset), textureRegion);
+    }
+}
+
+void Renderer::RecordMipGeneration(SDL_GPUCommandBuffer* commandBuffer, const TextureUpload& upload) {
+    // SDL_GenerateMipmapsForGPUTexture would redo every layer of the array, each level is blitted
+    // down from the one above within the texture's layer instead
+    SDL_GPUTexture* texture = mMaterialTable.GetArray(upload.slot);
+    if (!texture) {
+        return;
+    }
+    const Uint32 numLevels = TextureUtils::GetNumMipLevels(upload.imageSize.x, upload.imageSize.y);
+    for (Uint32 level = 1; level < numLevels; ++level) {
+        SDL_GPUBlitInfo blit{};
+        blit.source = { .texture = texture, .mip_level = level - 1, .layer_or_depth_plane = upload.slot.layer,
+            .w = std::max(upload.imageSize.x >> (level - 1), 1u), .h = std::max(upload.imageSize.y >> (level - 1), 1u) };
+        blit.destination = { .texture = texture, .mip_level = level, .layer_or_depth_plane = upload.slot.layer,
+            .w = std::max(upload.imageSize.x >> level, 1u), .h = std::max(upload.imageSize.y >> level, 1u) };
+        blit.load_op = SDL_GPU_LOADOP_DONT_CARE;
+        blit.filter = SDL_GPU_FILTER_LINEAR;
+        SDL_BlitGPUTexture(commandBuffer, &blit);
+    }
+}
+
+void Renderer::AddStreamedMaterials(StreamedModel& model) {
+    MeshData& mesh = model.mesh;
+    for (const StreamedTexture& texture : model.textures) {
+        Texture& meshTexture = mesh.textureIdMap[texture.filename];
+        meshTexture.type = texture.type;
+        meshTexture.slot = texture.slot;
+    }
+    for (size_t i = 0; i < mesh.materials.size(); ++i) {
+        PBRMaterial& meshMat = mesh.materials[i];
+        for (const auto& [texType, textureIndex] : model.materialTextures[i]) {
+            Texture meshTexture = mesh.textureIdMap[model.textures[textureIndex].filename];
             meshTexture.type = texType;
-            meshTexture.sampler = mSamplers[1];
             meshMat.textureMap.emplace(texType, meshTexture);
-            context.textureInfoMap.emplace(texInfo.filename, texInfo);
         }
         SDL_assert(meshMat.textureMap.size() == s_TextureTypes.size());
+        meshMat.tableIndex = mMaterialTable.AddMaterial(GetMaterialGPU(meshMat));
     }
+}
 
-    // Upload the transfer data to the vertex buffer
-    SDL_GPUCommandBuffer* uploadCmdBuff = SDL_AcquireGPUCommandBuffer(mSDLDevice);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuff);
-    {   // upload vertex data
-        SDL_GPUTransferBufferLocation transferBufferLocation{ vertexTransferBuffer, 0 };
-        SDL_GPUBufferRegion bufferRegion{ mesh.vertexBuffer, 0, vertexBufferCreateInfo.size };
-        SDL_UploadToGPUBuffer(copyPass, &transferBufferLocation, &bufferRegion, false);
-    }
-    {   // upload index data
-        SDL_GPUTransferBufferLocation transferBufferLocation{ indexTransferBuffer, 0 };
-        SDL_GPUBufferRegion bufferRegion{ mesh.indexBuffer, 0, indexBufferCreateInfo.size };
-        SDL_UploadToGPUBuffer(copyPass, &transferBufferLocation, &bufferRegion, false);
-    }
-    {   // upload texture data
-        for (auto& matInfo : context.materialInfos) {
-            for (auto& [texType, texInfo] : matInfo.textureContextMap) {
-                SDL_assert(texInfo.transferBuffer);
-                SDL_GPUTexture* texture = mesh.textureIdMap[texInfo.filename].texture;
-                SDL_GPUTextureTransferInfo textureTransferInfo{ .transfer_buffer = texInfo.transferBuffer, .offset = 0 };
-                SDL_GPUTextureRegion textureRegion{ .texture = texture, .w = texInfo.imageSize.x, .h = texInfo.imageSize.y, .d = 1 };
-                SDL_UploadToGPUTexture(copyPass, &textureTransferInfo, &textureRegion, false);
+// Drops whatever GPU resources a model got before it failed or was abandoned
+void Renderer::ReleaseStreamedModel(StreamedModel& model) {
+    for (size_t i = 0; i < model.numTexturesCreated; ++i) {
+        if (model.textures[i].slot.IsValid()) ReleaseTexture(model.textures[i].slot);
+        model.textures[i].slot = {};
+    }
+    // Decoded ones it never created won't reach the cache either
+    for (size_t i = model.numTexturesCreated; i < model.textures.size(); ++i) {
+        if (model.textures[i].bHasTextureFile || model.textures[i].imageData) EraseDecodedTextureKey(model.textures[i].cacheKey);
+    }
+    mVertexArena.Free(model.mesh.vertexRange);
+    mIndexArena.Free(model.mesh.indexRange);
+}
+
+// Drops a reference to a cached texture, which the streamer forgets along with its last one
+void Renderer::ReleaseTexture(const TextureSlot slot) {
+    const uint64_t bytes = mMaterialTable.GetLayerBytes(slot);
+    const uint64_t baseLevelBytes = mMaterialTable.GetLayerBytes(slot, 1);
+    const uint64_t key = mTextureCache.GetKey(slot);
+    if (mTextureCache.Release(slot)) {
+        // A later load of it has to decode it again
+        EraseDecodedTextureKey(key);
+        mTextureStreamer.Remove(slot);
+        --mTextureMemory.numTextures;
+        mTextureMemory.bytes -= bytes;
+        mTextureMemory.baseLevelBytes -= baseLevelBytes;
+    }
+}
+
+// Frees a loaded mesh's GPU resources and drops it from the registry
+void Renderer::UnloadMesh(const MeshHandle handle) {
+    MeshData* mesh = mMeshRegistry.Get(handle);
+    SDL_assert(mesh && mesh->bLoaded);
+    for (auto& [filename, texture] : mesh->textureIdMap) {
+        if (texture.slot.IsValid()) ReleaseTexture(texture.slot);
+    }
+    for (const PBRMaterial& material : mesh->materials) {
+        mMaterialTable.FreeMaterial(material.tableIndex);
+    }
+    mVertexArena.Free(mesh->vertexRange);
+    mIndexArena.Free(mesh->indexRange);
+    SDL_Log("Unloaded mesh %s", mesh->filepath.c_str());
+    mMeshRegistry.Remove(handle);
+}
+
+void Renderer::UnloadMeshes(const uint64_t budget) {
+    bool bUnloaded = false;
+    while (GetAssetMemory() > budget) {
+        // Meshes still loading are finished first
+        const MeshHandle handle = mMeshRegistry.GetLeastRecentlyReleased([](const MeshData& mesh) { return mesh.bLoaded; });
+        if (!handle.IsValid()) break;
+        UnloadMesh(handle);
+        bUnloaded = true;
+    }
+    if (bUnloaded) {
+        CompactGeometry();
+    }
+}
+
+// GPU memory of everything meshes hold: their geometry and textures
+uint64_t Renderer::GetAssetMemory() const {
+    return mVertexArena.GetStats()->usedBytes + mIndexArena.GetStats()->usedBytes + mTextureMemory.bytes;
+}
+
+// Moves streamed textures to the mip levels the last frame's visible submeshes asked for (see
+// CullMeshes), and points everything holding their slots at where they moved
+void Renderer::UpdateTextureStreaming() {
+    std::vector<TextureStreamer::Relocation> relocations;
+    mTextureStreamer.Update(s_TextureStreamingUploadBudget, relocations);
+    if (relocations.empty()) {
+        return;
+    }
+
+    std::unordered_map<uint32_t, TextureSlot> movedSlots;
+    for (const TextureStreamer::Relocation& relocation : relocations) {
+        mTextureCache.Relocate(relocation.from, relocation.to, relocation.byteDelta);
+        mMaterialTable.ReplaceTexture(relocation.from, relocation.to);
+        mTextureMemory.bytes = static_cast<uint64_t>(static_cast<int64_t>(mTextureMemory.bytes) + relocation.byteDelta);
+        mTextureMemory.baseLevelBytes = static_cast<uint64_t>(static_cast<int64_t>(mTextureMemory.baseLevelBytes) + relocation.baseLevelByteDelta);
+        movedSlots[relocation.from.Pack()] = relocation.to;
+    }
+    auto relocate = [&](TextureSlot& slot) {
+        auto it = movedSlots.find(slot.Pack());
+        if (it != movedSlots.end()) slot = it->second;
+    };
+    mMeshRegistry.ForEach([&](MeshHandle, MeshData& mesh) {
+        for (auto& [filename, texture] : mesh.textureIdMap) {
+            relocate(texture.slot);
+        }
+        for (PBRMaterial& material : mesh.materials) {
+            for (auto& [type, texture] : material.textureMap) {
+                relocate(texture.slot);
             }
         }
+    });
+    // Cached textures may be shared with the model being finalized
+    if (mStreamingModel) {
+        for (StreamedTexture& texture : mStreamingModel->textures) {
+            relocate(texture.slot);
+        }
     }
 
+    SDL_GPUCommandBuffer* uploadCmdBuff = SDL_AcquireGPUCommandBuffer(mSDLDevice);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuff);
+    mTextureStreamer.Record(copyPass);
+    if (!mMaterialTable.Upload(copyPass, mStagingRing)) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to upload the material table");
+    }
     SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(uploadCmdBuff);
+    // Ahead of the frame's command buffer, which samples the moved textures
+    mStagingRing.Submit(uploadCmdBuff);
+}
 
-    SDL_ReleaseGPUTransferBuffer(mSDLDevice, vertexTransferBuffer);
-    SDL_ReleaseGPUTransferBuffer(mSDLDevice, indexTransferBuffer);
-    for (auto& [filename, texInfo] : context.textureInfoMap) {
-        SDL_DestroySurface(texInfo.imageData);
-        SDL_ReleaseGPUTransferBuffer(mSDLDevice, texInfo.transferBuffer);
+// Moves submesh offsets along with their mesh's ranges, which start out at 0 (the layout the mesh
+// was imported with) and move again when an arena compacts
+static void RebaseSubmeshes(MeshData& mesh, const int64_t vertexDelta, const int64_t indexDelta) {
+    for (SubMeshData& submesh : mesh.submeshes) {
+        submesh.baseVertex = static_cast<uint32_t>(submesh.baseVertex + vertexDelta / static_cast<int64_t>(sizeof(PackedVertex)));
+        submesh.indexBufferOffset = static_cast<uint32_t>(submesh.indexBufferOffset + indexDelta);
+        const uint32_t indexSize = submesh.indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT ? sizeof(Uint16) : sizeof(Uint32);
+        submesh.baseIndex = submesh.indexBufferOffset / indexSize;
     }
-    return true;
+}
+
+// Compacts the arenas once freed meshes left them fragmented, and rebases what moved
+void Renderer::CompactGeometry() {
+    const bool bVerticesMoved = mVertexArena.IsFragmented() && mVertexArena.Compact();
+    const bool bIndicesMoved = mIndexArena.IsFragmented() && mIndexArena.Compact();
+    if (!bVerticesMoved && !bIndicesMoved) {
+        return;
+    }
+    auto rebase = [&](MeshData& mesh) {
+        if (!mesh.vertexRange.IsValid()) return;
+        const uint32_t vertexOffset = mVertexArena.GetOffset(mesh.vertexRange);
+        const uint32_t indexOffset = mIndexArena.GetOffset(mesh.indexRange);
+        RebaseSubmeshes(mesh,
+            static_cast<int64_t>(vertexOffset) - mesh.vertexRange.offset,
+            static_cast<int64_t>(indexOffset) - mesh.indexRange.offset);
+        mesh.vertexRange.offset = vertexOffset;
+        mesh.indexRange.offset = indexOffset;
+    };
+    rebase(mGridMesh);
+    mMeshRegistry.ForEach([&](MeshHandle, MeshData& mesh) {
+        rebase(mesh);
+    });
+    SDL_Log("Compacted geometry: vertices %.1f MB, indices %.1f MB in use",
+        static_cast<double>(mVertexArena.GetStats()->usedBytes) / (1024.0 * 1024.0),
+        static_cast<double>(mIndexArena.GetStats()->usedBytes) / (1024.0 * 1024.0));
 }
 
 bool Renderer::CreateModelGPUResources(
         MeshData& mesh,
-        SDL_GPUBufferCreateInfo& vertexBufferCreateInfo,
-        SDL_GPUTransferBuffer*& vertexTransferBuffer,
-        SDL_GPUBufferCreateInfo& indexBufferCreateInfo,
-        SDL_GPUTransferBuffer*& indexTransferBuffer) {
+        StagingRing::Allocation& outVertexStaging,
+        StagingRing::Allocation& outIndexStaging) {
     
     // Create GPU resources
-    vertexBufferCreateInfo.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-    vertexBufferCreateInfo.size = static_cast<Uint32>(mesh.vertices.size() * sizeof(Vertex));
-    mesh.vertexBuffer = SDL_CreateGPUBuffer(mSDLDevice, &vertexBufferCreateInfo);
-    if (!mesh.vertexBuffer) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create 'Vertex' buffer");
-        return false;
+    // Models upload their packed vertices, the grid still uses the full Vertex layout (and binds
+    // its range at an offset instead of drawing with a base vertex).
+    // Cooked models copy both blobs straight from the mapped file, or decode them into staging.
+    const MeshFile* cookedFile = mesh.cookedFile.get();
+    const bool bPacked = !mesh.packedVertices.empty();
+    Uint32 vertexDataSize;
+    if (cookedFile) {
+        vertexDataSize = cookedFile->GetVertexDataSize();
     }
-    SDL_SetGPUBufferName(mSDLDevice, mesh.vertexBuffer, "Vertex Buffer");
-
-    indexBufferCreateInfo.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-    indexBufferCreateInfo.size = static_cast<Uint32>(mesh.indices.size() * sizeof(Uint32));
-    mesh.indexBuffer =  SDL_CreateGPUBuffer(mSDLDevice, &indexBufferCreateInfo);
-    if (!mesh.indexBuffer) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create 'Index' buffer");
-        return false;
+    else {
+        vertexDataSize = static_cast<Uint32>(bPacked ? mesh.packedVertices.size() * sizeof(PackedVertex) : mesh.vertices.size() * sizeof(Vertex));
     }
-    SDL_SetGPUBufferName(mSDLDevice, mesh.indexBuffer, "Index Buffer");
-
-    SDL_GPUTransferBufferCreateInfo vertexTransferBufferCreateInfo{};
-    vertexTransferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-    vertexTransferBufferCreateInfo.size = vertexBufferCreateInfo.size;
-    
-    SDL_GPUTransferBufferCreateInfo indexTransferBufferCreateInfo{};
-    indexTransferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-    indexTransferBufferCreateInfo.size = indexBufferCreateInfo.size;
+    const Uint32 indexDataSize = mesh.indexBufferSize > 0 ? mesh.indexBufferSize : static_cast<Uint32>(mesh.indices.size() * sizeof(Uint32));
 
-    vertexTransferBuffer = SDL_CreateGPUTransferBuffer(mSDLDevice, &vertexTransferBufferCreateInfo);
-    if (!vertexTransferBuffer) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU vertex transfer buffer");
-        return false;
-    }
-    
-    indexTransferBuffer = SDL_CreateGPUTransferBuffer(mSDLDevice, &indexTransferBufferCreateInfo);
-    if (!indexTransferBuffer) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU index transfer buffer");
+    mesh.vertexRange = mVertexArena.Allocate(vertexDataSize);
+    mesh.indexRange = mIndexArena.Allocate(indexDataSize);
+    if (!mesh.vertexRange.IsValid() || !mesh.indexRange.IsValid()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No room for %u vertex and %u index bytes in the geometry arenas", vertexDataSize, indexDataSize);
         return false;
     }
 
-    void* vertexBufferDataPtr = SDL_MapGPUTransferBuffer(mSDLDevice, vertexTransferBuffer, false);
-    void* indexBufferDataPtr = SDL_MapGPUTransferBuffer(mSDLDevice, indexTransferBuffer, false);
+    outVertexStaging = mStagingRing.Allocate(vertexDataSize);
+    outIndexStaging = mStagingRing.Allocate(indexDataSize);
+    void* vertexBufferDataPtr = outVertexStaging.data;
+    void* indexBufferDataPtr = outIndexStaging.data;
     if (!vertexBufferDataPtr || !indexBufferDataPtr) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to map GPU transfer buffer data pointers");
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to stage vertex and index data");
         return false;
     }
+    else if (cookedFile) {
+        if (!cookedFile->ReadVertexData(vertexBufferDataPtr) || !cookedFile->ReadIndexData(indexBufferDataPtr)) {
+            SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Corrupt compressed geometry in the cooked mesh of %s", mesh.filepath.c_str());
+            return false;
+        }
+    }
     else {
-        std::span transferBufferData{ static_cast<Vertex*>(vertexBufferDataPtr), mesh.vertices.size()};
-        std::ranges::copy(mesh.vertices, transferBufferData.begin());
+        if (bPacked) {
+            std::span transferBufferData{ static_cast<PackedVertex*>(vertexBufferDataPtr), mesh.packedVertices.size()};
+            std::ranges::copy(mesh.packedVertices, transferBufferData.begin());
+        }
+        else {
+            std::span transferBufferData{ static_cast<Vertex*>(vertexBufferDataPtr), mesh.vertices.size()};
+            std::ranges::copy(mesh.vertices, transferBufferData.begin());
+        }
 
-        std::span indexBufferData{ static_cast<Uint32*>(indexBufferDataPtr), mesh.indices.size()};
-        std::ranges::copy(mesh.indices, indexBufferData.begin());
+        if (mesh.indexBufferSize > 0) {
+            ModelImporter::WriteIndexBuffer(mesh, indexBufferDataPtr);
+        }
+        else {
+            std::span indexBufferData{ static_cast<Uint32*>(indexBufferDataPtr), mesh.indices.size()};
+            std::ranges::copy(mesh.indices, indexBufferData.begin());
+        }
     }
 
-    SDL_UnmapGPUTransferBuffer(mSDLDevice, vertexTransferBuffer);
-    SDL_UnmapGPUTransferBuffer(mSDLDevice, indexTransferBuffer);
+    // Written in the mesh's own layout, drawn from where its ranges landed
+    RebaseSubmeshes(mesh, mesh.vertexRange.offset, mesh.indexRange.offset);
     return true;
 }
 
 bool Renderer::CreateTextureGPUResources(
         const SDL_Surface* imageData,
         const std::string textureName,
-        SDL_GPUTexture*& outTexture,
-        SDL_GPUTransferBuffer*& outTransferBuffer) {
-
-    SDL_GPUTextureCreateInfo createInfo = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
-        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
-        .width = static_cast<Uint32>(imageData->w),
-        .height = static_cast<Uint32>(imageData->h),
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-    };
-    outTexture = SDL_CreateGPUTexture(mSDLDevice, &createInfo);
-    if (!outTexture) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create texture: %s", SDL_GetError());
+        TextureSlot& outSlot,
+        StagingRing::Allocation& outStaging) {
+
+    // Level 0 is uploaded, the rest of the chain is generated on the GPU (see UpdateStreaming)
+    const SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    const Uint32 width = static_cast<Uint32>(imageData->w);
+    const Uint32 height = static_cast<Uint32>(imageData->h);
+    const Uint32 numLevels = TextureUtils::GetNumMipLevels(width, height);
+    outSlot = mMaterialTable.AllocateTexture(format, width, height, numLevels);
+    if (!outSlot.IsValid()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No texture array layer for %s", textureName.c_str());
         return false;
     }
-    SDL_SetGPUTextureName(mSDLDevice, outTexture, textureName.c_str());
+
+    ++mTextureMemory.numTextures;
+    mTextureMemory.bytes += TextureUtils::GetTextureSize(format, width, height, numLevels);
+    mTextureMemory.baseLevelBytes += TextureUtils::GetTextureSize(format, width, height, 1);
 
     // Set the texture data
-    SDL_GPUTransferBufferCreateInfo textureTransferBufferCreateInfo{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = static_cast<Uint32>(imageData->h * imageData->w * 4),
-    };
-    outTransferBuffer = SDL_CreateGPUTransferBuffer(mSDLDevice, &textureTransferBufferCreateInfo);
-    void* textureDataPtr = static_cast<Uint8*>(SDL_MapGPUTransferBuffer(mSDLDevice, outTransferBuffer, false));
-    if (!textureDataPtr) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to map GPU transfer buffer data pointer for texture");
+    outStaging = mStagingRing.Allocate(static_cast<Uint32>(imageData->h * imageData->w * 4));
+    if (!outStaging.IsValid()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to stage texture %s", textureName.c_str());
+        mMaterialTable.FreeTexture(outSlot);
+        outSlot = {};
         return false;
     }
-    else {
-        SDL_memcpy(textureDataPtr, imageData->pixels, textureTransferBufferCreateInfo.size);
+    SDL_memcpy(outStaging.data, imageData->pixels, outStaging.size);
+
+    return true;
+}
+
+bool Renderer::CreateTextureGPUResources(
+        const TextureFile& textureFile,
+        const uint32_t firstLevel,
+        const std::string textureName,
+        TextureSlot& outSlot,
+        StagingRing::Allocation& outStaging,
+        std::vector<TextureLevel>& outLevels) {
+
+    const std::vector<TextureLevel>& levels = textureFile.GetLevels();
+    const SDL_GPUTextureFormat format = textureFile.GetFormat();
+    const Uint32 width = levels[firstLevel].width;
+    const Uint32 height = levels[firstLevel].height;
+    const Uint32 numLevels = static_cast<Uint32>(levels.size()) - firstLevel;
+    outSlot = mMaterialTable.AllocateTexture(format, width, height, numLevels);
+    if (!outSlot.IsValid()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "No texture array layer for %s", textureName.c_str());
+        return false;
     }
-    SDL_UnmapGPUTransferBuffer(mSDLDevice, outTransferBuffer);
-    
+
+    ++mTextureMemory.numTextures;
+    mTextureMemory.bytes += TextureUtils::GetTextureSize(format, width, height, numLevels);
+    mTextureMemory.baseLevelBytes += TextureUtils::GetTextureSize(format, width, height, 1);
+
+    // Every level goes in one staging allocation, offsets kept aligned for the copy
+    constexpr size_t levelAlignment = 16;
+    outLevels.assign(levels.begin() + firstLevel, levels.end());
+    size_t stagingSize = 0;
+    for (TextureLevel& level : outLevels) {
+        level.offset = stagingSize;
+        stagingSize += (level.size + levelAlignment - 1) & ~(levelAlignment - 1);
+    }
+
+    outStaging = mStagingRing.Allocate(static_cast<Uint32>(stagingSize), levelAlignment);
+    if (!outStaging.IsValid()) {
+        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to stage texture %s", textureName.c_str());
+        mMaterialTable.FreeTexture(outSlot);
+        outSlot = {};
+        return false;
+    }
+    for (size_t level = 0; level < outLevels.size(); ++level) {
+        SDL_memcpy(outStaging.data + outLevels[level].offset, textureFile.GetLevelData(firstLevel + level), outLevels[level].size);
+    }
+
     return true;
 }
 
-bool Renderer::CreateFallbackTexture(
+bool Renderer::AcquireFallbackTexture(
     aiTextureType type, 
-    SDL_GPUTexture*& outTexture, 
-    SDL_GPUTransferBuffer*& outTransferBuffer
+    TextureSlot& outSlot, 
+    StagingRing::Allocation& outStaging
 ) {
+    FallbackTexture kind;
+    switch (type) {
+        case aiTextureType_METALNESS:
+        case aiTextureType_EMISSIVE:
+            kind = FallbackTexture::Black;
+            break;
+        case aiTextureType_NORMALS:
+            kind = FallbackTexture::FlatNormal;
+            break;
+        default: // roughness, AO, albedo
+            kind = FallbackTexture::White;
+            break;
+    }
+    outSlot = mTextureCache.AcquireFallback(kind);
+    if (outSlot.IsValid()) {
+        return true;
+    }
+
     const SDL_PixelFormat format = SDL_PIXELFORMAT_RGBA8888;
     SDL_Surface* surface = SDL_CreateSurface(1, 1, format);
     // TODO: Figure out how to fill the pixel with the appropriate color information
@@ -755,105 +1188,33 @@ bool Renderer::CreateFallbackTexture(
     // For emissive: https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#_material_emissivetexture
     const SDL_PixelFormatDetails* formatDetails = SDL_GetPixelFormatDetails(format);
     Uint32 color;
-    switch (type) {
-        case aiTextureType_METALNESS:
-        case aiTextureType_EMISSIVE:
+    switch (kind) {
+        case FallbackTexture::Black:
             color = SDL_MapRGBA(formatDetails, nullptr, 0, 0, 0, 0);
             break;
-        case aiTextureType_NORMALS:
+        case FallbackTexture::FlatNormal:
             color = SDL_MapRGBA(formatDetails, nullptr, 128, 128, 255, 255);
             break;
-        default: // roughness, AO, albedo
+        default:
             color = SDL_MapRGBA(formatDetails, nullptr, 255, 255, 255, 255);
             break;
     }
     if (!SDL_FillSurfaceRect(surface, nullptr, color)) {
+        SDL_DestroySurface(surface);
         return false;
     }
 
     std::string name = std::format("{}-Fallback", aiTextureTypeToString(type));
-    if (!CreateTextureGPUResources(surface, name, outTexture, outTransferBuffer)) {
+    const uint64_t textureBytes = mTextureMemory.bytes;
+    const bool bCreated = CreateTextureGPUResources(surface, name, outSlot, outStaging);
+    SDL_DestroySurface(surface);
+    if (!bCreated) {
         return false;
     }
-
-    SDL_DestroySurface(surface);
+    mTextureCache.AddFallback(kind, outSlot, mTextureMemory.bytes - textureBytes);
     return true;
 }
 
-SDL_GPUShader* Renderer::LoadShader(
-    SDL_GPUDevice* device,
-    const std::string& shaderFilename,
-    const Uint32 samplerCount,
-    const Uint32 uniformBufferCount,
-    const Uint32 storageBufferCount,
-    const Uint32 storageTextureCount) {
-
-    // Auto-detect the shader stage from the file name for convenience
-    SDL_GPUShaderStage stage;
-    if (shaderFilename.contains(".vert"))
-    {
-        stage = SDL_GPU_SHADERSTAGE_VERTEX;
-    }
-    else if (shaderFilename.contains(".frag"))
-    {
-        stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-    }
-    else
-    {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid shader stage!");
-        return nullptr;
-    }
-
-	std::string fullPath;
-	SDL_GPUShaderFormat backendFormats = SDL_GetGPUShaderFormats(device);
-	SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
-	const char *entrypoint;
-
-	if (backendFormats & SDL_GPU_SHADERFORMAT_SPIRV) {
-        fullPath = std::format("{}/Content/Shaders/Compiled/SPIRV/{}.spv", BasePath, shaderFilename);
-		format = SDL_GPU_SHADERFORMAT_SPIRV;
-		entrypoint = "main";
-	} else if (backendFormats & SDL_GPU_SHADERFORMAT_MSL) {
-        fullPath = std::format("{}/Content/Shaders/Compiled/MSL/{}.msl", BasePath, shaderFilename);
-		format = SDL_GPU_SHADERFORMAT_MSL;
-		entrypoint = "main0";
-	} else if (backendFormats & SDL_GPU_SHADERFORMAT_DXIL) {
-        fullPath = std::format("{}/Content/Shaders/Compiled/DXIL/{}.dxil", BasePath, shaderFilename);
-		format = SDL_GPU_SHADERFORMAT_DXIL;
-		entrypoint = "main";
-	} else {
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s", "Unrecognized backend shader format!");
-		return nullptr;
-	}
-
-    std::ifstream file{fullPath, std::ios::binary};
-    if (!file) {
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Couldn't open shader file: %s", fullPath);
-        return nullptr;
-    }
-    std::vector<Uint8> code{std::istreambuf_iterator(file), {}};
-
-	SDL_GPUShaderCreateInfo shaderInfo{};
-    shaderInfo.code = code.data();
-    shaderInfo.code_size = code.size();
-    shaderInfo.entrypoint = entrypoint;
-    shaderInfo.format = format;
-    shaderInfo.stage = stage;
-    shaderInfo.num_samplers = samplerCount;
-    shaderInfo.num_uniform_buffers = uniformBufferCount;
-    shaderInfo.num_storage_buffers = storageBufferCount;
-    shaderInfo.num_storage_textures = storageTextureCount;
-
-	SDL_GPUShader* shader = SDL_CreateGPUShader(device, &shaderInfo);
-	if (shader == nullptr)
-	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create shader!");
-		return nullptr;
-	}
-
-	return shader;
-}
-
 SDL_Surface* Renderer::LoadImage(const ModelDescriptor& modelDescriptor, int desiredChannels) {
     return LoadImage(modelDescriptor.foldername, modelDescriptor.subFoldername, modelDescriptor.textureFilename, desiredChannels);
 }
@@ -862,11 +1223,65 @@ SDL_Surface* Renderer::LoadImage(const std::string& foldername, const std::strin
     // Construct the full path
     std::filesystem::path texturePath = std::format("{}/Content/Models/{}/{}/{}", BasePath, foldername, subfoldername, texturename);
     std::string filePathString = texturePath.make_preferred().string();
-    SDL_Surface* image = IMG_Load(filePathString.c_str());
+    size_t packedSize = 0;
+    const uint8_t* packedData = mContentPack.Find(filePathString, packedSize);
+    SDL_Surface* image = packedData ? IMG_Load_IO(SDL_IOFromConstMem(packedData, packedSize), true) : IMG_Load(filePathString.c_str());
     SDL_assert(image);
     return LoadImageShared(image, desiredChannels);
 }
 
+std::string Renderer::GetTextureSourcePath(const std::string& foldername, const std::string& subfoldername, const std::string& texturename) {
+    std::filesystem::path texturePath = std::format("{}/Content/Models/{}/{}/{}", BasePath, foldername, subfoldername, texturename);
+    texturePath.make_preferred();
+
+    // A container next to the source image (same name, compressed offline) takes precedence over it
+    if (!TextureFile::IsContainerPath(texturePath.string())) {
+        for (const char* extension : {".ktx2", ".ktx", ".dds"}) {
+            std::filesystem::path candidate = texturePath;
+            candidate.replace_extension(extension);
+            if (mContentPack.Contains(candidate.string()) || std::filesystem::exists(candidate)) {
+                return candidate.string();
+            }
+        }
+    }
+    return texturePath.string();
+}
+
+bool Renderer::PrepareTextureFile(TextureFile& textureFile, const std::string& textureName) {
+    if (SDL_GPUTextureSupportsFormat(mSDLDevice, textureFile.GetFormat(), SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER)) {
+        return true;
+    }
+    if (textureFile.Decompress()) {
+        SDL_Log("Texture format of %s isn't supported by the device, decompressed it to RGBA8", textureName.c_str());
+        return true;
+    }
+    SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Texture format of %s isn't supported by the device and can't be decompressed", textureName.c_str());
+    return false;
+}
+
+bool Renderer::CompressTexture(const SDL_Surface* imageData, const TextureEncoder::TextureRole role, const std::string& textureName, TextureFile& outFile) {
+    const SDL_GPUTextureFormat format = TextureEncoder::GetFormatForRole(role);
+    if (!SDL_GPUTextureSupportsFormat(mSDLDevice, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER)) {
+        return false;
+    }
+    // LoadImageShared converts to ABGR8888, which is RGBA in memory
+    if (imageData->format != SDL_PIXELFORMAT_ABGR8888 || imageData->pitch != imageData->w * 4) {
+        return false;
+    }
+
+    const Uint64 startTime = SDL_GetPerformanceCounter();
+    double psnr = 0.0;
+    if (!TextureEncoder::EncodeTexture(format, static_cast<const uint8_t*>(imageData->pixels), imageData->w, imageData->h,
+            mTextureCompressionQuality, &mThreadPool, outFile, &psnr)) {
+        return false;
+    }
+    const double milliseconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    const char* formatName = (role == TextureEncoder::TextureRole::Normal) ? "BC5" : (role == TextureEncoder::TextureRole::SingleChannel ? "BC4" : "BC7");
+    SDL_Log("Compressed %s to %s (%dx%d, %zu levels) in %.1f ms, PSNR %.2f dB",
+        textureName.c_str(), formatName, imageData->w, imageData->h, outFile.GetLevels().size(), milliseconds, psnr);
+    return true;
+}
+
 SDL_Surface* Renderer::LoadImageShared(SDL_Surface* image, int desiredChannels) {
     SDL_PixelFormat format = SDL_PIXELFORMAT_UNKNOWN;
     if (!image) {
@@ -894,214 +1309,18 @@ SDL_Surface* Renderer::LoadImageShared(SDL_Surface* image, int desiredChannels)
     return image;
 }
 
-bool Renderer::LoadModel(const ModelDescriptor& modelDescriptor, MeshData& outMesh, MeshLoadingContext& outContext) {
-    // Construct the full path
-    std::filesystem::path modelPath = std::format("{}Content/Models/{}/{}/{}{}", BasePath, modelDescriptor.foldername, modelDescriptor.subFoldername, modelDescriptor.foldername, modelDescriptor.fileExtension);
-    std::string modelPathString = modelPath.make_preferred().string();
-    // Load the model
-    
-    const aiScene* scene = outContext.importer.ReadFile(modelPathString, s_ModelLoadingFlags);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->HasMeshes()) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to load model: %s \nmodel filepath: %s", outContext.importer.GetErrorString(), modelPathString.c_str());
-        return false;
-    }
-    outContext.scene = scene;
-
-    ParseVertices(scene, modelDescriptor.flipX, modelDescriptor.flipY, modelDescriptor.flipZ, outMesh, outContext);
-    ParseNodes(outMesh, outContext);
-    ParseMaterials(scene, outMesh, outContext);
-    ParseTextures(scene, outMesh, outContext);
-    //SDL_assert(outMesh.textureIdMap.size() == outContext.textureInfoMap.size());
-    outMesh.samplerTypeIndex = modelDescriptor.samplerTypeIndex;
-    outMesh.filepath = modelPathString;
-    outMesh.bDoNotRender = scene->mNumTextures > 0;
-    return true;
-}
-
-void Renderer::ParseNodes(MeshData& outMesh, MeshLoadingContext& outContext) {
-    int totalChildMeshes = 0;
-    int parentId = -1;
-    int nodeId = 0;
-    NodeLoadingContext rootNode(outContext.scene->mRootNode);
-    std::queue<NodeLoadingContext> queue;
-    queue.push(rootNode);
-    while (!queue.empty()) {
-        NodeLoadingContext& curr = queue.front();
-        outContext.nodeInfoMap.emplace(curr.pNode->mName.C_Str(), curr);
-        queue.pop();
-
-        SceneNode scenenode{parentId, nodeId};
-
-        // Assign this node's ID to its meshes
-        for (unsigned int m = 0; m < curr.pNode->mNumMeshes; ++m) {
-            unsigned int meshIndex = curr.pNode->mMeshes[m];
-            if (meshIndex < outMesh.submeshes.size()) {
-                outMesh.submeshes[meshIndex].nodeId = nodeId;
-            }
-        }
-        totalChildMeshes += curr.pNode->mNumMeshes;
-        // Copy Assimp's row-major matrix to GLM's column-major format
-        const aiMatrix4x4& m = curr.pNode->mTransformation;
-        glm::mat4 nodeTransform(
-            m.a1, m.b1, m.c1, m.d1,
-            m.a2, m.b2, m.c2, m.d2,
-            m.a3, m.b3, m.c3, m.d3,
-            m.a4, m.b4, m.c4, m.d4
-        );
-        scenenode.transformation = nodeTransform;
-
-        outMesh.nodeMap.emplace(nodeId, scenenode);
-        parentId = nodeId;
-        ++nodeId;
-
-        // Queue child nodes
-        for (size_t i = 0; i < curr.pNode->mNumChildren; ++i) {
-            NodeLoadingContext child(curr.pNode->mChildren[i]);
-            queue.push(child);
-        }
-    }
-    //SDL_assert(totalChildMeshes == outContext.scene->mNumMeshes);
-    if (totalChildMeshes == outContext.scene->mNumMeshes) {
-        UpdateCachedTransformations(outMesh);
-    }
-    else {
-        SDL_LogWarn(SDL_LOG_CATEGORY_CUSTOM, "WARNING: Model has mismatch between number of meshes and meshes in nodes [%i] != [%i]", outContext.scene->mNumMeshes, totalChildMeshes);
-        
-        for (size_t i = 0; i < outContext.scene->mNumMeshes; ++i) {
-            outMesh.submeshes[i].transformation = glm::mat4(1.0f);
-        }
-    }
-}
-
-void Renderer::ParseVertices(const aiScene* scene, const bool flipX, const bool flipY, const bool flipZ, MeshData& outMesh, MeshLoadingContext& outContext) {
-    const float xMod = flipX ? -1.0f : 1.0f;
-    const float yMod = flipY ? -1.0f : 1.0f;
-    const float zMod = flipZ ? -1.0f : 1.0f;
-
-    uint32_t totalVertices = 0;
-    uint32_t totalIndices = 0;
-
-    outMesh.submeshes.resize(scene->mNumMeshes);
-
-    for (size_t i = 0; i < outMesh.submeshes.size(); ++i) {
-        auto mesh = scene->mMeshes[i];
-        outMesh.submeshes[i].materialIndex = mesh->mMaterialIndex;
-        outMesh.submeshes[i].numVertices = mesh->mNumVertices;
-        outMesh.submeshes[i].numIndices = mesh->mNumFaces * 3;
-        outMesh.submeshes[i].baseVertex = totalVertices;
-        outMesh.submeshes[i].baseIndex = totalIndices;
-
-        totalVertices += outMesh.submeshes[i].numVertices;
-        totalIndices  += outMesh.submeshes[i].numIndices;
-
-        if (mesh->HasPositions()) {
-            const aiVector3D zero3D(0.0f, 0.0f, 0.0f);
-            outMesh.vertices.reserve(mesh->mNumVertices);
-            for (size_t j = 0; j < mesh->mNumVertices; ++j) {
-                aiVector3D position = mesh->mVertices[j];
-                aiVector3D normal = (mesh->HasNormals()) ? mesh->mNormals[j] : aiVector3D(0.0f, 1.0f, 0.0f);
-                aiVector3D tangent = (mesh->HasTangentsAndBitangents()) ? mesh->mTangents[j] : aiVector3D(0.0f);
-                aiVector3D bitangent = (mesh->HasTangentsAndBitangents()) ? mesh->mBitangents[j] : aiVector3D(0.0f);
-                aiVector3D uv = (mesh->HasTextureCoords(0)) ? mesh->mTextureCoords[0][j] : zero3D;
-                outMesh.vertices.push_back({ 
-                    .position = {
-                        position.x * xMod,
-                        position.y * yMod,
-                        position.z * zMod
-                    },
-                    .normal = {
-                        normal.x * xMod,
-                        normal.y * yMod,
-                        normal.z * zMod
-                    },
-                    .tangent = {
-                        tangent.x * xMod,
-                        tangent.y * yMod,
-                        tangent.z * zMod
-                    },
-                    .bitangent = {
-                        bitangent.x * xMod,
-                        bitangent.y * yMod,
-                        bitangent.z * zMod
-                    },
-                    .uv = {
-                        uv.x, 
-                        uv.y
-                    }
-                });
-                // TODO: Convert from Array-Of-Vertices to Mesh-of-Arrays
-                // v_positions.pushback(info);
-                // v_normals.pushback(info);
-                // v_uv.pushback(info);
-            }
-            for (size_t j = 0; j < mesh->mNumFaces; ++j) {
-                auto face = mesh->mFaces[j];
-                SDL_assert(face.mNumIndices == 3);
-                outMesh.indices.reserve(face.mNumIndices);
-                outMesh.indices.push_back(face.mIndices[0]);
-                outMesh.indices.push_back(face.mIndices[1]);
-                outMesh.indices.push_back(face.mIndices[2]);
-            }
-        }
-    }
-}
-
-// TODO: Is this necessary? How do I detect information rather than hardcode?
-void Renderer::ParseMaterials(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext) {
-    // const bool bIsBinary = (scene->mNumTextures > 0);
-    // for (size_t i = 0; i < scene->mNumMaterials; ++i) {
-    //     auto material = scene->mMaterials[i];
-    //     if (material) {
-    //         aiColor4D baseColor;
-    //         material->Get(AI_MATKEY_BASE_COLOR, baseColor);
-    //         bool bUseMetallic;
-    //         if (material->Get(AI_MATKEY_USE_METALLIC_MAP, bUseMetallic) == aiReturn_SUCCESS) {
-    //             material->Get(AI_MATKEY_METALLIC_TEXTURE, bUseMetallic);
-    //         }
-    //         bool bUseRoughness;
-    //         material->Get(AI_MATKEY_USE_ROUGHNESS_MAP, bUseRoughness);
-    //         if (bUseRoughness) {
-    //             material->Get(AI_MATKEY_ROUGHNESS_FACTOR, )
-    //         }
-    //     }
-    // }
-}
-
-void Renderer::ParseTextures(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext) {
-    outMesh.materials.resize(scene->mNumMaterials);
-    for (size_t i = 0; i < outMesh.materials.size(); ++i) {
-        auto material = scene->mMaterials[i];
-        if (material) {
-            MaterialLoadingContext materialContext{};
-            aiString texturePath;
-            for (aiTextureType type : s_TextureTypes) {
-                TextureLoadingContext textureContext{};
-                textureContext.type = type;
-                if (material->GetTexture(type, 0, &texturePath) == AI_SUCCESS) {
-                    textureContext.filename = texturePath.data;
-                    SDL_Log("  [%s] Texture found: %s (type %d)", material->GetName().C_Str(), texturePath.C_Str(), type);
-                }
-                else {
-                    textureContext.bUseFallback = true;
-                    textureContext.filename = aiTextureTypeToString(type);
-                    SDL_Log("  [%s] FALLBACK for type %d (%s)", material->GetName().C_Str(), type, aiTextureTypeToString(type));
-                }
-                materialContext.textureContextMap.emplace(type, textureContext);
-            }
-            SDL_assert(materialContext.textureContextMap.size() == s_TextureTypes.size());
-
-            outContext.materialInfos.push_back(materialContext);
-        }
-    }
-    SDL_assert(outMesh.materials.size() == outContext.materialInfos.size());
-}
-
 void Renderer::Clear() {
 }
 
 // This is ugly. I'm passing the UIManager in because 
 // I haven't figured out how to do multiple render passes.
 void Renderer::Render(UIManager* uiManager) {
+    UnloadMeshes(mAssetMemoryBudget);
+    // Every command buffer writing to the arrays was submitted last frame, they can be recreated
+    mMaterialTable.Trim();
+    UpdateStreaming();
+    UpdateTextureStreaming();
+
     RenderPassContext context{};
     if (!BeginRenderPass(context)) {
         EndRenderPass(context);
@@ -1112,14 +1331,70 @@ void Renderer::Render(UIManager* uiManager) {
     CameraData cameraData{};
     InitCameraData(mCameraNodes[0], context.cameraData);
 
-    RecordModelCommands(context);
-    RecordGridCommands(context);
-    RecordDebugLightCommands(context);
-    RecordUICommands(context);
+    const std::vector<std::string> reloadedShaders = mShaderLibrary.Poll();
+    if (!reloadedShaders.empty()) {
+        mPipelineCache.Rebuild(reloadedShaders);
+    }
+
+    BuildFrameGraph(context);
+    mFrameGraph.Compile();
+    mFrameGraph.Execute(mSDLDevice, context.commandBuffer, mPassStats);
 
     EndRenderPass(context);
 }
 
+void Renderer::BuildFrameGraph(RenderPassContext& context) {
+    mFrameGraph.Reset();
+
+    FrameGraph::TextureDesc backbufferDesc{};
+    backbufferDesc.width = context.swapchainWidth;
+    backbufferDesc.height = context.swapchainHeight;
+    backbufferDesc.format = SDL_GetGPUSwapchainTextureFormat(mSDLDevice, mWindow);
+    backbufferDesc.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+    const FrameGraph::ResourceHandle backbuffer = mFrameGraph.ImportTexture("Backbuffer", context.swapchainTexture, backbufferDesc);
+
+    FrameGraph::TextureDesc depthDesc = backbufferDesc;
+    depthDesc.format = mDepthStencilFormat;
+    depthDesc.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+    const FrameGraph::ResourceHandle sceneDepth = mFrameGraph.CreateTexture("Scene Depth", depthDesc);
+
+    const SDL_FColor clearColor{0.3f,0.2f,0.2f,1.0f};
+    // Passes hand their SDL render pass to the Record functions through the context
+    auto record = [this, &context](void (Renderer::*recordFn)(RenderPassContext&)) {
+        return [this, &context, recordFn](const FrameGraph::PassContext& pass) {
+            context.renderPass = pass.renderPass;
+            (this->*recordFn)(context);
+            context.renderPass = nullptr;
+        };
+    };
+
+    // Copy passes can't be nested in a render pass, so all uploads are recorded up front
+    mFrameGraph.AddPass("Uploads", record(&Renderer::RecordUploadCommands))
+        .SetSideEffect();
+
+    // Scene: these all share the backbuffer + depth attachments and end up in one render pass
+    if (IsDepthPrepassActive()) {
+        mFrameGraph.AddPass("Depth Prepass", record(&Renderer::RecordDepthPrepassCommands))
+            .WriteColor(backbuffer, clearColor)
+            .WriteDepth(sceneDepth, 1.0f);
+    }
+    mFrameGraph.AddPass("Meshes", record(&Renderer::RecordModelCommands))
+        .WriteColor(backbuffer, clearColor)
+        .WriteDepth(sceneDepth, 1.0f);
+    mFrameGraph.AddPass("Grid", record(&Renderer::RecordGridCommands))
+        .WriteColor(backbuffer)
+        .WriteDepth(sceneDepth);
+    if (mShowDebugLights) {
+        mFrameGraph.AddPass("Debug Lights", record(&Renderer::RecordDebugLightCommands))
+            .WriteColor(backbuffer)
+            .WriteDepth(sceneDepth);
+    }
+
+    // UI: the ImGui pipeline has no depth attachment, so it gets its own pass
+    mFrameGraph.AddPass("UI", record(&Renderer::RecordUICommands))
+        .WriteColor(backbuffer);
+}
+
 bool Renderer::BeginRenderPass(RenderPassContext& context) {
     context.commandBuffer = SDL_AcquireGPUCommandBuffer(mSDLDevice);
     if (!context.commandBuffer) {
@@ -1128,7 +1403,7 @@ bool Renderer::BeginRenderPass(RenderPassContext& context) {
         return false;
     }
 
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(context.commandBuffer, mWindow, &context.swapchainTexture, nullptr, nullptr)) {
+    if (!SDL_WaitAndAcquireGPUSwapchainTexture(context.commandBuffer, mWindow, &context.swapchainTexture, &context.swapchainWidth, &context.swapchainHeight)) {
         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_WaitAndAcquireGPUSwapchainTexture failed: %s", SDL_GetError());
         mNodesThisFrame.clear();
         return false;
@@ -1144,31 +1419,28 @@ void Renderer::InitCameraData(const CameraNode* cameraNode, CameraData& outCamer
     outCameraData.viewPosition = cameraNode->mTransform->mPosition;
 }
 
+void Renderer::UpdateLightClusters(RenderPassContext& context) {
+    const CameraComponent* camera = mCameraNodes[0]->mCamera;
+    mLightClusters.Build(
+        mSceneLighting.pointLights,
+        context.cameraData.view,
+        context.cameraData.projection,
+        camera->mNearPlane,
+        camera->mFarPlane,
+        glm::vec2(context.swapchainWidth, context.swapchainHeight));
+    mLightClusters.Upload(mSDLDevice, context.commandBuffer);
+}
+
 void Renderer::RecordGridCommands(RenderPassContext& context) {
-    SDL_GPUColorTargetInfo colorTarget{};
-    colorTarget.texture = context.swapchainTexture;
-    colorTarget.load_op = SDL_GPU_LOADOP_LOAD;
-    colorTarget.store_op = SDL_GPU_STOREOP_STORE;
-    colorTarget.layer_or_depth_plane = 0;
-    colorTarget.clear_color = SDL_FColor{0.3f,0.2f,0.2f,1.0f};
-    std::vector<SDL_GPUColorTargetInfo> colorTargets {colorTarget};
-
-    SDL_GPUDepthStencilTargetInfo depthStencilTarget{};
-    depthStencilTarget.texture = mDepthTexture;
-    depthStencilTarget.clear_depth = 1.0f;
-    depthStencilTarget.load_op = SDL_GPU_LOADOP_LOAD;
-    depthStencilTarget.store_op = SDL_GPU_STOREOP_STORE;
-    depthStencilTarget.clear_stencil = 0;
-    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(context.commandBuffer, colorTargets.data(), static_cast<Uint32>(colorTargets.size()), &depthStencilTarget);
-    if (!renderPass) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_BeginGPURenderPass failed: %s", SDL_GetError());
-        return;
-    }
+    SDL_GPURenderPass* renderPass = context.renderPass;
+    SDL_GPUGraphicsPipeline* pipeline = mPipelineCache.Get(mGridPipelineDesc);
+    if (!pipeline) return;
     // Draw Grid
-    SDL_BindGPUGraphicsPipeline(renderPass, mGridPipeline);
-    std::vector<SDL_GPUBufferBinding> gridBindings{{mGridMesh.vertexBuffer, 0}};
+    SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+    // Full Vertex layout, so the grid's range is bound at its offset rather than drawn with a base vertex
+    std::vector<SDL_GPUBufferBinding> gridBindings{{mVertexArena.GetBuffer(), mGridMesh.vertexRange.offset}};
     SDL_BindGPUVertexBuffers(renderPass, 0, gridBindings.data(), static_cast<Uint32>(gridBindings.size()));
-    SDL_GPUBufferBinding gridIndexBufferBinding{mGridMesh.indexBuffer, 0};
+    SDL_GPUBufferBinding gridIndexBufferBinding{mIndexArena.GetBuffer(), 0};
     SDL_BindGPUIndexBuffer(renderPass, &gridIndexBufferBinding, SDL_GPU_INDEXELEMENTSIZE_32BIT);
     
     glm::mat4 gridModelMatrix = glm::mat4(1.0f);
@@ -1181,139 +1453,253 @@ void Renderer::RecordGridCommands(RenderPassContext& context) {
     gridParamsFragGPU.thickness = 0.05f;
     gridParamsFragGPU.scroll = 5.0f;
     SDL_PushGPUFragmentUniformData(context.commandBuffer, 0, &gridParamsFragGPU, sizeof(GridParamsFragGPU));
-    SDL_DrawGPUIndexedPrimitives(renderPass, static_cast<Uint32>(mGridMesh.indices.size()), 1, 0, 0, 0);
+    SDL_DrawGPUIndexedPrimitives(renderPass, static_cast<Uint32>(mGridMesh.indices.size()), 1, mGridMesh.indexRange.offset / static_cast<Uint32>(sizeof(Uint32)), 0, 0);
+}
 
-    SDL_EndGPURenderPass(renderPass);
+glm::mat4 Renderer::GetModelMatrix(const TransformComponent& transform, const SubMeshData& submesh) const {
+    // model matrix: component world transform * mesh node transform
+    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    modelMatrix = glm::translate(modelMatrix, transform.mPosition);
+    modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.mRotation.z), glm::vec3(0, 0, 1));
+    modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.mRotation.y), glm::vec3(0, 1, 0));
+    modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.mRotation.x), glm::vec3(1, 0, 0));
+    modelMatrix = glm::scale(modelMatrix, transform.mScale * glm::vec3(mScale));
+    return modelMatrix * submesh.transformation;
 }
 
-void Renderer::RecordModelCommands(RenderPassContext& context) {
-    SDL_GPUColorTargetInfo colorTarget{};
-    colorTarget.texture = context.swapchainTexture;
-    colorTarget.load_op = SDL_GPU_LOADOP_CLEAR;
-    colorTarget.store_op = SDL_GPU_STOREOP_STORE;
-    colorTarget.layer_or_depth_plane = 0;
-    colorTarget.clear_color = SDL_FColor{0.3f,0.2f,0.2f,1.0f};
-    std::vector<SDL_GPUColorTargetInfo> colorTargets {colorTarget};
-    SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
-
-    SDL_GPUDepthStencilTargetInfo depthStencilTarget{};
-    depthStencilTarget.texture = mDepthTexture;
-    depthStencilTarget.clear_depth = 1.0f;
-    depthStencilTarget.load_op = SDL_GPU_LOADOP_CLEAR;
-    depthStencilTarget.store_op = SDL_GPU_STOREOP_STORE;
-    depthStencilTarget.clear_stencil = 0;
-    
-    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(context.commandBuffer, colorTargets.data(), static_cast<Uint32>(colorTargets.size()), &depthStencilTarget);
-    if (!renderPass) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_BeginGPURenderPass failed: %s", SDL_GetError());
-        mNodesThisFrame.clear();
-        return;
+ModelUniformGPU Renderer::GetModelUniform(const TransformComponent& transform, const SubMeshData& submesh) const {
+    ModelUniformGPU modelUniform{};
+    modelUniform.model = GetModelMatrix(transform, submesh);
+    VertexPacking::GetDequantization(submesh, modelUniform.positionOffset, modelUniform.positionScale);
+    return modelUniform;
+}
+
+// Pixels one object space unit of the submesh covers on screen, at the nearest point of its
+// bounding sphere. 0 when a perspective camera is inside the sphere, where everything is at full
+// detail. Orthographic projections cover the same number of pixels per unit at any distance.
+static float GetPixelsPerObjectUnit(const SubMeshData& submesh, const glm::mat4& modelMatrix, const Renderer::RenderPassContext& context) {
+    // Bounding sphere in world space, scaled by the largest axis scale of the model matrix
+    const glm::vec3 localCenter = (submesh.boundsMin + submesh.boundsMax) * 0.5f;
+    const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(localCenter, 1.0f));
+    const float scale = glm::max(glm::length(glm::vec3(modelMatrix[0])),
+        glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    const glm::mat4& projection = context.cameraData.projection;
+    const float halfHeight = static_cast<float>(context.swapchainHeight) * 0.5f;
+    // w doesn't depend on depth: projection[1][1] = 2 / (top - bottom)
+    if (projection[3][3] == 1.0f) {
+        return projection[1][1] * halfHeight * scale;
+    }
+    const float radius = glm::length(submesh.boundsMax - localCenter) * scale;
+    const float distance = glm::length(center - context.cameraData.viewPosition) - radius;
+    if (distance <= 0.0f) return 0.0f;
+
+    // projection[1][1] = 1 / tan(fovY / 2), so this is the number of pixels one world unit covers at that distance
+    const float pixelsPerUnit = projection[1][1] * halfHeight / distance;
+    return pixelsPerUnit * scale;
+}
+
+uint32_t Renderer::SelectLod(const SubMeshData& submesh, const glm::mat4& modelMatrix, const RenderPassContext& context) const {
+    if (!mMeshLods || submesh.numLods <= 1) return 0;
+
+    const float pixelsPerUnit = GetPixelsPerObjectUnit(submesh, modelMatrix, context);
+    if (pixelsPerUnit <= 0.0f) return 0;
+    uint32_t lodIndex = 0;
+    for (uint32_t i = 1; i < submesh.numLods; ++i) {
+        if (submesh.lods[i].error * pixelsPerUnit > mLodPixelError) break;
+        lodIndex = i;
     }
+    return lodIndex;
+}
 
-    // TEMP
-    if (!mSceneLighting.inited) {
-        mSceneLighting.inited = true;
-        auto& lu = mSceneLighting.lightsUniform;
-        lu.lights[0].position = {  0.0f, 5.0f,  0.0f};
-        lu.lights[1].position = { 17.0f, 5.0f,  0.0f};
-        lu.lights[2].position = {-17.0f, 5.0f,  0.0f};
+// The texels across its textures a submesh needs to map about one texel to a pixel: its projected
+// size in texture coordinate units
+void Renderer::RequestTextureResolutions(const MeshData& mesh, const SubMeshData& submesh, const glm::mat4& modelMatrix, const RenderPassContext& context) {
+    const float pixelsPerUnit = GetPixelsPerObjectUnit(submesh, modelMatrix, context);
+    float resolution = std::numeric_limits<float>::max();
+    if (submesh.uvDensity <= 0.0f) {
+        // Every texel lookup lands on the same spot, the coarsest levels will do
+        resolution = 0.0f;
+    }
+    else if (pixelsPerUnit > 0.0f) {
+        resolution = pixelsPerUnit / submesh.uvDensity;
+    }
+    for (const auto& [type, texture] : mesh.materials[submesh.materialIndex].textureMap) {
+        mTextureStreamer.Request(texture.slot, resolution);
+    }
+}
 
-        lu.lights[3].position = {  0.0f, 5.0f,  7.0f};
-        lu.lights[4].position = { 17.0f, 5.0f,  7.0f};
-        lu.lights[5].position = {-17.0f, 5.0f,  7.0f};
+bool Renderer::IsDepthPrepassActive() const {
+    // The EQUAL test only makes sense for filled triangles
+    return mDepthPrepass && mRenderMode == RenderMode::Fill;
+}
 
-        lu.lights[6].position = {  0.0f, 5.0f, -7.0f};
-        lu.lights[7].position = { 17.0f, 5.0f, -7.0f};
-        lu.lights[8].position = {-17.0f, 5.0f, -7.0f};
-        lu.numLights = 9;
+void Renderer::CullMeshes(RenderPassContext& context) {
+    // Decides LOD and visible meshlets once per frame, so the depth pre-pass and the mesh pass
+    // draw exactly the same triangles. The passes walk mSubmeshDraws in the same order.
+    mSubmeshDraws.clear();
+    mMeshletCuller.Begin(context.cameraData.viewProjection, context.cameraData.viewPosition);
+    for (auto& node : mNodesThisFrame) {
+        const MeshData* meshData = mMeshRegistry.Get(node->mDisplay->mMesh);
+        if (!node->mDisplay->mShow || !meshData || !meshData->bLoaded) continue;
+
+        const MeshData& mesh = *meshData;
+        const TransformComponent& transform = *(node->mTransform);
+        for (const SubMeshData& submesh : mesh.submeshes) {
+            const glm::mat4 modelMatrix = GetModelMatrix(transform, submesh);
+            SubmeshDraw& draw = mSubmeshDraws.emplace_back();
+
+            const glm::vec3 localCenter = (submesh.boundsMin + submesh.boundsMax) * 0.5f;
+            const float scale = glm::max(glm::length(glm::vec3(modelMatrix[0])),
+                glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+            draw.bVisible = mMeshletCuller.IsSphereVisible(
+                glm::vec3(modelMatrix * glm::vec4(localCenter, 1.0f)),
+                glm::length(submesh.boundsMax - localCenter) * scale);
+            if (!draw.bVisible) continue;
+
+            RequestTextureResolutions(mesh, submesh, modelMatrix, context);
+            draw.lodIndex = SelectLod(submesh, modelMatrix, context);
+            draw.numIndices = submesh.lods[draw.lodIndex].numIndices;
+            // Coarser LODs are cheap enough to draw whole
+            if (mMeshletCulling && draw.lodIndex == 0 && submesh.numMeshlets > 0) {
+                const bool bBackfaceCulling = !mesh.materials[submesh.materialIndex].isDoubleSided;
+                draw.meshlets = mMeshletCuller.CullSubmesh(mesh, submesh, modelMatrix, bBackfaceCulling, mPassStats);
+                draw.bUseMeshlets = true;
+                draw.numIndices = draw.meshlets.numIndices;
+                draw.bVisible = draw.meshlets.numCommands > 0;
+            }
+        }
     }
-    
-    SDL_BindGPUGraphicsPipeline(renderPass, mPipelines[mRenderMode]);
+    if (!mMeshletCuller.Upload(mSDLDevice, context.commandBuffer)) {
+        // Fall back to whole LOD0 draws this frame
+        for (SubmeshDraw& draw : mSubmeshDraws) {
+            draw.bUseMeshlets = false;
+        }
+    }
+}
+
+// Every mesh shares the arenas' bindings. The vertex arena is bound once per pass, the index arena
+// again only when the element size changes, submeshes draw at absolute indices.
+void Renderer::BindGeometry(SDL_GPURenderPass* renderPass) const {
+    std::vector<SDL_GPUBufferBinding> vertexBufferBindings{{mVertexArena.GetBuffer(), 0}};
+    SDL_BindGPUVertexBuffers(renderPass, 0, vertexBufferBindings.data(), static_cast<Uint32>(vertexBufferBindings.size()));
+}
+
+void Renderer::DrawSubmesh(SDL_GPURenderPass* renderPass, const SubMeshData& submesh, const SubmeshDraw& draw, std::optional<SDL_GPUIndexElementSize>& boundIndexSize) const {
+    if (boundIndexSize != submesh.indexElementSize) {
+        SDL_GPUBufferBinding indexBufferBinding{mIndexArena.GetBuffer(), 0};
+        SDL_BindGPUIndexBuffer(renderPass, &indexBufferBinding, submesh.indexElementSize);
+        boundIndexSize = submesh.indexElementSize;
+    }
+    if (draw.bUseMeshlets) {
+        SDL_DrawGPUIndexedPrimitivesIndirect(
+            renderPass,
+            mMeshletCuller.GetDrawBuffer(),
+            draw.meshlets.firstCommand * sizeof(SDL_GPUIndexedIndirectDrawCommand),
+            draw.meshlets.numCommands);
+    }
+    else {
+        const SubMeshLod& lod = submesh.lods[draw.lodIndex];
+        SDL_DrawGPUIndexedPrimitives(renderPass, lod.numIndices, 1, submesh.baseIndex + lod.firstIndex, submesh.baseVertex, 0);
+    }
+}
+
+void Renderer::RecordDepthPrepassCommands(RenderPassContext& context) {
+    SDL_GPURenderPass* renderPass = context.renderPass;
+    SDL_GPUGraphicsPipeline* pipeline = mPipelineCache.Get(mDepthPrepassPipelineDesc);
+    if (!pipeline) return;
+    SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+    BindGeometry(renderPass);
+    std::optional<SDL_GPUIndexElementSize> boundIndexSize;
+    size_t drawIndex = 0;
+    for (auto& node : mNodesThisFrame) {
+        const MeshData* meshData = mMeshRegistry.Get(node->mDisplay->mMesh);
+        if (!node->mDisplay->mShow || !meshData || !meshData->bLoaded) continue;
+
+        const MeshData& mesh = *meshData;
+        const TransformComponent& transform = *(node->mTransform);
+        for (const SubMeshData& submesh : mesh.submeshes) {
+            const SubmeshDraw& draw = mSubmeshDraws[drawIndex++];
+            if (!draw.bVisible) continue;
+
+            const ModelUniformGPU modelUniform = GetModelUniform(transform, submesh);
+            SDL_PushGPUVertexUniformData(context.commandBuffer, 0, &context.cameraData, sizeof(CameraData));
+            SDL_PushGPUVertexUniformData(context.commandBuffer, 1, &modelUniform, sizeof(ModelUniformGPU));
+            DrawSubmesh(renderPass, submesh, draw, boundIndexSize);
+        }
+    }
+}
+
+void Renderer::RecordModelCommands(RenderPassContext& context) {
+    SDL_GPURenderPass* renderPass = context.renderPass;
+    const bool bDepthPrepassed = IsDepthPrepassActive();
+
+    SDL_GPUGraphicsPipeline* pipeline = mPipelineCache.Get(GetMeshPipelineDesc(mRenderMode, bDepthPrepassed));
+    if (!pipeline) return;
+    SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+    mLightClusters.Bind(context.commandBuffer, renderPass);
+    // Every material is reachable from here on, draws only pass their material index.
+    // Storage buffer slot 3 follows the light cluster buffers.
+    if (!mMaterialTable.Bind(renderPass, mSamplers[1], 3)) return;
+    BindGeometry(renderPass);
+    std::optional<SDL_GPUIndexElementSize> boundIndexSize;
     // Draw Meshes
+    size_t drawIndex = 0;
     for (auto& node : mNodesThisFrame) {
-        if (!node->mDisplay->mShow) continue;
+        const MeshData* meshData = mMeshRegistry.Get(node->mDisplay->mMesh);
+        if (!node->mDisplay->mShow || !meshData || !meshData->bLoaded) continue;
         
-        const MeshData& mesh = *(node->mDisplay->mMesh);
+        const MeshData& mesh = *meshData;
         const TransformComponent& transform = *(node->mTransform);
-        SDL_GPUTexture* diffuseTexture = GetTexture(mesh, aiTextureType_BASE_COLOR);
-        std::vector<SDL_GPUBufferBinding> vertexBufferBindings{{mesh.vertexBuffer, 0}};
-        SDL_BindGPUVertexBuffers(renderPass, 0, vertexBufferBindings.data(), static_cast<Uint32>(vertexBufferBindings.size()));
-        SDL_GPUBufferBinding indexBufferBinding{mesh.indexBuffer, 0};
-        SDL_BindGPUIndexBuffer(renderPass, &indexBufferBinding, SDL_GPU_INDEXELEMENTSIZE_32BIT);
 
         for (const SubMeshData& submesh : mesh.submeshes) {
-            const PBRMaterial& material = mesh.materials[submesh.materialIndex];
-            std::vector<SDL_GPUTextureSamplerBinding> samplerBindings;
-            GetValidTextureBindings(material, samplerBindings);
-            SDL_BindGPUFragmentSamplers(renderPass, 0, samplerBindings.data(), static_cast<Uint32>(samplerBindings.size()));
-    
-            // model matrix: component world transform * mesh node transform
-            glm::mat4 modelMatrix = glm::mat4(1.0f);
-            modelMatrix = glm::translate(modelMatrix, transform.mPosition);
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.mRotation.z), glm::vec3(0, 0, 1));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.mRotation.y), glm::vec3(0, 1, 0));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.mRotation.x), glm::vec3(1, 0, 0));
-            modelMatrix = glm::scale(modelMatrix, transform.mScale * glm::vec3(mScale));
-            modelMatrix = modelMatrix * submesh.transformation;
+            const SubmeshDraw& draw = mSubmeshDraws[drawIndex++];
+            mPassStats.numTrianglesLod0 += submesh.numIndices / 3;
+            if (!draw.bVisible) continue;
+
+            ModelUniformGPU modelUniform = GetModelUniform(transform, submesh);
+            modelUniform.material.x = mesh.materials[submesh.materialIndex].tableIndex;
             
             SDL_PushGPUVertexUniformData(context.commandBuffer, 0, &context.cameraData, sizeof(CameraData));
-            SDL_PushGPUVertexUniformData(context.commandBuffer, 1, &modelMatrix, sizeof(glm::mat4));
-            SDL_PushGPUVertexUniformData(context.commandBuffer, 2, &mSceneLighting.lightsUniform, sizeof(LightsUniform));
+            SDL_PushGPUVertexUniformData(context.commandBuffer, 1, &modelUniform, sizeof(ModelUniformGPU));
     
-            SDL_DrawGPUIndexedPrimitives(renderPass, static_cast<Uint32>(submesh.numIndices), 1, submesh.baseIndex, submesh.baseVertex, 0);
+            DrawSubmesh(renderPass, submesh, draw, boundIndexSize);
+            mPassStats.numDrawCalls += draw.bUseMeshlets ? draw.meshlets.numCommands : 1;
+            mPassStats.numTriangles += draw.numIndices / 3;
         }
     }
-
-    SDL_EndGPURenderPass(renderPass);
 }
 
 void Renderer::RecordDebugLightCommands(RenderPassContext& context) {
-    if (!mShowDebugLights) return;
-
-    SDL_GPUColorTargetInfo colorTarget{};
-    colorTarget.texture = context.swapchainTexture;
-    colorTarget.load_op = SDL_GPU_LOADOP_LOAD;
-    colorTarget.store_op = SDL_GPU_STOREOP_STORE;
-    colorTarget.layer_or_depth_plane = 0;
-    std::vector<SDL_GPUColorTargetInfo> colorTargets{colorTarget};
-
-    SDL_GPUDepthStencilTargetInfo depthStencilTarget{};
-    depthStencilTarget.texture = mDepthTexture;
-    depthStencilTarget.load_op = SDL_GPU_LOADOP_LOAD;
-    depthStencilTarget.store_op = SDL_GPU_STOREOP_STORE;
-
-    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(
-        context.commandBuffer, colorTargets.data(),
-        static_cast<Uint32>(colorTargets.size()), &depthStencilTarget);
-    if (!renderPass) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_BeginGPURenderPass (debug lights) failed: %s", SDL_GetError());
-        return;
-    }
-
+    SDL_GPURenderPass* renderPass = context.renderPass;
     struct BillboardUniform {
         glm::vec3 position;
         float size;
         glm::vec4 color;
     };
 
-    SDL_BindGPUGraphicsPipeline(renderPass, mBillboardPipeline);
+    SDL_GPUGraphicsPipeline* pipeline = mPipelineCache.Get(mBillboardPipelineDesc);
+    if (!pipeline) return;
+    SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
 
-    const auto& lu = mSceneLighting.lightsUniform;
-    for (uint32_t i = 0; i < lu.numLights; ++i) {
+    for (const PointLight& light : mSceneLighting.pointLights) {
         BillboardUniform billboard{};
-        billboard.position = lu.lights[i].position;
+        billboard.position = light.position;
         billboard.size = 0.3f;
-        billboard.color = glm::vec4(lu.lights[i].color, 1.0f);
+        billboard.color = glm::vec4(light.color, 1.0f);
 
         SDL_PushGPUVertexUniformData(context.commandBuffer, 0, &context.cameraData, sizeof(CameraData));
         SDL_PushGPUVertexUniformData(context.commandBuffer, 1, &billboard, sizeof(BillboardUniform));
         SDL_DrawGPUPrimitives(renderPass, 6, 1, 0, 0);
     }
+}
 
-    SDL_EndGPURenderPass(renderPass);
+void Renderer::RecordUploadCommands(RenderPassContext& context) {
+    UpdateLightClusters(context);
+    CullMeshes(context);
+    PrepareUIDrawData(context);
 }
 
-void Renderer::RecordUICommands(RenderPassContext& context) {
+void Renderer::PrepareUIDrawData(RenderPassContext& context) {
     ImGui::Render();
     ImDrawData* drawData = ImGui::GetDrawData();
     const bool bUIMinimized = (drawData->DisplaySize.x <= 0.0f || drawData->DisplaySize.y <= 0.0f);
@@ -1322,24 +1708,15 @@ void Renderer::RecordUICommands(RenderPassContext& context) {
         // This is mandatory: call ImGui_ImplSDLGPU3_PrepareDrawData() to upload the vertex/index buffer!
         ImGui_ImplSDLGPU3_PrepareDrawData(drawData, context.commandBuffer);
     }
+}
 
-    SDL_GPUColorTargetInfo colorTarget{};
-    colorTarget.texture = context.swapchainTexture;
-    colorTarget.load_op = SDL_GPU_LOADOP_LOAD;
-    colorTarget.store_op = SDL_GPU_STOREOP_STORE;
-    colorTarget.layer_or_depth_plane = 0;
-    colorTarget.clear_color = SDL_FColor{0.3f,0.2f,0.2f,1.0f};
-    std::vector<SDL_GPUColorTargetInfo> colorTargets {colorTarget};
-    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(context.commandBuffer, colorTargets.data(), static_cast<Uint32>(colorTargets.size()), nullptr);
-    if (!renderPass) {
-        SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_BeginGPURenderPass failed: %s", SDL_GetError());
-        return;
-    }
+void Renderer::RecordUICommands(RenderPassContext& context) {
+    ImDrawData* drawData = ImGui::GetDrawData();
+    const bool bUIMinimized = (drawData->DisplaySize.x <= 0.0f || drawData->DisplaySize.y <= 0.0f);
     // Draw UI
     if (!bUIMinimized) {
-        ImGui_ImplSDLGPU3_RenderDrawData(drawData, context.commandBuffer, renderPass);
+        ImGui_ImplSDLGPU3_RenderDrawData(drawData, context.commandBuffer, context.renderPass);
     }
-    SDL_EndGPURenderPass(renderPass);
 }
 
 void Renderer::EndRenderPass(RenderPassContext& context) {
@@ -1349,63 +1726,54 @@ void Renderer::EndRenderPass(RenderPassContext& context) {
     context.commandBuffer = nullptr;
     context.swapchainTexture = nullptr;
 
+    mLastPassStats = mPassStats;
+    mPassStats = {};
+
     mNodesThisFrame.clear();
 }
 
 void Renderer::Shutdown() {
-    mPipelines[RenderMode::count] = mGridPipeline;
-    mMeshes["Grid"] = mGridMesh;
-
-    for (auto modePipeline : mPipelines) {
-        SDL_ReleaseGPUGraphicsPipeline(mSDLDevice, modePipeline.second);
+    // Loads still queued are skipped, the one in flight is waited for
+    mCancelModelLoads = true;
+    mLoaderThread.Shutdown();
+    mModelLoads.clear();
+    if (mStreamingModel) {
+        ReleaseStreamedModel(*mStreamingModel);
+        mStreamingModel.reset();
     }
+
+    mPipelineCache.Release();
+    mShaderLibrary.Release();
     for (auto sampler : mSamplers) {
         SDL_ReleaseGPUSampler(mSDLDevice, sampler);
     }
     
-    for (auto& namedMesh : mMeshes) {
-        MeshData& mesh = namedMesh.second;
-        if (mesh.vertexBuffer) SDL_ReleaseGPUBuffer(mSDLDevice, mesh.vertexBuffer);
-        if (mesh.indexBuffer) SDL_ReleaseGPUBuffer(mSDLDevice, mesh.indexBuffer);
+    mMeshRegistry.ForEach([&](MeshHandle, MeshData& mesh) {
         for (auto [type, meshTexture] : mesh.textureIdMap) {
-            if (meshTexture.texture) SDL_ReleaseGPUTexture(mSDLDevice, meshTexture.texture);
+            if (meshTexture.slot.IsValid()) ReleaseTexture(meshTexture.slot);
         }
-    }
-    if (mDepthTexture) SDL_ReleaseGPUTexture(mSDLDevice, mDepthTexture);
+    });
+    mVertexArena.Release();
+    mIndexArena.Release();
+    mStagingRing.Release();
+    mTextureStreamer.Release();
+    mTextureCache.Release();
+    mMaterialTable.Release();
+    mLightClusters.Release(mSDLDevice);
+    mMeshletCuller.Release(mSDLDevice);
+    mFrameGraph.Release(mSDLDevice);
+    mThreadPool.Shutdown();
     if (mWindow) SDL_DestroyWindow(mWindow);
 }
 
 void Renderer::ResizeWindow() {
-    if (mDepthTexture) SDL_ReleaseGPUTexture(mSDLDevice, mDepthTexture);
+    // Size dependent render targets are transient frame graph textures, sized from the swapchain each frame
     int windowWidth, windowHeight;
     if (!SDL_GetWindowSize(mWindow, &windowWidth, &windowHeight)) {
         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "SDL_GetWindowSize failed: %s", SDL_GetError());
         return;
     }
     mCachedWindowCenter = {windowWidth/2, windowHeight/2};
-    SDL_GPUTextureCreateInfo colorTextureCreateInfo{
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GetGPUSwapchainTextureFormat(mSDLDevice, mWindow),
-        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
-        .width = static_cast<Uint32>(windowWidth),
-        .height = static_cast<Uint32>(windowHeight),
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = SDL_GPU_SAMPLECOUNT_1,
-    };
-
-    SDL_GPUTextureCreateInfo depthTextureCreateInfo{
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT,
-        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
-        .width = static_cast<Uint32>(windowWidth),
-        .height = static_cast<Uint32>(windowHeight),
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = SDL_GPU_SAMPLECOUNT_1,
-    };
-    mDepthTexture = SDL_CreateGPUTexture(mSDLDevice, &depthTextureCreateInfo);
-    SDL_SetGPUTextureName(mSDLDevice, mDepthTexture, "Depth Texture");
 
     if (mCameraNodes.size() == 0) return;
     mCameraNodes[0]->mCamera->mAspectRatio = static_cast<float>(windowWidth) / static_cast<float>(windowHeight);
@@ -1,23 +1,49 @@
 #pragma once
 
+#include <AssetRegistry.h>
 #include <assimp/Importer.hpp>
 #include <assimp/material.h>
+#include <ContentPack.h>
 #include <glm/glm.hpp>
 #include <Input.h>
+#include <Render/FrameGraph.h>
+#include <Render/GeometryArena.h>
+#include <Render/LightClusters.h>
+#include <Render/MaterialTable.h>
+#include <Render/MeshletCuller.h>
+#include <Render/ModelImporter.h>
+#include <Render/PipelineCache.h>
 #include <Render/RenderStructs.h>
+#include <Render/ShaderLibrary.h>
+#include <Render/StagingRing.h>
+#include <Render/TextureCache.h>
+#include <Render/TextureEncoder.h>
+#include <Render/TextureFile.h>
+#include <Render/TextureStreamer.h>
 #include <set>
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_gpu.h>
 #include <string>
+#include <ThreadPool.h>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 struct aiNode;
 struct aiScene;
 class CameraNode;
 class RenderNode;
+class TransformComponent;
 class UIManager;
 
+using MeshHandle = AssetHandle<MeshData>;
+
 class Renderer {
 public:
     enum RenderMode : Uint8 {
@@ -37,36 +63,6 @@ public:
         glm::vec2 size = {0, 0};
     };
 
-    struct TextureLoadingContext {
-        bool bUseFallback = false;
-        aiTextureType          type = aiTextureType_NONE;
-        std::string            filename;
-        glm::u32vec2           imageSize;
-        SDL_Surface*           imageData      = nullptr;
-        SDL_GPUTransferBuffer* transferBuffer = nullptr;
-    };
-
-    struct MaterialLoadingContext {
-        std::unordered_map<aiTextureType, TextureLoadingContext> textureContextMap;
-    };
-
-    struct NodeLoadingContext {
-        NodeLoadingContext() {}
-        NodeLoadingContext(const aiNode* n) { pNode = n;}
-        const aiNode* pNode = nullptr;
-        bool isRequired = false;
-    };
-
-    struct MeshLoadingContext {
-        // Scene info
-        std::unordered_map<std::string, NodeLoadingContext> nodeInfoMap;
-        std::unordered_map<std::string, TextureLoadingContext> textureInfoMap;
-        std::vector<MaterialLoadingContext> materialInfos; // we use indices for identifying materials
-
-        Assimp::Importer importer;
-        const aiScene* scene;
-    };
-
     struct ModelDescriptor {
         std::string foldername;
         std::string subFoldername;
@@ -78,13 +74,69 @@ public:
         bool flipZ = false;
     };
 
+    // A texture of a streamed model, decoded on the loader thread
+    struct StreamedTexture {
+        std::string filename;
+        aiTextureType type = aiTextureType_NONE; // first material slot it's bound to
+        bool bUseFallback = false;
+        TextureEncoder::TextureRole role = TextureEncoder::TextureRole::Color;
+        uint64_t cacheKey = 0;                // 0 if the source couldn't be read
+        // Not decoded since an earlier model had decoded it. Decoded on the render thread after all
+        // if the cache lost it by then, embedded images from a copy of their bytes.
+        bool bDecodeSkipped = false;
+        std::vector<uint8_t> skippedSource;
+        std::string skippedSourceFormat;
+        TextureFile textureFile;              // block compressed, or a container
+        bool bHasTextureFile = false;
+        SDL_Surface* imageData = nullptr;     // RGBA8, when there's no texture file
+        std::vector<uint8_t> embeddedData;    // copy of an embedded container, textureFile reads from it
+        TextureSlot slot;                     // set on the render thread
+    };
+
+    // A model loaded on the loader thread, finalized on the render thread over one or more frames
+    struct StreamedModel {
+        ~StreamedModel();
+        std::string name;
+        ModelDescriptor descriptor;
+        MeshHandle handle;
+        MeshData mesh;
+        std::vector<StreamedTexture> textures; // unique per filename
+        std::vector<std::unordered_map<aiTextureType, uint32_t>> materialTextures; // per material, into textures
+        double loadMilliseconds = 0.0;
+        Uint64 requestTime = 0;
+        // Finalization progress
+        size_t numTexturesCreated = 0;
+        uint32_t numFrames = 0;
+        bool bFailed = false;
+    };
+
+    // A texture waiting in the staging ring for the next streaming copy pass
+    struct TextureUpload {
+        TextureSlot slot;
+        glm::u32vec2 imageSize = {0, 0};
+        StagingRing::Allocation staging;
+        std::vector<TextureLevel> levels; // staging layout of textures loaded from a TextureFile
+        bool bGenerateMips = false;
+    };
+
     struct RenderPassContext {
         SDL_GPUCommandBuffer* commandBuffer = nullptr;
         SDL_GPUTexture* swapchainTexture = nullptr;
-        //SDL_GPURenderPass* renderPass = nullptr;
+        Uint32 swapchainWidth = 0;
+        Uint32 swapchainHeight = 0;
+        SDL_GPURenderPass* renderPass = nullptr; // set by the frame graph while a pass executes
         CameraData cameraData{};
     };
 
+    // What to draw for one submesh of a submitted node this frame
+    struct SubmeshDraw {
+        bool bVisible = false;
+        bool bUseMeshlets = false; // LOD0 through the culled meshlet draws
+        uint32_t lodIndex = 0;
+        uint32_t numIndices = 0;
+        MeshletCuller::DrawRange meshlets{};
+    };
+
 public:
     Renderer();
     ~Renderer();
@@ -105,11 +157,32 @@ public:
     SDL_Window* GetWindow() { return mWindow; }
     SDL_GPUDevice* GetDevice() { return mSDLDevice; }
     bool* GetDebugLightsToggle() { return &mShowDebugLights; }
-    MeshData* GetMeshData(std::string meshName) {
-        return &mMeshes[meshName]; 
-    }
+    bool* GetDepthPrepassToggle() { return &mDepthPrepass; }
+    bool* GetMeshLodsToggle() { return &mMeshLods; }
+    bool* GetMeshletCullingToggle() { return &mMeshletCulling; }
+    const RenderPassStats* GetPassStats() const { return &mLastPassStats; }
+    const TextureMemoryStats* GetTextureMemoryStats() const { return &mTextureMemory; }
+    const TextureCacheStats* GetTextureCacheStats() const { return mTextureCache.GetStats(); }
+    const StagingStats* GetStagingStats() const { return mStagingRing.GetStats(); }
+    const AssetRegistryStats* GetMeshRegistryStats() const { return mMeshRegistry.GetStats(); }
+    const TextureStreamingStats* GetTextureStreamingStats() const { return mTextureStreamer.GetStats(); }
 #pragma endregion
 
+    // Meshes by model name, shared by everyone holding a handle. The first acquire starts the
+    // load, the mesh is drawn once bLoaded is set. Invalid for names that aren't models.
+    MeshHandle AcquireMesh(const std::string& name);
+    void ReleaseMesh(const MeshHandle handle);
+    // Null for stale handles, whose mesh was unloaded. Don't keep it across AcquireMesh.
+    const MeshData* GetMesh(const MeshHandle handle) const { return mMeshRegistry.Get(handle); }
+    // Meshes nobody holds a handle to are unloaded, least recently released first, while the
+    // geometry and texture memory is over this
+    void SetAssetMemoryBudget(const uint64_t bytes) { mAssetMemoryBudget = bytes; }
+    // Unloads every mesh nobody holds a handle to, e.g. between levels
+    void UnloadUnusedAssets() { UnloadMeshes(0); }
+
+    // GPU memory the streamed mip levels of material textures are kept under
+    void SetTextureStreamingBudget(const uint64_t bytes) { mTextureStreamer.SetBudget(bytes); }
+
     void SetCameraEntity(CameraNode* cameraNode);
     CameraNode* GetCameraEntity() const {
         if (mCameraNodes.size() > 0) {
@@ -121,83 +194,138 @@ public:
         mNodesThisFrame.push_back(node);
     }
 
-    // returns nullptr if texture type not found
-    static SDL_GPUTexture* GetTexture(const MeshData& mesh, const aiTextureType type) {
-        for (auto& [filename, meshTexture] : mesh.textureIdMap) {
-            if (meshTexture.type == type) return meshTexture.texture;
-        }
-        return nullptr;
-    }
-
 private:
     void InitAssetLoader();
     bool InitPipelines();
-    bool InitCardPipeline();
-    bool InitGridPipeline();
-    bool InitMeshPipeline();
-    bool InitBillboardPipeline();
+    GraphicsPipelineDesc GetMeshPipelineDesc(const RenderMode renderMode, const bool bDepthPrepassed) const;
     void InitSamplers();
+    bool InitLighting();
     void InitGrid();
     void InitMeshes();
-    bool InitMesh(const ModelDescriptor& modelDescriptor, MeshData& mesh);
+
+    // Model streaming: loads run on mLoaderThread, UpdateStreaming finalizes them on the render thread
+    void RequestModel(const ModelDescriptor& modelDescriptor, const MeshHandle handle);
+    std::unique_ptr<StreamedModel> LoadStreamedModel(const ModelDescriptor& modelDescriptor);
+    // Skips textures an earlier model decoded if bSkipDecoded, the cache shares those
+    void DecodeStreamedTexture(const ModelDescriptor& modelDescriptor, const aiScene* scene, const bool bSkipDecoded, StreamedTexture& texture);
+    void CompressStreamedTexture(StreamedTexture& texture);
+    // Lets later loads decode the texture again, once the cache won't have it
+    void EraseDecodedTextureKey(const uint64_t key);
+    void UpdateStreaming();
+    uint64_t CreateStreamedTexture(const ModelDescriptor& modelDescriptor, StreamedTexture& texture, std::vector<TextureUpload>& outUploads);
+    void RecordTextureUpload(SDL_GPUCopyPass* copyPass, const TextureUpload& upload);
+    void RecordMipGeneration(SDL_GPUCommandBuffer* commandBuffer, const TextureUpload& upload);
+    void AddStreamedMaterials(StreamedModel& model);
+    void ReleaseStreamedModel(StreamedModel& model);
+    // Texture streaming: CullMeshes requests resolutions, UpdateTextureStreaming moves the mip levels
+    void RequestTextureResolutions(const MeshData& mesh, const SubMeshData& submesh, const glm::mat4& modelMatrix, const RenderPassContext& context);
+    void UpdateTextureStreaming();
+    void ReleaseTexture(const TextureSlot slot);
+    void UnloadMesh(const MeshHandle handle);
+    // Unloads unreferenced meshes until the asset memory is within budget
+    void UnloadMeshes(const uint64_t budget);
+    uint64_t GetAssetMemory() const;
 
     // Render pass functions
     bool BeginRenderPass(RenderPassContext& context);
+    void BuildFrameGraph(RenderPassContext& context);
     void InitCameraData(const CameraNode* cameraNode, CameraData& outCameraData) const;
+    void RecordUploadCommands(RenderPassContext& context);
+    void UpdateLightClusters(RenderPassContext& context);
     void RecordGridCommands(RenderPassContext& context);
+    void CullMeshes(RenderPassContext& context);
+    void RecordDepthPrepassCommands(RenderPassContext& context);
     void RecordModelCommands(RenderPassContext& context);
     void RecordDebugLightCommands(RenderPassContext& context);
+    void PrepareUIDrawData(RenderPassContext& context);
     void RecordUICommands(RenderPassContext& context);
     void EndRenderPass(RenderPassContext& context);
+    bool IsDepthPrepassActive() const;
+    glm::mat4 GetModelMatrix(const TransformComponent& transform, const SubMeshData& submesh) const;
+    ModelUniformGPU GetModelUniform(const TransformComponent& transform, const SubMeshData& submesh) const;
+    void BindGeometry(SDL_GPURenderPass* renderPass) const;
+    void DrawSubmesh(SDL_GPURenderPass* renderPass, const SubMeshData& submesh, const SubmeshDraw& draw, std::optional<SDL_GPUIndexElementSize>& boundIndexSize) const;
+    uint32_t SelectLod(const SubMeshData& submesh, const glm::mat4& modelMatrix, const RenderPassContext& context) const;
 
+    // Allocates the mesh's arena ranges and stages its geometry for them
     bool CreateModelGPUResources(
         MeshData& mesh,
-        SDL_GPUBufferCreateInfo& vertexBufferCreateInfo,
-        SDL_GPUTransferBuffer*& vertexTransferBuffer,
-        SDL_GPUBufferCreateInfo& indexBufferCreateInfo,
-        SDL_GPUTransferBuffer*& indexTransferBuffer
+        StagingRing::Allocation& outVertexStaging,
+        StagingRing::Allocation& outIndexStaging
     );
+    void CompactGeometry();
     bool CreateTextureGPUResources(
         const SDL_Surface* imageData,
         const std::string textureName,
-        SDL_GPUTexture*& outTexture,
-        SDL_GPUTransferBuffer*& outTransferBuffer
+        TextureSlot& outSlot,
+        StagingRing::Allocation& outStaging
     );
-    bool CreateFallbackTexture(
+    // Levels firstLevel and coarser of the file
+    bool CreateTextureGPUResources(
+        const TextureFile& textureFile,
+        const uint32_t firstLevel,
+        const std::string textureName,
+        TextureSlot& outSlot,
+        StagingRing::Allocation& outStaging,
+        std::vector<TextureLevel>& outLevels
+    );
+    // Shared fallback for the texture type. outStaging is only set (and needs uploading)
+    // the first time the fallback is created.
+    bool AcquireFallbackTexture(
         aiTextureType type, 
-        SDL_GPUTexture*& outTexture, 
-        SDL_GPUTransferBuffer*& outTransferBuffer
+        TextureSlot& outSlot, 
+        StagingRing::Allocation& outStaging
     );
 
-    SDL_GPUShader* LoadShader(
-        SDL_GPUDevice* device,
-        const std::string& shaderFilename,
-        const Uint32 samplerCount,
-        const Uint32 uniformBufferCount,
-        const Uint32 storageBufferCount,
-        const Uint32 storageTextureCount);
     SDL_Surface* LoadImage(const ModelDescriptor& modelDescriptor, int desiredChannels = 0);
     SDL_Surface* LoadImage(const std::string& foldername, const std::string& subfoldername, const std::string& texturename, int desiredChannels = 0);
     SDL_Surface* LoadImageShared(SDL_Surface* image, int desiredChannels = 0);
-    bool LoadModel(const ModelDescriptor& modelDescriptor, MeshData& outMesh, MeshLoadingContext& outContext);
-    void ParseNodes(MeshData& outMesh, MeshLoadingContext& outContext);
-    void ParseVertices(const aiScene* scene, const bool flipX, const bool flipY, const bool flipZ, MeshData& outMesh, MeshLoadingContext& outContext);
-    void ParseMaterials(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext);
-    void ParseTextures(const aiScene* scene, MeshData& outMesh, MeshLoadingContext& outContext);
+    std::string GetTextureSourcePath(const std::string& foldername, const std::string& subfoldername, const std::string& texturename);
+    bool PrepareTextureFile(TextureFile& textureFile, const std::string& textureName);
+    bool CompressTexture(const SDL_Surface* imageData, const TextureEncoder::TextureRole role, const std::string& textureName, TextureFile& outFile);
     
 private:
     SDL_Window* mWindow = nullptr;
     SDL_GPUDevice* mSDLDevice = nullptr;
-    SDL_GPUTexture* mDepthTexture = nullptr;
+    SDL_GPUTextureFormat mDepthStencilFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
     SDL_GPUTexture* mFallbackTexture = nullptr;
     
     std::vector<SDL_GPUSampler*> mSamplers;
-    std::unordered_map<RenderMode, SDL_GPUGraphicsPipeline*> mPipelines;
-    std::unordered_map<std::string, MeshData> mMeshes;
-    SDL_GPUGraphicsPipeline* mGridPipeline = nullptr;
-    SDL_GPUGraphicsPipeline* mBillboardPipeline = nullptr;
+    ContentPack mContentPack; // Content.scpack when there is one, loose files otherwise. Outlives its readers.
+    AssetRegistry<MeshData> mMeshRegistry;
+    uint64_t mAssetMemoryBudget = 1024ull * 1024 * 1024; // see SetAssetMemoryBudget
+    ThreadPool mThreadPool;
+    ModelImporter mModelImporter;
+    ShaderLibrary mShaderLibrary;
+    PipelineCache mPipelineCache;
+    GraphicsPipelineDesc mMeshPipelineDesc; // fill mode, see GetMeshPipelineDesc for the permutations
+    GraphicsPipelineDesc mDepthPrepassPipelineDesc;
+    GraphicsPipelineDesc mGridPipelineDesc;
+    GraphicsPipelineDesc mBillboardPipelineDesc;
     MeshData mGridMesh;
     SceneLighting mSceneLighting;
+    LightClusters mLightClusters;
+    FrameGraph mFrameGraph;
+    MeshletCuller mMeshletCuller;
+    std::vector<SubmeshDraw> mSubmeshDraws; // per visible node submesh, built by CullMeshes
+    RenderPassStats mPassStats; // accumulated while recording
+    RenderPassStats mLastPassStats; // last submitted frame, for display
+    TextureMemoryStats mTextureMemory;
+    MaterialTable mMaterialTable;
+    TextureCache mTextureCache;
+    TextureStreamer mTextureStreamer; // finer levels of the textures loaded from a TextureFile
+    StagingRing mStagingRing; // every upload is staged here
+    GeometryArena mVertexArena; // vertices and indices of every mesh
+    GeometryArena mIndexArena;
+
+    // One worker so models load in request order; loads may still spread work over mThreadPool
+    ThreadPool mLoaderThread;
+    std::deque<std::future<std::unique_ptr<StreamedModel>>> mModelLoads; // in request order
+    std::unique_ptr<StreamedModel> mStreamingModel; // loaded, GPU resources being created
+    // Textures decoded by a load, in the cache or on their way there. Erased when the cache frees one.
+    std::unordered_set<uint64_t> mDecodedTextureKeys;
+    std::mutex mDecodedTextureKeysMutex; // loads add and check keys, the render thread erases them
+    std::atomic<bool> mCancelModelLoads = false;
 
     std::vector<CameraNode*> mCameraNodes;
     std::vector<RenderNode*> mNodesThisFrame;
@@ -205,6 +333,14 @@ private:
     Uint8 mCurrentSamplerIndex = 0;
     RenderMode mRenderMode = RenderMode::Fill;
     bool mShowDebugLights = false;
+    bool mDepthPrepass = false;
+    bool mMeshLods = true;
+    bool mMeshletCulling = true;
+    // Block compress PNG/JPG textures at load, see CompressTexture. Off: SandCastleCook compresses
+    // them offline, encoding on the CPU would slow every load that misses a cooked texture.
+    bool mCompressTextures = false;
+    TextureEncoder::Quality mTextureCompressionQuality = TextureEncoder::Quality::Normal;
+    float mLodPixelError = 1.0f; // largest allowed projected simplification error, in pixels
     float mScale = 1.0f;
     glm::vec2 mCachedWindowCenter;
     const float mScaleStep = 10.0f;
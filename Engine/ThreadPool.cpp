@@ -0,0 +1,70 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::~ThreadPool() {
+    Shutdown();
+}
+
+void ThreadPool::Init(uint32_t numThreads) {
+    if (!mWorkers.empty()) return;
+    if (numThreads == 0) {
+        const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        numThreads = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+    }
+    mStopping = false;
+    mWorkers.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; ++i) {
+        mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+void ThreadPool::Shutdown() {
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    for (std::thread& worker : mWorkers) {
+        if (worker.joinable()) worker.join();
+    }
+    mWorkers.clear();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (mWorkers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // Items are claimed one at a time from a shared counter, which balances uneven item costs
+    std::atomic<size_t> next{0};
+    auto drain = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+
+    const size_t numHelpers = std::min(count - 1, mWorkers.size());
+    std::vector<std::future<void>> helpers;
+    helpers.reserve(numHelpers);
+    for (size_t i = 0; i < numHelpers; ++i) {
+        helpers.push_back(Submit(drain));
+    }
+    drain();
+    for (std::future<void>& helper : helpers) helper.get();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+            if (mStopping && mJobs.empty()) return;
+            job = std::move(mJobs.front());
+            mJobs.pop();
+        }
+        job();
+    }
+}
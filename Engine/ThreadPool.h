@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads consuming a FIFO of jobs.
+// Used for startup work (pipeline creation, asset processing) that is independent per item.
+class ThreadPool {
+public:
+    ThreadPool() = default;
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // numThreads == 0 uses one worker per hardware thread minus the calling thread
+    void Init(uint32_t numThreads = 0);
+    void Shutdown();
+
+    uint32_t GetNumThreads() const { return static_cast<uint32_t>(mWorkers.size()); }
+
+    template<typename F>
+    auto Submit(F&& job) -> std::future<decltype(job())>;
+
+    // Runs fn(i) for every i in [0, count) and blocks until all are done.
+    // The calling thread takes work too, so this is safe to call with no workers.
+    // Not meant to be called from inside a job.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> mWorkers;
+    std::queue<std::function<void()>> mJobs;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStopping = false;
+};
+
+template<typename F>
+auto ThreadPool::Submit(F&& job) -> std::future<decltype(job())> {
+    using Result = decltype(job());
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+    std::future<Result> future = task->get_future();
+    if (mWorkers.empty()) {
+        (*task)();
+        return future;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        mJobs.emplace([task]() { (*task)(); });
+    }
+    mCondition.notify_one();
+    return future;
+}
@@ -2,7 +2,9 @@
 
 #include <imgui_impl_sdl3.h>
 #include <imgui_impl_sdlgpu3.h>
+#include <AssetRegistry.h>
 #include <Nodes.h>
+#include <Render/RenderStructs.h>
 #include <SDL3/SDL.h>
 
 // statics
@@ -154,6 +156,75 @@ void UIManager::ToolbarUI()
         ImGui::SameLine();
         ImGui::Checkbox("Show Lights", mDebugLightsToggle);
     }
+    if (mDepthPrepassToggle) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Depth Prepass", mDepthPrepassToggle);
+    }
+    if (mMeshLodsToggle) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Mesh LODs", mMeshLodsToggle);
+    }
+    if (mMeshletCullingToggle) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Meshlet Culling", mMeshletCullingToggle);
+    }
+    if (mPassStats) {
+        ImGui::SameLine();
+        ImGui::Text("Passes: %u (culled %u)  Loads: %u  Clears: %u  Stores: %u  Transients: %u in %u textures (%.1f MB)",
+            mPassStats->numRenderPasses,
+            mPassStats->numPassesCulled,
+            mPassStats->numAttachmentLoads,
+            mPassStats->numAttachmentClears,
+            mPassStats->numAttachmentStores,
+            mPassStats->numTransientTextures,
+            mPassStats->numPooledTextures,
+            static_cast<double>(mPassStats->pooledTextureBytes) / (1024.0 * 1024.0));
+        ImGui::SameLine();
+        ImGui::Text("Meshlets: %u / %u  Draws: %u  Triangles: %llu / %llu",
+            mPassStats->numMeshletsVisible,
+            mPassStats->numMeshlets,
+            mPassStats->numDrawCalls,
+            static_cast<unsigned long long>(mPassStats->numTriangles),
+            static_cast<unsigned long long>(mPassStats->numTrianglesLod0));
+    }
+    if (mTextureMemoryStats) {
+        ImGui::SameLine();
+        ImGui::Text("Textures: %u  %.1f MB (mips %.1f MB)",
+            mTextureMemoryStats->numTextures,
+            static_cast<double>(mTextureMemoryStats->bytes) / (1024.0 * 1024.0),
+            static_cast<double>(mTextureMemoryStats->bytes - mTextureMemoryStats->baseLevelBytes) / (1024.0 * 1024.0));
+    }
+    if (mTextureCacheStats) {
+        ImGui::SameLine();
+        ImGui::Text("Shared: %u / %u (%.1f MB saved)",
+            mTextureCacheStats->numHits,
+            mTextureCacheStats->numRequests,
+            static_cast<double>(mTextureCacheStats->bytesSaved) / (1024.0 * 1024.0));
+    }
+    if (mStagingStats) {
+        ImGui::SameLine();
+        ImGui::Text("Staging: %.1f / %.1f MB (peak %.1f MB, %u stalls)",
+            static_cast<double>(mStagingStats->bytesInFlight) / (1024.0 * 1024.0),
+            static_cast<double>(mStagingStats->capacity) / (1024.0 * 1024.0),
+            static_cast<double>(mStagingStats->peakBytesInFlight) / (1024.0 * 1024.0),
+            mStagingStats->numStalls);
+    }
+    if (mTextureStreamingStats) {
+        ImGui::SameLine();
+        ImGui::Text("Textures: %.1f / %.1f MB (streamed %.1f MB, wanted %.1f MB)",
+            static_cast<double>(mTextureStreamingStats->reservedBytes) / (1024.0 * 1024.0),
+            static_cast<double>(mTextureStreamingStats->budget) / (1024.0 * 1024.0),
+            static_cast<double>(mTextureStreamingStats->residentBytes) / (1024.0 * 1024.0),
+            static_cast<double>(mTextureStreamingStats->wantedBytes) / (1024.0 * 1024.0));
+    }
+    if (mMeshRegistryStats) {
+        ImGui::SameLine();
+        ImGui::Text("Meshes: %u / %u referenced (%u shared, %u unloaded)",
+            mMeshRegistryStats->numReferenced,
+            mMeshRegistryStats->numAssets,
+            mMeshRegistryStats->numShared,
+            mMeshRegistryStats->numUnloaded);
+    }
   
 	ImGui::End();
 }
\ No newline at end of file
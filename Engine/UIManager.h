@@ -5,6 +5,12 @@
 #include <vector>
 
 class UINode;
+struct RenderPassStats;
+struct TextureMemoryStats;
+struct TextureCacheStats;
+struct StagingStats;
+struct TextureStreamingStats;
+struct AssetRegistryStats;
 
 class UIManager {
 public:
@@ -29,6 +35,15 @@ public:
     }
 
     void SetDebugLightsToggle(bool* toggle) { mDebugLightsToggle = toggle; }
+    void SetDepthPrepassToggle(bool* toggle) { mDepthPrepassToggle = toggle; }
+    void SetMeshLodsToggle(bool* toggle) { mMeshLodsToggle = toggle; }
+    void SetMeshletCullingToggle(bool* toggle) { mMeshletCullingToggle = toggle; }
+    void SetPassStats(const RenderPassStats* stats) { mPassStats = stats; }
+    void SetTextureMemoryStats(const TextureMemoryStats* stats) { mTextureMemoryStats = stats; }
+    void SetTextureCacheStats(const TextureCacheStats* stats) { mTextureCacheStats = stats; }
+    void SetStagingStats(const StagingStats* stats) { mStagingStats = stats; }
+    void SetTextureStreamingStats(const TextureStreamingStats* stats) { mTextureStreamingStats = stats; }
+    void SetMeshRegistryStats(const AssetRegistryStats* stats) { mMeshRegistryStats = stats; }
 
 protected:
     void DockSpaceUI();
@@ -38,4 +53,13 @@ protected:
 
     std::vector<UINode*> mNodesThisFrame;
     bool* mDebugLightsToggle = nullptr;
+    bool* mDepthPrepassToggle = nullptr;
+    bool* mMeshLodsToggle = nullptr;
+    bool* mMeshletCullingToggle = nullptr;
+    const RenderPassStats* mPassStats = nullptr;
+    const TextureMemoryStats* mTextureMemoryStats = nullptr;
+    const TextureCacheStats* mTextureCacheStats = nullptr;
+    const StagingStats* mStagingStats = nullptr;
+    const TextureStreamingStats* mTextureStreamingStats = nullptr;
+    const AssetRegistryStats* mMeshRegistryStats = nullptr;
 };
\ No newline at end of file